@@ -16,3 +16,31 @@ macro(set_output_paths)
 	set(CMAKE_ARCHIVE_OUTPUT_DIRECTORY ${PROJECT_BINARY_DIR}/bin)
 	set(CMAKE_LIBRARY_OUTPUT_DIRECTORY ${PROJECT_BINARY_DIR}/lib)
 endmacro()
+
+# Compiles GLSL shaders to SPIR-V with glslc and makes each one includable as "<name>.inc", a C array
+# initializer, so the binary carries its shaders. Shared code goes into .glsl files next to the shaders.
+# glslc is optional for the build as a whole: callers find GLSLC_EXECUTABLE and leave out what embeds shaders
+# when it is missing.
+function(target_embed_shaders target)
+	if (NOT GLSLC_EXECUTABLE)
+		message(FATAL_ERROR "target_embed_shaders(${target}) needs GLSLC_EXECUTABLE")
+	endif()
+	set(output_dir ${CMAKE_CURRENT_BINARY_DIR}/shaders)
+	foreach(shader ${ARGN})
+		get_filename_component(shader_path ${shader} ABSOLUTE)
+		get_filename_component(shader_name ${shader} NAME)
+		get_filename_component(shader_dir ${shader_path} DIRECTORY)
+		file(GLOB shader_includes ${shader_dir}/*.glsl)
+		set(output ${output_dir}/${shader_name}.inc)
+		add_custom_command(
+			OUTPUT ${output}
+			COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+			COMMAND ${GLSLC_EXECUTABLE} -O --target-env=vulkan1.1 -mfmt=c -o ${output} ${shader_path}
+			DEPENDS ${shader_path} ${shader_includes}
+			COMMENT "Compiling shader ${shader_name}"
+			VERBATIM
+		)
+		target_sources(${target} PRIVATE ${output})
+	endforeach()
+	target_include_directories(${target} PRIVATE ${output_dir})
+endfunction()
@@ -0,0 +1,3 @@
+#include "imgui.h"
+
+thread_local ImGuiContext* GImGuiThreadContext = nullptr;
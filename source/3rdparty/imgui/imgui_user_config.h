@@ -0,0 +1,7 @@
+#pragma once
+
+// The current ImGui context is per thread, so the render thread can record one window's draw data while the
+// main thread builds the next frame of another (see VulkanRenderer, --render-thread).
+struct ImGuiContext;
+extern thread_local ImGuiContext* GImGuiThreadContext;
+#define GImGui GImGuiThreadContext
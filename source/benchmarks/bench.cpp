@@ -0,0 +1,211 @@
+#include "bench.h"
+#include "cmd_line/parser.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace bench
+{
+    struct Result
+    {
+        std::string name;
+        uint64_t    iterations  = 0;
+        uint64_t    repetitions = 0;
+        double      median_ns   = 0.0;
+        double      min_ns      = 0.0;
+        double      mean_ns     = 0.0;
+    };
+
+    static std::vector<Benchmark>& registry()
+    {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    Registrar::Registrar(Benchmark benchmark) { registry().push_back(std::move(benchmark)); }
+
+    static double run_once(const Benchmark& benchmark, uint64_t iterations)
+    {
+        State state(iterations);
+        benchmark.run(state);
+        return state.get_elapsed_ns();
+    }
+
+    // Grows the iteration count until one run takes at least min_time_ns.
+    static uint64_t calibrate(const Benchmark& benchmark, double min_time_ns)
+    {
+        uint64_t iterations = 1;
+        for (;;)
+        {
+            const double elapsed = run_once(benchmark, iterations);
+            if (elapsed >= min_time_ns || iterations >= (1ull << 40))
+                return iterations;
+            const double factor = elapsed > 0.0 ? std::clamp(min_time_ns * 1.2 / elapsed, 2.0, 100.0) : 100.0;
+            iterations          = static_cast<uint64_t>(iterations * factor);
+        }
+    }
+
+    static Result measure(const Benchmark& benchmark, uint64_t repetitions, double min_time_ns)
+    {
+        Result result;
+        result.name        = benchmark.name;
+        result.repetitions = repetitions;
+        result.iterations  = benchmark.iterations ? benchmark.iterations : calibrate(benchmark, min_time_ns);
+
+        // One warm-up run, then repetitions that each yield a time per iteration.
+        run_once(benchmark, result.iterations);
+        std::vector<double> samples;
+        for (uint64_t r = 0; r < repetitions; ++r)
+            samples.push_back(run_once(benchmark, result.iterations) / static_cast<double>(result.iterations));
+
+        std::ranges::sort(samples);
+        result.min_ns    = samples.front();
+        result.median_ns = samples[samples.size() / 2];
+        result.mean_ns   = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+        return result;
+    }
+
+    static std::string escape(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    static bool write_json(const std::string& path, const std::vector<Result>& results)
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+
+        file << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& r = results[i];
+            file << "    {\"name\": \"" << escape(r.name) << "\", \"iterations\": " << r.iterations << ", \"repetitions\": " << r.repetitions
+                 << ", \"median_ns\": " << r.median_ns << ", \"min_ns\": " << r.min_ns << ", \"mean_ns\": " << r.mean_ns << "}"
+                 << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        file << "  ]\n}\n";
+        return true;
+    }
+
+    // Reads back the median of every benchmark from a file written by write_json.
+    static std::unordered_map<std::string, double> read_baseline(const std::string& path)
+    {
+        std::unordered_map<std::string, double> medians;
+        std::ifstream                           file(path);
+        std::stringstream                       text;
+        text << file.rdbuf();
+
+        const std::string content = text.str();
+        const std::regex  entry(R"re("name"\s*:\s*"((?:[^"\\]|\\.)*)"[^}]*"median_ns"\s*:\s*([-+0-9.eE]+))re");
+        for (auto it = std::sregex_iterator(content.begin(), content.end(), entry); it != std::sregex_iterator(); ++it)
+        {
+            medians[std::regex_replace((*it)[1].str(), std::regex(R"(\\(.))"), "$1")] = std::stod((*it)[2].str());
+        }
+        return medians;
+    }
+
+    static int run(int argc, char* argv[])
+    {
+        const core::Parser parser(argc, argv);
+        const std::string  filter      = parser.getOptionValue("filter");
+        const uint64_t     repetitions = std::max<uint64_t>(1, std::stoull(parser.getOptionValue("repetitions", "10")));
+        const double       min_time_ns = std::stod(parser.getOptionValue("min-time", "100")) * 1e6;
+        const double       tolerance   = std::stod(parser.getOptionValue("tolerance", "0.10"));
+        const std::string  out_path    = parser.getOptionValue("out");
+        const std::string  baseline    = parser.getOptionValue("baseline");
+
+        std::vector<Benchmark*> selected;
+        for (auto& benchmark : registry())
+        {
+            if (filter.empty() || benchmark.name.find(filter) != std::string::npos)
+                selected.push_back(&benchmark);
+        }
+        if (parser.hasOption("list"))
+        {
+            for (const Benchmark* benchmark : selected)
+                std::printf("%s\n", benchmark->name.c_str());
+            return 0;
+        }
+
+        std::vector<Result> results;
+        int                 failures = 0;
+        std::printf("%-40s %14s %14s %14s %12s\n", "benchmark", "median ns", "min ns", "mean ns", "iterations");
+        for (const Benchmark* benchmark : selected)
+        {
+            const std::string skipped = benchmark->skip ? benchmark->skip() : std::string();
+            if (!skipped.empty())
+            {
+                std::printf("%-40s SKIPPED: %s\n", benchmark->name.c_str(), skipped.c_str());
+                std::fflush(stdout);
+                continue;
+            }
+            if (benchmark->setup)
+                benchmark->setup();
+            results.push_back(measure(*benchmark, repetitions, min_time_ns));
+            const std::string failure = benchmark->check ? benchmark->check() : std::string();
+            if (benchmark->teardown)
+                benchmark->teardown();
+
+            const Result& r = results.back();
+            std::printf("%-40s %14.2f %14.2f %14.2f %12llu\n",
+                        r.name.c_str(),
+                        r.median_ns,
+                        r.min_ns,
+                        r.mean_ns,
+                        static_cast<unsigned long long>(r.iterations));
+            if (!failure.empty())
+            {
+                std::printf("%-40s FAILED: %s\n", r.name.c_str(), failure.c_str());
+                ++failures;
+            }
+            std::fflush(stdout);
+        }
+
+        if (!out_path.empty() && !write_json(out_path, results))
+        {
+            std::fprintf(stderr, "Could not write %s\n", out_path.c_str());
+            return 2;
+        }
+
+        if (baseline.empty())
+            return failures > 0 ? 1 : 0;
+
+        const auto medians     = read_baseline(baseline);
+        int        regressions = 0;
+        std::printf("\nCompared to %s (tolerance %.0f%%):\n", baseline.c_str(), tolerance * 100.0);
+        for (const Result& r : results)
+        {
+            auto it = medians.find(r.name);
+            if (it == medians.end())
+            {
+                std::printf("%-40s %14s\n", r.name.c_str(), "new");
+                continue;
+            }
+            const double change    = it->second > 0.0 ? r.median_ns / it->second - 1.0 : 0.0;
+            const bool   regressed = change > tolerance;
+            regressions += regressed ? 1 : 0;
+            std::printf("%-40s %+13.1f%% %s\n", r.name.c_str(), change * 100.0, regressed ? "REGRESSION" : "");
+        }
+        return regressions + failures > 0 ? 1 : 0;
+    }
+} // namespace bench
+
+int main(int argc, char* argv[])
+{
+    // Options not meant for the harness (--frame-arena-size, ...) reach the application through this instance.
+    core::Parser::instance(argc, argv);
+    return bench::run(argc, argv);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace bench
+{
+    class State
+    {
+    public:
+        explicit State(uint64_t iterations) : iterations_(iterations) {}
+
+        [[nodiscard]] uint64_t get_iterations() const noexcept { return iterations_; }
+
+        // Times body over all iterations; anything before the call is setup and not measured.
+        template<typename Body>
+        void run(Body&& body)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations_; ++i)
+                body();
+            elapsed_ns_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        [[nodiscard]] double get_elapsed_ns() const noexcept { return elapsed_ns_; }
+
+    private:
+        uint64_t iterations_;
+        double   elapsed_ns_ = 0.0;
+    };
+
+    struct Benchmark
+    {
+        std::string                 name;
+        std::function<void(State&)> run;
+        // Optional, called once around all repetitions, for fixtures too expensive to build per run.
+        std::function<void()> setup;
+        std::function<void()> teardown;
+        // 0 calibrates the iteration count against --min-time.
+        uint64_t iterations = 0;
+        // Optional, called after the repetitions and before teardown; a message fails the run.
+        std::function<std::string()> check;
+        // Optional, called before setup; a message skips the benchmark without failing the run.
+        std::function<std::string()> skip;
+    };
+
+    // Benchmarks register themselves through static Registrar objects.
+    struct Registrar
+    {
+        explicit Registrar(Benchmark benchmark);
+    };
+
+    // Keeps the optimizer from discarding a computed value.
+    template<typename T>
+    inline void do_not_optimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+} // namespace bench
@@ -0,0 +1,101 @@
+#include "bench.h"
+#include "headless_app.h"
+#include "memory/memory_tracker.h"
+#include "renderer/vulkan/vulkan_renderer.h"
+#include "system/subsystem.h"
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace
+{
+    std::unique_ptr<bench::HeadlessApp> app;
+
+    // Per memory tag; an array, so counting allocates nothing itself.
+    using AllocationCounts = std::array<uint64_t, core::MemoryTracker::max_tags>;
+    AllocationCounts allocations = {}; // Made by the measured frames, over all runs
+
+    // Heap allocations of every tag but the Vulkan driver's, whose callbacks are outside of the engine's control.
+    AllocationCounts count_allocations()
+    {
+        AllocationCounts counts = {};
+        for (uint16_t tag = 0; tag < core::MemoryTracker::get_tag_count(); ++tag)
+        {
+            if (tag != core::MemoryTracker::tag_vulkan)
+                counts[tag] = core::MemoryTracker::get_stats(tag).allocations;
+        }
+        return counts;
+    }
+
+    // Fixed frame count per repetition: every run covers the same amount of work.
+    bench::Registrar run_one_frame({
+        "app/run_one_frame",
+        [](bench::State& state) { state.run([]() { app->frame(); }); },
+        []() {
+            app = std::make_unique<bench::HeadlessApp>();
+            app->start_headless();
+        },
+        []() {
+            app->stop_headless();
+            app.reset();
+        },
+        300,
+    });
+
+    // The same frames with the main window read back every frame: what capturing adds to the frame time.
+    bench::Registrar run_one_frame_capture({
+        "app/run_one_frame/capture_every_frame",
+        [](bench::State& state) { state.run([]() { app->frame(); }); },
+        []() {
+            app = std::make_unique<bench::HeadlessApp>();
+            app->start_headless();
+            core::get_subsystem<core::VulkanRenderer>().get_frame_capture().set_interval(1, "bench_captures", core::FrameCapture::Format::raw);
+        },
+        []() {
+            app->stop_headless();
+            app.reset();
+            std::error_code error;
+            std::filesystem::remove_all("bench_captures", error);
+        },
+        300,
+    });
+
+    // Once the first frames have sized every cache and pool, a frame is meant not to touch the heap. Fails
+    // with the tags that allocated anyway; skipped without -DCORE_MEMORY_TRACKING=ON. Counts only around
+    // state.run, since the harness allocates its own bookkeeping between runs.
+    bench::Registrar steady_frame_allocations({
+        "app/steady_frame/allocations",
+        [](bench::State& state) {
+            const auto before = count_allocations();
+            state.run([]() { app->frame(); });
+            const auto after = count_allocations();
+            for (size_t tag = 0; tag < after.size(); ++tag)
+                allocations[tag] += after[tag] - before[tag];
+        },
+        []() {
+            app = std::make_unique<bench::HeadlessApp>();
+            app->start_headless();
+            for (int i = 0; i < 120; ++i)
+                app->frame();
+            allocations = {};
+        },
+        []() {
+            app->stop_headless();
+            app.reset();
+        },
+        300,
+        []() {
+            std::string failure;
+            for (uint16_t tag = 0; tag < core::MemoryTracker::get_tag_count(); ++tag)
+            {
+                if (allocations[tag] == 0)
+                    continue;
+                failure += failure.empty() ? "" : ", ";
+                failure += std::string(core::MemoryTracker::get_stats(tag).name) + " " + std::to_string(allocations[tag]);
+            }
+            return failure.empty() ? failure : "steady frames allocated: " + failure;
+        },
+        []() { return core::MemoryTracker::is_enabled() ? std::string() : std::string("needs -DCORE_MEMORY_TRACKING=ON"); },
+    });
+} // namespace
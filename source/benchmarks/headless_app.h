@@ -0,0 +1,31 @@
+#pragma once
+#include "app.h"
+#include "cmd_line/parser.hpp"
+#include <SDL3/SDL_hints.h>
+
+namespace bench
+{
+    // Drives the real frame loop without a visible window: SDL's offscreen video driver still gives
+    // Vulkan a (headless) surface, so the whole renderer runs. Needs a Vulkan driver that supports
+    // VK_EXT_headless_surface, e.g. lavapipe on machines without a GPU.
+    class HeadlessApp : public core::App
+    {
+    public:
+        void start_headless()
+        {
+            const auto driver = core::Parser::instance().getOptionValue("video-driver", "offscreen");
+            SDL_SetHint(SDL_HINT_VIDEO_DRIVER, driver.c_str());
+
+            // Frames are what gets measured, an unchanged one must not sleep.
+            wait_when_unchanged_ = false;
+
+            char  name[] = "benchmarks";
+            char* argv[] = {name, nullptr};
+            initialize("benchmarks", 1280, 720, 1, argv);
+        }
+
+        void frame() { run_one_frame(1.0f / 60.0f); }
+
+        void stop_headless() { shutdown(); }
+    };
+} // namespace bench
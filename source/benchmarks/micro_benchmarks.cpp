@@ -0,0 +1,151 @@
+#include "bench.h"
+#include "cmd_line/parser.hpp"
+#include "event/EventManager.h"
+#include "jobs/task.h"
+#include "log/ring_sink.h"
+#include "logger.h"
+#include "system/subsystem.h"
+#include "system/timer_wheel.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using core::Logger;
+
+    struct BenchEvent
+    {
+        int value;
+    };
+
+    struct Receiver
+    {
+        int64_t sum = 0;
+        void    on_event(const BenchEvent& event) { sum += event.value; }
+    };
+
+    void trigger(bench::State& state, size_t subscriber_count)
+    {
+        core::EventManager    events;
+        std::vector<Receiver> receivers(subscriber_count);
+        for (auto& receiver : receivers)
+            events.connect<BenchEvent, &Receiver::on_event>(receiver);
+
+        state.run([&]() { events.trigger<BenchEvent>(1); });
+        bench::do_not_optimize(receivers.front().sum);
+    }
+
+    bench::Registrar trigger_1({"event_manager/trigger/1", [](bench::State& state) { trigger(state, 1); }});
+    bench::Registrar trigger_16({"event_manager/trigger/16", [](bench::State& state) { trigger(state, 16); }});
+
+    bench::Registrar trigger_unconnected({"event_manager/trigger/unconnected", [](bench::State& state) {
+                                              core::EventManager events;
+                                              state.run([&]() { events.trigger<BenchEvent>(1); });
+                                          }});
+
+    // One subscriber joins and leaves next to 16 others, which disconnect has to scan past.
+    bench::Registrar connect_disconnect({"event_manager/connect_disconnect/16", [](bench::State& state) {
+                                             core::EventManager    events;
+                                             std::vector<Receiver> receivers(16);
+                                             for (auto& receiver : receivers)
+                                                 events.connect<BenchEvent, &Receiver::on_event>(receiver);
+
+                                             Receiver extra;
+                                             state.run([&]() {
+                                                 events.connect<BenchEvent, &Receiver::on_event>(extra);
+                                                 events.disconnect(extra);
+                                             });
+                                         }});
+
+    bench::Registrar get_subsystem({
+        "subsystem/get_subsystem",
+        [](bench::State& state) {
+            state.run([]() { bench::do_not_optimize(&core::get_subsystem<core::EventManager>()); });
+        },
+        []() {
+            core::details::initialize();
+            core::add_subsystem<core::EventManager>();
+        },
+        []() { core::details::dispose(); },
+    });
+
+    bench::Registrar parser_parse({"parser/parse/32", [](bench::State& state) {
+                                       std::vector<std::string> args = {"app"};
+                                       for (int i = 0; i < 16; ++i)
+                                       {
+                                           args.push_back("--option-" + std::to_string(i));
+                                           args.push_back(std::to_string(i * 1000));
+                                       }
+                                       std::vector<char*> argv;
+                                       for (auto& arg : args)
+                                           argv.push_back(arg.data());
+
+                                       state.run([&]() {
+                                           core::Parser parser(static_cast<int>(argv.size()), argv.data());
+                                           bench::do_not_optimize(parser);
+                                       });
+                                   }});
+
+    // A statement below the logger's level: what every disabled APPLOG_DEBUG costs.
+    bench::Registrar logger_filtered({"logger/filtered", [](bench::State& state) {
+                                          core::Logger::init();
+                                          state.run([]() { APPLOG_DEBUG("filtered {} {}", 42, "message"); });
+                                      }});
+
+    // Formatting plus the ring sink, the path every record takes into the in-app log viewer. The console
+    // and file sinks are left out, their cost is the terminal's and the disk's.
+    bench::Registrar logger_ring({"logger/ring_sink", [](bench::State& state) {
+                                      auto           sink = std::make_shared<core::RingSink>(1 << 16);
+                                      spdlog::logger logger("bench", sink);
+                                      logger.set_level(spdlog::level::info);
+                                      state.run([&]() { logger.info("frame {} took {:.3f} ms on {}", 1234, 16.667, "main"); });
+                                  }});
+
+    core::Task<int> add_one(int value) { co_return value + 1; }
+    core::Task<>    await_child(int& value) { value = co_await add_one(value); }
+
+    // Two coroutine frames from the TaskFramePool and a symmetric transfer each way.
+    bench::Registrar task_await({"task/await_child", [](bench::State& state) {
+                                     int value = 0;
+                                     state.run([&]() {
+                                         auto handle = await_child(value).release();
+                                         handle.resume();
+                                         handle.destroy();
+                                     });
+                                     bench::do_not_optimize(value);
+                                 }});
+
+    constexpr uint64_t ms = 1'000'000;
+
+    // Schedule and cancel next to 10000 waiting timers: constant time whatever the wheel holds.
+    bench::Registrar timer_wheel_add_remove({"timer_wheel/add_remove/10000", [](bench::State& state) {
+                                                 core::TimerWheel<int> wheel;
+                                                 for (uint64_t i = 0; i < 10000; ++i)
+                                                     wheel.add((i * 7919 % 10000) * ms, 0);
+
+                                                 uint64_t deadline = 0;
+                                                 state.run([&]() {
+                                                     wheel.remove(wheel.add(deadline, 0));
+                                                     deadline = (deadline + 7 * ms) % (10000 * ms);
+                                                 });
+                                             }});
+
+    // A frame's worth of time (16 ms) through 10000 timers repeating every 10 s: about 16 expire per step.
+    bench::Registrar timer_wheel_advance({"timer_wheel/advance/10000", [](bench::State& state) {
+                                              core::TimerWheel<int> wheel;
+                                              for (uint64_t i = 0; i < 10000; ++i)
+                                                  wheel.add(i * ms + 1, 0);
+
+                                              std::vector<core::TimerWheel<int>::Id> expired;
+                                              uint64_t                               now = 0;
+                                              state.run([&]() {
+                                                  now += 16 * ms;
+                                                  wheel.advance(now, expired);
+                                                  for (auto id : expired)
+                                                      wheel.reschedule(id, wheel.get_deadline(id) + 10000 * ms);
+                                                  expired.clear();
+                                              });
+                                              bench::do_not_optimize(wheel.get_scheduled_count());
+                                          }});
+} // namespace
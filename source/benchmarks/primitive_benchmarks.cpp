@@ -0,0 +1,200 @@
+// PrimitiveRenderer is only built where glslc was found.
+#ifdef CORE_PRIMITIVE_RENDERER
+#include "bench.h"
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include "headless_app.h"
+#include "renderer/primitives/primitive_renderer.h"
+#include "renderer/vulkan/vulkan_renderer.h"
+#include "window/window_manager.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t batch_count = 10;
+    constexpr uint32_t batch_size  = 1'000'000;
+    constexpr float    world_size  = 10'000.0f;
+    constexpr uint32_t grid_size   = 64; // Thumbnails per row and column
+    constexpr uint32_t thumb_size  = 64; // Texels per side
+
+    // Shows 10M random quads, lines and points in one canvas filling the main window. Most of them are
+    // sub-pixel at this zoom, so the culling and LOD passes decide the cost, not the rasterizer.
+    class PrimitiveStress : public core::EventSubscriber
+    {
+    public:
+        PrimitiveStress()
+        {
+            auto&                                   primitives = core::get_subsystem<core::PrimitiveRenderer>();
+            std::mt19937                            random(42);
+            std::uniform_real_distribution<float>   position(0.0f, world_size);
+            std::uniform_real_distribution<float>   extent(0.0f, 8.0f);
+            std::uniform_int_distribution<uint32_t> color(0, 0xFFFFFF);
+
+            std::vector<core::Primitive> data(batch_size);
+            for (uint32_t b = 0; b < batch_count; ++b)
+            {
+                for (uint32_t i = 0; i < batch_size; ++i)
+                {
+                    const ImVec2 p    = {position(random), position(random)};
+                    const ImVec2 q    = {p.x + extent(random), p.y + extent(random)};
+                    const ImU32  rgba = color(random) | IM_COL32_A_MASK;
+                    switch (i % 3)
+                    {
+                    case 0: data[i] = core::Primitive::quad(p, q, rgba); break;
+                    case 1: data[i] = core::Primitive::line(p, q, 1.0f, rgba); break;
+                    default: data[i] = core::Primitive::point(p, 2.0f, rgba); break;
+                    }
+                }
+                batches_.push_back(primitives.create_batch(batch_size));
+                primitives.write_batch(batches_.back(), 0, data);
+            }
+            canvas_ = primitives.create_canvas();
+            connect<core::FrameUiRender, PrimitiveStress, &PrimitiveStress::ui_render>(*this);
+        }
+
+        ~PrimitiveStress()
+        {
+            disconnect(*this);
+            auto& primitives = core::get_subsystem<core::PrimitiveRenderer>();
+            primitives.destroy_canvas(canvas_);
+            for (auto batch : batches_)
+                primitives.destroy_batch(batch);
+        }
+
+    private:
+        void ui_render(const core::FrameUiRender& event)
+        {
+            if (!core::get_subsystem<core::WindowManager>().is_main_window(event.window_id))
+                return;
+
+            const ImGuiViewport* viewport = ImGui::GetMainViewport();
+            ImGui::SetNextWindowPos(viewport->WorkPos);
+            ImGui::SetNextWindowSize(viewport->WorkSize);
+            ImGui::Begin("Primitive stress", nullptr, ImGuiWindowFlags_NoDecoration);
+            core::get_subsystem<core::PrimitiveRenderer>().draw_canvas(
+                canvas_, ImGui::GetContentRegionAvail(), {{0.0f, 0.0f}, {world_size, world_size}, IM_COL32_BLACK}, batches_);
+            ImGui::End();
+        }
+
+        std::vector<core::PrimitiveRenderer::BatchId> batches_;
+        core::PrimitiveRenderer::CanvasId             canvas_ = 0;
+    };
+
+    // A grid of 4096 distinct 64x64 textures, as a gallery of asset thumbnails would be. With a bindless
+    // heap they are one batch sampled through a single descriptor set bind, without one tinted quads.
+    class ThumbnailGrid : public core::EventSubscriber
+    {
+    public:
+        ThumbnailGrid()
+        {
+            auto& renderer   = core::get_subsystem<core::VulkanRenderer>();
+            auto& primitives = core::get_subsystem<core::PrimitiveRenderer>();
+
+            std::vector<uint8_t>         pixels(thumb_size * thumb_size * 4);
+            std::vector<core::Primitive> data;
+            for (uint32_t i = 0; i < grid_size * grid_size; ++i)
+            {
+                const uint32_t texture = renderer.create_bindless_texture(thumb_size, thumb_size);
+                for (uint32_t texel = 0; texel < thumb_size * thumb_size; ++texel)
+                {
+                    const uint32_t x      = texel % thumb_size;
+                    const uint32_t y      = texel / thumb_size;
+                    pixels[texel * 4 + 0] = static_cast<uint8_t>(x * 4);
+                    pixels[texel * 4 + 1] = static_cast<uint8_t>(y * 4);
+                    pixels[texel * 4 + 2] = static_cast<uint8_t>(i);
+                    pixels[texel * 4 + 3] = 255;
+                }
+                renderer.update_bindless_texture(texture, 0, 0, thumb_size, thumb_size, pixels.data(), thumb_size);
+                textures_.push_back(texture);
+
+                const ImVec2 min = {static_cast<float>(i % grid_size), static_cast<float>(i / grid_size)};
+                data.push_back(core::Primitive::image(min, {min.x + 0.9f, min.y + 0.9f}, texture));
+            }
+            batch_ = primitives.create_batch(static_cast<uint32_t>(data.size()));
+            primitives.write_batch(batch_, 0, data);
+            canvas_ = primitives.create_canvas();
+            connect<core::FrameUiRender, ThumbnailGrid, &ThumbnailGrid::ui_render>(*this);
+        }
+
+        ~ThumbnailGrid()
+        {
+            disconnect(*this);
+            auto& primitives = core::get_subsystem<core::PrimitiveRenderer>();
+            primitives.destroy_canvas(canvas_);
+            primitives.destroy_batch(batch_);
+            for (uint32_t texture : textures_)
+                core::get_subsystem<core::VulkanRenderer>().destroy_bindless_texture(texture);
+        }
+
+    private:
+        void ui_render(const core::FrameUiRender& event)
+        {
+            if (!core::get_subsystem<core::WindowManager>().is_main_window(event.window_id))
+                return;
+
+            const ImGuiViewport* viewport = ImGui::GetMainViewport();
+            ImGui::SetNextWindowPos(viewport->WorkPos);
+            ImGui::SetNextWindowSize(viewport->WorkSize);
+            ImGui::Begin("Thumbnail grid", nullptr, ImGuiWindowFlags_NoDecoration);
+            const core::PrimitiveRenderer::BatchId batches[] = {batch_};
+            const float                            extent    = static_cast<float>(grid_size);
+            core::CanvasView                       view      = {{0.0f, 0.0f}, {extent, extent}, IM_COL32_BLACK, 0.0f};
+            core::get_subsystem<core::PrimitiveRenderer>().draw_canvas(canvas_, ImGui::GetContentRegionAvail(), view, batches);
+            ImGui::End();
+        }
+
+        std::vector<uint32_t>             textures_;
+        core::PrimitiveRenderer::BatchId  batch_  = 0;
+        core::PrimitiveRenderer::CanvasId canvas_ = 0;
+    };
+
+    std::unique_ptr<bench::HeadlessApp> app;
+    std::unique_ptr<PrimitiveStress>    stress;
+    std::unique_ptr<ThumbnailGrid>      thumbnails;
+
+    // Waits for the GPU every frame so the GPU side of culling and drawing is part of the time.
+    bench::Registrar primitives_10m({
+        "primitives/frame/10m",
+        [](bench::State& state) {
+            state.run([]() {
+                app->frame();
+                core::get_subsystem<core::VulkanRenderer>().wait_gpu_idle();
+            });
+        },
+        []() {
+            app = std::make_unique<bench::HeadlessApp>();
+            app->start_headless();
+            stress = std::make_unique<PrimitiveStress>();
+        },
+        []() {
+            stress.reset();
+            app->stop_headless();
+            app.reset();
+        },
+        100,
+    });
+
+    bench::Registrar primitives_thumbnails({
+        "primitives/frame/thumbnails",
+        [](bench::State& state) {
+            state.run([]() {
+                app->frame();
+                core::get_subsystem<core::VulkanRenderer>().wait_gpu_idle();
+            });
+        },
+        []() {
+            app = std::make_unique<bench::HeadlessApp>();
+            app->start_headless();
+            thumbnails = std::make_unique<ThumbnailGrid>();
+        },
+        []() {
+            thumbnails.reset();
+            app->stop_headless();
+            app.reset();
+        },
+        100,
+    });
+} // namespace
+#endif
@@ -0,0 +1,144 @@
+#include "bench.h"
+#include "cmd_line/parser.hpp"
+#include "jobs/job_system.h"
+#include "search/text_corpus.h"
+#include "search/text_search.h"
+#include "system/subsystem.h"
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr size_t corpus_size = size_t {1} << 30;
+    constexpr size_t text_size   = 16 << 20;
+
+    // Log lines in the style of the engine's own, from a small vocabulary; one line in a million has
+    // "device lost", whose trigrams the rest never contains.
+    void generate_log(size_t size, const std::function<void(std::string_view)>& add)
+    {
+        static const char* levels[]  = {"trace", "debug", "info", "info", "info", "warning", "error"};
+        static const char* systems[] = {"render", "jobs", "asset", "gui", "scene", "input", "shader", "window"};
+        static const char* actions[] = {"frame submitted", "swapchain resized", "texture uploaded", "pipeline built", "buffer mapped",
+                                        "batch culled", "font atlas rebuilt", "timer fired", "mesh streamed", "queue flushed"};
+
+        std::mt19937 random(7);
+        char         line[160];
+        for (size_t written = 0, index = 0; written < size; ++index)
+        {
+            const int length = index % 1'000'000 == 999'999
+                                   ? std::snprintf(line, sizeof(line), "[error] [render] device lost after frame %zu", index)
+                                   : std::snprintf(line,
+                                                   sizeof(line),
+                                                   "[%s] [%s] %s %u in %u.%03u ms",
+                                                   levels[random() % std::size(levels)],
+                                                   systems[random() % std::size(systems)],
+                                                   actions[random() % std::size(actions)],
+                                                   static_cast<unsigned>(random() % 100'000),
+                                                   static_cast<unsigned>(random() % 20),
+                                                   static_cast<unsigned>(random() % 1000));
+            add({line, static_cast<size_t>(length)});
+            written += static_cast<size_t>(length) + 1;
+        }
+    }
+
+    std::string                       text;
+    std::unique_ptr<core::TextCorpus> corpus;
+
+    void find_text(bench::State& state, core::SearchIsa isa)
+    {
+        core::set_search_isa(isa);
+        // Not in the text, so every byte is looked at.
+        const core::TextPattern pattern("vulkan", true);
+        state.run([&]() { bench::do_not_optimize(pattern.find(text)); });
+        core::set_search_isa(core::SearchIsa::avx2); // Back to the best the CPU has
+    }
+
+    void search_corpus(bench::State& state, std::string_view query)
+    {
+        const core::TextMatcher               matcher(query);
+        std::vector<core::TextCorpus::LineId> lines;
+        state.run([&]() {
+            lines.clear();
+            corpus->search(matcher, lines);
+        });
+        bench::do_not_optimize(lines.size());
+    }
+
+    void make_text()
+    {
+        text.reserve(text_size);
+        generate_log(text_size, [](std::string_view line) {
+            text += line;
+            text += '\n';
+        });
+    }
+
+    void make_corpus()
+    {
+        // --search-workers picks the worker count, to see how the scan scales; 0 is the JobSystem's default.
+        const size_t workers = core::Parser::instance().getOptionNumber<size_t>("search-workers", 0).value_or(0);
+        core::details::initialize();
+        core::add_subsystem<core::JobSystem>(workers);
+        corpus = std::make_unique<core::TextCorpus>();
+        generate_log(corpus_size, [](std::string_view line) { corpus->append(line); });
+        // The scan time means little without what it ran on.
+        std::printf("search/corpus: %llu MiB scanned by %zu JobSystem workers and the caller, %u hardware threads\n",
+                    static_cast<unsigned long long>(corpus->get_size() >> 20),
+                    core::get_subsystem<core::JobSystem>().get_worker_count(),
+                    std::thread::hardware_concurrency());
+    }
+
+    void destroy_corpus()
+    {
+        corpus.reset();
+        core::details::dispose();
+    }
+
+    // 16 MiB with each kernel; the fastest the CPU has is the default.
+    bench::Registrar find_text_scalar({
+        "search/find_text/scalar",
+        [](bench::State& state) { find_text(state, core::SearchIsa::scalar); },
+        make_text,
+        []() { std::string().swap(text); },
+    });
+
+    bench::Registrar find_text_sse2({
+        "search/find_text/sse2",
+        [](bench::State& state) { find_text(state, core::SearchIsa::sse2); },
+        make_text,
+        []() { std::string().swap(text); },
+    });
+
+    bench::Registrar find_text_avx2({
+        "search/find_text/avx2",
+        [](bench::State& state) { find_text(state, core::SearchIsa::avx2); },
+        make_text,
+        []() { std::string().swap(text); },
+    });
+
+    // Both words are in every block, so the index rules nothing out: all of the 1 GiB is scanned on the
+    // JobSystem, which is the worst case of a query. Filtering 1 GiB is meant to take under 100 ms; on one
+    // hardware thread this scan takes about three and a half times that, so it needs four cores to get there.
+    bench::Registrar corpus_scan({
+        "search/corpus/scan/1g",
+        [](bench::State& state) { search_corpus(state, "swapchain error"); },
+        make_corpus,
+        destroy_corpus,
+        10,
+    });
+
+    // The trigram signatures leave the few blocks with the rare line and the open block to scan.
+    bench::Registrar corpus_selective({
+        "search/corpus/selective/1g",
+        [](bench::State& state) { search_corpus(state, "device lost"); },
+        make_corpus,
+        destroy_corpus,
+        10,
+    });
+} // namespace
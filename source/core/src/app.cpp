@@ -4,28 +4,57 @@
 #include "system/subsystem.h"
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <asset/asset_system.h>
 #include <event/EventManager.h>
 #include <event/frame_event.h>
 #include <event/sdl_event.h>
+#include <font/font_manager.h>
 #include <gui/gui.h>
+#include <input/input_recorder.h>
+#include <jobs/job_system.h>
+#include <jobs/task_scheduler.h>
+#include <memory/frame_arena.h>
+#include <memory/memory_reporter.h>
+#include <memory/memory_tracker.h>
+#include <metrics/metrics.h>
+#ifdef CORE_PRIMITIVE_RENDERER
+#include <renderer/primitives/primitive_renderer.h>
+#endif
 #include <renderer/renderer.h>
+#include <renderer/shader_manager.h>
 #include <renderer/vulkan/vulkan_renderer.h>
+#include <scene/scene.h>
+#include <system/session_snapshot.h>
+#include <system/timers.h>
+#include <system/watchdog.h>
 #include <window/window_manager.h>
 
 namespace core
 {
-    int App::run(const std::string& title, int w, int h, int argc, char* argv[])
+    namespace
     {
-        details::initialize();
-        Parser::instance(argc, argv);
-        setup();
-        APPLOG_INFO("App {} setup", title);
+        constexpr double   default_fixed_update_rate      = 60.0;
+        constexpr uint32_t default_fixed_update_max_steps = 5;
 
-        add_subsystem<WindowManager>(title, w, h);
-        start();
-        APPLOG_INFO("App {} start", title);
+        // Upper bound of an idle sleep, for wake ups that are no SDL event (replayed input, windows shown by code).
+        constexpr int32_t max_idle_timeout_ms = 100;
 
-        APPLOG_INFO(Parser::instance().getOptionsString());
+        int32_t get_idle_timeout(const Timers& timers)
+        {
+            const auto deadline = timers.get_next_deadline();
+            if (!deadline)
+                return max_idle_timeout_ms;
+            // Rounded up: waking before the deadline would only find the timer not due yet.
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(*deadline - Timers::Clock::now()).count();
+            return static_cast<int32_t>(std::clamp<int64_t>(left, 0, max_idle_timeout_ms));
+        }
+    } // namespace
+
+    int App::run(const std::string& title, int w, int h, int argc, char* argv[])
+    {
+        initialize(title, w, h, argc, argv);
 
         auto& window_manager = get_subsystem<WindowManager>();
 
@@ -38,46 +67,177 @@ namespace core
             lastTime = currentTime;
         }
 
-        stop();
+        shutdown();
+        return 0;
+    }
+
+    void App::initialize(const std::string& title, int w, int h, int argc, char* argv[])
+    {
+        MemoryTracker::install();
+        details::initialize();
+        Parser::instance(argc, argv);
+        setup();
+        APPLOG_INFO("App {} setup", title);
 
+        // Bad values fall back to the defaults instead of stopping the app.
+        auto& parser    = Parser::instance();
+        auto  rate      = parser.getOptionNumber<double>("fixed-update-rate", default_fixed_update_rate);
+        auto  max_steps = parser.getOptionNumber<uint32_t>("fixed-update-max-steps", default_fixed_update_max_steps);
+        if (!rate || !std::isfinite(*rate) || *rate < 0.0)
+        {
+            APPLOG_WARNING("--fixed-update-rate {} is not a rate in Hz (0 for none), using {}",
+                           parser.getOptionValue("fixed-update-rate"),
+                           default_fixed_update_rate);
+            rate = default_fixed_update_rate;
+        }
+        if (!max_steps || *max_steps == 0)
+        {
+            APPLOG_WARNING("--fixed-update-max-steps {} is not a step count, using {}",
+                           parser.getOptionValue("fixed-update-max-steps"),
+                           default_fixed_update_max_steps);
+            max_steps = default_fixed_update_max_steps;
+        }
+        fixed_timestep_ = FixedTimestep(*rate, *max_steps);
+
+        add_subsystem<WindowManager>(title, w, h);
+        start();
+        APPLOG_INFO("App {} start", title);
+
+        APPLOG_INFO(Parser::instance().getOptionsString());
+    }
+
+    void App::shutdown()
+    {
+        stop();
         details::dispose();
-        return 0;
     }
 
-    void core::App::setup() { Logger::init(true, "log/logs.txt", spdlog::level::info); }
+    // Runs after the command line is parsed, so the logger can take its options.
+    void core::App::setup()
+    {
+        const auto ring_size = Parser::instance().getOptionNumber<size_t>("log-ring-size", Logger::default_ring_size);
+        Logger::init(true, "log/logs.txt", spdlog::level::info, ring_size.value_or(Logger::default_ring_size));
+        if (!ring_size)
+            APPLOG_WARNING("--log-ring-size {} is not a record count, using {}",
+                           Parser::instance().getOptionValue("log-ring-size"),
+                           Logger::default_ring_size);
+    }
 
     void core::App::start()
     {
+        add_subsystem<JobSystem>();
         add_subsystem<EventManager>();
+        add_subsystem<Timers>();
+        add_subsystem<InputRecorder>();
+        add_subsystem<FrameArena>();
+        add_subsystem<Watchdog>();
+        add_subsystem<Metrics>();
+        add_subsystem<AssetSystem>();
+        // Before everything that restores state from it, so it is disposed after them and sees their last state.
+        add_subsystem<SessionSnapshot>();
+        if (MemoryTracker::is_enabled())
+            add_subsystem<MemoryReporter>();
         add_subsystem<VulkanRenderer>();
+        add_subsystem<ShaderManager>();
+#ifdef CORE_PRIMITIVE_RENDERER
+        add_subsystem<PrimitiveRenderer>();
+#endif
+        add_subsystem<FontManager>();
+        add_subsystem<Scene>();
         add_subsystem<Gui>();
+        add_subsystem<TaskScheduler>();
+    }
+
+    void core::App::dispatch_event(SDL_Event& event, std::pmr::vector<uint32_t>& closed_windows)
+    {
+        auto&       window_manager = get_subsystem<WindowManager>();
+        SDL_Window* sdl_window     = SDL_GetWindowFromEvent(&event);
+        Window*     window         = sdl_window ? window_manager.get_window_by_id(SDL_GetWindowID(sdl_window)) : nullptr;
+
+        get_subsystem<EventManager>().trigger<SDLEvent>(SDLEvent {&event, window});
+        if (event.type == SDL_EVENT_QUIT)
+            running_ = false;
+        if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && window)
+        {
+            if (window_manager.is_main_window(window->get_id()))
+                running_ = false;
+            else
+                closed_windows.push_back(window->get_id());
+        }
     }
 
     void core::App::run_one_frame(float dt)
     {
-        SDL_Event event;
-        auto      window        = get_subsystem<WindowManager>().get_main_window();
-        auto&     event_manager = get_subsystem<EventManager>();
+        SDL_Event                  event;
+        auto&                      window_manager = get_subsystem<WindowManager>();
+        auto&                      event_manager  = get_subsystem<EventManager>();
+        auto&                      frame_arena    = get_subsystem<FrameArena>();
+        auto&                      input          = get_subsystem<InputRecorder>();
+        auto&                      watchdog       = get_subsystem<Watchdog>();
+        std::pmr::vector<uint32_t> closed_windows(frame_arena.get_resource());
 
+        watchdog.begin_frame();
+        dt = input.begin_frame(dt);
         while (SDL_PollEvent(&event))
         {
-            event_manager.trigger<SDLEvent>(SDLEvent {&event});
-            if (event.type == SDL_EVENT_QUIT)
-                running_ = false;
-            if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && event.window.windowID == window->get_id())
-                running_ = false;
+            if (input.accept_live_event(event))
+                dispatch_event(event, closed_windows);
+        }
+        for (SDL_Event& replayed : input.get_replayed_events())
+        {
+            dispatch_event(replayed, closed_windows);
         }
-        if (window->get_flags() & SDL_WINDOW_MINIMIZED)
+        if (input.is_finished())
+            running_ = false;
+
+        for (uint32_t id : closed_windows)
         {
-            SDL_Delay(10);
+            window_manager.destroy_window(id);
+        }
+
+        auto windows = window_manager.get_windows(frame_arena.get_resource());
+        std::erase_if(windows, [](const Window* w) { return !w->is_renderable(); });
+        if (windows.empty())
+        {
+            // Without frame events timers run here, then the loop sleeps until an event or the next timer.
+            auto& timers = get_subsystem<Timers>();
+            timers.run_due();
+            // No FrameEnd comes for this iteration, the arena still has to move on.
+            frame_arena.reset_frame();
+            watchdog.skip_frame();
+            SDL_WaitEventTimeout(nullptr, get_idle_timeout(timers));
             return;
         }
 
+        // Idle iterations above do not advance the simulation, it picks up where it was once a window shows again.
+        const uint32_t steps = fixed_timestep_.advance(dt);
+        const uint64_t first = fixed_timestep_.get_step_count() - steps;
+        const float    alpha = fixed_timestep_.get_alpha();
+
+        watchdog.phase(FramePhase::begin);
         event_manager.trigger<FrameBegin>(FrameBegin {dt});
+        watchdog.phase(FramePhase::fixed_update);
+        for (uint32_t i = 0; i < steps; ++i)
+        {
+            event_manager.trigger<FrameFixedUpdate>(FrameFixedUpdate {fixed_timestep_.get_step(), first + i});
+        }
+        watchdog.phase(FramePhase::update);
         event_manager.trigger<FrameUpdate>(FrameUpdate {dt});
-        event_manager.trigger<FrameUiRender>(FrameUiRender {dt});
-        event_manager.trigger<FrameRender>(FrameRender {dt});
+        watchdog.phase(FramePhase::ui_render);
+        for (Window* window : windows)
+        {
+            event_manager.trigger<FrameUiRender>(FrameUiRender {dt, window->get_id(), alpha});
+        }
+        watchdog.phase(FramePhase::render);
+        event_manager.trigger<FrameRender>(FrameRender {dt, alpha});
+        watchdog.phase(FramePhase::end);
         event_manager.trigger<FrameEnd>(FrameEnd {dt});
+        watchdog.end_frame();
+
+        // Drawing the same frame again would only burn power. Like the idle path above, the wait is capped, so
+        // changes no event announces (job results, hover delays) show up late by at most that much.
+        if (wait_when_unchanged_ && get_subsystem<VulkanRenderer>().is_frame_unchanged())
+            SDL_WaitEventTimeout(nullptr, get_idle_timeout(get_subsystem<Timers>()));
     }
 
     void App::stop() {}
@@ -1,7 +1,12 @@
 #pragma once
 #include "cmd_line/parser.hpp"
+#include "system/fixed_timestep.h"
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <vector>
+
+union SDL_Event;
 
 namespace core
 {
@@ -11,11 +16,22 @@ namespace core
         int run(const std::string& title, int w, int h, int argc, char* argv[]);
 
     protected:
+        // run() is initialize(), run_one_frame() until quit, shutdown(); split for hosts that drive frames themselves.
+        void initialize(const std::string& title, int w, int h, int argc, char* argv[]);
+        void shutdown();
+
         void setup();
         void start();
         void stop();
         void run_one_frame(float dt);
 
-        bool running_ = true;
+        // Sends an SDL event to the EventManager and handles quit and window close requests.
+        void dispatch_event(SDL_Event& event, std::pmr::vector<uint32_t>& closed_windows);
+
+        bool          running_ = true;
+        // After a frame that changed nothing on screen, wait for an event or the next timer; hosts that time
+        // frames turn it off.
+        bool          wait_when_unchanged_ = true;
+        FixedTimestep fixed_timestep_;
     };
 } // namespace core
@@ -0,0 +1,156 @@
+#include "asset_archive.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace core
+{
+    bool AssetArchive::open(const std::filesystem::path& path)
+    {
+        entries_ = {};
+        names_   = {};
+        if (!file_.open(path))
+            return false;
+
+        const auto data = file_.get_data();
+        Header     header;
+        if (data.size() < sizeof(header))
+        {
+            file_.close();
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        // Everything the index points at has to lie inside the file, so lookups need no further checks.
+        const bool valid = std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version &&
+                           header.index_offset % alignof(Entry) == 0 && header.index_offset <= data.size() &&
+                           header.entry_count <= (data.size() - header.index_offset) / sizeof(Entry) &&
+                           header.names_offset >= header.index_offset + header.entry_count * sizeof(Entry) && header.names_offset <= data.size();
+        if (!valid)
+        {
+            file_.close();
+            return false;
+        }
+
+        entries_ = {reinterpret_cast<const Entry*>(data.data() + header.index_offset), static_cast<size_t>(header.entry_count)};
+        names_   = {reinterpret_cast<const char*>(data.data() + header.names_offset), data.size() - static_cast<size_t>(header.names_offset)};
+        for (const Entry& entry : entries_)
+        {
+            if (entry.offset > data.size() || entry.size > data.size() - entry.offset || entry.name_offset > names_.size() ||
+                entry.name_size > names_.size() - entry.name_offset)
+            {
+                entries_ = {};
+                names_   = {};
+                file_.close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const AssetArchive::Entry* AssetArchive::find(std::string_view path) const
+    {
+        const uint64_t hash  = hash_asset_path(path);
+        auto           first = std::lower_bound(
+            entries_.begin(), entries_.end(), hash, [](const Entry& entry, uint64_t value) { return entry.path_hash < value; });
+        for (auto it = first; it != entries_.end() && it->path_hash == hash; ++it)
+        {
+            const std::string_view name = get_path(*it);
+            if (name.size() == path.size() &&
+                std::equal(name.begin(), name.end(), path.begin(), [](char a, char b) { return a == (b == '\\' ? '/' : b); }))
+                return &*it;
+        }
+        return nullptr;
+    }
+
+    std::span<const std::byte> AssetArchive::get_data(const Entry& entry) const
+    {
+        return file_.get_data().subspan(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+    }
+
+    std::string_view AssetArchive::get_path(const Entry& entry) const { return names_.substr(entry.name_offset, entry.name_size); }
+
+    bool AssetArchive::build(const std::filesystem::path& root, const std::filesystem::path& output, std::string& error)
+    {
+        struct Source
+        {
+            std::filesystem::path path;
+            std::string           name;
+            Entry                 entry {};
+        };
+
+        std::error_code     code;
+        std::vector<Source> sources;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, code); !code && it != std::filesystem::recursive_directory_iterator();
+             it.increment(code))
+        {
+            if (it->is_regular_file())
+                sources.push_back({it->path(), it->path().lexically_relative(root).generic_string()});
+        }
+        if (code)
+        {
+            error = "can not list " + root.string() + ": " + code.message();
+            return false;
+        }
+
+        // Sorted by name first so the data order, and with it the archive, is reproducible.
+        std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.name < b.name; });
+
+        std::ofstream file(output, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            error = "can not create " + output.string();
+            return false;
+        }
+
+        auto pad = [&file](uint64_t alignment)
+        {
+            static constexpr char zeros[data_alignment] = {};
+            const uint64_t        position              = static_cast<uint64_t>(file.tellp());
+            file.write(zeros, static_cast<std::streamsize>((alignment - position % alignment) % alignment));
+        };
+
+        Header header {{magic[0], magic[1], magic[2], magic[3]}, version, sources.size(), 0, 0};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::string       names;
+        std::vector<char> bytes;
+        for (Source& source : sources)
+        {
+            std::ifstream input(source.path, std::ios::binary);
+            if (!input)
+            {
+                error = "can not read " + source.path.string();
+                return false;
+            }
+            bytes.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+            pad(data_alignment);
+            source.entry.path_hash   = hash_asset_path(source.name);
+            source.entry.offset      = static_cast<uint64_t>(file.tellp());
+            source.entry.size        = bytes.size();
+            source.entry.name_offset = static_cast<uint32_t>(names.size());
+            source.entry.name_size   = static_cast<uint32_t>(source.name.size());
+            names += source.name;
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+
+        std::stable_sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.entry.path_hash < b.entry.path_hash; });
+        pad(data_alignment);
+        header.index_offset = static_cast<uint64_t>(file.tellp());
+        for (const Source& source : sources)
+            file.write(reinterpret_cast<const char*>(&source.entry), sizeof(Entry));
+        header.names_offset = static_cast<uint64_t>(file.tellp());
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!file)
+        {
+            error = "can not write " + output.string();
+            return false;
+        }
+        return true;
+    }
+} // namespace core
@@ -0,0 +1,76 @@
+#pragma once
+#include "asset/mapped_file.h"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace core
+{
+    // Hash of an asset path as the archive index stores it: FNV-1a 64 over the path relative to the asset
+    // root, with '/' separators.
+    constexpr uint64_t hash_asset_path(std::string_view path)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (char c : path)
+        {
+            hash ^= static_cast<uint8_t>(c == '\\' ? '/' : c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    // Packed, read-only set of asset files in one memory mapped file.
+    //
+    // Layout: Header, file data (each file aligned to data_alignment), the index as entry_count Entry
+    // records sorted by path hash, then the path strings the entries point at. A lookup is a binary search
+    // on the hash plus a string compare to rule out collisions, and file contents are spans into the
+    // mapping, so reading an asset neither opens a file nor copies it.
+    class AssetArchive
+    {
+    public:
+        struct Header
+        {
+            char     magic[4];
+            uint32_t version;
+            uint64_t entry_count;
+            uint64_t index_offset;
+            uint64_t names_offset;
+        };
+
+        struct Entry
+        {
+            uint64_t path_hash;
+            uint64_t offset; // From the start of the archive
+            uint64_t size;
+            uint32_t name_offset; // From names_offset
+            uint32_t name_size;
+        };
+
+        static constexpr char     magic[4]       = {'C', 'P', 'A', 'K'};
+        static constexpr uint32_t version        = 1;
+        static constexpr uint64_t data_alignment = 16;
+
+        bool open(const std::filesystem::path& path);
+
+        [[nodiscard]] bool is_open() const noexcept { return file_.is_open(); }
+
+        // nullptr if path is not in the archive.
+        [[nodiscard]] const Entry* find(std::string_view path) const;
+
+        [[nodiscard]] std::span<const std::byte> get_data(const Entry& entry) const;
+        [[nodiscard]] std::string_view           get_path(const Entry& entry) const;
+        [[nodiscard]] std::span<const Entry>     get_entries() const noexcept { return entries_; }
+
+        void prefetch(const Entry& entry) const { file_.prefetch(entry.offset, entry.size); }
+
+        // Packs every regular file under root into an archive at output. Returns false and sets error on failure.
+        static bool build(const std::filesystem::path& root, const std::filesystem::path& output, std::string& error);
+
+    private:
+        MappedFile             file_;
+        std::span<const Entry> entries_;
+        std::string_view       names_;
+    };
+} // namespace core
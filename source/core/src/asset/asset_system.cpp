@@ -0,0 +1,113 @@
+#include "asset_system.h"
+#include "cmd_line/parser.hpp"
+#include "event/asset_event.h"
+#include "jobs/job_system.h"
+#include "logger.h"
+#include <chrono>
+
+namespace core
+{
+    AssetSystem::AssetSystem()
+    {
+        const auto& parser = Parser::instance();
+        root_              = parser.getOptionValue("asset-dir", "data");
+
+        const std::filesystem::path archive = parser.getOptionValue("asset-archive", "data.pak");
+        if (archive_.open(archive))
+            APPLOG_INFO("Asset archive {} mounted, {} files", archive.string(), archive_.get_entries().size());
+        else if (std::filesystem::exists(archive))
+            APPLOG_ERROR("Asset archive {} is not valid, reading loose files from {}", archive.string(), root_.string());
+        else
+            APPLOG_INFO("No asset archive {}, reading loose files from {}", archive.string(), root_.string());
+
+        connect<FrameBegin, AssetSystem, &AssetSystem::frame_begin>(*this);
+    }
+
+    AssetSystem::~AssetSystem()
+    {
+        disconnect(*this);
+        // Jobs reference this object, none may outlive it.
+        for (auto& job : jobs_)
+            job.wait();
+    }
+
+    AssetSystem::RequestId AssetSystem::request(std::string_view path)
+    {
+        const RequestId id = next_request_++;
+        jobs_.push_back(get_subsystem<JobSystem>().submit(
+            [this, id, path = std::string(path)]()
+            {
+                std::span<const std::byte> data;
+                const bool                 found = find(path, data, true);
+
+                std::lock_guard lock(completed_mutex_);
+                completed_.push_back({id, path, data, found});
+            }));
+        return id;
+    }
+
+    std::span<const std::byte> AssetSystem::read(std::string_view path)
+    {
+        std::span<const std::byte> data;
+        find(path, data, false);
+        return data;
+    }
+
+    bool AssetSystem::exists(std::string_view path) const
+    {
+        return archive_.find(path) != nullptr || std::filesystem::is_regular_file(root_ / std::filesystem::path(path));
+    }
+
+    bool AssetSystem::find(std::string_view path, std::span<const std::byte>& data, bool prefetch)
+    {
+        if (const AssetArchive::Entry* entry = archive_.find(path))
+        {
+            if (prefetch)
+                archive_.prefetch(*entry);
+            data = archive_.get_data(*entry);
+            return true;
+        }
+
+        const std::string key(path);
+        {
+            std::lock_guard lock(loose_mutex_);
+            if (auto it = loose_.find(key); it != loose_.end())
+            {
+                data = it->second->get_data();
+                if (prefetch)
+                    it->second->prefetch(0, data.size());
+                return true;
+            }
+        }
+
+        // Mapped outside the lock; if another thread mapped the same file meanwhile, its mapping wins.
+        auto file = std::make_unique<MappedFile>();
+        if (!file->open(root_ / std::filesystem::path(path)))
+            return false;
+        if (prefetch)
+            file->prefetch(0, file->get_data().size());
+
+        std::lock_guard lock(loose_mutex_);
+        auto it = loose_.try_emplace(key, std::move(file)).first;
+        data    = it->second->get_data();
+        return true;
+    }
+
+    void AssetSystem::frame_begin(const FrameBegin&)
+    {
+        std::vector<Completion> completed;
+        {
+            std::lock_guard lock(completed_mutex_);
+            completed.swap(completed_);
+        }
+        std::erase_if(jobs_, [](const std::future<void>& job) { return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
+        auto& events = get_subsystem<EventManager>();
+        for (const Completion& completion : completed)
+        {
+            if (!completion.found)
+                APPLOG_WARNING("Asset {} not found", completion.path);
+            events.trigger<AssetLoaded>(AssetLoaded {completion.request, completion.path, completion.data, completion.found});
+        }
+    }
+} // namespace core
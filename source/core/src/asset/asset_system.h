@@ -0,0 +1,70 @@
+#pragma once
+#include "asset/asset_archive.h"
+#include "asset/mapped_file.h"
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace core
+{
+    // Read-only access to assets by path relative to the asset root, e.g. "fonts/default.ttf".
+    //
+    // Assets come from the packed archive (--asset-archive, default data.pak, built by the asset_packer
+    // tool) when it has them, else from loose files under --asset-dir (default data). Both are memory
+    // mapped: the archive once at startup, a loose file on its first use. Data is handed out as spans
+    // into the mappings, valid as long as the AssetSystem, so nothing is copied.
+    //
+    // request() does the lookup and reads the pages in on a JobSystem worker, then AssetLoaded is
+    // triggered on the main thread at the next FrameBegin.
+    class AssetSystem : public EventSubscriber
+    {
+    public:
+        using RequestId = uint64_t;
+
+        AssetSystem();
+        ~AssetSystem();
+
+        RequestId request(std::string_view path);
+
+        // Synchronous lookup; the data is mapped but may still fault on first touch. Empty when not found.
+        std::span<const std::byte> read(std::string_view path);
+        bool                       exists(std::string_view path) const;
+
+        [[nodiscard]] bool   has_archive() const noexcept { return archive_.is_open(); }
+        [[nodiscard]] size_t get_pending_count() const noexcept { return jobs_.size(); }
+
+        void frame_begin(const FrameBegin& event);
+
+    private:
+        struct Completion
+        {
+            RequestId                  request;
+            std::string                path;
+            std::span<const std::byte> data;
+            bool                       found;
+        };
+
+        // Safe to call from any thread.
+        bool find(std::string_view path, std::span<const std::byte>& data, bool prefetch);
+
+        AssetArchive          archive_;
+        std::filesystem::path root_;
+        RequestId             next_request_ = 1;
+
+        std::mutex                                                   loose_mutex_;
+        std::unordered_map<std::string, std::unique_ptr<MappedFile>> loose_;
+
+        std::mutex                     completed_mutex_;
+        std::vector<Completion>        completed_;
+        std::vector<std::future<void>> jobs_;
+    };
+} // namespace core
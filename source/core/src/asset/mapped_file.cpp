@@ -0,0 +1,130 @@
+#include "mapped_file.h"
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace core
+{
+    MappedFile::~MappedFile() { close(); }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)), open_(std::exchange(other.open_, false))
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            open_ = std::exchange(other.open_, false);
+        }
+        return *this;
+    }
+
+    bool MappedFile::open(const std::filesystem::path& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            return false;
+        }
+        if (size.QuadPart > 0)
+        {
+            // The view keeps the file referenced, both handles can go right away.
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+            {
+                data_ = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+            if (!data_)
+            {
+                CloseHandle(file);
+                return false;
+            }
+        }
+        CloseHandle(file);
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+            return false;
+
+        struct stat status;
+        if (fstat(file, &status) != 0)
+        {
+            ::close(file);
+            return false;
+        }
+        if (status.st_size > 0)
+        {
+            // The mapping keeps the file referenced, the descriptor can go right away.
+            void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (data == MAP_FAILED)
+            {
+                ::close(file);
+                return false;
+            }
+            data_ = static_cast<const std::byte*>(data);
+        }
+        ::close(file);
+        size_ = static_cast<size_t>(status.st_size);
+#endif
+        open_ = true;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (data_)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(data_);
+#else
+            munmap(const_cast<std::byte*>(data_), size_);
+#endif
+        }
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+    void MappedFile::prefetch(size_t offset, size_t size) const
+    {
+        if (offset >= size_ || size == 0)
+            return;
+        size = std::min(size, size_ - offset);
+
+        constexpr size_t page_size = 4096;
+#ifndef _WIN32
+        // madvise wants a page aligned start.
+        const size_t aligned = offset & ~(page_size - 1);
+        madvise(const_cast<std::byte*>(data_) + aligned, size + (offset - aligned), MADV_WILLNEED);
+#endif
+        // Reading one byte per page faults the range in; the volatile sink keeps the reads from being optimized out.
+        volatile std::byte sink {};
+        for (size_t i = offset; i < offset + size; i += page_size)
+            sink = data_[i];
+        sink = data_[offset + size - 1];
+        (void)sink;
+    }
+} // namespace core
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace core
+{
+    // Read-only memory mapping of a whole file. Pages are read in by the OS on first touch, so mapping
+    // costs one open() and no copy; prefetch() pays the faults up front, e.g. on a worker thread.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // False if the file can not be opened or mapped; empty files map to an empty span.
+        bool open(const std::filesystem::path& path);
+        void close();
+
+        [[nodiscard]] bool                       is_open() const noexcept { return open_; }
+        [[nodiscard]] std::span<const std::byte> get_data() const noexcept { return {data_, size_}; }
+
+        // Asks the OS to read the range ahead and touches every page of it, so later reads do not fault.
+        void prefetch(size_t offset, size_t size) const;
+
+    private:
+        const std::byte* data_ = nullptr;
+        size_t           size_ = 0;
+        bool             open_ = false;
+    };
+} // namespace core
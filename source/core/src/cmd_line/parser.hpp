@@ -1,6 +1,8 @@
 #pragma once
 #include <cassert>
+#include <charconv>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -18,6 +20,9 @@ namespace core
             return instance;
         }
 
+        // The application's options live in instance(); standalone parsers are for tools and benchmarks.
+        Parser(int argc, char* argv[]) { parse(argc, argv); }
+
         bool hasOption(const std::string& option) const { return options.find(option) != options.end(); }
 
         std::string getOptionValue(const std::string& option, const std::string& defaultValue = "") const
@@ -30,6 +35,26 @@ namespace core
             return defaultValue;
         }
 
+        // The option's value as a T, defaultValue when the option is not given and nullopt when its value
+        // is not a T in full (or out of T's range), so the caller can report it and fall back.
+        template<typename T>
+        std::optional<T> getOptionNumber(const std::string& option, T defaultValue) const
+        {
+            auto it = options.find(option);
+            if (it == options.end())
+            {
+                return defaultValue;
+            }
+            const std::string& text  = it->second;
+            T                  value = {};
+            const auto [end, error]  = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc() || end != text.data() + text.size())
+            {
+                return std::nullopt;
+            }
+            return value;
+        }
+
         std::string getRequiredOptionValue(const std::string& option) const
         {
             auto it = options.find(option);
@@ -51,8 +76,6 @@ namespace core
         }
 
     private:
-        Parser(int argc, char* argv[]) { parse(argc, argv); }
-
         Parser(const Parser&)            = delete;
         Parser& operator=(const Parser&) = delete;
 
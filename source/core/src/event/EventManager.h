@@ -1,7 +1,8 @@
 ﻿#pragma once
+#include "memory/memory_tracker.h"
 #include <algorithm>
-#include <functional>
 #include <memory>
+#include <string_view>
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
@@ -13,45 +14,89 @@ namespace core
     public:
         using HandlerId = size_t;
 
+        // A plain function pointer rather than a std::function: connecting never allocates a closure and
+        // dispatch is one indirect call.
         struct Subscriber
         {
-            void*                            owner;
-            std::function<void(const void*)> func;
+            void*    owner;
+            void     (*invoke)(void* owner, const void* event);
+            uint16_t memory_tag = MemoryTracker::tag_untagged;
         };
 
-        std::unordered_map<std::type_index, std::vector<Subscriber>> subscribers_;
+        // How often an event type was triggered, for diagnostics (see Watchdog).
+        struct TriggerCount
+        {
+            std::string_view name; // Implementation defined type name
+            uint64_t         total = 0;
+            uint32_t         frame = 0; // Since the last reset_frame_counts()
+        };
 
-        template<typename Event, typename Class>
-        void connect(Class& instance, void (Class::*method)(const Event&))
+        template<typename Event, auto Method, typename Class>
+        void connect(Class& instance)
         {
-            auto& subs = subscribers_[std::type_index(typeid(Event))];
+            auto& subs = channels_[std::type_index(typeid(Event))].subscribers;
 
-            subs.push_back(Subscriber {&instance, [&instance, method](const void* e) { (instance.*method)(*static_cast<const Event*>(e)); }});
+            subs.push_back(Subscriber {
+                &instance,
+                [](void* owner, const void* e) { (static_cast<Class*>(owner)->*Method)(*static_cast<const Event*>(e)); },
+                memory_tag<Class>()});
         }
 
         template<typename Event, typename... Args>
         void trigger(const Args&... args)
         {
-            Event e {args...};
-            auto  it = subscribers_.find(std::type_index(typeid(Event)));
-            if (it == subscribers_.end())
-                return;
+            Event    e {args...};
+            Channel& channel = channels_[std::type_index(typeid(Event))];
+            ++channel.total;
+            ++channel.frame;
+            ++triggered_;
 
-            for (auto& sub : it->second)
+            for (auto& sub : channel.subscribers)
             {
-                sub.func(&e);
+                MemoryScope scope(sub.memory_tag);
+                sub.invoke(sub.owner, &e);
             }
         }
 
         template<typename Class>
         void disconnect(Class& instance)
         {
-            for (auto& [type, subs] : subscribers_)
+            for (auto& [type, channel] : channels_)
             {
+                auto& subs = channel.subscribers;
                 subs.erase(std::remove_if(subs.begin(), subs.end(), [&](const Subscriber& s) { return s.owner == &instance; }), subs.end());
             }
         }
 
-        void clear() { subscribers_.clear(); }
+        void clear() { channels_.clear(); }
+
+        void reset_frame_counts()
+        {
+            for (auto& [type, channel] : channels_)
+                channel.frame = 0;
+        }
+
+        // Events of every type triggered since startup.
+        [[nodiscard]] uint64_t get_trigger_total() const noexcept { return triggered_; }
+
+        [[nodiscard]] std::vector<TriggerCount> get_trigger_counts() const
+        {
+            std::vector<TriggerCount> counts;
+            counts.reserve(channels_.size());
+            for (const auto& [type, channel] : channels_)
+                counts.push_back({type.name(), channel.total, channel.frame});
+            return counts;
+        }
+
+    private:
+        struct Channel
+        {
+            std::vector<Subscriber> subscribers;
+            uint64_t                total = 0;
+            uint32_t                frame = 0;
+        };
+
+        std::unordered_map<std::type_index, Channel> channels_;
+        uint64_t                                     triggered_ = 0;
     };
 } // namespace core
@@ -10,7 +10,7 @@ namespace core
         template<typename Event, typename Class, void (Class::*Method)(const Event&)>
         void connect(Class& instance)
         {
-            get_subsystem<EventManager>().connect<Event>(instance, Method);
+            get_subsystem<EventManager>().connect<Event, Method>(instance);
         }
 
         template<typename Class>
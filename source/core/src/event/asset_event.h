@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace core
+{
+    // Triggered on the main thread, at FrameBegin, for every finished AssetSystem::request().
+    struct AssetLoaded
+    {
+        uint64_t                   request;
+        std::string_view           path; // Valid for the duration of the event
+        std::span<const std::byte> data; // Mapped, resident and valid while the AssetSystem exists
+        bool                       found;
+    };
+} // namespace core
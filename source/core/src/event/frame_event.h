@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 namespace core
 {
@@ -7,19 +8,32 @@ namespace core
         float delta_time;
     };
 
+    // Triggered zero or more times per frame, between FrameBegin and FrameUpdate, once per simulation step.
+    // delta_time is the fixed step (--fixed-update-rate, 0 steps once per frame with the frame's delta time).
+    struct FrameFixedUpdate
+    {
+        float    delta_time;
+        uint64_t step = 0; // Index of this step since startup
+    };
+
     struct FrameUpdate
     {
         float delta_time;
     };
 
+    // alpha is how far the frame lies between the last and the next fixed step, for interpolating simulated state.
     struct FrameRender
     {
         float delta_time;
+        float alpha = 1.0f;
     };
 
+    // Triggered once per renderable window, with that window's ImGui context current.
     struct FrameUiRender
     {
-        float delta_time;
+        float    delta_time;
+        uint32_t window_id = 0;
+        float    alpha     = 1.0f;
     };
 
     struct FrameEnd
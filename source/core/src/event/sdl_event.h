@@ -4,8 +4,11 @@
 
 namespace core
 {
+    class Window;
+
     struct SDLEvent
     {
         SDL_Event* event;
+        Window*    window = nullptr; // Target window of the event, nullptr for events not bound to a managed window
     };
 } // namespace core
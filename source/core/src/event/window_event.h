@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+namespace core
+{
+    class Window;
+
+    struct WindowCreated
+    {
+        Window* window;
+    };
+
+    struct WindowDestroyed
+    {
+        uint32_t window_id;
+    };
+} // namespace core
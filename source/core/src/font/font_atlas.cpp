@@ -0,0 +1,110 @@
+#include "font_atlas.h"
+#include <algorithm>
+#include <cstring>
+
+namespace core
+{
+    static constexpr int glyph_padding = 1;
+
+    FontAtlas::FontAtlas(int width, int height, int max_height) : width_(width), height_(height), max_height_(std::max(height, max_height))
+    {
+        clear();
+    }
+
+    bool FontAtlas::allocate(int w, int h, Rect& out)
+    {
+        const int padded_w = w + glyph_padding;
+        const int padded_h = h + glyph_padding;
+        if (padded_w > width_)
+        {
+            return false;
+        }
+
+        // Best fit: the lowest existing shelf that is tall enough without wasting more than a third of it.
+        Shelf* best = nullptr;
+        for (auto& shelf : shelves_)
+        {
+            if (shelf.height >= padded_h && shelf.height * 2 <= padded_h * 3 && shelf.cursor_x + padded_w <= width_)
+            {
+                if (!best || shelf.height < best->height)
+                {
+                    best = &shelf;
+                }
+            }
+        }
+
+        if (!best)
+        {
+            if (next_shelf_y_ + padded_h > height_)
+            {
+                return false;
+            }
+            shelves_.push_back(Shelf {next_shelf_y_, padded_h, 0});
+            next_shelf_y_ += padded_h;
+            best = &shelves_.back();
+        }
+
+        out = Rect {best->cursor_x, best->y, w, h};
+        best->cursor_x += padded_w;
+        return true;
+    }
+
+    void FontAtlas::write_alpha(const Rect& rect, const uint8_t* alpha, int pitch)
+    {
+        for (int row = 0; row < rect.h; ++row)
+        {
+            const uint8_t* src = alpha + row * pitch;
+            uint8_t*       dst = &pixels_[(static_cast<size_t>(rect.y + row) * width_ + rect.x) * 4];
+            for (int col = 0; col < rect.w; ++col)
+            {
+                dst[col * 4 + 0] = 255;
+                dst[col * 4 + 1] = 255;
+                dst[col * 4 + 2] = 255;
+                dst[col * 4 + 3] = src[col];
+            }
+        }
+        extend_dirty(rect);
+    }
+
+    bool FontAtlas::grow()
+    {
+        if (height_ >= max_height_)
+        {
+            return false;
+        }
+
+        // Rows are appended at the bottom, so existing glyphs keep their pixel position; only V coordinates change.
+        height_ = std::min(height_ * 2, max_height_);
+        pixels_.resize(static_cast<size_t>(width_) * height_ * 4, 0);
+        mark_all_dirty();
+        return true;
+    }
+
+    void FontAtlas::clear()
+    {
+        shelves_.clear();
+        next_shelf_y_ = 0;
+        pixels_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+
+        // A small opaque block for ImGui's solid fills (TexUvWhitePixel).
+        const uint8_t white[4] = {255, 255, 255, 255};
+        allocate(2, 2, white_);
+        write_alpha(white_, white, 2);
+        mark_all_dirty();
+    }
+
+    void FontAtlas::extend_dirty(const Rect& rect)
+    {
+        if (!has_dirty())
+        {
+            dirty_ = rect;
+            return;
+        }
+
+        const int x0 = std::min(dirty_.x, rect.x);
+        const int y0 = std::min(dirty_.y, rect.y);
+        const int x1 = std::max(dirty_.x + dirty_.w, rect.x + rect.w);
+        const int y1 = std::max(dirty_.y + dirty_.h, rect.y + rect.h);
+        dirty_       = Rect {x0, y0, x1 - x0, y1 - y0};
+    }
+} // namespace core
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace core
+{
+    // CPU side of the dynamic glyph atlas. Glyphs are packed incrementally into shelves of
+    // RGBA8 pixels and the region written since the last upload is tracked, so only that part
+    // has to be copied to the GPU. The atlas grows in height without moving existing glyphs.
+    class FontAtlas
+    {
+    public:
+        struct Rect
+        {
+            int x = 0;
+            int y = 0;
+            int w = 0;
+            int h = 0;
+        };
+
+        FontAtlas(int width, int height, int max_height);
+
+        // Reserves a w*h region; false when the atlas has to grow (or be cleared) first.
+        bool allocate(int w, int h, Rect& out);
+        void write_alpha(const Rect& rect, const uint8_t* alpha, int pitch);
+        bool grow();
+        void clear();
+
+        [[nodiscard]] bool           has_dirty() const noexcept { return dirty_.w > 0 && dirty_.h > 0; }
+        [[nodiscard]] const Rect&    get_dirty() const noexcept { return dirty_; }
+        void                         clear_dirty() noexcept { dirty_ = {}; }
+        void                         mark_all_dirty() noexcept { dirty_ = {0, 0, width_, height_}; }
+        [[nodiscard]] const uint8_t* get_pixels() const noexcept { return pixels_.data(); }
+        [[nodiscard]] int            get_width() const noexcept { return width_; }
+        [[nodiscard]] int            get_height() const noexcept { return height_; }
+        [[nodiscard]] const Rect&    get_white_rect() const noexcept { return white_; }
+
+    private:
+        struct Shelf
+        {
+            int y;
+            int height;
+            int cursor_x;
+        };
+
+        void extend_dirty(const Rect& rect);
+
+        int                  width_;
+        int                  height_;
+        int                  max_height_;
+        int                  next_shelf_y_ = 0;
+        Rect                 white_;
+        Rect                 dirty_;
+        std::vector<Shelf>   shelves_;
+        std::vector<uint8_t> pixels_;
+    };
+} // namespace core
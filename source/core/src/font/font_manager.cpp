@@ -0,0 +1,346 @@
+#include "font_manager.h"
+#include "cmd_line/parser.hpp"
+#include "imgui_internal.h"
+#include "logger.h"
+#include <cmath>
+#include <fstream>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <renderer/vulkan/vulkan_renderer.h>
+#include <window/window.h>
+
+namespace core
+{
+    static constexpr int      atlas_width        = 1024;
+    static constexpr int      atlas_height       = 512;
+    static constexpr int      atlas_max_height   = 4096;
+    static constexpr uint32_t fallback_codepoint = 0xFFFD;
+
+    FontManager::FontManager() : atlas_(atlas_width, atlas_height, atlas_max_height)
+    {
+        const auto& parser = Parser::instance();
+        const auto  path   = parser.getOptionValue("font", "data/fonts/default.ttf");
+        base_size_         = std::stof(parser.getOptionValue("font-size", "16"));
+        glyphs_per_frame_  = std::stoi(parser.getOptionValue("font-glyphs-per-frame", "64"));
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            APPLOG_WARNING("Font {} not found, using the built-in ImGui font", path);
+            return;
+        }
+        font_data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        if (FT_Init_FreeType(&library_) != 0)
+        {
+            APPLOG_ERROR("FT_Init_FreeType failed");
+            return;
+        }
+        if (FT_New_Memory_Face(library_, font_data_.data(), static_cast<FT_Long>(font_data_.size()), 0, &face_) != 0)
+        {
+            APPLOG_ERROR("Failed to load font face {}", path);
+            face_ = nullptr;
+            return;
+        }
+
+        // ASCII is always needed; everything else is rasterized when first requested.
+        for (uint32_t c = 0x20; c < 0x7F; ++c)
+        {
+            if (known_.insert(c).second)
+                requested_.push_back(c);
+        }
+        known_.insert(fallback_codepoint);
+        requested_.push_back(fallback_codepoint);
+
+        texture_              = get_subsystem<VulkanRenderer>().create_texture(atlas_.get_width(), atlas_.get_height());
+        container_.TexID      = texture_;
+        container_.TexWidth   = atlas_.get_width();
+        container_.TexHeight  = atlas_.get_height();
+        container_.TexUvScale = ImVec2(1.0f / atlas_.get_width(), 1.0f / atlas_.get_height());
+        container_.Flags |= ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoMouseCursors;
+        const auto& white          = atlas_.get_white_rect();
+        container_.TexUvWhitePixel = ImVec2((white.x + 0.5f) * container_.TexUvScale.x, (white.y + 0.5f) * container_.TexUvScale.y);
+        container_.TexReady        = true;
+
+        APPLOG_INFO("Font {} loaded ({} glyphs, {}px)", path, face_->num_glyphs, base_size_);
+        connect<FrameBegin, FontManager, &FontManager::frame_begin>(*this);
+        connect<SDLEvent, FontManager, &FontManager::sdl_event>(*this);
+    }
+
+    FontManager::~FontManager()
+    {
+        disconnect(*this);
+        if (texture_ && has_subsystem<VulkanRenderer>())
+            get_subsystem<VulkanRenderer>().destroy_texture(texture_);
+        if (face_)
+            FT_Done_Face(face_);
+        if (library_)
+            FT_Done_FreeType(library_);
+    }
+
+    void FontManager::request_glyphs(std::string_view text)
+    {
+        if (!face_)
+            return;
+
+        const char* it  = text.data();
+        const char* end = text.data() + text.size();
+        while (it < end)
+        {
+            // ASCII is always in the atlas.
+            if (static_cast<uint8_t>(*it) < 0x80)
+            {
+                ++it;
+                continue;
+            }
+            unsigned int c = 0;
+            it += ImTextCharFromUtf8(&c, it, end);
+            // ImWchar is 16-bit unless IMGUI_USE_WCHAR32 is defined.
+            if (c == 0 || c > IM_UNICODE_CODEPOINT_MAX)
+                continue;
+            if (known_.insert(c).second)
+                requested_.push_back(c);
+        }
+    }
+
+    void FontManager::apply(const Window* window)
+    {
+        if (ImFont* font = get_font(window))
+        {
+            ImGuiIO& io    = ImGui::GetIO();
+            io.FontDefault = font;
+            // Lines are anti-aliased with geometry, our atlas doesn't bake them.
+            io.Fonts->Flags |= ImFontAtlasFlags_NoBakedLines;
+        }
+    }
+
+    ImFont* FontManager::get_font(const Window* window)
+    {
+        if (!face_ || !window)
+            return nullptr;
+
+        SDL_Window* sdl_window    = window->get_sdl_window_ptr();
+        const float display_scale = SDL_GetWindowDisplayScale(sdl_window);
+        const float pixel_density = SDL_GetWindowPixelDensity(sdl_window);
+        const int   pixel_size    = static_cast<int>(std::lround(base_size_ * (display_scale > 0.0f ? display_scale : 1.0f)));
+        const int   density_key   = static_cast<int>(std::lround((pixel_density > 0.0f ? pixel_density : 1.0f) * 100.0f));
+
+        auto it = fonts_.find({pixel_size, density_key});
+        if (it != fonts_.end())
+            return it->second->font;
+        return create_font(pixel_size, density_key / 100.0f).font;
+    }
+
+    FontManager::SizedFont& FontManager::create_font(int pixel_size, float pixel_density)
+    {
+        auto sized                = std::make_unique<SizedFont>();
+        sized->pixel_size         = pixel_size;
+        sized->config             = std::make_unique<ImFontConfig>();
+        sized->config->SizePixels = static_cast<float>(pixel_size);
+        ImFormatString(sized->config->Name, IM_ARRAYSIZE(sized->config->Name), "FontManager %dpx", pixel_size);
+
+        FT_Set_Pixel_Sizes(face_, 0, pixel_size);
+
+        ImFont* font          = IM_NEW(ImFont)();
+        font->FontSize        = static_cast<float>(pixel_size);
+        font->Scale           = 1.0f / pixel_density; // Glyphs are rasterized in framebuffer pixels, laid out in window units
+        font->ContainerAtlas  = &container_;
+        font->ConfigData      = sized->config.get();
+        font->ConfigDataCount = 1;
+        font->FallbackChar    = static_cast<ImWchar>(fallback_codepoint);
+        font->Ascent          = std::ceil(face_->size->metrics.ascender / 64.0f);
+        font->Descent         = std::floor(face_->size->metrics.descender / 64.0f);
+        sized->config->DstFont = font;
+        sized->font            = font;
+        container_.Fonts.push_back(font);
+
+        auto& result = *sized;
+        fonts_.emplace(std::make_pair(pixel_size, static_cast<int>(std::lround(pixel_density * 100.0f))), std::move(sized));
+        rasterize_ascii(result);
+        upload();
+        return result;
+    }
+
+    bool FontManager::rasterize_ascii(SizedFont& sized)
+    {
+        // The printable ASCII block leads requested_ and is needed right away for layout, the rest follows lazily.
+        bool fits = true;
+        FT_Set_Pixel_Sizes(face_, 0, sized.pixel_size);
+        while (sized.rasterized < requested_.size() && requested_[sized.rasterized] < 0x7F)
+        {
+            if (!rasterize(sized, requested_[sized.rasterized]))
+            {
+                if (!grow_or_reset())
+                {
+                    fits = false;
+                    break;
+                }
+                FT_Set_Pixel_Sizes(face_, 0, sized.pixel_size);
+                continue;
+            }
+            ++sized.rasterized;
+        }
+        if (!sized.font->Glyphs.empty())
+            sized.font->BuildLookupTable();
+        return fits;
+    }
+
+    bool FontManager::rasterize(SizedFont& sized, uint32_t codepoint)
+    {
+        const FT_UInt glyph_index = FT_Get_Char_Index(face_, codepoint);
+        if (glyph_index == 0)
+            return true; // Not in the font, drawn with the fallback glyph
+
+        if (FT_Load_Glyph(face_, glyph_index, FT_LOAD_DEFAULT) != 0 || FT_Render_Glyph(face_->glyph, FT_RENDER_MODE_NORMAL) != 0)
+            return true;
+
+        const FT_GlyphSlot slot    = face_->glyph;
+        const FT_Bitmap&   bitmap  = slot->bitmap;
+        const float        x0      = static_cast<float>(slot->bitmap_left);
+        const float        y0      = sized.font->Ascent - static_cast<float>(slot->bitmap_top);
+        const float        advance = slot->advance.x / 64.0f;
+
+        FontAtlas::Rect rect;
+        if (static_cast<int>(bitmap.width) >= atlas_width || static_cast<int>(bitmap.rows) >= atlas_max_height)
+        {
+            APPLOG_WARNING("Glyph U+{:04X} is too large for the font atlas", codepoint);
+            return true;
+        }
+        if (bitmap.width > 0 && bitmap.rows > 0)
+        {
+            if (!atlas_.allocate(static_cast<int>(bitmap.width), static_cast<int>(bitmap.rows), rect))
+                return false;
+            atlas_.write_alpha(rect, bitmap.buffer, bitmap.pitch);
+        }
+
+        const ImVec2 uv_scale = container_.TexUvScale;
+        sized.font->AddGlyph(sized.config.get(),
+                             static_cast<ImWchar>(codepoint),
+                             x0,
+                             y0,
+                             x0 + rect.w,
+                             y0 + rect.h,
+                             rect.x * uv_scale.x,
+                             rect.y * uv_scale.y,
+                             (rect.x + rect.w) * uv_scale.x,
+                             (rect.y + rect.h) * uv_scale.y,
+                             advance);
+        return true;
+    }
+
+    bool FontManager::grow_or_reset()
+    {
+        auto&     renderer   = get_subsystem<VulkanRenderer>();
+        const int old_height = atlas_.get_height();
+
+        const bool cleared = !atlas_.grow();
+        // Full again while the cleared atlas is refilled: clearing once more would only repeat this.
+        if (cleared && resetting_)
+            return false;
+        if (!cleared)
+        {
+            // Pixels stay where they are, only the V coordinates shrink with the taller texture.
+            const float v_scale = static_cast<float>(old_height) / atlas_.get_height();
+            for (ImFont* font : container_.Fonts)
+            {
+                for (ImFontGlyph& glyph : font->Glyphs)
+                {
+                    glyph.V0 *= v_scale;
+                    glyph.V1 *= v_scale;
+                }
+            }
+            APPLOG_INFO("Font atlas grown to {}x{}", atlas_.get_width(), atlas_.get_height());
+        }
+        else
+        {
+            // Full: start over, every size re-rasterizes what is requested again over the next frames.
+            APPLOG_WARNING("Font atlas full at {}x{}, clearing it", atlas_.get_width(), atlas_.get_height());
+            atlas_.clear();
+            for (auto& [key, sized] : fonts_)
+            {
+                sized->font->Glyphs.clear();
+                sized->rasterized = 0;
+            }
+        }
+
+        // Frames in flight keep drawing with the old texture; it is freed once they retired, without a wait.
+        renderer.destroy_texture(texture_);
+        texture_                   = renderer.create_texture(atlas_.get_width(), atlas_.get_height());
+        container_.TexID           = texture_;
+        container_.TexHeight       = atlas_.get_height();
+        container_.TexUvScale      = ImVec2(1.0f / atlas_.get_width(), 1.0f / atlas_.get_height());
+        const auto& white          = atlas_.get_white_rect();
+        container_.TexUvWhitePixel = ImVec2((white.x + 0.5f) * container_.TexUvScale.x, (white.y + 0.5f) * container_.TexUvScale.y);
+        atlas_.mark_all_dirty();
+
+        if (cleared)
+        {
+            // Fonts must never be left without glyphs, their lookup tables would point into nothing.
+            bool fits  = true;
+            resetting_ = true;
+            for (auto& [key, sized] : fonts_)
+                fits = fits && rasterize_ascii(*sized);
+            resetting_ = false;
+            if (!fits)
+            {
+                APPLOG_ERROR("Font atlas of {}x{} can not hold ASCII at {} font sizes, missing glyphs are drawn as the fallback",
+                             atlas_.get_width(),
+                             atlas_.get_height(),
+                             fonts_.size());
+                // Nothing more is tried, or every frame would clear the atlas again.
+                for (auto& [key, sized] : fonts_)
+                    sized->rasterized = requested_.size();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void FontManager::upload()
+    {
+        if (!atlas_.has_dirty())
+            return;
+
+        const auto& dirty = atlas_.get_dirty();
+        get_subsystem<VulkanRenderer>().update_texture(texture_, dirty.x, dirty.y, dirty.w, dirty.h, atlas_.get_pixels(), atlas_.get_width());
+        atlas_.clear_dirty();
+    }
+
+    void FontManager::sdl_event(const SDLEvent& event)
+    {
+        if (event.event->type == SDL_EVENT_TEXT_INPUT && event.event->text.text)
+            request_glyphs(event.event->text.text);
+        else if (event.event->type == SDL_EVENT_TEXT_EDITING && event.event->edit.text)
+            request_glyphs(event.event->edit.text);
+    }
+
+    void FontManager::frame_begin(const FrameBegin& event)
+    {
+        int budget = glyphs_per_frame_;
+        for (auto& [key, sized] : fonts_)
+        {
+            if (sized->rasterized == requested_.size())
+                continue;
+
+            ImFont* font = sized->font;
+            // BuildLookupTable() appends a TAB glyph, drop it so it is not duplicated on every rebuild.
+            if (!font->Glyphs.empty() && font->Glyphs.back().Codepoint == '\t')
+                font->Glyphs.pop_back();
+
+            FT_Set_Pixel_Sizes(face_, 0, sized->pixel_size);
+            while (budget > 0 && sized->rasterized < requested_.size())
+            {
+                if (!rasterize(*sized, requested_[sized->rasterized]))
+                {
+                    grow_or_reset();
+                    break;
+                }
+                ++sized->rasterized;
+                --budget;
+            }
+            if (!font->Glyphs.empty())
+                font->BuildLookupTable();
+        }
+        upload();
+    }
+} // namespace core
@@ -0,0 +1,76 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include "event/sdl_event.h"
+#include "font_atlas.h"
+#include "imgui.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_*    FT_Face;
+
+namespace core
+{
+    class Window;
+
+    // Lazily rasterized FreeType fonts backed by one dynamic GPU atlas.
+    // Codepoints are rasterized the frame after they are requested, a few per frame, and only the
+    // touched part of the atlas is uploaded. Typed and IME text is requested from the SDL text events;
+    // code drawing other text that may leave ASCII (log records, file names) requests it itself. Each display scale gets its own ImFont in the same
+    // atlas, so moving to a high-DPI monitor only rasterizes what is missing at the new size.
+    class FontManager : public EventSubscriber
+    {
+    public:
+        FontManager();
+        ~FontManager();
+
+        [[nodiscard]] bool is_loaded() const noexcept { return face_ != nullptr; }
+
+        // Queues the codepoints of UTF-8 text that have not been requested before. Cheap for ASCII text,
+        // so it can be called on every visible line every frame.
+        void request_glyphs(std::string_view text);
+
+        // Font matching the display scale of window, created on first use; nullptr if no font file was loaded.
+        ImFont* get_font(const Window* window);
+        // Makes that font the default of the current ImGui context, called before its NewFrame().
+        void apply(const Window* window);
+
+        void frame_begin(const FrameBegin& event);
+        void sdl_event(const SDLEvent& event);
+
+    private:
+        struct SizedFont
+        {
+            std::unique_ptr<ImFontConfig> config;
+            ImFont*                       font       = nullptr;
+            int                           pixel_size = 0;
+            size_t                        rasterized = 0; // Prefix of requested_ already in the atlas at this size
+        };
+
+        SizedFont& create_font(int pixel_size, float pixel_density);
+        bool       rasterize_ascii(SizedFont& sized);
+        bool       rasterize(SizedFont& sized, uint32_t codepoint);
+        bool       grow_or_reset();
+        void       upload();
+
+        FT_Library           library_ = nullptr;
+        FT_Face              face_    = nullptr;
+        std::vector<uint8_t> font_data_;
+        float                base_size_        = 16.0f;
+        int                  glyphs_per_frame_ = 64;
+        bool                 resetting_        = false; // Re-rasterizing ASCII into a cleared atlas
+
+        FontAtlas                                                 atlas_;
+        ImFontAtlas                                               container_;
+        ImTextureID                                               texture_ = ImTextureID {};
+        std::map<std::pair<int, int>, std::unique_ptr<SizedFont>> fonts_;    // Keyed by pixel size and pixel density * 100
+        std::vector<uint32_t>                                     requested_;
+        std::unordered_set<uint32_t>                              known_;
+    };
+} // namespace core
@@ -2,19 +2,104 @@
 #include "imgui.h"
 #include "imgui_impl_sdl3.h"
 #include "system/subsystem.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <event/frame_event.h>
+#include <font/font_manager.h>
+#include <gui/log_viewer.h>
+#include <gui/widgets/virtual_table.h>
+#include <memory/frame_arena.h>
+#include <memory/memory_tracker.h>
+#include <scene/scene.h>
+#include <string>
+#include <system/session_snapshot.h>
+#include <window/window_manager.h>
 
 namespace core
 {
-    core::Gui::Gui() { connect<FrameUiRender, Gui, &Gui::ui_renderer>(*this); }
+    namespace
+    {
+        constexpr uint32_t state_section_version = 1;
+
+        struct SavedState
+        {
+            float   f;
+            int32_t counter;
+            int32_t large_table_modulo;
+            uint8_t show_demo_window;
+            uint8_t show_another_window;
+            uint8_t show_large_table;
+            uint8_t show_log;
+            uint8_t show_memory;
+        };
+    } // namespace
+
+    core::Gui::Gui()
+    {
+        auto& state = get_subsystem<Scene>().get_registry().ctx().emplace<State>();
+        if (has_subsystem<SessionSnapshot>())
+        {
+            auto& session = get_subsystem<SessionSnapshot>();
+            restore_state(state, session.get_section("gui.state", state_section_version));
+            session.add_section("gui.state", state_section_version, [](std::vector<std::byte>& data) {
+                save_state(get_subsystem<Scene>().get_registry().ctx().get<State>(), data);
+            });
+        }
+        connect<FrameUiRender, Gui, &Gui::ui_renderer>(*this);
+    }
+
+    core::Gui::~Gui()
+    {
+        if (has_subsystem<SessionSnapshot>())
+            get_subsystem<SessionSnapshot>().remove_section("gui.state");
+        disconnect(*this);
+    }
+
+    void Gui::save_state(const State& state, std::vector<std::byte>& data)
+    {
+        SavedState saved          = {};
+        saved.f                   = state.f;
+        saved.counter             = state.counter;
+        saved.large_table_modulo  = state.large_table_modulo;
+        saved.show_demo_window    = state.show_demo_window;
+        saved.show_another_window = state.show_another_window;
+        saved.show_large_table    = state.show_large_table;
+        saved.show_log            = state.show_log;
+        saved.show_memory         = state.show_memory;
+        data.resize(sizeof(saved));
+        std::memcpy(data.data(), &saved, sizeof(saved));
+    }
 
-    core::Gui::~Gui() { disconnect(*this); }
+    void Gui::restore_state(State& state, std::span<const std::byte> data)
+    {
+        SavedState saved;
+        if (data.size() != sizeof(saved))
+            return;
+        std::memcpy(&saved, data.data(), sizeof(saved));
+        state.f                   = saved.f;
+        state.counter             = saved.counter;
+        state.large_table_modulo  = std::clamp(saved.large_table_modulo, 1, 64);
+        state.show_demo_window    = saved.show_demo_window != 0;
+        state.show_another_window = saved.show_another_window != 0;
+        state.show_large_table    = saved.show_large_table != 0;
+        state.show_log            = saved.show_log != 0;
+        state.show_memory         = saved.show_memory != 0;
+    }
 
     void Gui::ui_renderer(const FrameUiRender& event)
     {
+        auto& window_manager = get_subsystem<WindowManager>();
+        if (!window_manager.is_main_window(event.window_id))
+        {
+            tool_window_renderer(event);
+            return;
+        }
+
         // Our state
-        static bool show_demo_window    = false;
-        static bool show_another_window = false;
+        auto& state               = get_subsystem<Scene>().get_registry().ctx().get<State>();
+        bool& show_demo_window    = state.show_demo_window;
+        bool& show_another_window = state.show_another_window;
 
         // Main loop
         ImGuiIO& io = ImGui::GetIO();
@@ -26,14 +111,22 @@ namespace core
 
         // 2. Show a simple window that we create ourselves. We use a Begin/End pair to create a named window.
         {
-            static float f       = 0.0f;
-            static int   counter = 0;
+            float& f       = state.f;
+            int&   counter = state.counter;
 
             ImGui::Begin("Hello, world!");
 
             ImGui::Text("This is some useful text.");
+            // Outside ASCII: the glyphs show up one frame after they are first requested.
+            static const char* unicode_sample = reinterpret_cast<const char*>(u8"Gr\u00FC\u00DFe, \u0393\u03B5\u03B9\u03B1, \u65E5\u672C\u8A9E");
+            if (has_subsystem<FontManager>())
+                get_subsystem<FontManager>().request_glyphs(unicode_sample);
+            ImGui::TextUnformatted(unicode_sample);
             ImGui::Checkbox("Demo Window", &show_demo_window);
             ImGui::Checkbox("Another Window", &show_another_window);
+            ImGui::Checkbox("Large Table", &state.show_large_table);
+            ImGui::Checkbox("Log", &state.show_log);
+            ImGui::Checkbox("Memory", &state.show_memory);
 
             ImGui::SliderFloat("float", &f, 0.0f, 1.0f);
 
@@ -42,7 +135,18 @@ namespace core
             ImGui::SameLine();
             ImGui::Text("counter = %d", counter);
 
+            if (ImGui::Button("Open Tool Window"))
+                window_manager.create_window("Tool View " + std::to_string(++state.tool_windows), 640, 480);
+
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+            if (has_subsystem<FrameArena>())
+            {
+                const auto& arena = get_subsystem<FrameArena>();
+                ImGui::Text("Frame arena %zu KiB (peak %zu KiB of %zu KiB)",
+                            arena.get_frame_used() / 1024,
+                            arena.get_high_water() / 1024,
+                            arena.get_capacity() / 1024);
+            }
             ImGui::End();
         }
 
@@ -54,5 +158,116 @@ namespace core
                 show_another_window = false;
             ImGui::End();
         }
+
+        if (state.show_large_table)
+            large_table_renderer(state);
+
+        if (state.show_log)
+        {
+            if (!state.log_viewer)
+                state.log_viewer = std::make_shared<LogViewer>();
+            state.log_viewer->draw(&state.show_log);
+        }
+
+        if (state.show_memory)
+            memory_renderer(state);
+    }
+
+    void Gui::memory_renderer(State& state)
+    {
+        ImGui::Begin("Memory", &state.show_memory);
+        if (!MemoryTracker::is_enabled())
+        {
+            ImGui::TextUnformatted("Configure with -DCORE_MEMORY_TRACKING=ON to track heap usage.");
+            ImGui::End();
+            return;
+        }
+
+        const auto total = MemoryTracker::get_total();
+        ImGui::Text("%.1f MiB in %lld blocks, peak %.1f MiB",
+                    total.current / (1024.0 * 1024.0),
+                    static_cast<long long>(total.live),
+                    total.peak / (1024.0 * 1024.0));
+        if (ImGui::Button("Log summary"))
+            MemoryTracker::log_summary();
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV |
+                                      ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("memory_tags", 5, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Tag");
+            ImGui::TableSetupColumn("Current KiB");
+            ImGui::TableSetupColumn("Peak KiB");
+            ImGui::TableSetupColumn("Blocks");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableHeadersRow();
+            for (uint16_t tag = 0; tag < MemoryTracker::get_tag_count(); ++tag)
+            {
+                const auto stats = MemoryTracker::get_stats(tag);
+                if (stats.peak == 0)
+                    continue;
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(stats.name);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%lld", static_cast<long long>(stats.current / 1024));
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%lld", static_cast<long long>(stats.peak / 1024));
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%lld", static_cast<long long>(stats.live));
+                ImGui::TableSetColumnIndex(4);
+                ImGui::Text("%llu", static_cast<unsigned long long>(stats.allocations));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+    // Rows are synthesized from their index, the table only ever touches the visible ones.
+    static uint32_t large_table_value(uint32_t row)
+    {
+        row ^= row >> 16;
+        row *= 0x7feb352dU;
+        row ^= row >> 15;
+        row *= 0x846ca68bU;
+        return row ^ (row >> 16);
+    }
+
+    void Gui::large_table_renderer(State& state)
+    {
+        static constexpr uint32_t row_count = 10'000'000;
+
+        if (!state.large_table)
+        {
+            std::vector<VirtualTable::Column> columns;
+            columns.push_back({"Row", [](uint32_t row) { ImGui::Text("%u", row); }, [](uint32_t a, uint32_t b) { return a < b; }});
+            columns.push_back({"Value",
+                               [](uint32_t row) { ImGui::Text("%08X", large_table_value(row)); },
+                               [](uint32_t a, uint32_t b) { return large_table_value(a) < large_table_value(b); }});
+            state.large_table = std::make_shared<VirtualTable>("large_table", std::move(columns));
+            state.large_table->get_model().set_source_size(row_count);
+        }
+
+        ImGui::Begin("Large Table", &state.show_large_table);
+        if (ImGui::SliderInt("Value modulo", &state.large_table_modulo, 1, 64))
+        {
+            const uint32_t modulo = static_cast<uint32_t>(state.large_table_modulo);
+            state.large_table->get_model().set_filter([modulo](uint32_t row) { return large_table_value(row) % modulo == 0; });
+        }
+        auto& model = state.large_table->get_model();
+        ImGui::Text("%zu of %u rows%s", model.size(), row_count, model.is_busy() ? " (updating)" : "");
+        state.large_table->draw();
+        ImGui::End();
+    }
+
+    void Gui::tool_window_renderer(const FrameUiRender& event)
+    {
+        ImGuiIO& io = ImGui::GetIO();
+
+        ImGui::Begin("Tool View");
+        ImGui::Text("Window id = %u", event.window_id);
+        ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+        ImGui::End();
     }
 } // namespace core
@@ -1,14 +1,49 @@
 #pragma once
 #include "event/EventSubscriber.h"
 #include <event/frame_event.h>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
 
 namespace core
 {
+    class LogViewer;
+    class VirtualTable;
+
     class Gui : public EventSubscriber
     {
     public:
         Gui();
         ~Gui();
         void ui_renderer(const FrameUiRender& event);
+
+    private:
+        // Lives in the scene registry context rather than in function statics.
+        struct State
+        {
+            bool  show_demo_window    = false;
+            bool  show_another_window = false;
+            int   tool_windows        = 0;
+            float f                   = 0.0f;
+            int   counter             = 0;
+
+            bool                          show_large_table   = false;
+            int                           large_table_modulo = 1;
+            std::shared_ptr<VirtualTable> large_table;
+
+            bool                       show_log = false;
+            std::shared_ptr<LogViewer> log_viewer;
+
+            bool show_memory = false;
+        };
+
+        // The part of State the session snapshot keeps.
+        static void save_state(const State& state, std::vector<std::byte>& data);
+        static void restore_state(State& state, std::span<const std::byte> data);
+
+        void tool_window_renderer(const FrameUiRender& event);
+        void large_table_renderer(State& state);
+        void memory_renderer(State& state);
     };
 } // namespace core
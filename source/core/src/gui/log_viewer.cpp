@@ -0,0 +1,322 @@
+#include "log_viewer.h"
+#include "font/font_manager.h"
+#include "imgui.h"
+#include "jobs/job_system.h"
+#include "log/log_ring.h"
+#include "logger.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <chrono>
+#include <spdlog/details/os.h>
+
+namespace core
+{
+    // Records matched per job; larger backlogs (e.g. after a filter change) stream in over several jobs.
+    static constexpr uint64_t max_job_records = 256 * 1024;
+    static constexpr size_t   job_grain       = 16 * 1024;
+
+    static ImVec4 level_color(spdlog::level::level_enum level)
+    {
+        switch (level)
+        {
+            case spdlog::level::trace:
+                return ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
+            case spdlog::level::debug:
+                return ImVec4(0.4f, 0.8f, 0.9f, 1.0f);
+            case spdlog::level::warn:
+                return ImVec4(1.0f, 0.8f, 0.2f, 1.0f);
+            case spdlog::level::err:
+                return ImVec4(1.0f, 0.35f, 0.3f, 1.0f);
+            case spdlog::level::critical:
+                return ImVec4(1.0f, 0.3f, 1.0f, 1.0f);
+            default:
+                return ImGui::GetStyleColorVec4(ImGuiCol_Text);
+        }
+    }
+
+    bool LogViewer::Filter::matches(const LogRecord& record) const
+    {
+        if (record.level < level)
+            return false;
+        const auto record_text = record.get_text();
+        if (text)
+            return text->matches(record_text);
+        if (regex)
+            return std::regex_search(record_text.begin(), record_text.end(), *regex);
+        return true;
+    }
+
+    void LogViewer::Corpus::update(const LogRing& ring, uint64_t oldest, uint64_t published)
+    {
+        // Records that left the ring before they got here would only be empty lines; start after them.
+        if (end < oldest)
+        {
+            text.clear();
+            first_ticket = oldest;
+            end          = oldest;
+        }
+
+        LogRecord record;
+        for (; end < published; ++end)
+        {
+            // An overwritten record keeps its line, empty, so lines stay in step with tickets.
+            text.append_line(ring.read(end, record) ? record.get_text() : std::string_view());
+        }
+        text.discard_before(oldest - first_ticket);
+    }
+
+    LogViewer::LogViewer() : ring_(Logger::getRing())
+    {
+        first_        = ring_.get_oldest();
+        published_    = first_;
+        filtered_end_ = first_;
+    }
+
+    LogViewer::~LogViewer()
+    {
+        ++*generation_;
+        if (pending_.valid())
+            pending_.wait();
+    }
+
+    void LogViewer::set_filter(Filter filter)
+    {
+        ++*generation_;
+        filter_       = std::move(filter);
+        filtered_end_ = first_;
+        matches_.clear();
+    }
+
+    void LogViewer::update()
+    {
+        if (pending_.valid() && pending_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            Result result = pending_.get();
+            if (result.generation == generation_->load())
+            {
+                matches_.insert(matches_.end(), result.tickets.begin(), result.tickets.end());
+                filtered_end_ = result.end;
+            }
+        }
+
+        // Records the ring has overwritten leave from the top.
+        const uint64_t oldest = std::max(ring_.get_oldest(), first_);
+        if (filter_.matches_all())
+        {
+            dropped_rows_ += oldest > first_ ? oldest - first_ : 0;
+        }
+        else
+        {
+            while (!matches_.empty() && matches_.front() < oldest)
+            {
+                matches_.pop_front();
+                ++dropped_rows_;
+            }
+            filtered_end_ = std::max(filtered_end_, oldest);
+        }
+        first_     = oldest;
+        published_ = ring_.get_published(std::max(published_, first_));
+
+        start_job();
+    }
+
+    void LogViewer::start_job()
+    {
+        if (filter_.matches_all() || pending_.valid() || filtered_end_ >= published_)
+            return;
+        if (filter_.text)
+        {
+            start_text_job();
+            return;
+        }
+
+        const uint64_t begin      = filtered_end_;
+        const uint64_t end        = std::min(published_, begin + max_job_records);
+        const uint64_t generation = generation_->load();
+
+        auto& jobs = get_subsystem<JobSystem>();
+        auto  job  = [&jobs, &ring = ring_, begin, end, generation, cancel = generation_, filter = filter_]() {
+            Result result;
+            result.generation = generation;
+            result.end        = end;
+
+            std::vector<std::vector<uint64_t>> chunks((end - begin + job_grain - 1) / job_grain);
+            jobs.parallel_for(end - begin, job_grain, [&](size_t chunk_begin, size_t chunk_end) {
+                if (cancel->load() != generation)
+                    return;
+                auto&     out = chunks[chunk_begin / job_grain];
+                LogRecord record;
+                for (size_t i = chunk_begin; i < chunk_end; ++i)
+                {
+                    // Overwritten records are skipped, they would be evicted right away anyway.
+                    if (ring.read(begin + i, record) && filter.matches(record))
+                        out.push_back(begin + i);
+                }
+            });
+
+            for (const auto& chunk : chunks)
+                result.tickets.insert(result.tickets.end(), chunk.begin(), chunk.end());
+            return result;
+        };
+        pending_ = jobs.submit(std::move(job));
+    }
+
+    // All records up to the published ones in one job: with the index and the block kernels a search
+    // takes a fraction of what matching record by record does, so it needs no batches.
+    void LogViewer::start_text_job()
+    {
+        const uint64_t begin      = filtered_end_;
+        const uint64_t end        = published_;
+        const uint64_t oldest     = first_;
+        const uint64_t generation = generation_->load();
+
+        auto job = [&ring = ring_, corpus = corpus_, begin, end, oldest, generation, cancel = generation_, filter = filter_]() {
+            Result result;
+            result.generation = generation;
+            result.end        = end;
+            if (cancel->load() != generation)
+                return result;
+
+            corpus->update(ring, oldest, end);
+            std::vector<TextCorpus::LineId> lines;
+            corpus->text.search(*filter.text, lines, begin - corpus->first_ticket);
+
+            // Only the level needs the record itself.
+            LogRecord record;
+            for (TextCorpus::LineId line : lines)
+            {
+                const uint64_t ticket = corpus->first_ticket + line;
+                if (filter.level == spdlog::level::trace || (ring.read(ticket, record) && record.level >= filter.level))
+                    result.tickets.push_back(ticket);
+            }
+            return result;
+        };
+        pending_ = get_subsystem<JobSystem>().submit(std::move(job));
+    }
+
+    void LogViewer::draw(bool* open)
+    {
+        update();
+
+        if (!ImGui::Begin("Log", open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        draw_controls();
+
+        const bool   all   = filter_.matches_all();
+        const size_t count = all ? static_cast<size_t>(published_ - first_) : matches_.size();
+        ImGui::Text("%zu records%s", count, pending_.valid() ? " (filtering)" : "");
+        ImGui::Separator();
+
+        ImGui::BeginChild("##log_records", ImVec2(0.0f, 0.0f), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+        const float line_height = ImGui::GetTextLineHeightWithSpacing();
+
+        // Keep the lines under the cursor still while old records are evicted above them.
+        if (!at_bottom_ && dropped_rows_ > 0)
+            ImGui::SetScrollY(std::max(0.0f, ImGui::GetScrollY() - dropped_rows_ * line_height));
+        dropped_rows_ = 0;
+
+        // Paths and messages may leave ASCII; their glyphs are rasterized for the next frame.
+        FontManager* fonts = has_subsystem<FontManager>() ? &get_subsystem<FontManager>() : nullptr;
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(count), line_height);
+        LogRecord record;
+        while (clipper.Step())
+        {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+            {
+                const uint64_t ticket = all ? first_ + i : matches_[i];
+                if (ring_.read(ticket, record))
+                {
+                    if (fonts)
+                        fonts->request_glyphs(record.get_text());
+                    draw_record(record);
+                }
+                else
+                    ImGui::TextDisabled("<overwritten>");
+            }
+        }
+
+        if (auto_scroll_ && at_bottom_)
+            ImGui::SetScrollHereY(1.0f);
+        at_bottom_ = ImGui::GetScrollY() >= ImGui::GetScrollMaxY() - 1.0f;
+
+        ImGui::EndChild();
+        ImGui::End();
+    }
+
+    void LogViewer::draw_controls()
+    {
+        static const char* levels[] = {"Trace", "Debug", "Info", "Warning", "Error", "Critical"};
+
+        bool changed = false;
+        ImGui::SetNextItemWidth(100.0f);
+        changed |= ImGui::Combo("Level", &level_, levels, IM_ARRAYSIZE(levels));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(240.0f);
+        changed |= ImGui::InputTextWithHint("##filter", use_regex_ ? "regex filter" : "filter", filter_text_, IM_ARRAYSIZE(filter_text_));
+        ImGui::SameLine();
+        changed |= ImGui::Checkbox("Regex", &use_regex_);
+        ImGui::SameLine();
+        changed |= ImGui::Checkbox("Ignore case", &ignore_case_);
+        ImGui::SameLine();
+        ImGui::Checkbox("Auto-scroll", &auto_scroll_);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear"))
+        {
+            first_ = published_;
+            set_filter(filter_);
+        }
+
+        if (changed)
+        {
+            Filter filter;
+            filter.level = static_cast<spdlog::level::level_enum>(level_);
+            regex_error_.clear();
+            if (!use_regex_)
+            {
+                TextMatcher matcher(filter_text_, ignore_case_);
+                if (!matcher.empty())
+                    filter.text = std::make_shared<const TextMatcher>(std::move(matcher));
+            }
+            else if (filter_text_[0] != '\0')
+            {
+                try
+                {
+                    auto flags = std::regex::ECMAScript | std::regex::optimize;
+                    if (ignore_case_)
+                        flags |= std::regex::icase;
+                    filter.regex = std::make_shared<const std::regex>(filter_text_, flags);
+                }
+                catch (const std::regex_error& e)
+                {
+                    // Keep the previous filter while the pattern is being typed.
+                    regex_error_ = e.what();
+                    return;
+                }
+            }
+            set_filter(std::move(filter));
+        }
+
+        if (!regex_error_.empty())
+            ImGui::TextColored(level_color(spdlog::level::err), "%s", regex_error_.c_str());
+    }
+
+    void LogViewer::draw_record(const LogRecord& record) const
+    {
+        const auto seconds = static_cast<std::time_t>(record.time_ns / 1'000'000'000);
+        const auto millis  = static_cast<int>((record.time_ns / 1'000'000) % 1000);
+        const auto tm      = spdlog::details::os::localtime(seconds);
+
+        ImGui::TextDisabled("%02d:%02d:%02d.%03d", tm.tm_hour, tm.tm_min, tm.tm_sec, millis);
+        ImGui::SameLine();
+        ImGui::TextColored(level_color(record.level), "[%s]", spdlog::level::to_short_c_str(record.level));
+        ImGui::SameLine();
+        const auto text = record.get_text();
+        ImGui::TextUnformatted(text.data(), text.data() + text.size());
+    }
+} // namespace core
@@ -0,0 +1,92 @@
+#pragma once
+#include "search/text_corpus.h"
+#include "search/text_search.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <regex>
+#include <spdlog/common.h>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    class LogRing;
+    struct LogRecord;
+
+    // Panel showing the records of Logger's ring. Without a filter the rows map straight onto ring
+    // tickets and nothing is copied; with a level, text or regex filter, new records are matched on the
+    // job pool and only the matching tickets are kept. Plain text is the default filter: all of its words
+    // have to occur. Text filter jobs copy the records into a TextCorpus first and search that, so the
+    // SIMD kernels run over whole blocks and the trigram index skips blocks without the words.
+    class LogViewer
+    {
+    public:
+        LogViewer();
+        ~LogViewer();
+
+        LogViewer(const LogViewer&)            = delete;
+        LogViewer& operator=(const LogViewer&) = delete;
+
+        void draw(bool* open);
+
+    private:
+        struct Filter
+        {
+            spdlog::level::level_enum          level = spdlog::level::trace;
+            std::shared_ptr<const TextMatcher> text;
+            std::shared_ptr<const std::regex>  regex;
+
+            [[nodiscard]] bool matches_all() const noexcept { return level == spdlog::level::trace && !text && !regex; }
+            [[nodiscard]] bool matches(const LogRecord& record) const;
+        };
+
+        // The text of the ring's records from first_ticket on, one line each. Only filter jobs touch it,
+        // one at a time.
+        struct Corpus
+        {
+            TextCorpus text;
+            uint64_t   first_ticket = 0; // Ticket of line 0
+            uint64_t   end          = 0; // Ticket of the next line
+
+            void update(const LogRing& ring, uint64_t oldest, uint64_t published);
+        };
+
+        struct Result
+        {
+            uint64_t              generation = 0;
+            uint64_t              end        = 0;
+            std::vector<uint64_t> tickets;
+        };
+
+        void set_filter(Filter filter);
+        void update();
+        void start_job();
+        void start_text_job();
+        void draw_controls();
+        void draw_record(const LogRecord& record) const;
+
+        LogRing& ring_;
+        Filter   filter_;
+
+        std::deque<uint64_t> matches_;
+        uint64_t             first_        = 0; // Nothing before this ticket is shown (ring start or "Clear")
+        uint64_t             published_    = 0;
+        uint64_t             filtered_end_ = 0; // Tickets before this are reflected in matches_
+        size_t               dropped_rows_ = 0; // Rows that left the top since the last draw
+
+        std::shared_ptr<std::atomic<uint64_t>> generation_ = std::make_shared<std::atomic<uint64_t>>(0);
+        std::shared_ptr<Corpus>                corpus_     = std::make_shared<Corpus>();
+        std::future<Result>                    pending_;
+
+        char        filter_text_[256] = {};
+        int         level_            = spdlog::level::trace;
+        bool        use_regex_        = false;
+        bool        ignore_case_      = true;
+        bool        auto_scroll_      = true;
+        bool        at_bottom_        = true;
+        std::string regex_error_;
+    };
+} // namespace core
@@ -0,0 +1,238 @@
+#include "row_model.h"
+#include "jobs/job_system.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <chrono>
+
+namespace core
+{
+    static constexpr size_t filter_grain = 64 * 1024;
+    static constexpr size_t sort_grain   = 256 * 1024;
+
+    // Ties are broken by row id, so the order is total and binary searchable.
+    static RowModel::Less make_total_order(const RowModel::Less& less)
+    {
+        return [less](uint32_t a, uint32_t b) {
+            if (less(a, b))
+                return true;
+            if (less(b, a))
+                return false;
+            return a < b;
+        };
+    }
+
+    // Chunks are sorted in parallel, then merged pairwise in parallel rounds.
+    static void parallel_sort(JobSystem& jobs, std::vector<uint32_t>& rows, const RowModel::Less& less)
+    {
+        const size_t count = rows.size();
+        if (count < sort_grain * 2)
+        {
+            std::sort(rows.begin(), rows.end(), less);
+            return;
+        }
+
+        const size_t width  = std::max(sort_grain, count / (jobs.get_worker_count() + 1) + 1);
+        const size_t pieces = (count + width - 1) / width;
+        jobs.parallel_for(pieces, 1, [&](size_t begin, size_t end) {
+            for (size_t piece = begin; piece < end; ++piece)
+            {
+                std::sort(rows.begin() + piece * width, rows.begin() + std::min((piece + 1) * width, count), less);
+            }
+        });
+
+        for (size_t run = width; run < count; run *= 2)
+        {
+            const size_t merges = (count + run * 2 - 1) / (run * 2);
+            jobs.parallel_for(merges, 1, [&](size_t begin, size_t end) {
+                for (size_t merge = begin; merge < end; ++merge)
+                {
+                    const size_t lo  = merge * run * 2;
+                    const size_t mid = std::min(lo + run, count);
+                    const size_t hi  = std::min(lo + run * 2, count);
+                    if (mid < hi)
+                        std::inplace_merge(rows.begin() + lo, rows.begin() + mid, rows.begin() + hi, less);
+                }
+            });
+        }
+    }
+
+    RowModel::~RowModel()
+    {
+        ++*generation_;
+        if (pending_.valid())
+            pending_.wait();
+    }
+
+    void RowModel::set_source_size(size_t size)
+    {
+        if (size < source_size_)
+            invalidate();
+        source_size_ = size;
+    }
+
+    void RowModel::set_filter(Filter filter)
+    {
+        filter_ = std::move(filter);
+        invalidate();
+    }
+
+    void RowModel::set_sort(Less less)
+    {
+        less_ = less ? make_total_order(less) : Less {};
+        invalidate();
+    }
+
+    void RowModel::set_row_height(Height height)
+    {
+        height_ = std::move(height);
+        invalidate();
+    }
+
+    bool RowModel::update()
+    {
+        bool changed = false;
+        if (pending_.valid() && pending_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            Result result = pending_.get();
+            if (result.generation == generation_->load())
+            {
+                apply(result);
+                changed = true;
+            }
+        }
+
+        start_job();
+        return changed;
+    }
+
+    size_t RowModel::find_offset(double y) const noexcept
+    {
+        if (rows_.empty() || offsets_.empty())
+            return 0;
+
+        const auto   it    = std::upper_bound(offsets_.begin(), offsets_.end(), y);
+        const size_t index = it == offsets_.begin() ? 0 : static_cast<size_t>(it - offsets_.begin()) - 1;
+        return std::min(index, rows_.size() - 1);
+    }
+
+    size_t RowModel::find_row(uint32_t row) const
+    {
+        const auto it =
+            rows_less_ ? std::lower_bound(rows_.begin(), rows_.end(), row, rows_less_) : std::lower_bound(rows_.begin(), rows_.end(), row);
+        return it != rows_.end() && *it == row ? static_cast<size_t>(it - rows_.begin()) : npos;
+    }
+
+    void RowModel::invalidate()
+    {
+        // The running job notices the new generation and gives up; its result is dropped.
+        ++*generation_;
+        dirty_ = true;
+    }
+
+    void RowModel::start_job()
+    {
+        if (pending_.valid() || (!dirty_ && processed_ >= source_size_))
+            return;
+
+        // Sorted appends are merged into a new vector; everything else only adds a tail.
+        const bool  replace    = dirty_ || less_;
+        const auto* current    = dirty_ ? nullptr : &rows_; // Not modified until this job is applied
+        const auto  begin      = dirty_ ? 0 : processed_;
+        const auto  end        = source_size_;
+        const auto  generation = generation_->load();
+        dirty_                 = false;
+
+        auto& jobs = get_subsystem<JobSystem>();
+        auto  job  = [&jobs, current, begin, end, replace, generation, cancel = generation_, filter = filter_, less = less_, height = height_]() {
+            Result result;
+            result.generation = generation;
+            result.replace    = replace;
+            result.processed  = end;
+            result.less       = less;
+
+            // Filter in parallel chunks, concatenated in source order.
+            std::vector<std::vector<uint32_t>> chunks((end - begin + filter_grain - 1) / filter_grain);
+            jobs.parallel_for(end - begin, filter_grain, [&](size_t chunk_begin, size_t chunk_end) {
+                if (cancel->load() != generation)
+                    return;
+                auto& out = chunks[chunk_begin / filter_grain];
+                out.reserve(chunk_end - chunk_begin);
+                for (size_t i = chunk_begin; i < chunk_end; ++i)
+                {
+                    const auto row = static_cast<uint32_t>(begin + i);
+                    if (!filter || filter(row))
+                        out.push_back(row);
+                }
+            });
+            if (cancel->load() != generation)
+                return result;
+
+            std::vector<uint32_t> added;
+            size_t                added_count = 0;
+            for (const auto& chunk : chunks)
+                added_count += chunk.size();
+            added.reserve(added_count);
+            for (const auto& chunk : chunks)
+                added.insert(added.end(), chunk.begin(), chunk.end());
+
+            if (less)
+            {
+                parallel_sort(jobs, added, less);
+                if (current && !current->empty())
+                {
+                    result.rows.resize(current->size() + added.size());
+                    std::merge(current->begin(), current->end(), added.begin(), added.end(), result.rows.begin(), less);
+                }
+                else
+                {
+                    result.rows = std::move(added);
+                }
+            }
+            else
+            {
+                result.rows = std::move(added);
+            }
+            if (cancel->load() != generation)
+                return result;
+
+            if (height)
+            {
+                // Replacing: rows.size() + 1 offsets from 0. Appending: running sums of the tail only.
+                result.offsets.reserve(result.rows.size() + 1);
+                double offset = 0.0;
+                if (replace)
+                    result.offsets.push_back(offset);
+                for (const uint32_t row : result.rows)
+                {
+                    offset += height(row);
+                    result.offsets.push_back(offset);
+                }
+            }
+            return result;
+        };
+        pending_ = jobs.submit(std::move(job));
+    }
+
+    void RowModel::apply(Result& result)
+    {
+        if (result.replace)
+        {
+            rows_      = std::move(result.rows);
+            offsets_   = std::move(result.offsets);
+            rows_less_ = std::move(result.less);
+        }
+        else
+        {
+            rows_.insert(rows_.end(), result.rows.begin(), result.rows.end());
+            if (!result.offsets.empty())
+            {
+                if (offsets_.empty())
+                    offsets_.push_back(0.0);
+                const double base = offsets_.back();
+                for (const double offset : result.offsets)
+                    offsets_.push_back(base + offset);
+            }
+        }
+        processed_ = result.processed;
+    }
+} // namespace core
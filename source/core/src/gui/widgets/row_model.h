@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace core
+{
+    // The visible rows of a large, append-only dataset: source row ids after filtering and sorting,
+    // plus optional prefix sums of row heights. Filtering, sorting and height indexing run on the job
+    // pool; update() only swaps in finished results, so the frame never waits for them.
+    //
+    // Filter, Less and Height are called from worker threads. They may read any source row below the
+    // size last passed to set_source_size(), which therefore must not move in memory (use e.g. a deque).
+    class RowModel
+    {
+    public:
+        using Filter = std::function<bool(uint32_t row)>;
+        using Less   = std::function<bool(uint32_t a, uint32_t b)>;
+        using Height = std::function<float(uint32_t row)>;
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        RowModel() = default;
+        ~RowModel();
+
+        RowModel(const RowModel&)            = delete;
+        RowModel& operator=(const RowModel&) = delete;
+
+        // Appended rows are filtered incrementally; a smaller size than before starts over.
+        void set_source_size(size_t size);
+        void set_filter(Filter filter);
+        void set_sort(Less less);
+        void set_row_height(Height height);
+
+        // Takes finished background work and starts the next job; call once per frame before drawing.
+        // Returns true when the visible rows changed.
+        bool update();
+
+        [[nodiscard]] size_t   size() const noexcept { return rows_.size(); }
+        [[nodiscard]] uint32_t row(size_t index) const noexcept { return rows_[index]; }
+        [[nodiscard]] bool     is_busy() const noexcept { return pending_.valid(); }
+        [[nodiscard]] bool     is_sorted() const noexcept { return static_cast<bool>(less_); }
+
+        // Variable row heights: offsets are prefix sums over the visible rows.
+        [[nodiscard]] bool   has_row_heights() const noexcept { return static_cast<bool>(height_); }
+        [[nodiscard]] double get_offset(size_t index) const noexcept { return index < offsets_.size() ? offsets_[index] : get_total_height(); }
+        [[nodiscard]] double get_total_height() const noexcept { return offsets_.empty() ? 0.0 : offsets_.back(); }
+        // Visible index of the row covering y.
+        [[nodiscard]] size_t find_offset(double y) const noexcept;
+
+        // Visible index of a source row, or npos when it is filtered out.
+        [[nodiscard]] size_t find_row(uint32_t row) const;
+
+    private:
+        struct Result
+        {
+            uint64_t              generation = 0;
+            bool                  replace    = false;
+            size_t                processed  = 0;
+            std::vector<uint32_t> rows;
+            std::vector<double>   offsets; // Prefix sums of the row heights, starting at 0 when replacing
+            Less                  less;
+        };
+
+        void invalidate();
+        void start_job();
+        void apply(Result& result);
+
+        Filter filter_;
+        Less   less_;
+        Height height_;
+
+        std::vector<uint32_t> rows_;
+        std::vector<double>   offsets_;
+        Less                  rows_less_; // The order rows_ is currently sorted in
+        size_t                source_size_ = 0;
+        size_t                processed_   = 0; // Source rows already reflected in rows_
+        bool                  dirty_       = false;
+
+        std::shared_ptr<std::atomic<uint64_t>> generation_ = std::make_shared<std::atomic<uint64_t>>(0);
+        std::future<Result>                    pending_;
+    };
+} // namespace core
@@ -0,0 +1,95 @@
+#include "virtual_list.h"
+#include <algorithm>
+
+namespace core
+{
+    static double row_top(const RowModel& model, size_t index, float row_height)
+    {
+        return model.has_row_heights() ? model.get_offset(index) : static_cast<double>(index) * row_height;
+    }
+
+    void ScrollAnchor::restore(const RowModel& model, float row_height, bool model_changed)
+    {
+        if (!model_changed || model.size() == 0)
+            return;
+
+        if (at_bottom_)
+        {
+            scroll_tail_ = true;
+            return;
+        }
+
+        // Unsorted models only ever append, the anchor can only have moved in a sorted one.
+        if (valid_ && model.is_sorted())
+        {
+            const size_t index = model.find_row(row_);
+            if (index != RowModel::npos)
+                ImGui::SetScrollY(static_cast<float>(row_top(model, index, row_height)) + delta_);
+        }
+    }
+
+    void ScrollAnchor::capture(const RowModel& model, float row_height, bool follow_tail)
+    {
+        if (follow_tail && scroll_tail_)
+            ImGui::SetScrollHereY(1.0f);
+        scroll_tail_ = false;
+
+        const float scroll = ImGui::GetScrollY();
+        at_bottom_         = follow_tail && scroll >= ImGui::GetScrollMaxY() - 1.0f;
+        valid_             = model.size() > 0;
+        if (!valid_)
+            return;
+
+        const size_t first = model.has_row_heights() ? model.find_offset(scroll)
+                                                     : std::min(static_cast<size_t>(scroll / row_height), model.size() - 1);
+        row_               = model.row(first);
+        delta_             = scroll - static_cast<float>(row_top(model, first, row_height));
+    }
+
+    void VirtualList::draw(const DrawRow& draw_row, const ImVec2& size)
+    {
+        const bool changed = model_.update();
+
+        if (!ImGui::BeginChild(id_.c_str(), size, ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar))
+        {
+            ImGui::EndChild();
+            return;
+        }
+
+        const float row_height = ImGui::GetTextLineHeightWithSpacing();
+        anchor_.restore(model_, row_height, changed);
+
+        if (!model_.has_row_heights())
+        {
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(model_.size()), row_height);
+            while (clipper.Step())
+            {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+                {
+                    ImGui::PushID(i);
+                    draw_row(model_.row(i));
+                    ImGui::PopID();
+                }
+            }
+        }
+        else if (model_.size() > 0)
+        {
+            // Variable heights: binary search the prefix sums for the first row in view.
+            const double top    = ImGui::GetScrollY();
+            const double bottom = top + ImGui::GetWindowHeight();
+            for (size_t i = model_.find_offset(top); i < model_.size() && model_.get_offset(i) < bottom; ++i)
+            {
+                ImGui::SetCursorPosY(static_cast<float>(model_.get_offset(i)));
+                ImGui::PushID(static_cast<int>(i));
+                draw_row(model_.row(i));
+                ImGui::PopID();
+            }
+            ImGui::SetCursorPosY(static_cast<float>(model_.get_total_height()));
+            ImGui::Dummy(ImVec2(0.0f, 0.0f));
+        }
+
+        anchor_.capture(model_, row_height, follow_tail_);
+        ImGui::EndChild();
+    }
+} // namespace core
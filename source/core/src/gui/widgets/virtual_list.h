@@ -0,0 +1,50 @@
+#pragma once
+#include "imgui.h"
+#include "row_model.h"
+#include <functional>
+#include <string>
+
+namespace core
+{
+    // Keeps the content under the cursor still while the model changes underneath it: the first
+    // visible row is remembered and scrolled back to after a sorted insert moved it, and a view
+    // that sat at the bottom keeps following the tail.
+    class ScrollAnchor
+    {
+    public:
+        // Inside the scrolling window, before the rows are submitted.
+        void restore(const RowModel& model, float row_height, bool model_changed);
+        // Inside the scrolling window, after the rows are submitted.
+        void capture(const RowModel& model, float row_height, bool follow_tail);
+
+    private:
+        uint32_t row_         = 0;
+        float    delta_       = 0.0f;
+        bool     valid_       = false;
+        bool     at_bottom_   = true;
+        bool     scroll_tail_ = false;
+    };
+
+    // Scrolling list that only submits the rows in view. Uniform rows go through ImGuiListClipper;
+    // with RowModel::set_row_height() rows are placed from the model's prefix sums instead.
+    class VirtualList
+    {
+    public:
+        using DrawRow = std::function<void(uint32_t row)>;
+
+        explicit VirtualList(std::string id) : id_(std::move(id)) {}
+
+        [[nodiscard]] RowModel& get_model() noexcept { return model_; }
+
+        // Keep scrolled to the end while new rows arrive, as long as the user is at the bottom.
+        void set_follow_tail(bool follow) noexcept { follow_tail_ = follow; }
+
+        void draw(const DrawRow& draw_row, const ImVec2& size = ImVec2(0.0f, 0.0f));
+
+    private:
+        std::string  id_;
+        RowModel     model_;
+        ScrollAnchor anchor_;
+        bool         follow_tail_ = false;
+    };
+} // namespace core
@@ -0,0 +1,92 @@
+#include "virtual_table.h"
+
+namespace core
+{
+    void VirtualTable::draw(const ImVec2& size)
+    {
+        const bool changed = model_.update();
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV |
+                                      ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable |
+                                      ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti | ImGuiTableFlags_SortTristate;
+        if (!ImGui::BeginTable(id_.c_str(), static_cast<int>(columns_.size()), flags, size))
+            return;
+
+        ImGui::TableSetupScrollFreeze(0, 1);
+        for (size_t i = 0; i < columns_.size(); ++i)
+        {
+            const auto& column = columns_[i];
+            ImGui::TableSetupColumn(column.name.c_str(),
+                                    column.flags | (column.less ? ImGuiTableColumnFlags_None : ImGuiTableColumnFlags_NoSort),
+                                    0.0f,
+                                    static_cast<ImGuiID>(i));
+        }
+        ImGui::TableHeadersRow();
+
+        if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && specs->SpecsDirty)
+        {
+            apply_sort_specs(*specs);
+            specs->SpecsDirty = false;
+        }
+
+        // Rows are uniform; the clipper measures the first one and the anchor reuses that height.
+        anchor_.restore(model_, row_height_, changed);
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(model_.size()));
+        while (clipper.Step())
+        {
+            if (clipper.ItemsHeight > 0.0f)
+                row_height_ = clipper.ItemsHeight;
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+            {
+                const uint32_t row = model_.row(i);
+                ImGui::TableNextRow();
+                ImGui::PushID(i);
+                for (size_t c = 0; c < columns_.size(); ++c)
+                {
+                    ImGui::TableSetColumnIndex(static_cast<int>(c));
+                    columns_[c].draw(row);
+                }
+                ImGui::PopID();
+            }
+        }
+
+        anchor_.capture(model_, row_height_, follow_tail_);
+        ImGui::EndTable();
+    }
+
+    void VirtualTable::apply_sort_specs(const ImGuiTableSortSpecs& specs)
+    {
+        struct Key
+        {
+            RowModel::Less less;
+            bool           descending;
+        };
+
+        std::vector<Key> keys;
+        for (int i = 0; i < specs.SpecsCount; ++i)
+        {
+            const auto& spec = specs.Specs[i];
+            if (spec.ColumnUserID < columns_.size() && columns_[spec.ColumnUserID].less)
+                keys.push_back(Key {columns_[spec.ColumnUserID].less, spec.SortDirection == ImGuiSortDirection_Descending});
+        }
+
+        if (keys.empty())
+        {
+            model_.set_sort({});
+            return;
+        }
+
+        model_.set_sort([keys = std::move(keys)](uint32_t a, uint32_t b) {
+            for (const auto& key : keys)
+            {
+                if (key.less(a, b))
+                    return !key.descending;
+                if (key.less(b, a))
+                    return key.descending;
+            }
+            return false;
+        });
+    }
+} // namespace core
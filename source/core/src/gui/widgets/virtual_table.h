@@ -0,0 +1,42 @@
+#pragma once
+#include "imgui.h"
+#include "row_model.h"
+#include "virtual_list.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    // ImGui table over a RowModel: rows are clipped to the visible range and clicking a sortable
+    // header re-sorts on the job pool with the column comparators.
+    class VirtualTable
+    {
+    public:
+        struct Column
+        {
+            std::string                       name;
+            std::function<void(uint32_t row)> draw;
+            RowModel::Less                    less; // Column is not sortable without one
+            ImGuiTableColumnFlags             flags = ImGuiTableColumnFlags_None;
+        };
+
+        VirtualTable(std::string id, std::vector<Column> columns) : id_(std::move(id)), columns_(std::move(columns)) {}
+
+        [[nodiscard]] RowModel& get_model() noexcept { return model_; }
+
+        void set_follow_tail(bool follow) noexcept { follow_tail_ = follow; }
+
+        void draw(const ImVec2& size = ImVec2(0.0f, 0.0f));
+
+    private:
+        void apply_sort_specs(const ImGuiTableSortSpecs& specs);
+
+        std::string         id_;
+        std::vector<Column> columns_;
+        RowModel            model_;
+        ScrollAnchor        anchor_;
+        float               row_height_  = 1.0f;
+        bool                follow_tail_ = false;
+    };
+} // namespace core
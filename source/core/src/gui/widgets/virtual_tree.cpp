@@ -0,0 +1,116 @@
+#include "virtual_tree.h"
+#include <cassert>
+
+namespace core
+{
+    uint32_t VirtualTree::append_node(uint32_t depth)
+    {
+        assert(depth <= path_.size() && "Nodes must be appended in depth-first preorder");
+
+        path_.resize(depth);
+        path_open_.resize(depth);
+
+        const auto node = static_cast<uint32_t>(depth_.size());
+        depth_.push_back(depth);
+        subtree_end_.push_back(node + 1);
+        expanded_.push_back(0);
+        for (const uint32_t ancestor : path_)
+            subtree_end_[ancestor] = node + 1;
+
+        // The new node is last in preorder, so when visible it is also the last visible row.
+        const bool visible = path_open_.empty() || path_open_.back();
+        if (visible && !dirty_)
+            visible_.push_back(node);
+
+        path_.push_back(node);
+        path_open_.push_back(0);
+        return node;
+    }
+
+    void VirtualTree::clear()
+    {
+        depth_.clear();
+        subtree_end_.clear();
+        expanded_.clear();
+        path_.clear();
+        path_open_.clear();
+        visible_.clear();
+        dirty_ = false;
+    }
+
+    void VirtualTree::set_expanded(uint32_t node, bool expanded)
+    {
+        if (is_expanded(node) == expanded)
+            return;
+
+        expanded_[node] = expanded ? 1 : 0;
+        dirty_          = true;
+
+        bool open = true;
+        for (size_t i = 0; i < path_.size(); ++i)
+        {
+            open          = open && is_expanded(path_[i]);
+            path_open_[i] = open ? 1 : 0;
+        }
+    }
+
+    void VirtualTree::rebuild_visible()
+    {
+        // O(visible rows): a collapsed node jumps straight past its subtree.
+        visible_.clear();
+        for (uint32_t node = 0; node < depth_.size();)
+        {
+            visible_.push_back(node);
+            node = is_expanded(node) ? node + 1 : subtree_end_[node];
+        }
+        dirty_ = false;
+    }
+
+    void VirtualTree::draw(const DrawNode& draw_node, const ImVec2& size)
+    {
+        if (dirty_)
+            rebuild_visible();
+
+        if (!ImGui::BeginChild(id_.c_str(), size, ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar))
+        {
+            ImGui::EndChild();
+            return;
+        }
+
+        const float indent  = ImGui::GetStyle().IndentSpacing;
+        int64_t     toggled = -1;
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(visible_.size()), ImGui::GetTextLineHeightWithSpacing());
+        while (clipper.Step())
+        {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+            {
+                const uint32_t node = visible_[i];
+                const float    x    = indent * depth_[node];
+
+                ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanAvailWidth;
+                flags |= has_children(node) ? ImGuiTreeNodeFlags_OpenOnArrow : ImGuiTreeNodeFlags_Leaf;
+
+                ImGui::PushID(static_cast<int>(node));
+                if (x > 0.0f)
+                    ImGui::Indent(x);
+                ImGui::SetNextItemOpen(is_expanded(node));
+                ImGui::TreeNodeEx("##node", flags);
+                if (ImGui::IsItemToggledOpen())
+                    toggled = node;
+                ImGui::SameLine();
+                draw_node(node);
+                if (x > 0.0f)
+                    ImGui::Unindent(x);
+                ImGui::PopID();
+            }
+        }
+
+        // Applied after the loop, the visible list must not change while it is being walked.
+        if (toggled >= 0)
+            set_expanded(static_cast<uint32_t>(toggled), !is_expanded(static_cast<uint32_t>(toggled)));
+
+        ImGui::EndChild();
+    }
+} // namespace core
@@ -0,0 +1,44 @@
+#pragma once
+#include "imgui.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    // Tree of nodes stored in depth-first preorder. Only expanded branches are flattened into the
+    // visible row list, collapsed subtrees are skipped in one step, and only rows in view are submitted.
+    class VirtualTree
+    {
+    public:
+        using DrawNode = std::function<void(uint32_t node)>;
+
+        explicit VirtualTree(std::string id) : id_(std::move(id)) {}
+
+        // depth may be at most one more than the depth of the previous node. Returns the node id.
+        uint32_t append_node(uint32_t depth);
+        void     clear();
+
+        void               set_expanded(uint32_t node, bool expanded);
+        [[nodiscard]] bool is_expanded(uint32_t node) const noexcept { return expanded_[node] != 0; }
+        [[nodiscard]] bool has_children(uint32_t node) const noexcept { return subtree_end_[node] > node + 1; }
+
+        [[nodiscard]] size_t get_node_count() const noexcept { return depth_.size(); }
+        [[nodiscard]] size_t get_visible_count() const noexcept { return visible_.size(); }
+
+        void draw(const DrawNode& draw_node, const ImVec2& size = ImVec2(0.0f, 0.0f));
+
+    private:
+        void rebuild_visible();
+
+        std::string           id_;
+        std::vector<uint32_t> depth_;
+        std::vector<uint32_t> subtree_end_; // One past the last descendant
+        std::vector<uint8_t>  expanded_;
+        std::vector<uint32_t> path_;        // Ancestors of the next appended node
+        std::vector<uint8_t>  path_open_;   // path_open_[i]: path_[0..i] are all visible and expanded
+        std::vector<uint32_t> visible_;
+        bool                  dirty_ = false;
+    };
+} // namespace core
@@ -0,0 +1,226 @@
+#include "input_recorder.h"
+#include "cmd_line/parser.hpp"
+#include "logger.h"
+#include <SDL3/SDL_timer.h>
+#include <cstring>
+#include <iterator>
+
+namespace core
+{
+    namespace
+    {
+        constexpr uint32_t null_string = 0xFFFFFFFFu;
+
+        bool is_text_event(uint32_t type) { return type == SDL_EVENT_TEXT_EDITING || type == SDL_EVENT_TEXT_INPUT; }
+
+        bool is_drop_event(uint32_t type) { return type >= SDL_EVENT_DROP_FILE && type <= SDL_EVENT_DROP_POSITION; }
+
+        // Events whose pointers can not be written out meaningfully.
+        bool is_unrecordable(uint32_t type)
+        {
+            return type == SDL_EVENT_TEXT_EDITING_CANDIDATES || type == SDL_EVENT_CLIPBOARD_UPDATE || type >= SDL_EVENT_USER;
+        }
+
+        // Events describing the real application and its windows. They are not recorded and stay live during a
+        // replay, so each reaches the app once. Everything below SDL_EVENT_KEY_DOWN is application, lifecycle,
+        // display or window; no input event is in that range.
+        bool is_system_event(uint32_t type) { return type < SDL_EVENT_KEY_DOWN; }
+
+        void append(std::vector<char>& bytes, const void* data, size_t size)
+        {
+            const char* begin = static_cast<const char*>(data);
+            bytes.insert(bytes.end(), begin, begin + size);
+        }
+
+        void append_string(std::vector<char>& bytes, const char* text)
+        {
+            uint32_t length = text ? static_cast<uint32_t>(std::strlen(text)) : null_string;
+            append(bytes, &length, sizeof(length));
+            if (text)
+                append(bytes, text, length + 1);
+        }
+    } // namespace
+
+    InputRecorder::InputRecorder()
+    {
+        auto& parser = Parser::instance();
+        if (parser.hasOption("replay-input"))
+            open_replay(parser.getRequiredOptionValue("replay-input"));
+        else if (parser.hasOption("record-input"))
+            open_recording(parser.getRequiredOptionValue("record-input"));
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        if (mode_ == Mode::record && frame_open_)
+            write_frame();
+    }
+
+    void InputRecorder::open_recording(const std::string& path)
+    {
+        output_.open(path, std::ios::binary | std::ios::trunc);
+        if (!output_)
+        {
+            APPLOG_ERROR("Can not open input recording {}", path);
+            return;
+        }
+
+        FileHeader header {{magic_[0], magic_[1], magic_[2], magic_[3]}, version_, sizeof(SDL_Event)};
+        output_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        mode_ = Mode::record;
+        APPLOG_INFO("Recording input to {}", path);
+    }
+
+    void InputRecorder::open_replay(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            APPLOG_ERROR("Can not open input replay {}", path);
+            return;
+        }
+        input_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        FileHeader header {};
+        if (input_.size() < sizeof(header))
+        {
+            APPLOG_ERROR("Input replay {} is truncated", path);
+            return;
+        }
+        std::memcpy(&header, input_.data(), sizeof(header));
+        if (std::memcmp(header.magic, magic_, sizeof(magic_)) != 0 || header.version != version_ ||
+            header.event_size != sizeof(SDL_Event))
+        {
+            APPLOG_ERROR("Input replay {} was recorded by an incompatible build", path);
+            return;
+        }
+
+        read_offset_ = sizeof(header);
+        fast_        = Parser::instance().hasOption("replay-fast");
+        mode_        = Mode::replay;
+        APPLOG_INFO("Replaying input from {}{}", path, fast_ ? " as fast as possible" : "");
+    }
+
+    float InputRecorder::begin_frame(float dt)
+    {
+        if (mode_ == Mode::record)
+        {
+            if (frame_open_)
+                write_frame();
+            frame_dt_   = dt;
+            frame_open_ = true;
+            return dt;
+        }
+
+        if (mode_ != Mode::replay || finished_)
+            return dt;
+
+        replayed_.clear();
+        FrameHeader frame {};
+        if (input_.size() - read_offset_ < sizeof(frame))
+        {
+            finish_replay();
+            return dt;
+        }
+        std::memcpy(&frame, input_.data() + read_offset_, sizeof(frame));
+        read_offset_ += sizeof(frame);
+
+        // The strings point into input_, which stays untouched until the recorder goes away.
+        auto read_string = [this](const char*& text) -> bool
+        {
+            uint32_t length = 0;
+            if (input_.size() - read_offset_ < sizeof(length))
+                return false;
+            std::memcpy(&length, input_.data() + read_offset_, sizeof(length));
+            read_offset_ += sizeof(length);
+            if (length == null_string)
+            {
+                text = nullptr;
+                return true;
+            }
+            if (input_.size() - read_offset_ < size_t(length) + 1)
+                return false;
+            text = input_.data() + read_offset_;
+            read_offset_ += size_t(length) + 1;
+            return true;
+        };
+
+        for (uint32_t i = 0; i < frame.event_count; ++i)
+        {
+            SDL_Event event;
+            bool      complete = input_.size() - read_offset_ >= sizeof(event);
+            if (complete)
+            {
+                std::memcpy(&event, input_.data() + read_offset_, sizeof(event));
+                read_offset_ += sizeof(event);
+                if (is_text_event(event.type))
+                    complete = read_string(event.type == SDL_EVENT_TEXT_INPUT ? event.text.text : event.edit.text);
+                else if (is_drop_event(event.type))
+                    complete = read_string(event.drop.source) && read_string(event.drop.data);
+            }
+            if (!complete)
+            {
+                APPLOG_WARNING("Input replay is truncated at frame {}", frame_count_);
+                replayed_.clear();
+                finish_replay();
+                return dt;
+            }
+            // Recordings of older builds hold them; the live ones already describe the real windows.
+            if (!is_system_event(event.type))
+                replayed_.push_back(event);
+        }
+
+        // Frame n started dt_1 + ... + dt_n after the first one when it was recorded, wait until then.
+        if (frame_count_++ == 0)
+            start_ns_ = SDL_GetTicksNS();
+        else
+            scheduled_ns_ += static_cast<uint64_t>(static_cast<double>(frame.delta_time) * SDL_NS_PER_SECOND);
+        if (!fast_)
+        {
+            uint64_t now    = SDL_GetTicksNS();
+            uint64_t target = start_ns_ + scheduled_ns_;
+            if (now < target)
+                SDL_DelayNS(target - now);
+        }
+        return frame.delta_time;
+    }
+
+    bool InputRecorder::accept_live_event(const SDL_Event& event)
+    {
+        if (mode_ == Mode::replay && !finished_)
+            return is_system_event(event.type);
+
+        if (mode_ == Mode::record && frame_open_ && !is_unrecordable(event.type) && !is_system_event(event.type))
+        {
+            append(frame_bytes_, &event, sizeof(event));
+            if (is_text_event(event.type))
+                append_string(frame_bytes_, event.type == SDL_EVENT_TEXT_INPUT ? event.text.text : event.edit.text);
+            else if (is_drop_event(event.type))
+            {
+                append_string(frame_bytes_, event.drop.source);
+                append_string(frame_bytes_, event.drop.data);
+            }
+            ++frame_events_;
+        }
+        return true;
+    }
+
+    void InputRecorder::write_frame()
+    {
+        FrameHeader frame {frame_events_, frame_dt_};
+        output_.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        output_.write(frame_bytes_.data(), static_cast<std::streamsize>(frame_bytes_.size()));
+        frame_bytes_.clear();
+        frame_events_ = 0;
+    }
+
+    void InputRecorder::finish_replay()
+    {
+        finished_ = true;
+
+        double elapsed  = frame_count_ ? static_cast<double>(SDL_GetTicksNS() - start_ns_) / SDL_NS_PER_SECOND : 0.0;
+        double recorded = static_cast<double>(scheduled_ns_) / SDL_NS_PER_SECOND;
+        APPLOG_INFO("Input replay finished: {} frames in {:.3f} s (recorded {:.3f} s), {:.3f} ms per frame", frame_count_, elapsed,
+                    recorded, frame_count_ ? elapsed * 1000.0 / static_cast<double>(frame_count_) : 0.0);
+    }
+} // namespace core
@@ -0,0 +1,90 @@
+#pragma once
+#include <SDL3/SDL_events.h>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    // Records the SDL events and delta time of every App frame to a binary file (--record-input <file>)
+    // or plays such a file back in place of live input (--replay-input <file>). Replay keeps the recorded
+    // pacing unless --replay-fast is given, the recorded delta times are used either way.
+    //
+    // File layout: FileHeader, then per frame a FrameHeader followed by event_count raw SDL_Event structs.
+    // Text and drop events carry their strings inline after the event as a uint32_t length and the
+    // NUL terminated bytes; other pointer payloads (clipboard, IME candidates, user events) are not recorded.
+    // Neither are application, display and window events: they describe the real windows, which during a
+    // replay report their own.
+    class InputRecorder
+    {
+    public:
+        enum class Mode
+        {
+            off,
+            record,
+            replay
+        };
+
+        InputRecorder();
+        ~InputRecorder();
+
+        [[nodiscard]] Mode get_mode() const noexcept { return mode_; }
+
+        // Starts a frame. Recording writes out the previous frame; replay loads the next one, waits for its
+        // recorded start time and returns its delta time in place of dt.
+        float begin_frame(float dt);
+
+        // Recording: appends a live event to the current frame. Replay: returns false for live input, only
+        // application (quit, lifecycle), display and window events of the real windows still get through.
+        bool accept_live_event(const SDL_Event& event);
+
+        // Events of the frame being replayed, valid until the next begin_frame().
+        [[nodiscard]] std::span<SDL_Event> get_replayed_events() noexcept { return replayed_; }
+
+        // True once the replay ran past the last recorded frame.
+        [[nodiscard]] bool is_finished() const noexcept { return finished_; }
+
+    private:
+        struct FileHeader
+        {
+            char     magic[4];
+            uint32_t version;
+            uint32_t event_size;
+        };
+
+        struct FrameHeader
+        {
+            uint32_t event_count;
+            float    delta_time;
+        };
+
+        void open_recording(const std::string& path);
+        void open_replay(const std::string& path);
+        void write_frame();
+        void finish_replay();
+
+        Mode mode_ = Mode::off;
+
+        // Recording
+        std::ofstream     output_;
+        std::vector<char> frame_bytes_;
+        uint32_t          frame_events_ = 0;
+        float             frame_dt_     = 0.0f;
+        bool              frame_open_   = false;
+
+        // Replay
+        std::vector<char>      input_;
+        size_t                 read_offset_ = 0;
+        std::vector<SDL_Event> replayed_;
+        bool                   fast_         = false;
+        bool                   finished_     = false;
+        uint64_t               start_ns_     = 0;
+        uint64_t               scheduled_ns_ = 0;
+        uint64_t               frame_count_  = 0;
+
+        static constexpr char     magic_[4] = {'C', 'I', 'N', 'P'};
+        static constexpr uint32_t version_  = 1;
+    };
+} // namespace core
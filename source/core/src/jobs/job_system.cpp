@@ -0,0 +1,122 @@
+#include "job_system.h"
+#include "memory/memory_tracker.h"
+
+namespace core
+{
+    JobSystem::JobSystem(size_t worker_count)
+    {
+        if (worker_count == 0)
+        {
+            const size_t hardware = std::thread::hardware_concurrency();
+            worker_count          = hardware > 1 ? hardware - 1 : 1;
+        }
+
+        workers_.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            workers_.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void JobSystem::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func)
+    {
+        if (count == 0)
+            return;
+
+        grain                    = std::max<size_t>(grain, 1);
+        const size_t chunk_count = (count + grain - 1) / grain;
+        if (chunk_count == 1 || workers_.empty())
+        {
+            func(0, count);
+            return;
+        }
+
+        // Workers and the caller pull chunks from a shared counter, so uneven chunks balance themselves.
+        std::atomic<size_t> next_chunk {0};
+        auto                run_chunks = [&]() {
+            for (size_t chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++)
+            {
+                const size_t begin = chunk * grain;
+                func(begin, std::min(begin + grain, count));
+            }
+        };
+
+        const size_t                   helper_count = std::min(workers_.size(), chunk_count - 1);
+        std::vector<std::future<void>> helpers;
+        helpers.reserve(helper_count);
+        for (size_t i = 0; i < helper_count; ++i)
+        {
+            helpers.push_back(submit(run_chunks));
+        }
+
+        run_chunks();
+        for (auto& helper : helpers)
+        {
+            // Helpers may still sit in the queue behind other work (or behind us, when called from a worker): run jobs while waiting.
+            while (helper.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                if (!run_pending_job())
+                    std::this_thread::yield();
+            }
+            helper.get();
+        }
+    }
+
+    bool JobSystem::run_pending_job()
+    {
+        Job job;
+        {
+            std::lock_guard lock(mutex_);
+            if (queue_.empty())
+                return false;
+
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        MemoryScope scope(job.memory_tag);
+        job.func();
+        return true;
+    }
+
+    void JobSystem::enqueue(std::function<void()> job)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(Job {std::move(job), MemoryTracker::get_current_tag()});
+        }
+        condition_.notify_one();
+    }
+
+    void JobSystem::worker_loop()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock lock(mutex_);
+                condition_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (stopping_ && queue_.empty())
+                    return;
+
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            MemoryScope scope(job.memory_tag);
+            job.func();
+        }
+    }
+} // namespace core
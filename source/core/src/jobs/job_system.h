@@ -0,0 +1,69 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace core
+{
+    // Fixed pool of worker threads shared by every subsystem that needs background or parallel work.
+    class JobSystem
+    {
+    public:
+        // worker_count == 0 picks one worker per hardware thread, minus the main thread.
+        explicit JobSystem(size_t worker_count = 0);
+        ~JobSystem();
+
+        template<typename Func>
+        auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>>;
+
+        // Splits [0, count) into chunks of at least grain items and runs func(begin, end) on them,
+        // the calling thread included. Returns once every chunk is done.
+        void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func);
+
+        [[nodiscard]] size_t get_worker_count() const noexcept { return workers_.size(); }
+
+    private:
+        // Jobs run under the memory tag of the code that submitted them.
+        struct Job
+        {
+            std::function<void()> func;
+            uint16_t              memory_tag = 0;
+        };
+
+        void enqueue(std::function<void()> job);
+        bool run_pending_job();
+        void worker_loop();
+
+        std::vector<std::thread> workers_;
+        std::deque<Job>          queue_;
+        std::mutex               mutex_;
+        std::condition_variable  condition_;
+        bool                     stopping_ = false;
+    };
+
+    template<typename Func>
+    auto JobSystem::submit(Func&& func) -> std::future<std::invoke_result_t<Func>>
+    {
+        using Result = std::invoke_result_t<Func>;
+
+        auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        auto future = task->get_future();
+        if (workers_.empty())
+        {
+            (*task)();
+            return future;
+        }
+
+        enqueue([task]() { (*task)(); });
+        return future;
+    }
+} // namespace core
@@ -0,0 +1,91 @@
+#include "task.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace core
+{
+    namespace
+    {
+        constexpr size_t class_count  = std::countr_zero(TaskFramePool::max_block_size / TaskFramePool::min_block_size) + 1;
+        constexpr size_t max_retained = 256; // Free blocks kept per class, more go back to the heap
+
+        struct FreeLists
+        {
+            std::mutex                                  mutex;
+            std::array<std::vector<void*>, class_count> blocks;
+
+            // Reserved up front, so deallocate() never allocates.
+            FreeLists()
+            {
+                for (auto& list : blocks)
+                    list.reserve(max_retained);
+            }
+
+            ~FreeLists()
+            {
+                for (size_t i = 0; i < class_count; ++i)
+                {
+                    for (void* block : blocks[i])
+                        ::operator delete(block, TaskFramePool::min_block_size << i);
+                }
+            }
+        };
+
+        // Function local, so it is constructed on first use whatever the static initialization order.
+        FreeLists& get_free_lists()
+        {
+            static FreeLists lists;
+            return lists;
+        }
+
+        size_t get_class(size_t size) noexcept
+        {
+            return static_cast<size_t>(std::countr_zero(std::bit_ceil(std::max(size, TaskFramePool::min_block_size)))) -
+                   std::countr_zero(TaskFramePool::min_block_size);
+        }
+    } // namespace
+
+    void* TaskFramePool::allocate(size_t size)
+    {
+        if (size > max_block_size)
+            return ::operator new(size);
+
+        const size_t index = get_class(size);
+        {
+            FreeLists&      lists = get_free_lists();
+            std::lock_guard lock(lists.mutex);
+            if (!lists.blocks[index].empty())
+            {
+                void* block = lists.blocks[index].back();
+                lists.blocks[index].pop_back();
+                return block;
+            }
+        }
+        return ::operator new(min_block_size << index);
+    }
+
+    void TaskFramePool::deallocate(void* ptr, size_t size) noexcept
+    {
+        if (size > max_block_size)
+        {
+            ::operator delete(ptr, size);
+            return;
+        }
+
+        const size_t index = get_class(size);
+        {
+            FreeLists&      lists = get_free_lists();
+            std::lock_guard lock(lists.mutex);
+            if (lists.blocks[index].size() < max_retained)
+            {
+                lists.blocks[index].push_back(ptr);
+                return;
+            }
+        }
+        ::operator delete(ptr, min_block_size << index);
+    }
+} // namespace core
@@ -0,0 +1,145 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace core
+{
+    // Recycles coroutine frames by power of two size classes, so tasks started every frame do not go to the
+    // heap. Frames above max_block_size use operator new. Any thread.
+    class TaskFramePool
+    {
+    public:
+        static constexpr size_t min_block_size = 128;
+        static constexpr size_t max_block_size = 8192;
+
+        static void* allocate(size_t size);
+        static void  deallocate(void* ptr, size_t size) noexcept;
+    };
+
+    template<typename T = void>
+    class Task;
+
+    namespace details
+    {
+        struct TaskPromiseBase
+        {
+            // Symmetric transfer back to whoever awaited the task, nothing for a task the scheduler owns.
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    return handle.promise().continuation;
+                }
+                void await_resume() const noexcept {}
+            };
+
+            static void* operator new(size_t size) { return TaskFramePool::allocate(size); }
+            static void  operator delete(void* ptr, size_t size) noexcept { TaskFramePool::deallocate(ptr, size); }
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter        final_suspend() const noexcept { return {}; }
+            // The codebase does not use exceptions; one escaping a task is a bug.
+            void unhandled_exception() const noexcept { std::terminate(); }
+
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase
+        {
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& value)
+            {
+                result.emplace(std::forward<U>(value));
+            }
+            T take() { return std::move(*result); }
+
+            std::optional<T> result;
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase
+        {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept {}
+            void take() const noexcept {}
+        };
+    } // namespace details
+
+    // Coroutine that starts when first awaited, either by another Task or by TaskScheduler::spawn(), and
+    // destroys its frame with the Task object. Awaiting one runs it until it finishes and yields its result:
+    //
+    //     Task<Index> build_index(std::string path)
+    //     {
+    //         auto& tasks = get_subsystem<TaskScheduler>();
+    //         auto  data  = co_await tasks.load(path);
+    //         Index index = co_await tasks.run_job([data]() { return Index::build(data); });
+    //         co_await tasks.next(TaskPhase::update);
+    //         co_return index;
+    //     }
+    template<typename T>
+    class [[nodiscard]] Task
+    {
+    public:
+        using promise_type = details::TaskPromise<T>;
+        using Handle       = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+        explicit Task(Handle handle) noexcept : handle_(handle) {}
+        Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle_)
+                    handle_.destroy();
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        }
+        ~Task()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        [[nodiscard]] bool is_valid() const noexcept { return static_cast<bool>(handle_); }
+        [[nodiscard]] bool is_done() const noexcept { return !handle_ || handle_.done(); }
+
+        bool                    await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle_.promise().continuation = awaiting;
+            return handle_;
+        }
+        T await_resume() { return handle_.promise().take(); }
+
+        // Gives up ownership of the frame, see TaskScheduler::spawn().
+        Handle release() noexcept { return std::exchange(handle_, nullptr); }
+
+    private:
+        Handle handle_;
+    };
+
+    namespace details
+    {
+        template<typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept
+        {
+            return Task<T>(Task<T>::Handle::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept
+        {
+            return Task<void>(Task<void>::Handle::from_promise(*this));
+        }
+    } // namespace details
+} // namespace core
@@ -0,0 +1,121 @@
+#include "task_scheduler.h"
+#include "asset/asset_system.h"
+#include "logger.h"
+#include <algorithm>
+
+namespace core
+{
+    TaskScheduler::TaskScheduler()
+    {
+        connect<FrameBegin, TaskScheduler, &TaskScheduler::frame_begin>(*this);
+        connect<FrameUpdate, TaskScheduler, &TaskScheduler::frame_update>(*this);
+        connect<FrameRender, TaskScheduler, &TaskScheduler::frame_render>(*this);
+        connect<FrameEnd, TaskScheduler, &TaskScheduler::frame_end>(*this);
+        connect<AssetLoaded, TaskScheduler, &TaskScheduler::asset_loaded>(*this);
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        disconnect(*this);
+        // Timers outlives the scheduler, its callbacks must not.
+        for (const auto& [address, timer] : delays_)
+            get_subsystem<Timers>().cancel(timer);
+        if (!tasks_.empty())
+            APPLOG_INFO("[tasks] Destroying {} unfinished tasks", tasks_.size());
+
+        // Jobs may still write into the frames of the tasks awaiting them.
+        for (PendingPoll& pending : polls_)
+            pending.poll->drain();
+        // Destroying a task's frame destroys the Tasks it awaits with it.
+        for (Task<>::Handle task : tasks_)
+            task.destroy();
+    }
+
+    void TaskScheduler::spawn(Task<> task)
+    {
+        if (!task.is_valid())
+        {
+            APPLOG_WARNING("[tasks] spawn() got an empty task");
+            return;
+        }
+
+        Task<>::Handle handle = task.release();
+        tasks_.push_back(handle);
+        handle.resume();
+        if (handle.done())
+        {
+            std::erase(tasks_, handle);
+            handle.destroy();
+        }
+    }
+
+    void TaskScheduler::request_asset(const std::string& path, Handle handle, std::span<const std::byte>& data)
+    {
+        const uint64_t request = get_subsystem<AssetSystem>().request(path);
+        assets_[request]       = {handle, &data};
+    }
+
+    // Timers runs before the scheduler at FrameBegin, so a due task resumes in that same FrameBegin.
+    void TaskScheduler::add_delay(float seconds, Handle handle)
+    {
+        const auto delay = std::chrono::duration_cast<Timers::Clock::duration>(std::chrono::duration<float>(std::max(seconds, 0.0f)));
+        delays_[handle.address()] = get_subsystem<Timers>().schedule(
+            delay,
+            [this, handle]() {
+                delays_.erase(handle.address());
+                ready_.push_back(handle);
+            },
+            TimerPhase::begin);
+    }
+
+    void TaskScheduler::resume(std::vector<Handle>& handles)
+    {
+        if (handles.empty())
+            return;
+
+        // Swapped out, so tasks queueing themselves again land in the list for next time.
+        resuming_.swap(handles);
+        for (Handle handle : resuming_)
+            handle.resume();
+        resuming_.clear();
+
+        std::erase_if(tasks_, [](Task<>::Handle task) {
+            if (!task.done())
+                return false;
+            task.destroy();
+            return true;
+        });
+    }
+
+    void TaskScheduler::frame_begin(const FrameBegin&)
+    {
+        // ready_ already holds the tasks whose assets arrived in AssetLoaded and whose delays ran out earlier in
+        // this FrameBegin.
+        std::erase_if(polls_, [this](const PendingPoll& pending) {
+            if (!pending.poll->ready())
+                return false;
+            ready_.push_back(pending.handle);
+            return true;
+        });
+
+        resume(ready_);
+        resume(phases_[static_cast<size_t>(TaskPhase::begin)]);
+    }
+
+    void TaskScheduler::frame_update(const FrameUpdate&) { resume(phases_[static_cast<size_t>(TaskPhase::update)]); }
+
+    void TaskScheduler::frame_render(const FrameRender&) { resume(phases_[static_cast<size_t>(TaskPhase::render)]); }
+
+    void TaskScheduler::frame_end(const FrameEnd&) { resume(phases_[static_cast<size_t>(TaskPhase::end)]); }
+
+    void TaskScheduler::asset_loaded(const AssetLoaded& event)
+    {
+        const auto it = assets_.find(event.request);
+        if (it == assets_.end())
+            return;
+
+        *it->second.data = event.found ? event.data : std::span<const std::byte> {};
+        ready_.push_back(it->second.handle);
+        assets_.erase(it);
+    }
+} // namespace core
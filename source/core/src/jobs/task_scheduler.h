@@ -0,0 +1,199 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/asset_event.h"
+#include "event/frame_event.h"
+#include "jobs/job_system.h"
+#include "jobs/task.h"
+#include "system/timers.h"
+#include "vulkan/vulkan.h"
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <future>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace core
+{
+    // Frame events a task can wait for, in the order they happen.
+    enum class TaskPhase : uint8_t
+    {
+        begin,
+        update,
+        render,
+        end,
+        count,
+    };
+
+    // Runs Tasks on the main thread, spread over frames.
+    //
+    // Tasks only ever resume from the scheduler's frame event handlers, so their code runs between the
+    // other subsystems' handlers like any FrameUpdate code and needs no locking. What they wait for:
+    // - next(phase): the next FrameBegin, FrameUpdate, FrameRender or FrameEnd
+    // - delay(seconds): a Timers timer, resumed at the FrameBegin it is due in
+    // - load(path): an AssetSystem request, resumed at the FrameBegin after AssetLoaded
+    // - run_job(func): func on a JobSystem worker, yielding its result
+    // - wait(future), wait_fence(device, fence), until(predicate): polled at FrameBegin
+    // Frames in which no window renders have no frame events, so tasks pause with them.
+    //
+    // Every call here is main thread only.
+    class TaskScheduler : public EventSubscriber
+    {
+        struct Poll;
+
+    public:
+        TaskScheduler();
+        ~TaskScheduler();
+
+        // Takes the task over and runs it until its first suspension; its frame is freed once it finishes.
+        void spawn(Task<> task);
+
+        [[nodiscard]] size_t get_task_count() const noexcept { return tasks_.size(); }
+
+        auto next(TaskPhase phase = TaskPhase::update) noexcept
+        {
+            struct Awaiter
+            {
+                TaskScheduler& scheduler;
+                TaskPhase      phase;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { scheduler.phases_[static_cast<size_t>(phase)].push_back(handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter {*this, phase};
+        }
+
+        auto delay(float seconds) noexcept
+        {
+            struct Awaiter
+            {
+                TaskScheduler& scheduler;
+                float          seconds;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { scheduler.add_delay(seconds, handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter {*this, seconds};
+        }
+
+        // Yields the asset's data, empty when it was not found (see AssetSystem::request()).
+        auto load(std::string path)
+        {
+            struct Awaiter
+            {
+                TaskScheduler&             scheduler;
+                std::string                path;
+                std::span<const std::byte> data;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { scheduler.request_asset(path, handle, data); }
+                std::span<const std::byte> await_resume() const noexcept { return data; }
+            };
+            return Awaiter {*this, std::move(path), {}};
+        }
+
+        // Polls until the future is ready and yields its value.
+        template<typename T>
+        auto wait(std::future<T> future)
+        {
+            struct Awaiter : Poll
+            {
+                TaskScheduler& scheduler;
+                std::future<T> future;
+
+                Awaiter(TaskScheduler& scheduler, std::future<T> future) : scheduler(scheduler), future(std::move(future)) {}
+
+                bool ready() override { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+                void drain() override { future.wait(); }
+
+                bool await_ready() { return ready(); }
+                void await_suspend(std::coroutine_handle<> handle) { scheduler.add_poll(*this, handle); }
+                T    await_resume() { return future.get(); }
+            };
+            return Awaiter {*this, std::move(future)};
+        }
+
+        // Runs func on a JobSystem worker; the task resumes on the main thread with its result.
+        template<typename Func>
+        auto run_job(Func&& func)
+        {
+            return wait(get_subsystem<JobSystem>().submit(std::forward<Func>(func)));
+        }
+
+        // Polls predicate() once per frame until it returns true.
+        template<typename Func>
+        auto until(Func predicate)
+        {
+            struct Awaiter : Poll
+            {
+                TaskScheduler& scheduler;
+                Func           predicate;
+
+                Awaiter(TaskScheduler& scheduler, Func predicate) : scheduler(scheduler), predicate(std::move(predicate)) {}
+
+                bool ready() override { return predicate(); }
+
+                bool await_ready() { return ready(); }
+                void await_suspend(std::coroutine_handle<> handle) { scheduler.add_poll(*this, handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter {*this, std::move(predicate)};
+        }
+
+        // Polls until the fence is signaled, e.g. for readbacks or uploads submitted by the caller.
+        auto wait_fence(VkDevice device, VkFence fence)
+        {
+            return until([device, fence]() { return vkGetFenceStatus(device, fence) != VK_NOT_READY; });
+        }
+
+        void frame_begin(const FrameBegin& event);
+        void frame_update(const FrameUpdate& event);
+        void frame_render(const FrameRender& event);
+        void frame_end(const FrameEnd& event);
+        void asset_loaded(const AssetLoaded& event);
+
+    private:
+        using Handle = std::coroutine_handle<>;
+
+        // Awaiter that is checked every frame; lives in the suspended coroutine's frame.
+        struct Poll
+        {
+            virtual ~Poll()      = default;
+            virtual bool ready() = 0;
+            // Blocks until ready(), for shutdown: jobs may still reference the task's frame.
+            virtual void drain() {}
+        };
+
+        struct PendingPoll
+        {
+            Poll*  poll;
+            Handle handle;
+        };
+
+        struct AssetWait
+        {
+            Handle                      handle;
+            std::span<const std::byte>* data;
+        };
+
+        void add_poll(Poll& poll, Handle handle) { polls_.push_back({&poll, handle}); }
+        void add_delay(float seconds, Handle handle);
+        void request_asset(const std::string& path, Handle handle, std::span<const std::byte>& data);
+        // Resumes handles and frees the tasks that finished; handles queued meanwhile wait for the next time.
+        void resume(std::vector<Handle>& handles);
+
+        std::vector<Task<>::Handle>                                            tasks_;
+        std::array<std::vector<Handle>, static_cast<size_t>(TaskPhase::count)> phases_;
+        std::unordered_map<void*, Timers::TimerId>                             delays_; // By the waiting coroutine's address
+        std::vector<PendingPoll>                                               polls_;
+        std::unordered_map<uint64_t, AssetWait>                                assets_; // By AssetSystem request
+        std::vector<Handle>                                                    ready_;  // Resumed at the next FrameBegin
+        std::vector<Handle>                                                    resuming_;
+    };
+} // namespace core
@@ -0,0 +1,68 @@
+#include "log_ring.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace core
+{
+    LogRing::LogRing(size_t capacity) : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+    {
+        slots_ = std::make_unique<Slot[]>(mask_ + 1);
+    }
+
+    void LogRing::push(spdlog::level::level_enum level, int64_t time_ns, uint32_t thread_id, std::string_view text) noexcept
+    {
+        const uint64_t ticket = write_index_.fetch_add(1, std::memory_order_relaxed);
+        Slot&          slot   = slots_[ticket & mask_];
+
+        slot.sequence.store(ticket * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const size_t length = std::min(text.size(), LogRecord::text_capacity);
+        slot.time_ns        = time_ns;
+        slot.thread_id      = thread_id;
+        slot.length         = static_cast<uint16_t>(length);
+        slot.level          = static_cast<uint8_t>(level);
+        std::memcpy(slot.text, text.data(), length);
+
+        slot.sequence.store(ticket * 2 + 2, std::memory_order_release);
+    }
+
+    bool LogRing::read(uint64_t ticket, LogRecord& out) const noexcept
+    {
+        const Slot&    slot   = slots_[ticket & mask_];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != ticket * 2 + 2)
+            return false;
+
+        out.ticket    = ticket;
+        out.time_ns   = slot.time_ns;
+        out.thread_id = slot.thread_id;
+        out.level     = static_cast<spdlog::level::level_enum>(slot.level);
+        out.length    = std::min<uint16_t>(slot.length, LogRecord::text_capacity);
+        std::memcpy(out.text, slot.text, out.length);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == before;
+    }
+
+    uint64_t LogRing::get_published(uint64_t from) const noexcept
+    {
+        const uint64_t end    = get_write_index();
+        uint64_t       ticket = std::max(from, get_oldest());
+        while (ticket < end)
+        {
+            // A newer ticket in the slot means ours was published and already overwritten.
+            if (slots_[ticket & mask_].sequence.load(std::memory_order_acquire) < ticket * 2 + 2)
+                break;
+            ++ticket;
+        }
+        return ticket;
+    }
+
+    uint64_t LogRing::get_oldest() const noexcept
+    {
+        const uint64_t end = get_write_index();
+        return end > mask_ + 1 ? end - (mask_ + 1) : 0;
+    }
+} // namespace core
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <spdlog/common.h>
+#include <string_view>
+
+namespace core
+{
+    // One record as read back from the ring.
+    struct LogRecord
+    {
+        static constexpr size_t text_capacity = 232;
+
+        uint64_t                  ticket    = 0;
+        int64_t                   time_ns   = 0;
+        uint32_t                  thread_id = 0;
+        spdlog::level::level_enum level     = spdlog::level::info;
+        uint16_t                  length    = 0;
+        char                      text[text_capacity];
+
+        [[nodiscard]] std::string_view get_text() const noexcept { return {text, length}; }
+    };
+
+    // Fixed-size, lock-free ring of log records. Writers claim a ticket with one fetch_add and
+    // publish the slot through its sequence number; nothing ever blocks and memory never grows.
+    // The oldest records are overwritten once the ring wraps, readers detect that (and torn reads)
+    // by checking the slot sequence around their copy, seqlock style. Text longer than
+    // LogRecord::text_capacity is truncated.
+    class LogRing
+    {
+    public:
+        // capacity is rounded up to a power of two.
+        explicit LogRing(size_t capacity);
+
+        void push(spdlog::level::level_enum level, int64_t time_ns, uint32_t thread_id, std::string_view text) noexcept;
+
+        // False if ticket has not been published yet or was overwritten meanwhile.
+        bool read(uint64_t ticket, LogRecord& out) const noexcept;
+
+        // First ticket at or after from that is not published yet; every ticket before it is readable
+        // unless overwritten.
+        [[nodiscard]] uint64_t get_published(uint64_t from) const noexcept;
+        // Oldest ticket that has not been overwritten by construction of the ring size.
+        [[nodiscard]] uint64_t get_oldest() const noexcept;
+        [[nodiscard]] uint64_t get_write_index() const noexcept { return write_index_.load(std::memory_order_relaxed); }
+        [[nodiscard]] size_t   get_capacity() const noexcept { return mask_ + 1; }
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> sequence {0}; // 2 * ticket + 1 while written, 2 * ticket + 2 once published
+            int64_t               time_ns   = 0;
+            uint32_t              thread_id = 0;
+            uint16_t              length    = 0;
+            uint8_t               level     = 0;
+            char                  text[LogRecord::text_capacity];
+        };
+        static_assert(sizeof(Slot) == 256, "Log ring slots should stay four cache lines");
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t                  mask_;
+        alignas(64) std::atomic<uint64_t> write_index_ {0};
+    };
+} // namespace core
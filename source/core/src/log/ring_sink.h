@@ -0,0 +1,32 @@
+#pragma once
+#include "log_ring.h"
+#include <chrono>
+#include <memory>
+#include <spdlog/sinks/sink.h>
+
+namespace core
+{
+    // spdlog sink feeding a LogRing. It stores the raw payload and metadata without formatting or
+    // locking; the in-app viewer formats records when they are displayed.
+    class RingSink final : public spdlog::sinks::sink
+    {
+    public:
+        explicit RingSink(size_t capacity) : ring_(capacity) {}
+
+        void log(const spdlog::details::log_msg& msg) override
+        {
+            const auto time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count();
+            ring_.push(msg.level, time_ns, static_cast<uint32_t>(msg.thread_id), std::string_view(msg.payload.data(), msg.payload.size()));
+        }
+
+        void flush() override {}
+        void set_pattern(const std::string&) override {}
+        void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+
+        [[nodiscard]] LogRing&       get_ring() noexcept { return ring_; }
+        [[nodiscard]] const LogRing& get_ring() const noexcept { return ring_; }
+
+    private:
+        LogRing ring_;
+    };
+} // namespace core
@@ -1,31 +1,32 @@
 ﻿#include "Logger.h"
+#include "log/ring_sink.h"
 #include <mutex>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace core
 {
-    std::shared_ptr<spdlog::logger> Logger::logger = nullptr;
+    std::shared_ptr<spdlog::logger> Logger::logger   = nullptr;
+    std::shared_ptr<RingSink>       Logger::ringSink = nullptr;
     static std::once_flag           initFlag;
 
-    void Logger::init(bool logToFile, const std::string& logFilePath, spdlog::level::level_enum logLevel)
+    void Logger::init(bool logToFile, const std::string& logFilePath, spdlog::level::level_enum logLevel, size_t ringSize)
     {
         std::call_once(initFlag, [&]() {
             auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
             console_sink->set_level(logLevel);
 
+            ringSink = std::make_shared<RingSink>(ringSize);
+            ringSink->set_level(logLevel);
+
+            std::vector<spdlog::sink_ptr> sinks = {console_sink, ringSink};
             if (logToFile)
             {
                 auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath, true);
                 file_sink->set_level(logLevel);
-
-                std::vector<spdlog::sink_ptr> sinks = {console_sink, file_sink};
-                logger                              = std::make_shared<spdlog::logger>("Logger", sinks.begin(), sinks.end());
-            }
-            else
-            {
-                logger = std::make_shared<spdlog::logger>("Logger", console_sink);
+                sinks.push_back(file_sink);
             }
+            logger = std::make_shared<spdlog::logger>("Logger", sinks.begin(), sinks.end());
 
             logger->set_level(logLevel);
         });
@@ -40,6 +41,15 @@ namespace core
         return logger;
     }
 
+    LogRing& Logger::getRing()
+    {
+        if (!ringSink)
+        {
+            init();
+        }
+        return ringSink->get_ring();
+    }
+
     void Logger::setLogLevel(spdlog::level::level_enum level)
     {
         if (logger)
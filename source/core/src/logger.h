@@ -4,16 +4,27 @@
 
 namespace core
 {
+    class LogRing;
+    class RingSink;
+
     class Logger
     {
     public:
-        static void
-        init(bool logToFile = false, const std::string& logFilePath = "logs.txt", spdlog::level::level_enum logLevel = spdlog::level::info);
+        static constexpr size_t default_ring_size = 131072;
+
+        // Only the first call configures the logger; logging before it uses the defaults.
+        static void                            init(bool                      logToFile   = false,
+                                                    const std::string&        logFilePath = "logs.txt",
+                                                    spdlog::level::level_enum logLevel    = spdlog::level::info,
+                                                    size_t                    ringSize    = default_ring_size);
         static std::shared_ptr<spdlog::logger> get();
         static void                            setLogLevel(spdlog::level::level_enum level);
+        // In-memory ring of recent records, read by the log viewer panel.
+        static LogRing& getRing();
 
     private:
         static std::shared_ptr<spdlog::logger> logger;
+        static std::shared_ptr<RingSink>       ringSink;
     };
 
 #define APPLOG_INFO(...) Logger::get()->info(__VA_ARGS__)
@@ -0,0 +1,163 @@
+#include "frame_arena.h"
+#include "cmd_line/parser.hpp"
+#include "logger.h"
+#include <algorithm>
+#include <bit>
+#include <new>
+
+namespace core
+{
+    static constexpr size_t buffer_alignment = 64;
+    // Threads bump inside private chunks; only refills touch the shared buffer offset.
+    static constexpr size_t chunk_size = 16 * 1024;
+
+    namespace
+    {
+        struct ThreadCursor
+        {
+            uint64_t   arena = 0;
+            uint64_t   frame = 0;
+            std::byte* ptr   = nullptr;
+            std::byte* end   = nullptr;
+        };
+
+        std::atomic<uint64_t>     next_arena_id {1};
+        thread_local ThreadCursor cursor;
+    } // namespace
+
+    static std::byte* align_up(std::byte* ptr, size_t alignment)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(ptr);
+        return ptr + ((alignment - address % alignment) % alignment);
+    }
+
+    static std::byte* allocate_buffer(size_t capacity)
+    {
+        return static_cast<std::byte*>(::operator new(capacity, std::align_val_t(buffer_alignment)));
+    }
+
+    FrameArena::FrameArena() : id_(next_arena_id++)
+    {
+        const auto& parser = Parser::instance();
+        const auto  size   = std::stoul(parser.getOptionValue("frame-arena-size", "1024")) * 1024;
+        // A single buffer would be reset while the frame that filled it still runs its FrameEnd handlers.
+        buffer_count_ = std::clamp<size_t>(std::stoul(parser.getOptionValue("frame-arena-buffers", "2")), 2, 3);
+
+        buffers_ = std::make_unique<Buffer[]>(buffer_count_);
+        for (size_t i = 0; i < buffer_count_; ++i)
+        {
+            buffers_[i].capacity = std::bit_ceil(std::max<size_t>(size, chunk_size));
+            buffers_[i].memory   = allocate_buffer(buffers_[i].capacity);
+        }
+
+        connect<FrameEnd, FrameArena, &FrameArena::frame_end>(*this);
+    }
+
+    FrameArena::~FrameArena()
+    {
+        disconnect(*this);
+        for (size_t i = 0; i < buffer_count_; ++i)
+        {
+            reset(buffers_[i]);
+            ::operator delete(buffers_[i].memory, std::align_val_t(buffer_alignment));
+        }
+    }
+
+    void* FrameArena::allocate(size_t size, size_t alignment)
+    {
+        const uint64_t frame  = frame_.load(std::memory_order_acquire);
+        Buffer&        buffer = buffers_[frame % buffer_count_];
+        size                  = std::max<size_t>(size, 1);
+        if (alignment > buffer_alignment || size > chunk_size / 4)
+            return allocate_shared(buffer, size, alignment);
+
+        if (cursor.arena != id_ || cursor.frame != frame)
+            cursor = ThreadCursor {id_, frame};
+
+        if (cursor.ptr)
+        {
+            std::byte* ptr = align_up(cursor.ptr, alignment);
+            if (ptr + size <= cursor.end)
+            {
+                cursor.ptr = ptr + size;
+                return ptr;
+            }
+        }
+
+        // Chunks are aligned to buffer_alignment, so the allocation goes first without padding.
+        auto* chunk = static_cast<std::byte*>(allocate_shared(buffer, chunk_size, buffer_alignment));
+        cursor.ptr  = chunk + size;
+        cursor.end  = chunk + chunk_size;
+        return chunk;
+    }
+
+    void* FrameArena::allocate_shared(Buffer& buffer, size_t size, size_t alignment)
+    {
+        if (alignment <= buffer_alignment)
+        {
+            size_t offset = buffer.offset.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                const size_t begin = (offset + alignment - 1) / alignment * alignment;
+                if (begin + size > buffer.capacity)
+                    break;
+                if (buffer.offset.compare_exchange_weak(offset, begin + size, std::memory_order_relaxed))
+                    return buffer.memory + begin;
+            }
+        }
+        return allocate_spill(buffer, size, alignment);
+    }
+
+    void* FrameArena::allocate_spill(Buffer& buffer, size_t size, size_t alignment)
+    {
+        alignment           = std::max(alignment, alignof(Spill));
+        const size_t header = (sizeof(Spill) + alignment - 1) / alignment * alignment;
+        auto*        block  = static_cast<std::byte*>(::operator new(header + size, std::align_val_t(alignment)));
+        auto*        spill  = new (block) Spill {buffer.spills.load(std::memory_order_relaxed), alignment};
+        while (!buffer.spills.compare_exchange_weak(spill->next, spill, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        buffer.spilled.fetch_add(header + size, std::memory_order_relaxed);
+        return block + header;
+    }
+
+    void FrameArena::reset(Buffer& buffer)
+    {
+        for (Spill* spill = buffer.spills.exchange(nullptr, std::memory_order_acquire); spill;)
+        {
+            Spill* next = spill->next;
+            ::operator delete(spill, std::align_val_t(spill->alignment));
+            spill = next;
+        }
+        buffer.offset.store(0, std::memory_order_relaxed);
+        buffer.spilled.store(0, std::memory_order_relaxed);
+    }
+
+    size_t FrameArena::get_capacity() const noexcept { return buffers_[frame_.load(std::memory_order_relaxed) % buffer_count_].capacity; }
+
+    void FrameArena::reset_frame()
+    {
+        const uint64_t frame    = frame_.load(std::memory_order_relaxed);
+        Buffer&        finished = buffers_[frame % buffer_count_];
+        finished.last_used      = finished.offset.load(std::memory_order_relaxed) + finished.spilled.load(std::memory_order_relaxed);
+        frame_used_             = finished.last_used;
+        high_water_             = std::max(high_water_, frame_used_);
+
+        // The next buffer was last filled buffer_count_ frames ago; nothing may reference it anymore.
+        // It is grown to fit what either it or the frame just finished needed.
+        Buffer&      next   = buffers_[(frame + 1) % buffer_count_];
+        const size_t wanted = std::max(next.last_used, frame_used_);
+        reset(next);
+        if (wanted > next.capacity)
+        {
+            ::operator delete(next.memory, std::align_val_t(buffer_alignment));
+            next.capacity = std::bit_ceil(wanted);
+            next.memory   = allocate_buffer(next.capacity);
+            APPLOG_INFO("Frame arena buffer grown to {} KiB", next.capacity / 1024);
+        }
+
+        frame_.store(frame + 1, std::memory_order_release);
+    }
+
+    void FrameArena::frame_end(const FrameEnd& event) { reset_frame(); }
+} // namespace core
@@ -0,0 +1,91 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace core
+{
+    // Bump allocator for per-frame transient data. Memory is never freed individually: each frame
+    // allocates from one of several buffers, and a buffer is reset when its turn comes again at
+    // FrameEnd, so whatever a frame allocates stays valid until the end of the next buffer_count - 1
+    // frames. Any thread may allocate (job workers carve private chunks, no lock on the fast path),
+    // but only for work that finishes within that window. A frame that outgrows its buffer spills to
+    // the heap, and the buffer is grown before its next use so the steady state stays heap free.
+    class FrameArena : public EventSubscriber
+    {
+    public:
+        FrameArena();
+        ~FrameArena();
+
+        FrameArena(const FrameArena&)            = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template<typename T>
+        T* allocate_array(size_t count)
+        {
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        // For std::pmr containers; deallocation is a no-op.
+        [[nodiscard]] std::pmr::memory_resource* get_resource() noexcept { return &resource_; }
+
+        // Bytes the last finished frame used, including heap spills, and the peak over all frames.
+        [[nodiscard]] size_t get_frame_used() const noexcept { return frame_used_; }
+        [[nodiscard]] size_t get_high_water() const noexcept { return high_water_; }
+        [[nodiscard]] size_t get_capacity() const noexcept;
+
+        // Ends the arena's frame without a FrameEnd, for loop iterations that render nothing.
+        void reset_frame();
+
+        void frame_end(const FrameEnd& event);
+
+    private:
+        class Resource final : public std::pmr::memory_resource
+        {
+        public:
+            explicit Resource(FrameArena& arena) : arena_(arena) {}
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override { return arena_.allocate(bytes, alignment); }
+            void  do_deallocate(void*, size_t, size_t) override {}
+            bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+            FrameArena& arena_;
+        };
+
+        // Heap allocations of a buffer that ran full, released when the buffer is reset.
+        struct Spill
+        {
+            Spill* next;
+            size_t alignment;
+        };
+
+        struct Buffer
+        {
+            std::byte*          memory   = nullptr;
+            size_t              capacity = 0;
+            std::atomic<size_t> offset {0};
+            std::atomic<size_t> spilled {0};
+            std::atomic<Spill*> spills {nullptr};
+            size_t              last_used = 0;
+        };
+
+        void* allocate_shared(Buffer& buffer, size_t size, size_t alignment);
+        void* allocate_spill(Buffer& buffer, size_t size, size_t alignment);
+        void  reset(Buffer& buffer);
+
+        Resource                  resource_ {*this};
+        uint64_t                  id_;
+        std::unique_ptr<Buffer[]> buffers_;
+        size_t                    buffer_count_ = 2;
+        std::atomic<uint64_t>     frame_ {0};
+        size_t                    frame_used_ = 0;
+        size_t                    high_water_ = 0;
+    };
+} // namespace core
@@ -0,0 +1,30 @@
+#include "memory_reporter.h"
+#include "cmd_line/parser.hpp"
+#include "memory/memory_tracker.h"
+
+namespace core
+{
+    MemoryReporter::MemoryReporter()
+    {
+        interval_ = std::stof(Parser::instance().getOptionValue("memory-log-interval", "60"));
+        connect<FrameEnd, MemoryReporter, &MemoryReporter::frame_end>(*this);
+    }
+
+    MemoryReporter::~MemoryReporter()
+    {
+        MemoryTracker::log_summary();
+        disconnect(*this);
+    }
+
+    void MemoryReporter::frame_end(const FrameEnd& event)
+    {
+        if (interval_ <= 0.0f)
+            return;
+
+        elapsed_ += event.delta_time;
+        if (elapsed_ < interval_)
+            return;
+        elapsed_ = 0.0f;
+        MemoryTracker::log_summary();
+    }
+} // namespace core
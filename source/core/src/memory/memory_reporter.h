@@ -0,0 +1,20 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+
+namespace core
+{
+    // Logs MemoryTracker's summary every --memory-log-interval seconds (0 disables it).
+    class MemoryReporter : public EventSubscriber
+    {
+    public:
+        MemoryReporter();
+        ~MemoryReporter();
+
+        void frame_end(const FrameEnd& event);
+
+    private:
+        float interval_ = 60.0f;
+        float elapsed_  = 0.0f;
+    };
+} // namespace core
@@ -0,0 +1,316 @@
+#include "memory_tracker.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifdef CORE_MEMORY_TRACKING
+#include "imgui.h"
+#include <SDL3/SDL_stdinc.h>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+#endif
+
+namespace core
+{
+#ifdef CORE_MEMORY_TRACKING
+    namespace
+    {
+        struct Counters
+        {
+            char                  name[48];
+            std::atomic<int64_t>  current {0};
+            std::atomic<int64_t>  peak {0};
+            std::atomic<int64_t>  live {0};
+            std::atomic<uint64_t> allocations {0};
+        };
+
+        // In front of every tracked block. offset leads back to what malloc returned.
+        struct alignas(16) Header
+        {
+            uint64_t size;
+            uint32_t offset;
+            uint16_t tag;
+            uint16_t reserved;
+        };
+        static_assert(sizeof(Header) == 16);
+
+        // Constant initialized: operator new can run before any dynamic initializer.
+        Counters              counters[MemoryTracker::max_tags] = {{"Untagged"}, {"ImGui"}, {"SDL"}, {"Vulkan"}};
+        Counters              total                             = {"Total"};
+        std::atomic<uint16_t> tag_count {4};
+        std::mutex            tag_mutex;
+
+        thread_local uint16_t current_tag = MemoryTracker::tag_untagged;
+
+        // malloc alignment on every 64-bit target we build for.
+        constexpr size_t malloc_alignment = 16;
+
+        void update_peak(std::atomic<int64_t>& peak, int64_t value)
+        {
+            int64_t previous = peak.load(std::memory_order_relaxed);
+            while (value > previous && !peak.compare_exchange_weak(previous, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void account(uint16_t tag, int64_t bytes, int64_t blocks)
+        {
+            for (Counters* c : {&counters[tag], &total})
+            {
+                const int64_t current = c->current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+                c->live.fetch_add(blocks, std::memory_order_relaxed);
+                if (bytes > 0)
+                    update_peak(c->peak, current);
+                if (blocks > 0)
+                    c->allocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        Header* get_header(void* ptr) { return static_cast<Header*>(ptr) - 1; }
+
+        void* imgui_allocate(size_t size, void*) { return MemoryTracker::allocate(size, alignof(std::max_align_t), MemoryTracker::tag_imgui); }
+        void  imgui_free(void* ptr, void*) { MemoryTracker::deallocate(ptr); }
+
+        void* SDLCALL sdl_malloc(size_t size) { return MemoryTracker::allocate(size, alignof(std::max_align_t), MemoryTracker::tag_sdl); }
+        void* SDLCALL sdl_calloc(size_t count, size_t size)
+        {
+            void* ptr = MemoryTracker::allocate(count * size, alignof(std::max_align_t), MemoryTracker::tag_sdl);
+            if (ptr)
+                std::memset(ptr, 0, count * size);
+            return ptr;
+        }
+        void* SDLCALL sdl_realloc(void* ptr, size_t size)
+        {
+            // realloc(ptr, 0) keeps a valid block in SDL's contract.
+            return MemoryTracker::reallocate(ptr, std::max<size_t>(size, 1), alignof(std::max_align_t), MemoryTracker::tag_sdl);
+        }
+        void SDLCALL sdl_free(void* ptr) { MemoryTracker::deallocate(ptr); }
+    } // namespace
+
+    void MemoryTracker::install()
+    {
+        ImGui::SetAllocatorFunctions(imgui_allocate, imgui_free);
+        SDL_SetMemoryFunctions(sdl_malloc, sdl_calloc, sdl_realloc, sdl_free);
+    }
+
+    uint16_t MemoryTracker::register_tag(std::string_view name)
+    {
+        std::lock_guard lock(tag_mutex);
+        const uint16_t  count = tag_count.load(std::memory_order_relaxed);
+        name              = name.substr(0, sizeof(Counters::name) - 1);
+        for (uint16_t tag = 0; tag < count; ++tag)
+        {
+            if (name == counters[tag].name)
+                return tag;
+        }
+        if (count == max_tags)
+            return tag_untagged;
+
+        std::memcpy(counters[count].name, name.data(), name.size());
+        counters[count].name[name.size()] = '\0';
+        tag_count.store(count + 1, std::memory_order_release);
+        return count;
+    }
+
+    uint16_t MemoryTracker::register_type_tag(const std::type_info& type)
+    {
+        // Readable names without allocating through the tracker: demangling uses malloc directly.
+#if defined(__GNUG__)
+        int   status    = 0;
+        char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+        std::string_view name(status == 0 && demangled ? demangled : type.name());
+#else
+        std::string_view name(type.name());
+        for (std::string_view prefix : {"class ", "struct "})
+        {
+            if (name.starts_with(prefix))
+                name.remove_prefix(prefix.size());
+        }
+#endif
+        if (name.starts_with("core::"))
+            name.remove_prefix(6);
+        const uint16_t tag = register_tag(name);
+#if defined(__GNUG__)
+        std::free(demangled);
+#endif
+        return tag;
+    }
+
+    uint16_t MemoryTracker::get_current_tag() noexcept { return current_tag; }
+
+    void MemoryTracker::set_current_tag(uint16_t tag) noexcept { current_tag = tag; }
+
+    void* MemoryTracker::allocate(size_t size, size_t alignment, uint16_t tag) noexcept
+    {
+        // Small alignments sit right behind the header; larger ones pad in front of it.
+        const size_t padding = alignment > malloc_alignment ? alignment - 1 : 0;
+        auto*        raw     = static_cast<std::byte*>(std::malloc(size + sizeof(Header) + padding));
+        if (!raw)
+            return nullptr;
+
+        auto address = reinterpret_cast<uintptr_t>(raw + sizeof(Header));
+        if (padding)
+            address = (address + alignment - 1) / alignment * alignment;
+        auto* ptr    = reinterpret_cast<std::byte*>(address);
+        auto* header = get_header(ptr);
+        header->size   = size;
+        header->offset = static_cast<uint32_t>(ptr - raw);
+        header->tag    = tag;
+        account(tag, static_cast<int64_t>(size), 1);
+        return ptr;
+    }
+
+    void* MemoryTracker::reallocate(void* ptr, size_t size, size_t alignment, uint16_t tag) noexcept
+    {
+        if (!ptr)
+            return allocate(size, alignment, tag);
+        if (size == 0)
+        {
+            deallocate(ptr);
+            return nullptr;
+        }
+
+        Header*        header   = get_header(ptr);
+        const uint16_t old_tag  = header->tag;
+        const size_t   old_size = header->size;
+        if (alignment <= malloc_alignment && header->offset == sizeof(Header))
+        {
+            auto* raw = static_cast<std::byte*>(std::realloc(static_cast<std::byte*>(ptr) - sizeof(Header), size + sizeof(Header)));
+            if (!raw)
+                return nullptr;
+            header       = reinterpret_cast<Header*>(raw);
+            header->size = size;
+            account(old_tag, static_cast<int64_t>(size) - static_cast<int64_t>(old_size), 0);
+            return raw + sizeof(Header);
+        }
+
+        void* moved = allocate(size, alignment, old_tag);
+        if (!moved)
+            return nullptr;
+        std::memcpy(moved, ptr, std::min(size, old_size));
+        deallocate(ptr);
+        return moved;
+    }
+
+    void MemoryTracker::deallocate(void* ptr) noexcept
+    {
+        if (!ptr)
+            return;
+        Header* header = get_header(ptr);
+        account(header->tag, -static_cast<int64_t>(header->size), -1);
+        std::free(static_cast<std::byte*>(ptr) - header->offset);
+    }
+
+    uint16_t MemoryTracker::get_tag_count() noexcept { return tag_count.load(std::memory_order_acquire); }
+
+    static MemoryTracker::Stats read_counters(const Counters& c)
+    {
+        MemoryTracker::Stats stats;
+        stats.name        = c.name;
+        stats.current     = c.current.load(std::memory_order_relaxed);
+        stats.peak        = c.peak.load(std::memory_order_relaxed);
+        stats.live        = c.live.load(std::memory_order_relaxed);
+        stats.allocations = c.allocations.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    MemoryTracker::Stats MemoryTracker::get_stats(uint16_t tag) noexcept
+    {
+        return tag < get_tag_count() ? read_counters(counters[tag]) : Stats {};
+    }
+
+    MemoryTracker::Stats MemoryTracker::get_total() noexcept { return read_counters(total); }
+
+    void MemoryTracker::log_summary()
+    {
+        const Stats all = get_total();
+        APPLOG_INFO("Memory: {} KiB in {} blocks, peak {} KiB", all.current / 1024, all.live, all.peak / 1024);
+
+        std::vector<Stats> tags;
+        for (uint16_t tag = 0; tag < get_tag_count(); ++tag)
+        {
+            Stats stats = get_stats(tag);
+            if (stats.peak > 0)
+                tags.push_back(stats);
+        }
+        std::ranges::sort(tags, [](const Stats& a, const Stats& b) { return a.current > b.current; });
+        for (const Stats& stats : tags)
+        {
+            APPLOG_INFO("  {:<24} {:>10} KiB {:>8} blocks, peak {} KiB", stats.name, stats.current / 1024, stats.live, stats.peak / 1024);
+        }
+    }
+#else
+    void MemoryTracker::install() {}
+
+    uint16_t MemoryTracker::register_tag(std::string_view) { return tag_untagged; }
+
+    uint16_t MemoryTracker::register_type_tag(const std::type_info&) { return tag_untagged; }
+
+    uint16_t MemoryTracker::get_current_tag() noexcept { return tag_untagged; }
+
+    void MemoryTracker::set_current_tag(uint16_t) noexcept {}
+
+    void* MemoryTracker::allocate(size_t, size_t, uint16_t) noexcept { return nullptr; }
+
+    void* MemoryTracker::reallocate(void*, size_t, size_t, uint16_t) noexcept { return nullptr; }
+
+    void MemoryTracker::deallocate(void*) noexcept {}
+
+    uint16_t MemoryTracker::get_tag_count() noexcept { return 0; }
+
+    MemoryTracker::Stats MemoryTracker::get_stats(uint16_t) noexcept { return {}; }
+
+    MemoryTracker::Stats MemoryTracker::get_total() noexcept { return {}; }
+
+    void MemoryTracker::log_summary() {}
+#endif
+} // namespace core
+
+#ifdef CORE_MEMORY_TRACKING
+// Replacements for every global new/delete form, all funneled into the tracker under the current tag.
+static void* tracked_new(std::size_t size, std::size_t alignment)
+{
+    if (void* ptr = core::MemoryTracker::allocate(size, alignment, core::MemoryTracker::get_current_tag()))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+static void* tracked_new_nothrow(std::size_t size, std::size_t alignment) noexcept
+{
+    return core::MemoryTracker::allocate(size, alignment, core::MemoryTracker::get_current_tag());
+}
+
+void* operator new(std::size_t size) { return tracked_new(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](std::size_t size) { return tracked_new(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return tracked_new_nothrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return tracked_new_nothrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return tracked_new(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return tracked_new(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return tracked_new_nothrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return tracked_new_nothrow(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { core::MemoryTracker::deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { core::MemoryTracker::deallocate(ptr); }
+#endif
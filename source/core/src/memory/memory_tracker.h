@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <typeinfo>
+
+namespace core
+{
+    // Heap accounting by tag, compiled in with the CORE_MEMORY_TRACKING CMake option. Global
+    // new/delete, ImGui, SDL and the renderer's VkAllocationCallbacks then all allocate through
+    // allocate()/deallocate(), which keep a small header in front of each block to remember its
+    // size and tag. Tags are the ImGui/SDL/Vulkan libraries themselves, or else the tag of the
+    // calling thread's current MemoryScope: subsystem construction, event handlers and jobs each run
+    // in the scope of the subsystem they belong to. Without the option every call here is inert.
+    class MemoryTracker
+    {
+    public:
+        static constexpr uint16_t max_tags = 64;
+
+        static constexpr uint16_t tag_untagged = 0;
+        static constexpr uint16_t tag_imgui    = 1;
+        static constexpr uint16_t tag_sdl      = 2;
+        static constexpr uint16_t tag_vulkan   = 3;
+
+        struct Stats
+        {
+            const char* name        = "";
+            int64_t     current     = 0; // Bytes, headers excluded
+            int64_t     peak        = 0;
+            int64_t     live        = 0; // Blocks
+            uint64_t    allocations = 0; // Since start
+        };
+
+        static constexpr bool is_enabled() noexcept
+        {
+#ifdef CORE_MEMORY_TRACKING
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // Routes ImGui and SDL through the tracker; has to run before either allocates.
+        static void install();
+
+        // Tags are never released; registering a known name returns its existing tag.
+        static uint16_t register_tag(std::string_view name);
+        static uint16_t register_type_tag(const std::type_info& type);
+
+        static uint16_t get_current_tag() noexcept;
+        static void     set_current_tag(uint16_t tag) noexcept;
+
+        static void* allocate(size_t size, size_t alignment, uint16_t tag) noexcept;
+        // Keeps the block's tag; a null ptr allocates, a zero size frees and returns null.
+        static void* reallocate(void* ptr, size_t size, size_t alignment, uint16_t tag) noexcept;
+        static void  deallocate(void* ptr) noexcept;
+
+        [[nodiscard]] static uint16_t get_tag_count() noexcept;
+        [[nodiscard]] static Stats    get_stats(uint16_t tag) noexcept;
+        [[nodiscard]] static Stats    get_total() noexcept;
+
+        static void log_summary();
+    };
+
+    // Makes tag the calling thread's current tag for its lifetime.
+    class MemoryScope
+    {
+    public:
+#ifdef CORE_MEMORY_TRACKING
+        explicit MemoryScope(uint16_t tag) noexcept : previous_(MemoryTracker::get_current_tag()) { MemoryTracker::set_current_tag(tag); }
+        ~MemoryScope() { MemoryTracker::set_current_tag(previous_); }
+#else
+        explicit MemoryScope(uint16_t) noexcept {}
+#endif
+
+        MemoryScope(const MemoryScope&)            = delete;
+        MemoryScope& operator=(const MemoryScope&) = delete;
+
+    private:
+#ifdef CORE_MEMORY_TRACKING
+        uint16_t previous_;
+#endif
+    };
+
+    // Tag named after T, registered on first use.
+    template<typename T>
+    uint16_t memory_tag()
+    {
+#ifdef CORE_MEMORY_TRACKING
+        static const uint16_t tag = MemoryTracker::register_type_tag(typeid(T));
+        return tag;
+#else
+        return MemoryTracker::tag_untagged;
+#endif
+    }
+} // namespace core
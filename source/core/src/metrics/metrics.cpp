@@ -0,0 +1,189 @@
+#include "metrics.h"
+#include "cmd_line/parser.hpp"
+#include "log/log_ring.h"
+#include "logger.h"
+#include "memory/frame_arena.h"
+#include "memory/memory_tracker.h"
+#include "metrics_exporter.h"
+#include "system/watchdog.h"
+#include <algorithm>
+#include <cmath>
+
+namespace core
+{
+    namespace
+    {
+        // Frame time buckets in seconds: 240, 120, 60, 30 and 20 Hz, then hitches.
+        const std::vector<double> frame_time_bounds = {0.0042, 0.0083, 0.0167, 0.0333, 0.05, 0.1, 0.25, 0.5, 1.0};
+
+        void append_value(std::string& out, double value)
+        {
+            if (std::isnan(value))
+                out += "NaN";
+            else if (std::isinf(value))
+                out += value > 0.0 ? "+Inf" : "-Inf";
+            else
+                fmt::format_to(std::back_inserter(out), "{}", value);
+        }
+
+        // HELP text escapes backslashes and line feeds.
+        void append_help(std::string& out, std::string_view name, std::string_view help)
+        {
+            fmt::format_to(std::back_inserter(out), "# HELP {} ", name);
+            for (char c : help)
+            {
+                if (c == '\\')
+                    out += "\\\\";
+                else if (c == '\n')
+                    out += "\\n";
+                else
+                    out += c;
+            }
+            out += '\n';
+        }
+    } // namespace
+
+    Histogram::Histogram(std::vector<double> bounds) :
+        bounds_(std::move(bounds)), buckets_(std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1))
+    {}
+
+    void Histogram::observe(double value) noexcept
+    {
+        // Buckets are few, a linear scan beats a binary search.
+        size_t bucket = 0;
+        while (bucket < bounds_.size() && value > bounds_[bucket])
+            ++bucket;
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    Metrics::Metrics()
+    {
+        auto&       parser       = Parser::instance();
+        const auto  port         = static_cast<uint16_t>(std::stoul(parser.getOptionValue("metrics-port", "0")));
+        std::string shm_name     = parser.getOptionValue("metrics-shm", "");
+        const float shm_interval = std::stof(parser.getOptionValue("metrics-shm-interval", "1"));
+
+        frames_      = &add_counter("app_frames_total", "Frames rendered.");
+        frame_time_  = &add_histogram("app_frame_time_seconds", "Time between frames.", frame_time_bounds);
+        events_      = &add_counter("app_events_total", "Events triggered through the EventManager.");
+        log_records_ = &add_counter("app_log_records_total", "Log records written.");
+        hitches_     = &add_counter("app_hitches_total", "Frames over the watchdog's frame budget.");
+        arena_bytes_ = &add_gauge("app_frame_arena_used_bytes", "Frame arena bytes the last frame used.");
+        if (MemoryTracker::is_enabled())
+            heap_bytes_ = &add_gauge("app_heap_used_bytes", "Heap bytes in tracked allocations.");
+
+        connect<FrameEnd, Metrics, &Metrics::frame_end>(*this);
+
+        if (port != 0 || !shm_name.empty())
+            exporter_ = std::make_unique<MetricsExporter>(*this, port, std::move(shm_name), shm_interval);
+    }
+
+    Metrics::~Metrics()
+    {
+        disconnect(*this);
+        exporter_.reset();
+    }
+
+    Counter& Metrics::add_counter(std::string name, std::string help)
+    {
+        Entry& entry  = add_entry(std::move(name), std::move(help), Type::counter);
+        entry.counter = std::make_unique<Counter>();
+        return *entry.counter;
+    }
+
+    Gauge& Metrics::add_gauge(std::string name, std::string help)
+    {
+        Entry& entry = add_entry(std::move(name), std::move(help), Type::gauge);
+        entry.gauge  = std::make_unique<Gauge>();
+        return *entry.gauge;
+    }
+
+    Histogram& Metrics::add_histogram(std::string name, std::string help, std::vector<double> bounds)
+    {
+        Entry& entry    = add_entry(std::move(name), std::move(help), Type::histogram);
+        entry.histogram = std::make_unique<Histogram>(std::move(bounds));
+        return *entry.histogram;
+    }
+
+    Metrics::Entry& Metrics::add_entry(std::string name, std::string help, Type type)
+    {
+        std::lock_guard lock(mutex_);
+        if (std::ranges::any_of(entries_, [&](const auto& entry) { return entry->name == name; }))
+            APPLOG_WARNING("[metrics] {} is registered twice, the exporter will show both", name);
+
+        auto entry  = std::make_unique<Entry>();
+        entry->name = std::move(name);
+        entry->help = std::move(help);
+        entry->type = type;
+        return *entries_.emplace_back(std::move(entry));
+    }
+
+    std::string Metrics::format() const
+    {
+        static const char* const type_names[] = {"counter", "gauge", "histogram"};
+
+        std::string     out;
+        std::lock_guard lock(mutex_);
+        out.reserve(entries_.size() * 128);
+        for (const auto& entry : entries_)
+        {
+            append_help(out, entry->name, entry->help);
+            fmt::format_to(std::back_inserter(out), "# TYPE {} {}\n", entry->name, type_names[static_cast<size_t>(entry->type)]);
+            switch (entry->type)
+            {
+            case Type::counter:
+                fmt::format_to(std::back_inserter(out), "{} {}\n", entry->name, entry->counter->get());
+                break;
+            case Type::gauge:
+                out += entry->name;
+                out += ' ';
+                append_value(out, entry->gauge->get());
+                out += '\n';
+                break;
+            case Type::histogram:
+            {
+                // Buckets are cumulative in the exposition format. Observations landing while this runs may make
+                // the buckets disagree slightly with _count; scrapers tolerate that.
+                const Histogram& histogram  = *entry->histogram;
+                const auto&      bounds     = histogram.get_bounds();
+                uint64_t         cumulative = 0;
+                for (size_t i = 0; i < bounds.size(); ++i)
+                {
+                    cumulative += histogram.get_bucket(i);
+                    fmt::format_to(std::back_inserter(out), "{}_bucket{{le=\"", entry->name);
+                    append_value(out, bounds[i]);
+                    fmt::format_to(std::back_inserter(out), "\"}} {}\n", cumulative);
+                }
+                cumulative += histogram.get_bucket(bounds.size());
+                fmt::format_to(std::back_inserter(out), "{}_bucket{{le=\"+Inf\"}} {}\n", entry->name, cumulative);
+                fmt::format_to(std::back_inserter(out), "{}_sum ", entry->name);
+                append_value(out, histogram.get_sum());
+                fmt::format_to(std::back_inserter(out), "\n{}_count {}\n", entry->name, cumulative);
+                break;
+            }
+            }
+        }
+        return out;
+    }
+
+    bool Metrics::is_active() const noexcept { return exporter_ && exporter_->is_active(); }
+
+    void Metrics::frame_end(const FrameEnd& event)
+    {
+        frames_->add();
+        frame_time_->observe(event.delta_time);
+        events_->set(get_subsystem<EventManager>().get_trigger_total());
+        log_records_->set(Logger::getRing().get_write_index());
+        if (!is_active())
+            return;
+
+        if (has_subsystem<Watchdog>())
+            hitches_->set(get_subsystem<Watchdog>().get_hitch_count());
+        if (has_subsystem<FrameArena>())
+            arena_bytes_->set(static_cast<double>(get_subsystem<FrameArena>().get_frame_used()));
+        if (heap_bytes_)
+            heap_bytes_->set(static_cast<double>(MemoryTracker::get_total().current));
+    }
+} // namespace core
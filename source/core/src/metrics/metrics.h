@@ -0,0 +1,125 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    class MetricsExporter;
+
+    // Metric values are plain relaxed atomics: updating one from any thread costs about as much as a
+    // non-atomic add, and readers (the exporter thread) never block the writers.
+    class Counter
+    {
+    public:
+        void add(uint64_t amount = 1) noexcept { value_.fetch_add(amount, std::memory_order_relaxed); }
+        // Mirrors a monotonic total that is counted elsewhere anyway.
+        void set(uint64_t total) noexcept { value_.store(total, std::memory_order_relaxed); }
+
+        [[nodiscard]] uint64_t get() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_ {0};
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double value) noexcept { value_.store(value, std::memory_order_relaxed); }
+
+        [[nodiscard]] double get() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value_ {0.0};
+    };
+
+    // Counts observations into buckets with fixed upper bounds, plus an overflow bucket.
+    class Histogram
+    {
+    public:
+        // bounds have to be ascending.
+        explicit Histogram(std::vector<double> bounds);
+
+        void observe(double value) noexcept;
+
+        [[nodiscard]] const std::vector<double>& get_bounds() const noexcept { return bounds_; }
+        // Observations in bucket i alone, i == get_bounds().size() is the overflow bucket.
+        [[nodiscard]] uint64_t get_bucket(size_t i) const noexcept { return buckets_[i].load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t get_count() const noexcept { return count_.load(std::memory_order_relaxed); }
+        [[nodiscard]] double   get_sum() const noexcept { return sum_.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<double>                      bounds_;
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+        std::atomic<uint64_t>                    count_ {0};
+        std::atomic<double>                      sum_ {0.0};
+    };
+
+    // Registry of the process' metrics and their export.
+    //
+    // Metrics are registered once, usually at construction of the subsystem they belong to, and live as
+    // long as this subsystem. With --metrics-port <port> a background thread serves them over HTTP on
+    // 127.0.0.1 in the Prometheus text format (GET /metrics); with --metrics-shm <name> the same text is
+    // republished every --metrics-shm-interval seconds (default 1) into shared memory, see
+    // MetricsSharedHeader. Both are off by default.
+    //
+    // Built in: frames, frame time, events triggered, log records, and while exporting is active (see
+    // is_active()) also heap and frame arena usage and hitches, which cost a little more to sample.
+    class Metrics : public EventSubscriber
+    {
+    public:
+        Metrics();
+        ~Metrics();
+
+        // Names follow Prometheus conventions: snake_case, a unit suffix, _total for counters.
+        Counter&   add_counter(std::string name, std::string help);
+        Gauge&     add_gauge(std::string name, std::string help);
+        Histogram& add_histogram(std::string name, std::string help, std::vector<double> bounds);
+
+        // Every metric in the Prometheus text exposition format. Any thread.
+        [[nodiscard]] std::string format() const;
+
+        // Whether anything reads the metrics: a scrape within the last 30 seconds or the shared memory
+        // snapshot. Producers skip sampling that is not free while it is false.
+        [[nodiscard]] bool is_active() const noexcept;
+
+        void frame_end(const FrameEnd& event);
+
+    private:
+        enum class Type : uint8_t
+        {
+            counter,
+            gauge,
+            histogram,
+        };
+
+        struct Entry
+        {
+            std::string                name;
+            std::string                help;
+            Type                       type;
+            std::unique_ptr<Counter>   counter;
+            std::unique_ptr<Gauge>     gauge;
+            std::unique_ptr<Histogram> histogram;
+        };
+
+        Entry& add_entry(std::string name, std::string help, Type type);
+
+        mutable std::mutex                  mutex_; // Registration against format()
+        std::vector<std::unique_ptr<Entry>> entries_;
+        std::unique_ptr<MetricsExporter>    exporter_;
+
+        Counter*   frames_      = nullptr;
+        Histogram* frame_time_  = nullptr;
+        Counter*   events_      = nullptr;
+        Counter*   log_records_ = nullptr;
+        Gauge*     heap_bytes_  = nullptr;
+        Gauge*     arena_bytes_ = nullptr;
+        Counter*   hitches_     = nullptr;
+    };
+} // namespace core
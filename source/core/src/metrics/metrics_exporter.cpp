@@ -0,0 +1,310 @@
+#include "metrics_exporter.h"
+#include "logger.h"
+#include "metrics.h"
+#include "system/watchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace core
+{
+    namespace
+    {
+        constexpr int    poll_timeout_ms     = 200;
+        constexpr int    client_timeout_ms   = 1000;
+        constexpr size_t max_request_size    = 4096;
+        constexpr size_t shm_size            = 1 << 20; // Header and text, longer text is cut
+        constexpr auto   active_after_scrape = std::chrono::seconds(30);
+
+#ifdef _WIN32
+        using Socket                    = SOCKET;
+        constexpr Socket invalid_socket = INVALID_SOCKET;
+
+        void close_socket(Socket socket) { closesocket(socket); }
+        int  poll_socket(pollfd& fd, int timeout_ms) { return WSAPoll(&fd, 1, timeout_ms); }
+
+        void set_receive_timeout(Socket socket, int timeout_ms)
+        {
+            const DWORD timeout = static_cast<DWORD>(timeout_ms);
+            setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        }
+#else
+        using Socket                    = int;
+        constexpr Socket invalid_socket = -1;
+
+        void close_socket(Socket socket) { ::close(socket); }
+        int  poll_socket(pollfd& fd, int timeout_ms) { return ::poll(&fd, 1, timeout_ms); }
+
+        void set_receive_timeout(Socket socket, int timeout_ms)
+        {
+            timeval timeout {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+            setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+#endif
+
+        bool send_all(Socket socket, std::string_view data)
+        {
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_NOSIGNAL; // A scraper hanging up must not raise SIGPIPE
+#else
+            constexpr int flags = 0;
+#endif
+            while (!data.empty())
+            {
+                const auto sent = send(socket, data.data(), static_cast<int>(std::min<size_t>(data.size(), 1 << 30)), flags);
+                if (sent <= 0)
+                    return false;
+                data.remove_prefix(static_cast<size_t>(sent));
+            }
+            return true;
+        }
+
+        std::string make_response(std::string_view status, std::string_view content_type, std::string_view body)
+        {
+            return fmt::format("HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                               status,
+                               content_type,
+                               body.size(),
+                               body);
+        }
+    } // namespace
+
+    struct MetricsExporter::Platform
+    {
+        Socket                                listener = invalid_socket;
+        MetricsSharedHeader*                  shared   = nullptr;
+        std::chrono::steady_clock::time_point last_scrape;
+#ifdef _WIN32
+        HANDLE mapping   = nullptr;
+        bool   wsa_ready = false;
+#else
+        std::string shm_path;
+#endif
+    };
+
+    MetricsExporter::MetricsExporter(const Metrics& metrics, uint16_t port, std::string shm_name, float shm_interval) :
+        metrics_(metrics), port_(port), shm_name_(std::move(shm_name)), shm_interval_(std::max(shm_interval, 0.1f)),
+        platform_(std::make_unique<Platform>())
+    {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    MetricsExporter::~MetricsExporter()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void MetricsExporter::run()
+    {
+        Watchdog::name_thread("metrics");
+        const bool listening = port_ != 0 && open_listener();
+        const bool sharing   = !shm_name_.empty() && open_shared_memory();
+        if (!listening && !sharing)
+        {
+            close_all();
+            return;
+        }
+
+        using Clock             = std::chrono::steady_clock;
+        const auto interval     = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(shm_interval_));
+        auto       next_publish = Clock::now();
+        for (;;)
+        {
+            {
+                std::unique_lock lock(mutex_);
+                if (stopping_)
+                    break;
+                // Without a socket to poll, the condition variable provides the wait.
+                if (!listening)
+                    condition_.wait_until(lock, next_publish, [this]() { return stopping_; });
+            }
+
+            if (sharing && Clock::now() >= next_publish)
+            {
+                publish_shared_memory();
+                next_publish = Clock::now() + interval;
+            }
+
+            if (listening)
+            {
+                pollfd fd {};
+                fd.fd     = platform_->listener;
+                fd.events = POLLIN;
+                if (poll_socket(fd, poll_timeout_ms) > 0 && (fd.revents & POLLIN))
+                {
+                    const Socket client = accept(platform_->listener, nullptr, nullptr);
+                    if (client != invalid_socket)
+                    {
+                        serve_client(static_cast<uintptr_t>(client));
+                        close_socket(client);
+                    }
+                }
+            }
+
+            const bool scraped = platform_->last_scrape != Clock::time_point {} && Clock::now() - platform_->last_scrape < active_after_scrape;
+            active_.store(sharing || scraped, std::memory_order_relaxed);
+        }
+        close_all();
+    }
+
+    bool MetricsExporter::open_listener()
+    {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+        {
+            APPLOG_ERROR("[metrics] WSAStartup failed, the metrics endpoint is off");
+            return false;
+        }
+        platform_->wsa_ready = true;
+#endif
+        const Socket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener == invalid_socket)
+        {
+            APPLOG_ERROR("[metrics] Could not create a socket, the metrics endpoint is off");
+            return false;
+        }
+        const int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        // Loopback only: the endpoint is for an agent on the same machine, not the network.
+        sockaddr_in address {};
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(port_);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0)
+        {
+            APPLOG_ERROR("[metrics] Could not listen on 127.0.0.1:{}, the metrics endpoint is off", port_);
+            close_socket(listener);
+            return false;
+        }
+
+        platform_->listener = listener;
+        APPLOG_INFO("[metrics] Serving http://127.0.0.1:{}/metrics", port_);
+        return true;
+    }
+
+    // One request per connection; the metrics are formatted only when a scraper actually asks.
+    void MetricsExporter::serve_client(uintptr_t client)
+    {
+        const auto socket = static_cast<Socket>(client);
+        set_receive_timeout(socket, client_timeout_ms);
+
+        std::string request;
+        char        buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < max_request_size)
+        {
+            const auto received = recv(socket, buffer, sizeof(buffer), 0);
+            if (received <= 0)
+                return;
+            request.append(buffer, static_cast<size_t>(received));
+        }
+
+        const bool             get  = request.starts_with("GET ");
+        const std::string_view path = get ? std::string_view(request).substr(4, request.find_first_of(" \r\n", 4) - 4) : "";
+        if (!get || (path != "/metrics" && !path.starts_with("/metrics?")))
+        {
+            send_all(socket, make_response(get ? "404 Not Found" : "405 Method Not Allowed", "text/plain", "Try GET /metrics\n"));
+            return;
+        }
+
+        platform_->last_scrape = std::chrono::steady_clock::now();
+        send_all(socket, make_response("200 OK", "text/plain; version=0.0.4; charset=utf-8", metrics_.format()));
+    }
+
+    bool MetricsExporter::open_shared_memory()
+    {
+#ifdef _WIN32
+        const std::string name = "Local\\" + shm_name_;
+        platform_->mapping     = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(shm_size), name.c_str());
+        void* view             = platform_->mapping ? MapViewOfFile(platform_->mapping, FILE_MAP_ALL_ACCESS, 0, 0, shm_size) : nullptr;
+#else
+        platform_->shm_path = "/" + shm_name_;
+        const int fd        = shm_open(platform_->shm_path.c_str(), O_CREAT | O_RDWR, 0644);
+        void*     view      = nullptr;
+        if (fd >= 0)
+        {
+            if (ftruncate(fd, static_cast<off_t>(shm_size)) == 0)
+                view = mmap(nullptr, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (view == MAP_FAILED)
+                view = nullptr;
+        }
+#endif
+        if (!view)
+        {
+            APPLOG_ERROR("[metrics] Could not map shared memory {}, the snapshot is off", shm_name_);
+            return false;
+        }
+
+        auto* header           = new (view) MetricsSharedHeader {};
+        header->magic          = MetricsSharedHeader::magic_value;
+        header->layout_version = MetricsSharedHeader::version;
+        header->capacity       = shm_size - sizeof(MetricsSharedHeader);
+        platform_->shared      = header;
+        APPLOG_INFO("[metrics] Publishing to shared memory {} every {:.1f} s", shm_name_, shm_interval_);
+        return true;
+    }
+
+    void MetricsExporter::publish_shared_memory()
+    {
+        MetricsSharedHeader* header = platform_->shared;
+        const std::string    text   = metrics_.format();
+        const size_t         size   = std::min<size_t>(text.size(), header->capacity);
+
+        // Seqlock: odd while writing, readers retry on a torn copy.
+        const uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+        header->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header + 1, text.data(), size);
+        header->size    = size;
+        header->time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        header->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void MetricsExporter::close_all()
+    {
+        active_.store(false, std::memory_order_relaxed);
+        if (platform_->listener != invalid_socket)
+            close_socket(std::exchange(platform_->listener, invalid_socket));
+#ifdef _WIN32
+        if (platform_->shared)
+            UnmapViewOfFile(std::exchange(platform_->shared, nullptr));
+        if (platform_->mapping)
+            CloseHandle(std::exchange(platform_->mapping, nullptr));
+        if (std::exchange(platform_->wsa_ready, false))
+            WSACleanup();
+#else
+        if (platform_->shared)
+        {
+            munmap(std::exchange(platform_->shared, nullptr), shm_size);
+            shm_unlink(platform_->shm_path.c_str());
+        }
+#endif
+    }
+} // namespace core
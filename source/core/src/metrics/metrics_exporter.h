@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace core
+{
+    class Metrics;
+
+    // Start of the --metrics-shm region ("/<name>" with shm_open, "Local\<name>" on Windows), followed by
+    // capacity bytes of text. Readers copy size bytes and retry when sequence was odd or changed meanwhile.
+    struct MetricsSharedHeader
+    {
+        static constexpr uint32_t magic_value = 0x5352544D; // "MTRS"
+        static constexpr uint32_t version     = 1;
+
+        uint32_t              magic;
+        uint32_t              layout_version;
+        std::atomic<uint64_t> sequence; // Odd while the text is being written
+        uint64_t              capacity;
+        uint64_t              size;
+        int64_t               time_ns; // Unix time of the snapshot
+    };
+
+    // Background thread of Metrics: serves the HTTP endpoint and republishes the shared memory snapshot.
+    // Everything it does happens on its own thread; the frame thread only ever reads is_active().
+    class MetricsExporter
+    {
+    public:
+        // port 0 and an empty shm_name turn the respective export off.
+        MetricsExporter(const Metrics& metrics, uint16_t port, std::string shm_name, float shm_interval);
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&)            = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        [[nodiscard]] bool is_active() const noexcept { return active_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Platform;
+
+        void run();
+        bool open_listener();
+        void serve_client(uintptr_t client);
+        bool open_shared_memory();
+        void publish_shared_memory();
+        void close_all();
+
+        const Metrics&            metrics_;
+        uint16_t                  port_;
+        std::string               shm_name_;
+        float                     shm_interval_;
+        std::unique_ptr<Platform> platform_;
+
+        std::atomic<bool>       active_ {false};
+        std::thread             thread_;
+        std::mutex              mutex_;
+        std::condition_variable condition_;
+        bool                    stopping_ = false;
+    };
+} // namespace core
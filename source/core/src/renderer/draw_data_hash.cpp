@@ -0,0 +1,81 @@
+#include "draw_data_hash.h"
+#include "imgui.h"
+#include <cstring>
+
+namespace core
+{
+    static uint64_t mix(uint64_t hash, uint64_t value)
+    {
+        hash ^= value * 0x9E3779B97F4A7C15ull;
+        hash = (hash << 31 | hash >> 33) * 0xBF58476D1CE4E5B9ull;
+        return hash;
+    }
+
+    // Word at a time; vertex data is megabytes for dense UIs, so this has to stay well ahead of an upload.
+    static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        size_t      i     = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            hash = mix(hash, word);
+        }
+        if (i < size)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes + i, size - i);
+            hash = mix(hash, word);
+        }
+        return mix(hash, size);
+    }
+
+    static uint64_t mix_float(uint64_t hash, float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return mix(hash, bits);
+    }
+
+    static uint64_t hash_list(const ImDrawList& list, bool& cacheable)
+    {
+        uint64_t hash = 0;
+        // Commands are hashed field by field, ImDrawCmd has padding.
+        for (const ImDrawCmd& cmd : list.CmdBuffer)
+        {
+            if (cmd.UserCallback && cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                cacheable = false;
+            hash = mix_float(hash, cmd.ClipRect.x);
+            hash = mix_float(hash, cmd.ClipRect.y);
+            hash = mix_float(hash, cmd.ClipRect.z);
+            hash = mix_float(hash, cmd.ClipRect.w);
+            hash = mix(hash, static_cast<uint64_t>(cmd.TextureId));
+            hash = mix(hash, cmd.VtxOffset);
+            hash = mix(hash, cmd.IdxOffset);
+            hash = mix(hash, cmd.ElemCount);
+            hash = mix(hash, reinterpret_cast<uintptr_t>(cmd.UserCallback));
+        }
+        hash = hash_bytes(hash, list.VtxBuffer.Data, static_cast<size_t>(list.VtxBuffer.Size) * sizeof(ImDrawVert));
+        hash = hash_bytes(hash, list.IdxBuffer.Data, static_cast<size_t>(list.IdxBuffer.Size) * sizeof(ImDrawIdx));
+        return hash;
+    }
+
+    DrawDataHash hash_draw_data(const ImDrawData& draw_data)
+    {
+        DrawDataHash result;
+
+        uint64_t hash = mix(0, draw_data.CmdListsCount);
+        hash          = mix_float(hash, draw_data.DisplayPos.x);
+        hash          = mix_float(hash, draw_data.DisplayPos.y);
+        hash          = mix_float(hash, draw_data.DisplaySize.x);
+        hash          = mix_float(hash, draw_data.DisplaySize.y);
+        hash          = mix_float(hash, draw_data.FramebufferScale.x);
+        hash          = mix_float(hash, draw_data.FramebufferScale.y);
+        for (int i = 0; i < draw_data.CmdListsCount; ++i)
+            hash = mix(hash, hash_list(*draw_data.CmdLists[i], result.cacheable));
+
+        result.value = hash != 0 ? hash : 1;
+        return result;
+    }
+} // namespace core
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+struct ImDrawData;
+
+namespace core
+{
+    // Content hash of one frame of ImGui draw data, used to tell whether what a window would
+    // render is identical to something that was already recorded.
+    struct DrawDataHash
+    {
+        uint64_t value = 0; // Never 0, which stays free to mean "nothing recorded"
+        // False when a draw list carries user callbacks, whose effect cannot be captured by a hash.
+        bool cacheable = true;
+    };
+
+    DrawDataHash hash_draw_data(const ImDrawData& draw_data);
+} // namespace core
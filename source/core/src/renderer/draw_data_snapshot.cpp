@@ -0,0 +1,55 @@
+#include "draw_data_snapshot.h"
+#include <cstring>
+
+namespace core
+{
+    // ImVector's assignment frees and reallocates, this keeps the capacity of the destination.
+    template<typename T>
+    static void copy_vector(ImVector<T>& destination, const ImVector<T>& source)
+    {
+        destination.resize(source.Size);
+        if (source.Size > 0)
+            std::memcpy(destination.Data, source.Data, source.size_in_bytes());
+    }
+
+    DrawDataSnapshot::~DrawDataSnapshot()
+    {
+        for (ImDrawList* list : lists_)
+            IM_DELETE(list);
+    }
+
+    void DrawDataSnapshot::capture(const ImDrawData& source)
+    {
+        while (lists_.size() < static_cast<size_t>(source.CmdListsCount))
+            lists_.push_back(IM_NEW(ImDrawList)(nullptr));
+
+        data_.Valid            = source.Valid;
+        data_.CmdListsCount    = source.CmdListsCount;
+        data_.TotalIdxCount    = source.TotalIdxCount;
+        data_.TotalVtxCount    = source.TotalVtxCount;
+        data_.DisplayPos       = source.DisplayPos;
+        data_.DisplaySize      = source.DisplaySize;
+        data_.FramebufferScale = source.FramebufferScale;
+        data_.OwnerViewport    = source.OwnerViewport;
+        data_.CmdLists.resize(source.CmdListsCount);
+
+        for (int i = 0; i < source.CmdListsCount; ++i)
+        {
+            const ImDrawList* from = source.CmdLists[i];
+            ImDrawList*       to   = lists_[i];
+            copy_vector(to->CmdBuffer, from->CmdBuffer);
+            copy_vector(to->IdxBuffer, from->IdxBuffer);
+            copy_vector(to->VtxBuffer, from->VtxBuffer);
+            copy_vector(to->_CallbacksDataBuf, from->_CallbacksDataBuf);
+            to->Flags = from->Flags;
+
+            // Callback data ImGui copied into the list has to point into the copy.
+            for (ImDrawCmd& cmd : to->CmdBuffer)
+            {
+                if (cmd.UserCallback && cmd.UserCallbackDataSize > 0)
+                    cmd.UserCallbackData = to->_CallbacksDataBuf.Data + cmd.UserCallbackDataOffset;
+            }
+            data_.CmdLists[i] = to;
+        }
+    }
+} // namespace core
@@ -0,0 +1,26 @@
+#pragma once
+#include "imgui.h"
+#include <vector>
+
+namespace core
+{
+    // Copy of one frame of ImGui draw data that stays valid while ImGui builds the next frame, so another
+    // thread can render it. capture() reuses the buffers of the previous capture.
+    class DrawDataSnapshot
+    {
+    public:
+        DrawDataSnapshot() = default;
+        ~DrawDataSnapshot();
+
+        DrawDataSnapshot(const DrawDataSnapshot&)            = delete;
+        DrawDataSnapshot& operator=(const DrawDataSnapshot&) = delete;
+
+        void capture(const ImDrawData& source);
+
+        [[nodiscard]] ImDrawData* get() noexcept { return &data_; }
+
+    private:
+        ImDrawData               data_;
+        std::vector<ImDrawList*> lists_;
+    };
+} // namespace core
@@ -0,0 +1,357 @@
+#include "image_writer.h"
+#include "logger.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace core
+{
+    namespace
+    {
+        constexpr uint32_t adler_base = 65521;
+        constexpr size_t   adler_run  = 5552;
+
+        // LZ77 window and match limits of deflate; longer chains find longer matches at more cost per byte.
+        constexpr size_t   window_size = 32768;
+        constexpr size_t   min_match   = 3;
+        constexpr size_t   max_match   = 258;
+        constexpr size_t   max_chain   = 8;
+        constexpr uint32_t hash_bits   = 15;
+        constexpr uint32_t no_position = UINT32_MAX;
+
+        constexpr uint16_t length_base[29]  = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                               31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr uint8_t  length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr uint16_t distance_base[30]  = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                                 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr uint8_t  distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        struct Code
+        {
+            uint16_t bits;   // Reversed, ready to go into the LSB first stream
+            uint8_t  length;
+        };
+
+        uint16_t reverse_bits(uint32_t code, uint32_t length)
+        {
+            uint32_t reversed = 0;
+            for (uint32_t i = 0; i < length; ++i)
+                reversed |= ((code >> i) & 1) << (length - 1 - i);
+            return static_cast<uint16_t>(reversed);
+        }
+
+        // The fixed Huffman codes of deflate (RFC 1951, 3.2.6): literals and lengths, then distances.
+        const std::array<Code, 288> literal_codes = []() {
+            std::array<Code, 288> codes {};
+            for (uint32_t symbol = 0; symbol < 288; ++symbol)
+            {
+                if (symbol < 144)
+                    codes[symbol] = {reverse_bits(0x30 + symbol, 8), 8};
+                else if (symbol < 256)
+                    codes[symbol] = {reverse_bits(0x190 + symbol - 144, 9), 9};
+                else if (symbol < 280)
+                    codes[symbol] = {reverse_bits(symbol - 256, 7), 7};
+                else
+                    codes[symbol] = {reverse_bits(0xC0 + symbol - 280, 8), 8};
+            }
+            return codes;
+        }();
+
+        const std::array<Code, 30> distance_codes = []() {
+            std::array<Code, 30> codes {};
+            for (uint32_t symbol = 0; symbol < 30; ++symbol)
+                codes[symbol] = {reverse_bits(symbol, 5), 5};
+            return codes;
+        }();
+
+        const std::array<uint32_t, 256> crc_table = []() {
+            std::array<uint32_t, 256> table {};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return table;
+        }();
+
+        uint32_t update_crc(uint32_t crc, std::span<const uint8_t> data)
+        {
+            for (uint8_t byte : data)
+                crc = crc_table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+            return crc;
+        }
+
+        void put_u32(std::vector<uint8_t>& out, uint32_t value)
+        {
+            out.push_back(static_cast<uint8_t>(value >> 24));
+            out.push_back(static_cast<uint8_t>(value >> 16));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        void put_chunk(std::vector<uint8_t>& out, const char (&type)[5], std::span<const uint8_t> data)
+        {
+            put_u32(out, static_cast<uint32_t>(data.size()));
+            const size_t start = out.size();
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data.begin(), data.end());
+            put_u32(out, update_crc(0xFFFFFFFFu, std::span(out).subspan(start)) ^ 0xFFFFFFFFu);
+        }
+
+        bool write_file(const std::filesystem::path& path, std::span<const uint8_t> data)
+        {
+            std::error_code error;
+            if (path.has_parent_path())
+                std::filesystem::create_directories(path.parent_path(), error);
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file || !file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+            {
+                APPLOG_ERROR("[image] Could not write {}", path.string());
+                return false;
+            }
+            return true;
+        }
+
+        uint32_t adler32(std::span<const uint8_t> data)
+        {
+            uint32_t a = 1, b = 0;
+            for (size_t done = 0; done < data.size();)
+            {
+                // The sums cannot overflow within adler_run bytes, so the modulo is taken once per run.
+                const size_t run = std::min(data.size() - done, adler_run);
+                for (size_t i = 0; i < run; ++i)
+                {
+                    a += data[done + i];
+                    b += a;
+                }
+                a %= adler_base;
+                b %= adler_base;
+                done += run;
+            }
+            return (b << 16) | a;
+        }
+
+        // Deflate streams are written from the least significant bit of each byte up.
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+            void put(uint32_t bits, uint32_t count)
+            {
+                buffer_ |= static_cast<uint64_t>(bits) << count_;
+                count_ += count;
+                while (count_ >= 8)
+                {
+                    out_.push_back(static_cast<uint8_t>(buffer_));
+                    buffer_ >>= 8;
+                    count_ -= 8;
+                }
+            }
+            void put(const Code& code) { put(code.bits, code.length); }
+
+            void flush()
+            {
+                if (count_ > 0)
+                    out_.push_back(static_cast<uint8_t>(buffer_));
+                buffer_ = 0;
+                count_  = 0;
+            }
+
+        private:
+            std::vector<uint8_t>& out_;
+            uint64_t              buffer_ = 0;
+            uint32_t              count_  = 0;
+        };
+
+        uint32_t hash3(const uint8_t* data) { return ((data[0] << 16 | data[1] << 8 | data[2]) * 0x9E3779B1u) >> (32 - hash_bits); }
+
+        size_t match_length(const uint8_t* a, const uint8_t* b, size_t limit)
+        {
+            size_t length = 0;
+            while (length + 8 <= limit)
+            {
+                uint64_t x, y;
+                std::memcpy(&x, a + length, 8);
+                std::memcpy(&y, b + length, 8);
+                if (x != y)
+                    return length + std::countr_zero(x ^ y) / 8;
+                length += 8;
+            }
+            while (length < limit && a[length] == b[length])
+                ++length;
+            return length;
+        }
+
+        // One final block with the fixed Huffman codes and greedy LZ77 matching over hash chains. Filtered
+        // screenshots are mostly long runs, which this catches; dynamic codes would save little more.
+        void deflate(std::span<const uint8_t> data, std::vector<uint8_t>& out)
+        {
+            BitWriter bits(out);
+            bits.put(1, 1); // BFINAL
+            bits.put(1, 2); // BTYPE 01, fixed codes
+
+            std::vector<uint32_t> head(size_t {1} << hash_bits, no_position);
+            std::vector<uint32_t> previous(window_size, no_position); // Earlier position of the same hash
+            const auto            insert = [&](size_t position) {
+                const uint32_t hash                   = hash3(data.data() + position);
+                previous[position & (window_size - 1)] = head[hash];
+                head[hash]                            = static_cast<uint32_t>(position);
+            };
+
+            const size_t size = data.size();
+            for (size_t i = 0; i < size;)
+            {
+                size_t best_length = 0, best_distance = 0;
+                if (i + min_match <= size)
+                {
+                    const size_t limit     = std::min(max_match, size - i);
+                    uint32_t     candidate = head[hash3(data.data() + i)];
+                    for (size_t chain = 0; chain < max_chain && candidate != no_position && i - candidate <= window_size; ++chain)
+                    {
+                        const size_t length = match_length(data.data() + candidate, data.data() + i, limit);
+                        if (length > best_length)
+                        {
+                            best_length   = length;
+                            best_distance = i - candidate;
+                            if (length == limit)
+                                break;
+                        }
+                        const uint32_t next = previous[candidate & (window_size - 1)];
+                        candidate           = next < candidate ? next : no_position; // Stale once the window wrapped
+                    }
+                }
+
+                if (best_length < min_match)
+                {
+                    bits.put(literal_codes[data[i]]);
+                    if (i + min_match <= size)
+                        insert(i);
+                    ++i;
+                    continue;
+                }
+
+                const size_t length_symbol =
+                    std::upper_bound(std::begin(length_base), std::end(length_base), best_length) - std::begin(length_base) - 1;
+                bits.put(literal_codes[257 + length_symbol]);
+                bits.put(static_cast<uint32_t>(best_length - length_base[length_symbol]), length_extra[length_symbol]);
+                const size_t distance_symbol =
+                    std::upper_bound(std::begin(distance_base), std::end(distance_base), best_distance) - std::begin(distance_base) - 1;
+                bits.put(distance_codes[distance_symbol]);
+                bits.put(static_cast<uint32_t>(best_distance - distance_base[distance_symbol]), distance_extra[distance_symbol]);
+
+                for (size_t end = i + best_length; i < end; ++i)
+                {
+                    if (i + min_match <= size)
+                        insert(i);
+                }
+            }
+            bits.put(literal_codes[256]);
+            bits.flush();
+        }
+
+        uint8_t paeth(uint8_t left, uint8_t up, uint8_t up_left)
+        {
+            const int estimate = left + up - up_left;
+            const int to_left  = std::abs(estimate - left);
+            const int to_up    = std::abs(estimate - up);
+            const int to_diag  = std::abs(estimate - up_left);
+            if (to_left <= to_up && to_left <= to_diag)
+                return left;
+            return to_up <= to_diag ? up : up_left;
+        }
+
+        // Each row with the filter whose output has the smallest sum of absolute values (as signed bytes),
+        // the usual guess at what compresses best. Rows start with their filter type.
+        std::vector<uint8_t> filter_rows(uint32_t width, uint32_t height, std::span<const uint8_t> rgba)
+        {
+            constexpr size_t     bpp      = 4;
+            const size_t         row_size = static_cast<size_t>(width) * bpp;
+            std::vector<uint8_t> filtered((row_size + 1) * height);
+            std::vector<uint8_t> candidates[4] = {std::vector<uint8_t>(row_size),
+                                                  std::vector<uint8_t>(row_size),
+                                                  std::vector<uint8_t>(row_size),
+                                                  std::vector<uint8_t>(row_size)};
+            constexpr uint8_t    types[4]      = {0, 1, 2, 4}; // None, Sub, Up, Paeth
+            const std::vector<uint8_t> zero_row(row_size, 0);
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                const uint8_t* row = rgba.data() + y * row_size;
+                const uint8_t* up  = y > 0 ? rgba.data() + (y - 1) * row_size : zero_row.data();
+                for (size_t x = 0; x < row_size; ++x)
+                {
+                    const uint8_t left    = x >= bpp ? row[x - bpp] : 0;
+                    const uint8_t up_left = x >= bpp ? up[x - bpp] : 0;
+                    candidates[0][x]      = row[x];
+                    candidates[1][x]      = static_cast<uint8_t>(row[x] - left);
+                    candidates[2][x]      = static_cast<uint8_t>(row[x] - up[x]);
+                    candidates[3][x]      = static_cast<uint8_t>(row[x] - paeth(left, up[x], up_left));
+                }
+
+                size_t   best     = 0;
+                uint64_t best_sum = UINT64_MAX;
+                for (size_t f = 0; f < 4; ++f)
+                {
+                    uint64_t sum = 0;
+                    for (uint8_t byte : candidates[f])
+                        sum += static_cast<uint64_t>(std::abs(static_cast<int8_t>(byte)));
+                    if (sum < best_sum)
+                    {
+                        best     = f;
+                        best_sum = sum;
+                    }
+                }
+                uint8_t* out = filtered.data() + y * (row_size + 1);
+                out[0]       = types[best];
+                std::memcpy(out + 1, candidates[best].data(), row_size);
+            }
+            return filtered;
+        }
+    } // namespace
+
+    bool write_png(const std::filesystem::path& path, uint32_t width, uint32_t height, std::span<const uint8_t> rgba)
+    {
+        const size_t row_size = static_cast<size_t>(width) * 4;
+        if (rgba.size() < row_size * height)
+        {
+            APPLOG_ERROR("[image] {}x{} image for {} has only {} bytes", width, height, path.string(), rgba.size());
+            return false;
+        }
+
+        // Filtered scanlines, deflated into a zlib stream.
+        const std::vector<uint8_t> filtered = filter_rows(width, height, rgba);
+        std::vector<uint8_t>       idat     = {0x78, 0x01};
+        idat.reserve(filtered.size() / 4 + 64);
+        deflate(filtered, idat);
+        put_u32(idat, adler32(filtered));
+
+        std::vector<uint8_t> header;
+        put_u32(header, width);
+        put_u32(header, height);
+        header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bit RGBA, deflate, adaptive filters, no interlace
+
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        png.reserve(idat.size() + 64);
+        put_chunk(png, "IHDR", header);
+        put_chunk(png, "IDAT", idat);
+        put_chunk(png, "IEND", {});
+        return write_file(path, png);
+    }
+
+    bool write_raw(const std::filesystem::path& path, std::span<const uint8_t> rgba) { return write_file(path, rgba); }
+
+    std::filesystem::path get_raw_name(const std::filesystem::path& path, uint32_t width, uint32_t height)
+    {
+        std::filesystem::path name = path;
+        name.replace_filename(fmt::format("{}_{}x{}.rgba", path.stem().string(), width, height));
+        return name;
+    }
+} // namespace core
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace core
+{
+    // RGBA8 images, rows top to bottom without padding. Both return false and log when the file cannot be written.
+
+    // Filtered and deflated PNG, a fraction of the raw size for UI content; a 1080p frame takes in the order of
+    // 100 ms, so call it from a worker. Raw is the format for capturing every frame.
+    bool write_png(const std::filesystem::path& path, uint32_t width, uint32_t height, std::span<const uint8_t> rgba);
+    // The pixels as they are; the size goes into the file name, see get_raw_name().
+    bool write_raw(const std::filesystem::path& path, std::span<const uint8_t> rgba);
+
+    // "<stem>_<width>x<height>.rgba", so readers of raw files know the dimensions.
+    std::filesystem::path get_raw_name(const std::filesystem::path& path, uint32_t width, uint32_t height);
+} // namespace core
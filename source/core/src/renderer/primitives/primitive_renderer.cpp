@@ -0,0 +1,789 @@
+#include "primitive_renderer.h"
+#include "logger.h"
+#include "memory/frame_arena.h"
+#include "renderer/shader_manager.h"
+#include "renderer/vulkan/vulkan_renderer.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <memory_resource>
+#include <utility>
+
+namespace core
+{
+    namespace
+    {
+        // SPIR-V compiled at build time from shaders/ (see target_embed_shaders).
+        const uint32_t primitive_cull_spv[] =
+#include "primitive_cull.comp.inc"
+            ;
+        const uint32_t primitive_vert_spv[] =
+#include "primitive.vert.inc"
+            ;
+        const uint32_t primitive_frag_spv[] =
+#include "primitive.frag.inc"
+            ;
+        const uint32_t primitive_image_frag_spv[] =
+#include "primitive_image.frag.inc"
+            ;
+
+        constexpr uint32_t workgroup_size      = 256;
+        constexpr uint32_t max_descriptor_sets = 1024;
+
+        void check_vk_result(VkResult err)
+        {
+            if (err == VK_SUCCESS)
+                return;
+            APPLOG_ERROR("[primitives] Error: VkResult = {}", (int)err);
+            if (err < 0)
+                abort();
+        }
+
+        VkShaderModule create_shader_module(VkDevice device, const VkAllocationCallbacks* allocator, const uint32_t* code, size_t size)
+        {
+            VkShaderModuleCreateInfo info = {};
+            info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            info.codeSize                 = size;
+            info.pCode                    = code;
+            VkShaderModule module         = VK_NULL_HANDLE;
+            check_vk_result(vkCreateShaderModule(device, &info, allocator, &module));
+            return module;
+        }
+
+        VkPipelineShaderStageCreateInfo make_stage(VkShaderStageFlagBits stage, VkShaderModule module)
+        {
+            VkPipelineShaderStageCreateInfo info = {};
+            info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            info.stage                           = stage;
+            info.module                          = module;
+            info.pName                           = "main";
+            return info;
+        }
+
+        // What the pipelines are built against; copied into ShaderManager's builders, which run on workers.
+        struct PipelineTarget
+        {
+            VkDevice                     device;
+            const VkAllocationCallbacks* allocator;
+            VkPipelineCache              cache;
+            VkPipelineLayout             layout;
+            VkRenderPass                 render_pass;
+        };
+
+        VkResult create_cull_pipeline(const PipelineTarget& target, const VkPipelineShaderStageCreateInfo& stage, VkPipeline& pipeline)
+        {
+            VkComputePipelineCreateInfo info = {};
+            info.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            info.stage                       = stage;
+            info.layout                      = target.layout;
+            return vkCreateComputePipelines(target.device, target.cache, 1, &info, target.allocator, &pipeline);
+        }
+
+        // stages: vertex and fragment.
+        VkResult create_draw_pipeline(const PipelineTarget& target, std::span<const VkPipelineShaderStageCreateInfo> stages, VkPipeline& pipeline)
+        {
+            // No vertex input: the vertex shader expands each instance from the storage buffers.
+            VkPipelineVertexInputStateCreateInfo vertex_input = {};
+            vertex_input.sType                                = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+            VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+            input_assembly.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            input_assembly.topology                               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+            VkPipelineViewportStateCreateInfo viewport = {};
+            viewport.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            viewport.viewportCount                     = 1;
+            viewport.scissorCount                      = 1;
+
+            VkPipelineRasterizationStateCreateInfo raster = {};
+            raster.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            raster.polygonMode                            = VK_POLYGON_MODE_FILL;
+            raster.cullMode                               = VK_CULL_MODE_NONE;
+            raster.frontFace                              = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            raster.lineWidth                              = 1.0f;
+
+            VkPipelineMultisampleStateCreateInfo multisample = {};
+            multisample.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            multisample.rasterizationSamples                 = VK_SAMPLE_COUNT_1_BIT;
+
+            VkPipelineColorBlendAttachmentState blend_attachment = {};
+            blend_attachment.blendEnable                         = VK_TRUE;
+            blend_attachment.srcColorBlendFactor                 = VK_BLEND_FACTOR_SRC_ALPHA;
+            blend_attachment.dstColorBlendFactor                 = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            blend_attachment.colorBlendOp                        = VK_BLEND_OP_ADD;
+            blend_attachment.srcAlphaBlendFactor                 = VK_BLEND_FACTOR_ONE;
+            blend_attachment.dstAlphaBlendFactor                 = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            blend_attachment.alphaBlendOp                        = VK_BLEND_OP_ADD;
+            blend_attachment.colorWriteMask =
+                VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+            VkPipelineColorBlendStateCreateInfo blend = {};
+            blend.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            blend.attachmentCount                     = 1;
+            blend.pAttachments                        = &blend_attachment;
+
+            VkDynamicState                   dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+            VkPipelineDynamicStateCreateInfo dynamic          = {};
+            dynamic.sType                                     = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamic.dynamicStateCount                         = 2;
+            dynamic.pDynamicStates                            = dynamic_states;
+
+            VkGraphicsPipelineCreateInfo info = {};
+            info.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            info.stageCount                   = static_cast<uint32_t>(stages.size());
+            info.pStages                      = stages.data();
+            info.pVertexInputState            = &vertex_input;
+            info.pInputAssemblyState          = &input_assembly;
+            info.pViewportState               = &viewport;
+            info.pRasterizationState          = &raster;
+            info.pMultisampleState            = &multisample;
+            info.pColorBlendState             = &blend;
+            info.pDynamicState                = &dynamic;
+            info.layout                       = target.layout;
+            info.renderPass                   = target.render_pass;
+            return vkCreateGraphicsPipelines(target.device, target.cache, 1, &info, target.allocator, &pipeline);
+        }
+    } // namespace
+
+    PrimitiveRenderer::PrimitiveRenderer() : renderer_(get_subsystem<VulkanRenderer>()), device_(renderer_.get_device())
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(renderer_.get_physical_device(), &properties);
+        const uint64_t by_range    = properties.limits.maxStorageBufferRange / sizeof(Primitive);
+        const uint64_t by_dispatch = static_cast<uint64_t>(properties.limits.maxComputeWorkGroupCount[0]) * workgroup_size;
+        max_batch_size_            = static_cast<uint32_t>(std::min<uint64_t>({by_range, by_dispatch, UINT32_MAX}));
+
+        create_pipelines();
+        load_shader_sources();
+    }
+
+    PrimitiveRenderer::~PrimitiveRenderer()
+    {
+        if (shaders_)
+        {
+            // No build may still be running against the layout and render pass destroyed below.
+            shaders_->flush();
+            shaders_->destroy_pipeline(draw_id_);
+            shaders_->destroy_pipeline(cull_id_);
+        }
+        renderer_.wait_gpu_idle();
+        for (auto& [id, canvas] : canvases_)
+            destroy_canvas_resources(canvas);
+        for (auto& [id, batch] : batches_)
+            destroy_buffer(batch.storage);
+
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+        vkDestroyPipeline(device_, draw_pipeline_, allocator);
+        vkDestroyPipeline(device_, cull_pipeline_, allocator);
+        vkDestroyRenderPass(device_, render_pass_, allocator);
+        vkDestroyPipelineLayout(device_, pipeline_layout_, allocator);
+        vkDestroyDescriptorPool(device_, descriptor_pool_, allocator);
+        vkDestroyDescriptorSetLayout(device_, batch_layout_, allocator);
+        vkDestroyDescriptorSetLayout(device_, canvas_layout_, allocator);
+    }
+
+    void PrimitiveRenderer::create_pipelines()
+    {
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+        const VkShaderStageFlags     stages    = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+
+        {
+            // Set 0 per canvas: visible indices, indirect commands, pixel owners. Set 1 per batch: primitives.
+            VkDescriptorSetLayoutBinding bindings[3] = {};
+            for (uint32_t i = 0; i < 3; ++i)
+                bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr};
+
+            VkDescriptorSetLayoutCreateInfo info = {};
+            info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            info.bindingCount                    = 3;
+            info.pBindings                       = bindings;
+            check_vk_result(vkCreateDescriptorSetLayout(device_, &info, allocator, &canvas_layout_));
+            info.bindingCount = 1;
+            check_vk_result(vkCreateDescriptorSetLayout(device_, &info, allocator, &batch_layout_));
+        }
+        {
+            VkDescriptorPoolSize       pool_size = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, max_descriptor_sets * 3};
+            VkDescriptorPoolCreateInfo info      = {};
+            info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            info.flags                           = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+            info.maxSets                         = max_descriptor_sets;
+            info.poolSizeCount                   = 1;
+            info.pPoolSizes                      = &pool_size;
+            check_vk_result(vkCreateDescriptorPool(device_, &info, allocator, &descriptor_pool_));
+        }
+        BindlessHeap* bindless = renderer_.get_bindless_heap();
+        bindless_set_          = bindless ? bindless->get_set() : VK_NULL_HANDLE;
+        {
+            // Set 2: the bindless heap, when there is one.
+            VkDescriptorSetLayout      layouts[] = {canvas_layout_, batch_layout_, bindless ? bindless->get_layout() : VK_NULL_HANDLE};
+            VkPushConstantRange        range     = {stages, 0, sizeof(Params)};
+            VkPipelineLayoutCreateInfo info      = {};
+            info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            info.setLayoutCount                  = bindless ? 3 : 2;
+            info.pSetLayouts                     = layouts;
+            info.pushConstantRangeCount          = 1;
+            info.pPushConstantRanges             = &range;
+            check_vk_result(vkCreatePipelineLayout(device_, &info, allocator, &pipeline_layout_));
+        }
+        {
+            VkAttachmentDescription attachment = {};
+            attachment.format                  = VK_FORMAT_R8G8B8A8_UNORM;
+            attachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout             = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+            VkAttachmentReference color_reference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+            VkSubpassDescription  subpass         = {};
+            subpass.pipelineBindPoint             = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount          = 1;
+            subpass.pColorAttachments             = &color_reference;
+
+            // ImGui of earlier frames samples the image before it is drawn again, and this frame's UI after.
+            VkSubpassDependency dependencies[2] = {};
+            dependencies[0].srcSubpass          = VK_SUBPASS_EXTERNAL;
+            dependencies[0].dstSubpass          = 0;
+            dependencies[0].srcStageMask        = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[0].dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependencies[0].dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            dependencies[1].srcSubpass          = 0;
+            dependencies[1].dstSubpass          = VK_SUBPASS_EXTERNAL;
+            dependencies[1].srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependencies[1].srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            dependencies[1].dstStageMask        = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[1].dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+
+            VkRenderPassCreateInfo info = {};
+            info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            info.attachmentCount        = 1;
+            info.pAttachments           = &attachment;
+            info.subpassCount           = 1;
+            info.pSubpasses             = &subpass;
+            info.dependencyCount        = 2;
+            info.pDependencies          = dependencies;
+            check_vk_result(vkCreateRenderPass(device_, &info, allocator, &render_pass_));
+        }
+        const PipelineTarget target = {device_, allocator, renderer_.get_pipeline_cache(), pipeline_layout_, render_pass_};
+        {
+            VkShaderModule module = create_shader_module(device_, allocator, primitive_cull_spv, sizeof(primitive_cull_spv));
+            check_vk_result(create_cull_pipeline(target, make_stage(VK_SHADER_STAGE_COMPUTE_BIT, module), cull_pipeline_));
+            vkDestroyShaderModule(device_, module, allocator);
+        }
+        {
+            VkShaderModule vert = create_shader_module(device_, allocator, primitive_vert_spv, sizeof(primitive_vert_spv));
+            VkShaderModule frag = bindless ? create_shader_module(device_, allocator, primitive_image_frag_spv, sizeof(primitive_image_frag_spv))
+                                           : create_shader_module(device_, allocator, primitive_frag_spv, sizeof(primitive_frag_spv));
+            const VkPipelineShaderStageCreateInfo shader_stages[2] = {make_stage(VK_SHADER_STAGE_VERTEX_BIT, vert),
+                                                                      make_stage(VK_SHADER_STAGE_FRAGMENT_BIT, frag)};
+            check_vk_result(create_draw_pipeline(target, shader_stages, draw_pipeline_));
+            vkDestroyShaderModule(device_, frag, allocator);
+            vkDestroyShaderModule(device_, vert, allocator);
+        }
+    }
+
+    void PrimitiveRenderer::load_shader_sources()
+    {
+#ifdef CORE_PRIMITIVE_SHADER_DIR
+        const std::filesystem::path dir = CORE_PRIMITIVE_SHADER_DIR;
+        if (!has_subsystem<ShaderManager>() || !std::filesystem::exists(dir))
+            return;
+
+        shaders_             = &get_subsystem<ShaderManager>();
+        const char* fragment = bindless_set_ != VK_NULL_HANDLE ? "primitive_image.frag" : "primitive.frag";
+        const auto  cull     = shaders_->load({(dir / "primitive_cull.comp").string(), VK_SHADER_STAGE_COMPUTE_BIT});
+        const auto  vert     = shaders_->load({(dir / "primitive.vert").string(), VK_SHADER_STAGE_VERTEX_BIT});
+        const auto  frag     = shaders_->load({(dir / fragment).string(), VK_SHADER_STAGE_FRAGMENT_BIT});
+
+        const PipelineTarget target = {device_, renderer_.get_allocator(), renderer_.get_pipeline_cache(), pipeline_layout_, render_pass_};
+
+        auto build_cull = [target](std::span<const VkPipelineShaderStageCreateInfo> stages)
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            create_cull_pipeline(target, stages[0], pipeline);
+            return pipeline;
+        };
+        auto build_draw = [target](std::span<const VkPipelineShaderStageCreateInfo> stages)
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            create_draw_pipeline(target, stages, pipeline);
+            return pipeline;
+        };
+        cull_id_ = shaders_->create_pipeline({cull}, {}, build_cull);
+        draw_id_ = shaders_->create_pipeline({vert, frag}, {}, build_draw);
+        APPLOG_INFO("[primitives] Watching shader sources in {}", dir.string());
+#endif
+    }
+
+    VkPipeline PrimitiveRenderer::get_pipeline(uint32_t shader_pipeline, VkPipeline embedded) const
+    {
+        const VkPipeline reloaded = shaders_ ? shaders_->get_pipeline(shader_pipeline) : VK_NULL_HANDLE;
+        return reloaded != VK_NULL_HANDLE ? reloaded : embedded;
+    }
+
+    void PrimitiveRenderer::create_buffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool host_visible)
+    {
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+
+        VkBufferCreateInfo info = {};
+        info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size               = size;
+        info.usage              = usage;
+        info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+        check_vk_result(vkCreateBuffer(device_, &info, allocator, &buffer.buffer));
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device_, buffer.buffer, &requirements);
+
+        // Host visible buffers go to device local memory when the GPU exposes it to the host (resizable BAR),
+        // otherwise the GPU reads them over the bus.
+        const VkMemoryPropertyFlags host    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        const VkMemoryPropertyFlags local   = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        VkMemoryPropertyFlags       tries[] = {host_visible ? host | local : local, host_visible ? host : local};
+        VkResult                    err     = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        for (VkMemoryPropertyFlags properties : tries)
+        {
+            VkMemoryAllocateInfo alloc_info = {};
+            alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            alloc_info.allocationSize       = requirements.size;
+            alloc_info.memoryTypeIndex      = renderer_.find_memory_type(requirements.memoryTypeBits, properties);
+            if (alloc_info.memoryTypeIndex == UINT32_MAX)
+                continue;
+            err = vkAllocateMemory(device_, &alloc_info, allocator, &buffer.memory);
+            if (err == VK_SUCCESS)
+                break;
+        }
+        check_vk_result(err);
+        check_vk_result(vkBindBufferMemory(device_, buffer.buffer, buffer.memory, 0));
+        buffer.size = size;
+        if (host_visible)
+            check_vk_result(vkMapMemory(device_, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped));
+    }
+
+    void PrimitiveRenderer::destroy_buffer(Buffer& buffer)
+    {
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+        vkDestroyBuffer(device_, buffer.buffer, allocator);
+        vkFreeMemory(device_, buffer.memory, allocator);
+        buffer = Buffer {};
+    }
+
+    PrimitiveRenderer::BatchId PrimitiveRenderer::create_batch(uint32_t capacity)
+    {
+        if (capacity > max_batch_size_)
+            APPLOG_WARNING("Primitive batch of {} clamped to the device limit of {}", capacity, max_batch_size_);
+
+        Batch batch;
+        batch.capacity = std::clamp<uint32_t>(capacity, 1, max_batch_size_);
+        create_buffer(batch.storage, static_cast<VkDeviceSize>(batch.capacity) * sizeof(Primitive), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+
+        VkDescriptorSetAllocateInfo alloc_info = {};
+        alloc_info.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool              = descriptor_pool_;
+        alloc_info.descriptorSetCount          = 1;
+        alloc_info.pSetLayouts                 = &batch_layout_;
+        check_vk_result(vkAllocateDescriptorSets(device_, &alloc_info, &batch.set));
+
+        VkDescriptorBufferInfo buffer_info = {batch.storage.buffer, 0, VK_WHOLE_SIZE};
+        VkWriteDescriptorSet   write       = {};
+        write.sType                        = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet                       = batch.set;
+        write.descriptorCount              = 1;
+        write.descriptorType               = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo                  = &buffer_info;
+        vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+
+        const BatchId id = next_id_++;
+        batches_.emplace(id, batch);
+        return id;
+    }
+
+    void PrimitiveRenderer::destroy_batch(BatchId id)
+    {
+        auto it = batches_.find(id);
+        if (it == batches_.end())
+            return;
+
+        renderer_.wait_gpu_idle();
+        vkFreeDescriptorSets(device_, descriptor_pool_, 1, &it->second.set);
+        destroy_buffer(it->second.storage);
+        batches_.erase(it);
+    }
+
+    uint32_t PrimitiveRenderer::get_capacity(BatchId id) const
+    {
+        auto it = batches_.find(id);
+        return it != batches_.end() ? it->second.capacity : 0;
+    }
+
+    void PrimitiveRenderer::write_batch(BatchId id, uint32_t offset, std::span<const Primitive> primitives)
+    {
+        auto it = batches_.find(id);
+        if (it == batches_.end() || offset >= it->second.capacity || primitives.empty())
+            return;
+
+        Batch&         batch = it->second;
+        const uint32_t count = static_cast<uint32_t>(std::min<size_t>(primitives.size(), batch.capacity - offset));
+        if (offset < batch.drawn && !renderer_.is_frame_retired(batch.drawn_frame))
+            renderer_.wait_gpu_idle();
+        if (offset < batch.drawn)
+            batch.drawn = 0;
+        std::memcpy(static_cast<Primitive*>(batch.storage.mapped) + offset, primitives.data(), count * sizeof(Primitive));
+        batch.count = std::max(batch.count, offset + count);
+    }
+
+    void PrimitiveRenderer::set_count(BatchId id, uint32_t count)
+    {
+        auto it = batches_.find(id);
+        if (it != batches_.end())
+            it->second.count = std::min(count, it->second.capacity);
+    }
+
+    PrimitiveRenderer::CanvasId PrimitiveRenderer::create_canvas()
+    {
+        const CanvasId id = next_id_++;
+        canvases_.emplace(id, Canvas {});
+        return id;
+    }
+
+    void PrimitiveRenderer::destroy_canvas(CanvasId id)
+    {
+        auto it = canvases_.find(id);
+        if (it == canvases_.end())
+            return;
+
+        renderer_.wait_gpu_idle();
+        destroy_canvas_resources(it->second);
+        canvases_.erase(it);
+    }
+
+    void PrimitiveRenderer::destroy_canvas_resources(Canvas& canvas)
+    {
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+        if (canvas.texture)
+            renderer_.remove_image_texture(canvas.texture);
+        vkDestroyFramebuffer(device_, canvas.framebuffer, allocator);
+        vkDestroyImageView(device_, canvas.view, allocator);
+        vkDestroyImage(device_, canvas.image, allocator);
+        vkFreeMemory(device_, canvas.memory, allocator);
+        for (Buffer* buffer : {&canvas.visible, &canvas.indirect, &canvas.owners})
+        {
+            if (buffer->buffer)
+                destroy_buffer(*buffer);
+        }
+        if (canvas.set)
+            vkFreeDescriptorSets(device_, descriptor_pool_, 1, &canvas.set);
+        canvas = Canvas {};
+    }
+
+    void PrimitiveRenderer::resize_canvas(Canvas& canvas, uint32_t width, uint32_t height)
+    {
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+
+        // Keeps the culling buffers, the set is rewritten below anyway.
+        Buffer          visible  = std::exchange(canvas.visible, Buffer {});
+        Buffer          indirect = std::exchange(canvas.indirect, Buffer {});
+        VkDescriptorSet set      = std::exchange(canvas.set, VK_NULL_HANDLE);
+        renderer_.wait_gpu_idle();
+        destroy_canvas_resources(canvas);
+        canvas.visible  = visible;
+        canvas.indirect = indirect;
+        canvas.set      = set;
+        canvas.width    = width;
+        canvas.height   = height;
+
+        {
+            VkImageCreateInfo info = {};
+            info.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            info.imageType         = VK_IMAGE_TYPE_2D;
+            info.format            = VK_FORMAT_R8G8B8A8_UNORM;
+            info.extent            = {width, height, 1};
+            info.mipLevels         = 1;
+            info.arrayLayers       = 1;
+            info.samples           = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling            = VK_IMAGE_TILING_OPTIMAL;
+            info.usage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+            info.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+            check_vk_result(vkCreateImage(device_, &info, allocator, &canvas.image));
+
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(device_, canvas.image, &requirements);
+            VkMemoryAllocateInfo alloc_info = {};
+            alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            alloc_info.allocationSize       = requirements.size;
+            alloc_info.memoryTypeIndex      = renderer_.find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            check_vk_result(vkAllocateMemory(device_, &alloc_info, allocator, &canvas.memory));
+            check_vk_result(vkBindImageMemory(device_, canvas.image, canvas.memory, 0));
+        }
+        {
+            VkImageViewCreateInfo info       = {};
+            info.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            info.image                       = canvas.image;
+            info.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+            info.format                      = VK_FORMAT_R8G8B8A8_UNORM;
+            info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            info.subresourceRange.levelCount = 1;
+            info.subresourceRange.layerCount = 1;
+            check_vk_result(vkCreateImageView(device_, &info, allocator, &canvas.view));
+        }
+        {
+            VkFramebufferCreateInfo info = {};
+            info.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            info.renderPass              = render_pass_;
+            info.attachmentCount         = 1;
+            info.pAttachments            = &canvas.view;
+            info.width                   = width;
+            info.height                  = height;
+            info.layers                  = 1;
+            check_vk_result(vkCreateFramebuffer(device_, &info, allocator, &canvas.framebuffer));
+        }
+
+        create_buffer(canvas.owners, static_cast<VkDeviceSize>(width) * height * sizeof(uint32_t),
+                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+        canvas.texture = renderer_.add_image_texture(canvas.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        if (canvas.visible.buffer && canvas.indirect.buffer)
+            update_canvas_set(canvas);
+    }
+
+    void PrimitiveRenderer::reserve_canvas(Canvas& canvas, uint32_t visible_count, uint32_t draw_count)
+    {
+        const VkDeviceSize visible_size  = std::bit_ceil(std::max<VkDeviceSize>(visible_count, 1024) * sizeof(uint32_t));
+        const VkDeviceSize indirect_size = std::bit_ceil(std::max<VkDeviceSize>(draw_count, 4) * sizeof(VkDrawIndirectCommand));
+        if (canvas.visible.size >= visible_size && canvas.indirect.size >= indirect_size)
+            return;
+
+        renderer_.wait_gpu_idle();
+        if (canvas.visible.size < visible_size)
+        {
+            if (canvas.visible.buffer)
+                destroy_buffer(canvas.visible);
+            create_buffer(canvas.visible, visible_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false);
+        }
+        if (canvas.indirect.size < indirect_size)
+        {
+            if (canvas.indirect.buffer)
+                destroy_buffer(canvas.indirect);
+            create_buffer(canvas.indirect,
+                          indirect_size,
+                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                          false);
+        }
+        update_canvas_set(canvas);
+    }
+
+    // Only called with the GPU idle, the set is not in use.
+    void PrimitiveRenderer::update_canvas_set(Canvas& canvas)
+    {
+        if (!canvas.set)
+        {
+            VkDescriptorSetAllocateInfo alloc_info = {};
+            alloc_info.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            alloc_info.descriptorPool              = descriptor_pool_;
+            alloc_info.descriptorSetCount          = 1;
+            alloc_info.pSetLayouts                 = &canvas_layout_;
+            check_vk_result(vkAllocateDescriptorSets(device_, &alloc_info, &canvas.set));
+        }
+
+        VkDescriptorBufferInfo buffer_infos[3] = {
+            {canvas.visible.buffer, 0, VK_WHOLE_SIZE},
+            {canvas.indirect.buffer, 0, VK_WHOLE_SIZE},
+            {canvas.owners.buffer, 0, VK_WHOLE_SIZE},
+        };
+        VkWriteDescriptorSet writes[3] = {};
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet          = canvas.set;
+            writes[i].dstBinding      = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo     = &buffer_infos[i];
+        }
+        vkUpdateDescriptorSets(device_, 3, writes, 0, nullptr);
+    }
+
+    void PrimitiveRenderer::draw_canvas(CanvasId id, const ImVec2& size, const CanvasView& view, std::span<const BatchId> batch_ids)
+    {
+        auto it = canvases_.find(id);
+        if (it == canvases_.end() || size.x < 1.0f || size.y < 1.0f)
+        {
+            ImGui::Dummy(size);
+            return;
+        }
+        Canvas& canvas = it->second;
+
+        const ImVec2   scale  = ImGui::GetIO().DisplayFramebufferScale;
+        const uint32_t width  = std::max(1u, static_cast<uint32_t>(size.x * scale.x));
+        const uint32_t height = std::max(1u, static_cast<uint32_t>(size.y * scale.y));
+        if (canvas.width != width || canvas.height != height)
+            resize_canvas(canvas, width, height);
+
+        // The image keeps the full size, so scale changes never reallocate it.
+        const float    render_scale  = renderer_.get_render_scale();
+        const uint32_t render_width  = std::clamp(static_cast<uint32_t>(width * render_scale), 1u, width);
+        const uint32_t render_height = std::clamp(static_cast<uint32_t>(height * render_scale), 1u, height);
+
+        std::pmr::vector<Batch*> batches(has_subsystem<FrameArena>() ? get_subsystem<FrameArena>().get_resource() : std::pmr::get_default_resource());
+        uint32_t                 visible_count = 0;
+        for (BatchId batch_id : batch_ids)
+        {
+            auto batch = batches_.find(batch_id);
+            if (batch == batches_.end())
+                continue;
+            batches.push_back(&batch->second);
+            visible_count += batch->second.count;
+        }
+        reserve_canvas(canvas, visible_count, static_cast<uint32_t>(batches.size()));
+
+        const ImVec2 extent  = {view.max.x - view.min.x, view.max.y - view.min.y};
+        const float  scale_x = extent.x != 0.0f ? render_width / extent.x : 1.0f;
+        const float  scale_y = extent.y != 0.0f ? render_height / extent.y : 1.0f;
+        const ImVec4 clear   = ImGui::ColorConvertU32ToFloat4(view.background);
+        uint32_t     base    = 0;
+
+        CanvasPass& pass = acquire_pass();
+        pass.framebuffer = canvas.framebuffer;
+        pass.image       = canvas.image;
+        pass.set         = canvas.set;
+        pass.indirect    = canvas.indirect.buffer;
+        pass.owners      = canvas.owners.buffer;
+        pass.owners_size = canvas.owners.size;
+        pass.width         = width;
+        pass.height        = height;
+        pass.render_width  = render_width;
+        pass.render_height = render_height;
+        pass.clear.color   = {{clear.x, clear.y, clear.z, clear.w}};
+        pass.cull_pipeline = get_pipeline(cull_id_, cull_pipeline_);
+        pass.draw_pipeline = get_pipeline(draw_id_, draw_pipeline_);
+        for (Batch* batch : batches)
+        {
+            Params params         = {};
+            params.scale[0]       = scale_x;
+            params.scale[1]       = scale_y;
+            params.offset[0]      = -view.min.x * scale_x;
+            params.offset[1]      = -view.min.y * scale_y;
+            params.canvas_size[0] = static_cast<float>(render_width);
+            params.canvas_size[1] = static_cast<float>(render_height);
+            params.count          = batch->count;
+            params.visible_base   = base;
+            params.draw_slot      = static_cast<uint32_t>(pass.draws.size());
+            params.lod_size       = view.lod_size;
+            params.size_scale     = render_scale;
+            pass.draws.push_back({batch->set, params});
+
+            base += batch->count;
+            // Frames that drew it before and are retired no longer count.
+            batch->drawn       = renderer_.is_frame_retired(batch->drawn_frame) ? batch->count : std::max(batch->drawn, batch->count);
+            batch->drawn_frame = renderer_.get_frame_count();
+        }
+
+        // Two pointers, which std::function keeps inline.
+        renderer_.add_render_pass([this, pass = &pass](VkCommandBuffer command_buffer) { record(command_buffer, *pass); });
+        const ImVec2 uv_max = {static_cast<float>(render_width) / width, static_cast<float>(render_height) / height};
+        ImGui::Image(canvas.texture, size, ImVec2(0.0f, 0.0f), uv_max);
+    }
+
+    PrimitiveRenderer::CanvasPass& PrimitiveRenderer::acquire_pass()
+    {
+        auto it = std::find_if(passes_.begin(), passes_.end(), [this](const auto& pass) { return renderer_.is_frame_retired(pass->frame); });
+        if (it == passes_.end())
+            it = passes_.insert(passes_.end(), std::make_unique<CanvasPass>());
+
+        CanvasPass& pass = **it;
+        pass.draws.clear();
+        pass.frame = renderer_.get_frame_count();
+        return pass;
+    }
+
+    void PrimitiveRenderer::record(VkCommandBuffer command_buffer, const CanvasPass& pass) const
+    {
+        auto barrier =
+            [command_buffer](VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+        {
+            VkMemoryBarrier memory_barrier = {};
+            memory_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memory_barrier.srcAccessMask   = src_access;
+            memory_barrier.dstAccessMask   = dst_access;
+            vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+        };
+        const VkAccessFlags      compute_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        const VkShaderStageFlags push_stages    = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+
+        // The previous frame's culling and drawing may still read what is cleared here.
+        barrier(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdFillBuffer(command_buffer, pass.indirect, 0, VK_WHOLE_SIZE, 0);
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pass.cull_pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout_, 0, 1, &pass.set, 0, nullptr);
+        for (size_t i = 0; i < pass.draws.size(); ++i)
+        {
+            const CanvasPass::Draw& draw   = pass.draws[i];
+            Params                  params = draw.params;
+            const uint32_t          groups = (params.count + workgroup_size - 1) / workgroup_size;
+            const bool              lod    = params.lod_size > 0.0f;
+            if (lod)
+            {
+                if (i > 0)
+                    barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, compute_access, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+                vkCmdFillBuffer(command_buffer, pass.owners, 0, pass.owners_size, 0);
+            }
+            if (i == 0 || lod)
+                barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, compute_access);
+            if (groups == 0)
+                continue;
+
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout_, 1, 1, &draw.set, 0, nullptr);
+            if (lod)
+            {
+                params.pass = 0;
+                vkCmdPushConstants(command_buffer, pipeline_layout_, push_stages, 0, sizeof(params), &params);
+                vkCmdDispatch(command_buffer, groups, 1, 1);
+                barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, compute_access, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, compute_access);
+            }
+            params.pass = 1;
+            vkCmdPushConstants(command_buffer, pipeline_layout_, push_stages, 0, sizeof(params), &params);
+            vkCmdDispatch(command_buffer, groups, 1, 1);
+        }
+        barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_WRITE_BIT,
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+
+        VkRenderPassBeginInfo begin    = {};
+        begin.sType                    = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        begin.renderPass               = render_pass_;
+        begin.framebuffer              = pass.framebuffer;
+        begin.renderArea.extent.width  = pass.width;
+        begin.renderArea.extent.height = pass.height;
+        begin.clearValueCount          = 1;
+        begin.pClearValues             = &pass.clear;
+        vkCmdBeginRenderPass(command_buffer, &begin, VK_SUBPASS_CONTENTS_INLINE);
+
+        // The whole image is cleared, so the stretched part of it never filters in stale texels at its edges.
+        VkViewport viewport = {0.0f, 0.0f, static_cast<float>(pass.render_width), static_cast<float>(pass.render_height), 0.0f, 1.0f};
+        VkRect2D   scissor  = {{0, 0}, {pass.render_width, pass.render_height}};
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.draw_pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout_, 0, 1, &pass.set, 0, nullptr);
+        if (bindless_set_)
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout_, 2, 1, &bindless_set_, 0, nullptr);
+        for (const CanvasPass::Draw& draw : pass.draws)
+        {
+            if (draw.params.count == 0)
+                continue;
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout_, 1, 1, &draw.set, 0, nullptr);
+            vkCmdPushConstants(command_buffer, pipeline_layout_, push_stages, 0, sizeof(draw.params), &draw.params);
+            vkCmdDrawIndirect(command_buffer, pass.indirect, draw.params.draw_slot * sizeof(VkDrawIndirectCommand), 1, sizeof(VkDrawIndirectCommand));
+        }
+        vkCmdEndRenderPass(command_buffer);
+    }
+} // namespace core
@@ -0,0 +1,206 @@
+#pragma once
+#include "imgui.h"
+#include "vulkan/vulkan.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace core
+{
+    class ShaderManager;
+    class VulkanRenderer;
+
+    enum class PrimitiveKind : uint32_t
+    {
+        quad,  // Axis aligned rectangle between p0 and p1
+        line,  // From p0 to p1, size pixels wide
+        point, // Square of size pixels centered on p0
+        image, // Rectangle like quad, showing the bindless texture texture tinted by color
+    };
+
+    // One instance as the shaders read it (std430, see shaders/primitive_common.glsl). Positions are in the
+    // world space of the canvas view, size in pixels, color as IM_COL32.
+    struct Primitive
+    {
+        float         x0      = 0.0f;
+        float         y0      = 0.0f;
+        float         x1      = 0.0f;
+        float         y1      = 0.0f;
+        ImU32         color   = 0;
+        float         size    = 1.0f;
+        PrimitiveKind kind    = PrimitiveKind::quad;
+        uint32_t      texture = 0; // Bindless heap index of an image, see VulkanRenderer::create_bindless_texture()
+
+        static Primitive quad(const ImVec2& min, const ImVec2& max, ImU32 color)
+        {
+            return {min.x, min.y, max.x, max.y, color, 0.0f, PrimitiveKind::quad};
+        }
+        static Primitive line(const ImVec2& a, const ImVec2& b, float width, ImU32 color)
+        {
+            return {a.x, a.y, b.x, b.y, color, width, PrimitiveKind::line};
+        }
+        static Primitive point(const ImVec2& p, float size, ImU32 color) { return {p.x, p.y, p.x, p.y, color, size, PrimitiveKind::point}; }
+        static Primitive image(const ImVec2& min, const ImVec2& max, uint32_t texture, ImU32 tint = IM_COL32_WHITE)
+        {
+            return {min.x, min.y, max.x, max.y, tint, 0.0f, PrimitiveKind::image, texture};
+        }
+    };
+    static_assert(sizeof(Primitive) == 32);
+
+    // World space rectangle a canvas shows; min maps to the top left pixel, swap the y values for y up.
+    struct CanvasView
+    {
+        ImVec2 min;
+        ImVec2 max;
+        ImU32  background = IM_COL32(0, 0, 0, 0);
+        float  lod_size   = 1.0f; // Primitives smaller than this many pixels collapse to one per pixel
+    };
+
+    // Draws large amounts of 2D quads, lines, points and images for plots, timelines and thumbnail grids,
+    // where ImGui's CPU built draw lists (and its descriptor set per texture) do not scale. Primitives live
+    // in batches: persistently mapped storage buffers the GPU reads directly. Each frame a compute pass culls
+    // every batch against the canvas view and collapses sub-pixel primitives, then the survivors are drawn
+    // instanced with indirect draws into the canvas image, which ImGui shows like any texture. Images sample
+    // the bindless heap, bound once per canvas; without one they are drawn as plain quads of their tint.
+    // With dynamic resolution only the top left part of the image is drawn, and ImGui stretches it over the
+    // canvas; sizes in pixels are scaled along, so lines and points keep their width on screen.
+    // The shaders are embedded at build time. A build that still has their sources (CORE_PRIMITIVE_SHADER_DIR)
+    // also loads them through ShaderManager, so an edit rebuilds the pipelines while the old ones keep drawing.
+    class PrimitiveRenderer
+    {
+    public:
+        using BatchId  = uint32_t;
+        using CanvasId = uint32_t;
+
+        PrimitiveRenderer();
+        ~PrimitiveRenderer();
+
+        // A batch holds up to capacity primitives (clamped to what a storage buffer and a dispatch allow).
+        BatchId  create_batch(uint32_t capacity);
+        void     destroy_batch(BatchId batch);
+        uint32_t get_capacity(BatchId batch) const;
+
+        // Copies primitives to [offset, offset + size) and grows the count to cover them. Appending past the
+        // count is free, and so is overwriting primitives whose last draw the GPU has retired; overwriting
+        // ones a frame in flight still draws waits for the GPU. Data that changes every frame is better
+        // rotated through VulkanRenderer::get_frames_in_flight() + 1 batches.
+        void write_batch(BatchId batch, uint32_t offset, std::span<const Primitive> primitives);
+        void set_count(BatchId batch, uint32_t count);
+
+        CanvasId create_canvas();
+        void     destroy_canvas(CanvasId canvas);
+
+        // Renders batches, in order, into the canvas this frame and adds it as an ImGui::Image of size.
+        // Call it from UI code, once per canvas and frame.
+        void draw_canvas(CanvasId canvas, const ImVec2& size, const CanvasView& view, std::span<const BatchId> batches);
+
+    private:
+        struct Buffer
+        {
+            VkBuffer       buffer = VK_NULL_HANDLE;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize   size   = 0;
+            void*          mapped = nullptr;
+        };
+
+        struct Batch
+        {
+            Buffer          storage;
+            VkDescriptorSet set      = VK_NULL_HANDLE;
+            uint32_t        capacity    = 0;
+            uint32_t        count       = 0;
+            uint32_t        drawn       = 0; // Most drawn by frames in flight, primitives below it may be in use by the GPU
+            uint64_t        drawn_frame = 0; // VulkanRenderer::get_frame_count() of the last draw
+        };
+
+        struct Canvas
+        {
+            VkImage         image       = VK_NULL_HANDLE;
+            VkDeviceMemory  memory      = VK_NULL_HANDLE;
+            VkImageView     view        = VK_NULL_HANDLE;
+            VkFramebuffer   framebuffer = VK_NULL_HANDLE;
+            ImTextureID     texture     = 0;
+            uint32_t        width       = 0;
+            uint32_t        height      = 0;
+            Buffer          visible;  // Indices of the primitives that survived culling, per batch
+            Buffer          indirect; // VkDrawIndirectCommand per batch
+            Buffer          owners;   // uint per pixel for the LOD pass
+            VkDescriptorSet set = VK_NULL_HANDLE;
+        };
+
+        // Push constants, mirrors Params in shaders/primitive_common.glsl.
+        struct Params
+        {
+            float    scale[2];
+            float    offset[2];
+            float    canvas_size[2];
+            uint32_t count;
+            uint32_t visible_base;
+            uint32_t draw_slot;
+            uint32_t pass;
+            float    lod_size;
+            float    size_scale;
+        };
+
+        // Everything one canvas pass records, copied so the pass can run on the render thread. Passes are
+        // pooled and reused once the frame that added them is retired, so draws keeps its capacity.
+        struct CanvasPass
+        {
+            struct Draw
+            {
+                VkDescriptorSet set;
+                Params          params;
+            };
+
+            VkFramebuffer     framebuffer;
+            VkImage           image;
+            VkDescriptorSet   set;
+            VkBuffer          indirect;
+            VkBuffer          owners;
+            VkDeviceSize      owners_size;
+            uint32_t          width;
+            uint32_t          height;
+            uint32_t          render_width; // Part of the image drawn into, see VulkanRenderer::get_render_scale()
+            uint32_t          render_height;
+            VkClearValue      clear;
+            VkPipeline        cull_pipeline; // Picked when the pass was added; ShaderManager may replace them later
+            VkPipeline        draw_pipeline;
+            std::vector<Draw> draws;
+            uint64_t          frame; // VulkanRenderer::get_frame_count() when it was added
+        };
+
+        void        create_pipelines();
+        void        load_shader_sources();
+        VkPipeline  get_pipeline(uint32_t shader_pipeline, VkPipeline embedded) const;
+        void        create_buffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool host_visible);
+        void        destroy_buffer(Buffer& buffer);
+        void        resize_canvas(Canvas& canvas, uint32_t width, uint32_t height);
+        void        reserve_canvas(Canvas& canvas, uint32_t visible_count, uint32_t draw_count);
+        void        update_canvas_set(Canvas& canvas);
+        void        destroy_canvas_resources(Canvas& canvas);
+        CanvasPass& acquire_pass();
+        void        record(VkCommandBuffer command_buffer, const CanvasPass& pass) const;
+
+        VulkanRenderer&       renderer_;
+        VkDevice              device_          = VK_NULL_HANDLE;
+        VkDescriptorSetLayout canvas_layout_   = VK_NULL_HANDLE;
+        VkDescriptorSetLayout batch_layout_    = VK_NULL_HANDLE;
+        VkDescriptorPool      descriptor_pool_ = VK_NULL_HANDLE;
+        VkPipelineLayout      pipeline_layout_ = VK_NULL_HANDLE;
+        VkDescriptorSet       bindless_set_    = VK_NULL_HANDLE;
+        VkPipeline            cull_pipeline_   = VK_NULL_HANDLE;
+        VkPipeline            draw_pipeline_   = VK_NULL_HANDLE;
+        ShaderManager*        shaders_         = nullptr; // Set while the shader sources are watched
+        uint32_t              cull_id_         = 0;       // ShaderManager pipelines, drawn with once built
+        uint32_t              draw_id_         = 0;
+        VkRenderPass          render_pass_     = VK_NULL_HANDLE;
+        uint32_t              max_batch_size_  = 0;
+        uint32_t              next_id_         = 1;
+
+        std::unordered_map<BatchId, Batch>       batches_;
+        std::unordered_map<CanvasId, Canvas>     canvases_;
+        std::vector<std::unique_ptr<CanvasPass>> passes_;
+    };
+} // namespace core
@@ -0,0 +1,47 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "primitive_common.glsl"
+
+layout(std430, set = 0, binding = 0) readonly buffer Visible
+{
+    uint visible[];
+};
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec2 out_uv;
+layout(location = 2) flat out uint out_texture;
+
+const vec2 corners[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+// One instance per visible primitive, expanded to two triangles here; nothing is less than a pixel wide.
+void main()
+{
+    Primitive p      = primitives[visible[params.visible_base + gl_InstanceIndex]];
+    vec2      corner = corners[gl_VertexIndex];
+    vec2      a      = to_pixels(p.p0);
+    vec2      b      = to_pixels(p.p1);
+    vec2      pixel;
+    if (p.kind == PRIMITIVE_QUAD || p.kind == PRIMITIVE_IMAGE)
+    {
+        vec2 lo = min(a, b);
+        vec2 hi = max(max(a, b), lo + 1.0);
+        pixel   = mix(lo, hi, corner);
+    }
+    else if (p.kind == PRIMITIVE_LINE)
+    {
+        vec2  direction = b - a;
+        float len       = length(direction);
+        direction       = len > 0.0 ? direction / len : vec2(1.0, 0.0);
+        vec2 normal     = vec2(-direction.y, direction.x) * primitive_size(p) * 0.5;
+        pixel           = mix(a, b, corner.x) + normal * (corner.y * 2.0 - 1.0);
+    }
+    else
+    {
+        pixel = a + (corner - 0.5) * primitive_size(p);
+    }
+
+    gl_Position = vec4(pixel / params.canvas_size * 2.0 - 1.0, 0.0, 1.0);
+    out_color   = unpackUnorm4x8(p.color);
+    out_uv      = corner;
+    out_texture = p.kind == PRIMITIVE_IMAGE ? p.texture : NO_TEXTURE;
+}
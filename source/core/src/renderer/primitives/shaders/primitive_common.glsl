@@ -0,0 +1,51 @@
+// Shared by the primitive cull and draw shaders, mirrors core::Primitive and PrimitiveRenderer::Params.
+
+#define PRIMITIVE_QUAD  0u
+#define PRIMITIVE_LINE  1u
+#define PRIMITIVE_POINT 2u
+#define PRIMITIVE_IMAGE 3u
+
+#define NO_TEXTURE 0xFFFFFFFFu
+
+struct Primitive
+{
+    vec2  p0;
+    vec2  p1;
+    uint  color;
+    float size;
+    uint  kind;
+    uint  texture; // Bindless heap index, PRIMITIVE_IMAGE only
+};
+
+layout(push_constant) uniform Params
+{
+    vec2  scale;        // World to canvas pixels: pixel = world * scale + offset
+    vec2  offset;
+    vec2  canvas_size;  // In pixels
+    uint  count;        // Primitives in the batch
+    uint  visible_base; // First element of the batch in the visible index buffer
+    uint  draw_slot;    // Indirect draw command of the batch
+    uint  pass;         // Cull shader: 0 claims pixels for sub-pixel primitives, 1 emits the visible ones
+    float lod_size;     // Primitives smaller than this on both axes collapse into their pixel
+    float size_scale;   // Of Primitive::size, the canvas' render scale
+} params;
+
+layout(std430, set = 1, binding = 0) readonly buffer Primitives
+{
+    Primitive primitives[];
+};
+
+vec2 to_pixels(vec2 world) { return world * params.scale + params.offset; }
+
+// Line width or point size in canvas pixels.
+float primitive_size(Primitive p) { return max(p.size * params.size_scale, 1.0); }
+
+// Pixel space bounds of a primitive as drawn.
+void primitive_bounds(Primitive p, out vec2 lo, out vec2 hi)
+{
+    vec2  a   = to_pixels(p.p0);
+    vec2  b   = p.kind == PRIMITIVE_POINT ? a : to_pixels(p.p1);
+    float pad = p.kind == PRIMITIVE_QUAD || p.kind == PRIMITIVE_IMAGE ? 0.0 : primitive_size(p) * 0.5;
+    lo        = min(a, b) - pad;
+    hi        = max(a, b) + pad;
+}
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// primitive.frag with images: used when the device has a bindless heap (see core::BindlessHeap).
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+
+layout(location = 0) in vec4 in_color;
+layout(location = 1) in vec2 in_uv;
+layout(location = 2) flat in uint in_texture;
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    out_color = in_color;
+    // Neighbouring instances show different textures, so the index is not uniform.
+    if (in_texture != 0xFFFFFFFFu)
+        out_color *= texture(textures[nonuniformEXT(in_texture)], in_uv);
+}
@@ -0,0 +1,87 @@
+#include "render_thread.h"
+#include "memory/memory_tracker.h"
+#include "system/watchdog.h"
+#include <algorithm>
+
+namespace core
+{
+    RenderThread::RenderThread(size_t depth, RenderFunc render) : render_(std::move(render))
+    {
+        // One packet is being rendered while the others are queued or filled.
+        const size_t count = std::max<size_t>(1, depth) + 1;
+        for (size_t i = 0; i < count; ++i)
+        {
+            packets_.push_back(std::make_unique<FramePacket>());
+            free_.push_back(packets_.back().get());
+        }
+        memory_tag_ = MemoryTracker::get_current_tag();
+        thread_     = std::thread([this]() { run(); });
+    }
+
+    RenderThread::~RenderThread()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        thread_.join();
+    }
+
+    FramePacket& RenderThread::begin_frame()
+    {
+        WatchdogScope    scope("RenderThread::begin_frame: waiting for a free packet");
+        std::unique_lock lock(mutex_);
+        condition_.wait(lock, [this]() { return !free_.empty(); });
+        filling_ = free_.back();
+        free_.pop_back();
+        filling_->view_count = 0;
+        filling_->passes.clear();
+        return *filling_;
+    }
+
+    void RenderThread::submit_frame()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            queued_.push_back(filling_);
+            filling_ = nullptr;
+        }
+        condition_.notify_all();
+    }
+
+    void RenderThread::wait_idle()
+    {
+        WatchdogScope    scope("RenderThread::wait_idle");
+        std::unique_lock lock(mutex_);
+        condition_.wait(lock, [this]() { return queued_.empty() && !rendering_; });
+    }
+
+    void RenderThread::run()
+    {
+        MemoryScope scope(memory_tag_);
+        Watchdog::name_thread("render");
+        for (;;)
+        {
+            FramePacket* packet = nullptr;
+            {
+                std::unique_lock lock(mutex_);
+                condition_.wait(lock, [this]() { return stopping_ || !queued_.empty(); });
+                if (queued_.empty())
+                    return;
+                packet = queued_.front();
+                queued_.pop_front();
+                rendering_ = true;
+            }
+
+            render_(*packet);
+
+            {
+                std::lock_guard lock(mutex_);
+                free_.push_back(packet);
+                rendering_ = false;
+            }
+            condition_.notify_all();
+        }
+    }
+} // namespace core
@@ -0,0 +1,76 @@
+#pragma once
+#include "renderer/draw_data_hash.h"
+#include "renderer/draw_data_snapshot.h"
+#include "vulkan/vulkan.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core
+{
+    // Recorded ahead of the UI of a frame, outside of any render pass, e.g. to draw into offscreen images.
+    using RenderPass = std::function<void(VkCommandBuffer)>;
+
+    // Everything the render thread needs of one frame: the draw data of every window to present.
+    struct FramePacket
+    {
+        struct View
+        {
+            uint32_t         window_id = 0;
+            DrawDataSnapshot draw_data;
+            DrawDataHash     hash; // Of draw_data, computed on the main thread
+        };
+
+        // Views are kept across frames for their buffers, only the first view_count belong to this frame.
+        std::deque<View>        views;
+        size_t                  view_count = 0;
+        std::vector<RenderPass> passes;
+
+        View& add_view(uint32_t window_id)
+        {
+            if (view_count == views.size())
+                views.emplace_back();
+            View& view     = views[view_count++];
+            view.window_id = window_id;
+            return view;
+        }
+    };
+
+    // Runs render(packet) on its own thread for the frames the main thread hands over. At most depth frames
+    // wait in the queue; begin_frame() blocks beyond that, which bounds how far the main thread runs ahead.
+    class RenderThread
+    {
+    public:
+        using RenderFunc = std::function<void(FramePacket&)>;
+
+        RenderThread(size_t depth, RenderFunc render);
+        ~RenderThread();
+
+        // Returns an empty packet to fill for the next frame.
+        FramePacket& begin_frame();
+        // Queues the packet of begin_frame() for rendering.
+        void submit_frame();
+        // Returns once every submitted frame has been rendered.
+        void wait_idle();
+
+    private:
+        void run();
+
+        RenderFunc                                render_;
+        std::vector<std::unique_ptr<FramePacket>> packets_;
+        std::vector<FramePacket*>                 free_;
+        std::deque<FramePacket*>                  queued_;
+        FramePacket*                              filling_ = nullptr;
+        std::mutex                                mutex_;
+        std::condition_variable                   condition_;
+        bool                                      rendering_  = false;
+        bool                                      stopping_   = false;
+        uint16_t                                  memory_tag_ = 0;
+        std::thread                               thread_;
+    };
+} // namespace core
@@ -0,0 +1,523 @@
+#include "shader_manager.h"
+#include "cmd_line/parser.hpp"
+#include "jobs/job_system.h"
+#include "logger.h"
+#include "renderer/vulkan/vulkan_renderer.h"
+#include <SDL3/SDL_process.h>
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <unordered_set>
+
+namespace core
+{
+    namespace
+    {
+        constexpr uint32_t spirv_magic = 0x07230203u;
+        // Bump when the compiler options below change, so old cache entries are not picked up.
+        constexpr uint64_t cache_version = 1;
+
+        uint64_t mix(uint64_t hash, uint64_t value)
+        {
+            hash ^= value * 0x9E3779B97F4A7C15ull;
+            hash = (hash << 31 | hash >> 33) * 0xBF58476D1CE4E5B9ull;
+            return hash;
+        }
+
+        uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+        {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            size_t      i     = 0;
+            for (; i + 8 <= size; i += 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, 8);
+                hash = mix(hash, word);
+            }
+            if (i < size)
+            {
+                uint64_t word = 0;
+                std::memcpy(&word, bytes + i, size - i);
+                hash = mix(hash, word);
+            }
+            return mix(hash, size);
+        }
+
+        uint64_t hash_string(uint64_t hash, std::string_view text) { return hash_bytes(hash, text.data(), text.size()); }
+
+        bool read_file(const std::filesystem::path& path, std::vector<char>& bytes)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+                return false;
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        std::shared_ptr<const std::vector<uint32_t>> read_spirv(const std::filesystem::path& path)
+        {
+            std::vector<char> bytes;
+            if (!read_file(path, bytes) || bytes.size() < sizeof(uint32_t) || bytes.size() % sizeof(uint32_t) != 0)
+                return nullptr;
+
+            auto words = std::make_shared<std::vector<uint32_t>>(bytes.size() / sizeof(uint32_t));
+            std::memcpy(words->data(), bytes.data(), bytes.size());
+            if ((*words)[0] != spirv_magic)
+                return nullptr;
+            return words;
+        }
+
+        // Appends path and, depth first, the files its #include "..." lines name, relative to the including file.
+        void collect_sources(const std::filesystem::path& path, std::vector<std::filesystem::path>& files)
+        {
+            if (std::find(files.begin(), files.end(), path) != files.end())
+                return;
+            files.push_back(path);
+
+            std::ifstream file(path);
+            std::string   line;
+            while (std::getline(file, line))
+            {
+                const size_t start = line.find_first_not_of(" \t");
+                if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+                    continue;
+                const size_t open  = line.find('"', start + 8);
+                const size_t close = open != std::string::npos ? line.find('"', open + 1) : std::string::npos;
+                if (close == std::string::npos)
+                    continue;
+                const auto include = path.parent_path() / line.substr(open + 1, close - open - 1);
+                if (std::filesystem::exists(include))
+                    collect_sources(include.lexically_normal(), files);
+            }
+        }
+
+        const char* get_stage_name(VkShaderStageFlagBits stage)
+        {
+            switch (stage)
+            {
+            case VK_SHADER_STAGE_VERTEX_BIT: return "vertex";
+            case VK_SHADER_STAGE_FRAGMENT_BIT: return "fragment";
+            case VK_SHADER_STAGE_COMPUTE_BIT: return "compute";
+            case VK_SHADER_STAGE_GEOMETRY_BIT: return "geometry";
+            case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return "tesscontrol";
+            case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: return "tesseval";
+            default: return nullptr;
+            }
+        }
+
+        bool is_hlsl(const ShaderDesc& desc) { return std::filesystem::path(desc.path).extension() == ".hlsl"; }
+
+        bool is_spirv(const ShaderDesc& desc) { return std::filesystem::path(desc.path).extension() == ".spv"; }
+
+        std::vector<std::filesystem::file_time_type> get_write_times(const std::vector<std::filesystem::path>& files)
+        {
+            std::vector<std::filesystem::file_time_type> times;
+            times.reserve(files.size());
+            for (const auto& file : files)
+            {
+                std::error_code error;
+                times.push_back(std::filesystem::last_write_time(file, error));
+            }
+            return times;
+        }
+
+        template<typename T>
+        bool is_ready(const std::future<T>& future)
+        {
+            return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+    } // namespace
+
+    ShaderManager::ShaderManager() : renderer_(get_subsystem<VulkanRenderer>())
+    {
+        const auto& parser = Parser::instance();
+        cache_dir_         = parser.getOptionValue("shader-cache", "shader_cache");
+        watch_interval_    = std::stof(parser.getOptionValue("shader-watch-interval", "0.5"));
+
+        compiler_ = parser.getOptionValue("glslc");
+        if (compiler_.empty())
+        {
+            const char* sdk    = std::getenv("VULKAN_SDK");
+            const auto  in_sdk = sdk ? std::filesystem::path(sdk) / "bin" / "glslc" : std::filesystem::path();
+            compiler_          = sdk && std::filesystem::exists(in_sdk) ? in_sdk.string() : "glslc";
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(cache_dir_, error);
+        if (error)
+            APPLOG_WARNING("Can not create shader cache {}: {}", cache_dir_.string(), error.message());
+
+        connect<FrameBegin, ShaderManager, &ShaderManager::frame_begin>(*this);
+    }
+
+    ShaderManager::~ShaderManager()
+    {
+        disconnect(*this);
+        // Jobs reference this object, none may outlive it.
+        for (auto& [id, shader] : shaders_)
+        {
+            if (shader.pending.valid())
+                shader.pending.wait();
+        }
+
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+        const VkDevice               device    = renderer_.get_device();
+        renderer_.wait_gpu_idle();
+        for (auto& [id, pipeline] : pipelines_)
+        {
+            if (pipeline.pending.valid())
+                vkDestroyPipeline(device, pipeline.pending.get(), allocator);
+            vkDestroyPipeline(device, pipeline.pipeline, allocator);
+        }
+        for (auto& pending : orphaned_)
+            vkDestroyPipeline(device, pending.get(), allocator);
+        for (const Retired& retired : retired_)
+            vkDestroyPipeline(device, retired.pipeline, allocator);
+    }
+
+    ShaderManager::ShaderId ShaderManager::load(const ShaderDesc& desc)
+    {
+        for (auto& [id, shader] : shaders_)
+        {
+            if (shader.desc.path == desc.path && shader.desc.stage == desc.stage && shader.desc.entry_point == desc.entry_point &&
+                shader.desc.defines == desc.defines)
+                return id;
+        }
+
+        const ShaderId id     = next_id_++;
+        Shader&        shader = shaders_[id];
+        shader.desc           = desc;
+        start_compile(shader);
+        return id;
+    }
+
+    std::span<const uint32_t> ShaderManager::get_spirv(ShaderId id) const
+    {
+        auto it = shaders_.find(id);
+        if (it == shaders_.end() || !it->second.spirv)
+            return {};
+        return *it->second.spirv;
+    }
+
+    ShaderManager::PipelineId ShaderManager::create_pipeline(std::vector<ShaderId>   shaders,
+                                                             SpecializationConstants constants,
+                                                             PipelineBuilder         builder)
+    {
+        const PipelineId id       = next_id_++;
+        Pipeline&        pipeline = pipelines_[id];
+        pipeline.shaders          = std::move(shaders);
+        pipeline.constants        = std::make_shared<SpecializationConstants>(std::move(constants));
+        pipeline.builder          = std::move(builder);
+        start_build(pipeline);
+        return id;
+    }
+
+    void ShaderManager::destroy_pipeline(PipelineId id)
+    {
+        auto it = pipelines_.find(id);
+        if (it == pipelines_.end())
+            return;
+
+        if (it->second.pending.valid())
+            orphaned_.push_back(std::move(it->second.pending));
+        retire(it->second.pipeline);
+        pipelines_.erase(it);
+    }
+
+    VkPipeline ShaderManager::get_pipeline(PipelineId id) const
+    {
+        auto it = pipelines_.find(id);
+        return it != pipelines_.end() ? it->second.pipeline : VK_NULL_HANDLE;
+    }
+
+    void ShaderManager::flush()
+    {
+        // Applying compiles starts builds, which need another round.
+        for (;;)
+        {
+            apply_results(true);
+            const bool pending = std::any_of(shaders_.begin(), shaders_.end(), [](const auto& entry) { return entry.second.pending.valid(); }) ||
+                                 std::any_of(pipelines_.begin(), pipelines_.end(), [](const auto& entry) { return entry.second.pending.valid(); });
+            if (!pending)
+                return;
+        }
+    }
+
+    void ShaderManager::frame_begin(const FrameBegin& event)
+    {
+        apply_results(false);
+
+        if (watch_interval_ > 0.0f)
+        {
+            watch_elapsed_ += event.delta_time;
+            if (watch_elapsed_ >= watch_interval_)
+            {
+                watch_elapsed_ = 0.0f;
+                check_files();
+            }
+        }
+
+        const VkAllocationCallbacks* allocator = renderer_.get_allocator();
+        const VkDevice               device    = renderer_.get_device();
+        // Replaced pipelines live until no frame in flight can bind them, however deep --render-queue-depth makes it.
+        std::erase_if(retired_,
+                      [&](const Retired& retired)
+                      {
+                          if (!renderer_.is_frame_retired(retired.frame))
+                              return false;
+                          vkDestroyPipeline(device, retired.pipeline, allocator);
+                          return true;
+                      });
+        std::erase_if(orphaned_,
+                      [&](std::future<VkPipeline>& pending)
+                      {
+                          if (!is_ready(pending))
+                              return false;
+                          vkDestroyPipeline(device, pending.get(), allocator);
+                          return true;
+                      });
+    }
+
+    void ShaderManager::start_compile(Shader& shader)
+    {
+        shader.stale   = false;
+        shader.pending = get_subsystem<JobSystem>().submit([this, desc = shader.desc]() { return compile(desc); });
+    }
+
+    void ShaderManager::start_build(Pipeline& pipeline)
+    {
+        // Builds once every stage compiled at least once; the last compile to finish starts it otherwise.
+        std::vector<std::pair<VkShaderStageFlagBits, Spirv>> stages;
+        std::vector<std::string>                             entry_points;
+        for (ShaderId shader_id : pipeline.shaders)
+        {
+            auto it = shaders_.find(shader_id);
+            if (it == shaders_.end() || !it->second.spirv)
+                return;
+            stages.emplace_back(it->second.desc.stage, it->second.spirv);
+            entry_points.push_back(it->second.desc.entry_point);
+        }
+        if (pipeline.pending.valid())
+        {
+            pipeline.stale = true;
+            return;
+        }
+
+        pipeline.stale   = false;
+        pipeline.pending = get_subsystem<JobSystem>().submit(
+            [device    = renderer_.get_device(),
+             allocator = renderer_.get_allocator(),
+             stages    = std::move(stages),
+             entries   = std::move(entry_points),
+             constants = pipeline.constants,
+             builder   = pipeline.builder]() -> VkPipeline
+            {
+                const VkSpecializationInfo                   specialization = constants->get_info();
+                std::vector<VkPipelineShaderStageCreateInfo> infos(stages.size());
+                for (size_t i = 0; i < stages.size(); ++i)
+                {
+                    VkShaderModuleCreateInfo module_info = {};
+                    module_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+                    module_info.codeSize                 = stages[i].second->size() * sizeof(uint32_t);
+                    module_info.pCode                    = stages[i].second->data();
+
+                    infos[i].sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                    infos[i].stage               = stages[i].first;
+                    infos[i].pName               = entries[i].c_str();
+                    infos[i].pSpecializationInfo = specialization.mapEntryCount ? &specialization : nullptr;
+                    if (vkCreateShaderModule(device, &module_info, allocator, &infos[i].module) != VK_SUCCESS)
+                        APPLOG_ERROR("vkCreateShaderModule failed");
+                }
+
+                const bool modules_ok = std::all_of(infos.begin(), infos.end(), [](const auto& info) { return info.module != VK_NULL_HANDLE; });
+                VkPipeline pipeline   = modules_ok ? builder(infos) : VK_NULL_HANDLE;
+                for (const auto& info : infos)
+                    vkDestroyShaderModule(device, info.module, allocator);
+                return pipeline;
+            });
+    }
+
+    void ShaderManager::apply_results(bool wait)
+    {
+        for (auto& [id, shader] : shaders_)
+        {
+            if (!shader.pending.valid() || (!wait && !is_ready(shader.pending)))
+                continue;
+
+            CompileResult result = shader.pending.get();
+            if (!result.files.empty())
+            {
+                shader.files       = std::move(result.files);
+                shader.write_times = get_write_times(shader.files);
+            }
+            if (shader.stale)
+            {
+                start_compile(shader);
+                continue;
+            }
+            if (!result.spirv || result.hash == shader.hash)
+                continue;
+
+            const bool reload = shader.spirv != nullptr;
+            shader.spirv      = std::move(result.spirv);
+            shader.hash       = result.hash;
+            if (reload)
+                APPLOG_INFO("Shader {} reloaded", shader.desc.path);
+
+            for (auto& [pipeline_id, pipeline] : pipelines_)
+            {
+                if (std::find(pipeline.shaders.begin(), pipeline.shaders.end(), id) != pipeline.shaders.end())
+                    start_build(pipeline);
+            }
+        }
+
+        for (auto& [id, pipeline] : pipelines_)
+        {
+            if (!pipeline.pending.valid() || (!wait && !is_ready(pipeline.pending)))
+                continue;
+
+            VkPipeline built = pipeline.pending.get();
+            if (built != VK_NULL_HANDLE)
+            {
+                retire(pipeline.pipeline);
+                pipeline.pipeline = built;
+            }
+            else
+                APPLOG_ERROR("Pipeline {} failed to build, keeping the previous one", id);
+            if (pipeline.stale)
+                start_build(pipeline);
+        }
+    }
+
+    void ShaderManager::check_files()
+    {
+        for (auto& [id, shader] : shaders_)
+        {
+            if (shader.files.empty())
+                continue;
+            auto write_times = get_write_times(shader.files);
+            if (write_times == shader.write_times)
+                continue;
+
+            shader.write_times = std::move(write_times);
+            if (shader.pending.valid())
+                shader.stale = true;
+            else
+                start_compile(shader);
+        }
+    }
+
+    void ShaderManager::retire(VkPipeline pipeline)
+    {
+        if (pipeline != VK_NULL_HANDLE)
+            retired_.push_back({pipeline, renderer_.get_frame_count()});
+    }
+
+    ShaderManager::CompileResult ShaderManager::compile(const ShaderDesc& desc) const
+    {
+        CompileResult result;
+        if (is_spirv(desc))
+        {
+            result.files = {std::filesystem::path(desc.path)};
+            result.spirv = read_spirv(desc.path);
+            if (!result.spirv)
+            {
+                APPLOG_ERROR("Shader {} is not valid SPIR-V", desc.path);
+                return result;
+            }
+            result.hash = hash_bytes(cache_version, result.spirv->data(), result.spirv->size() * sizeof(uint32_t));
+            return result;
+        }
+
+        // Everything that changes the output goes into the cache key.
+        collect_sources(std::filesystem::path(desc.path).lexically_normal(), result.files);
+        uint64_t hash = mix(cache_version, static_cast<uint64_t>(desc.stage));
+        hash          = hash_string(hash, desc.entry_point);
+        hash          = mix(hash, is_hlsl(desc));
+        for (const auto& define : desc.defines)
+            hash = hash_string(hash, define);
+        std::vector<char> bytes;
+        for (const auto& file : result.files)
+        {
+            if (!read_file(file, bytes))
+            {
+                APPLOG_ERROR("Can not read shader {}", file.string());
+                return result;
+            }
+            hash = hash_bytes(hash, bytes.data(), bytes.size());
+        }
+        result.hash = hash;
+
+        const auto cached = cache_dir_ / fmt::format("{:016x}.spv", hash);
+        if ((result.spirv = read_spirv(cached)))
+            return result;
+
+        // Written next to the entry and renamed, so a reader never sees a partial file.
+        static std::atomic<uint32_t> temp_counter = 0;
+        const auto temp = cache_dir_ / fmt::format("{:016x}.{}.tmp", hash, temp_counter.fetch_add(1, std::memory_order_relaxed));
+        if (!run_compiler(desc, temp))
+            return result;
+
+        std::error_code error;
+        std::filesystem::rename(temp, cached, error);
+        result.spirv = read_spirv(error ? temp : cached);
+        if (error)
+            std::filesystem::remove(temp, error);
+        if (!result.spirv)
+            APPLOG_ERROR("Shader compiler wrote no SPIR-V for {}", desc.path);
+        else
+            APPLOG_INFO("Shader {} compiled", desc.path);
+        return result;
+    }
+
+    bool ShaderManager::run_compiler(const ShaderDesc& desc, const std::filesystem::path& output) const
+    {
+        const char* stage = get_stage_name(desc.stage);
+        if (!stage)
+        {
+            APPLOG_ERROR("Shader {} has a stage glslc does not support", desc.path);
+            return false;
+        }
+
+        std::vector<std::string> args = {compiler_, "-O", "--target-env=vulkan1.1", std::string("-fshader-stage=") + stage};
+        if (is_hlsl(desc))
+        {
+            args.insert(args.end(), {"-x", "hlsl", "-fentry-point=" + desc.entry_point});
+        }
+        for (const auto& define : desc.defines)
+            args.push_back("-D" + define);
+        args.insert(args.end(), {"-o", output.string(), desc.path});
+
+        std::vector<const char*> argv;
+        for (const auto& arg : args)
+            argv.push_back(arg.c_str());
+        argv.push_back(nullptr);
+
+        SDL_PropertiesID properties = SDL_CreateProperties();
+        SDL_SetPointerProperty(properties, SDL_PROP_PROCESS_CREATE_ARGS_POINTER, argv.data());
+        SDL_SetNumberProperty(properties, SDL_PROP_PROCESS_CREATE_STDOUT_NUMBER, SDL_PROCESS_STDIO_APP);
+        SDL_SetBooleanProperty(properties, SDL_PROP_PROCESS_CREATE_STDERR_TO_STDOUT_BOOLEAN, true);
+        SDL_Process* process = SDL_CreateProcessWithProperties(properties);
+        SDL_DestroyProperties(properties);
+        if (!process)
+        {
+            APPLOG_ERROR("Can not run shader compiler {}: {}", compiler_, SDL_GetError());
+            return false;
+        }
+
+        size_t size      = 0;
+        int    exit_code = -1;
+        char*  messages  = static_cast<char*>(SDL_ReadProcess(process, &size, &exit_code));
+        SDL_DestroyProcess(process);
+        if (exit_code != 0)
+            APPLOG_ERROR("Shader {} failed to compile:\n{}", desc.path, std::string_view(messages ? messages : "", messages ? size : 0));
+        else if (messages && size > 0)
+            APPLOG_WARNING("Shader {}:\n{}", desc.path, std::string_view(messages, size));
+        SDL_free(messages);
+        return exit_code == 0;
+    }
+} // namespace core
@@ -0,0 +1,148 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include "vulkan/vulkan.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace core
+{
+    class VulkanRenderer;
+
+    struct ShaderDesc
+    {
+        std::string              path;        // .spv is loaded as is, .hlsl compiled as HLSL, anything else as GLSL
+        VkShaderStageFlagBits    stage       = VK_SHADER_STAGE_VERTEX_BIT;
+        std::string              entry_point = "main";
+        std::vector<std::string> defines; // NAME or NAME=VALUE
+    };
+
+    // Specialization constant values of one pipeline variant.
+    class SpecializationConstants
+    {
+    public:
+        template<typename T>
+        SpecializationConstants& set(uint32_t constant_id, const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+            entries_.push_back({constant_id, static_cast<uint32_t>(data_.size()), sizeof(T)});
+            data_.resize(data_.size() + sizeof(T));
+            std::memcpy(data_.data() + entries_.back().offset, &value, sizeof(T));
+            return *this;
+        }
+
+        // Points into this object, which has to outlive the pipeline creation it is used for.
+        [[nodiscard]] VkSpecializationInfo get_info() const
+        {
+            return {static_cast<uint32_t>(entries_.size()), entries_.data(), data_.size(), data_.data()};
+        }
+
+    private:
+        std::vector<VkSpecializationMapEntry> entries_;
+        std::vector<uint8_t>                  data_;
+    };
+
+    // Loads shaders and builds the pipelines made of them, off the main thread.
+    //
+    // Sources are compiled to SPIR-V by glslc (--glslc <path>, else $VULKAN_SDK/bin or PATH), one job per
+    // shader on the JobSystem. Results land in a cache directory (--shader-cache, default shader_cache) named
+    // by a hash of the source, its #includes and the compile options, so a start only compiles what changed.
+    // Source files are polled every --shader-watch-interval seconds (default 0.5, 0 turns watching off);
+    // an edit recompiles in the background and rebuilds every pipeline using the shader, while the previous
+    // pipeline keeps drawing until the new one is ready. A failed compile is logged and changes nothing.
+    class ShaderManager : public EventSubscriber
+    {
+    public:
+        using ShaderId   = uint32_t;
+        using PipelineId = uint32_t;
+
+        // Creates the pipeline from ready stages. Runs on a worker thread, so it may only touch what it captures;
+        // the stages' modules are destroyed once it returns.
+        using PipelineBuilder = std::function<VkPipeline(std::span<const VkPipelineShaderStageCreateInfo> stages)>;
+
+        ShaderManager();
+        ~ShaderManager();
+
+        // Starts loading a shader; the same description returns the same id.
+        ShaderId load(const ShaderDesc& desc);
+        // SPIR-V of the last successful compile, empty until there was one.
+        [[nodiscard]] std::span<const uint32_t> get_spirv(ShaderId shader) const;
+
+        // A pipeline variant: one pipeline per combination of shaders and constants.
+        PipelineId create_pipeline(std::vector<ShaderId> shaders, SpecializationConstants constants, PipelineBuilder builder);
+        void       destroy_pipeline(PipelineId pipeline);
+        // The current pipeline, VK_NULL_HANDLE until its first build finished.
+        [[nodiscard]] VkPipeline get_pipeline(PipelineId pipeline) const;
+
+        // Blocks until every pending compile and build is done and applied, e.g. before a first frame that needs them.
+        void flush();
+
+        void frame_begin(const FrameBegin& event);
+
+    private:
+        using Spirv = std::shared_ptr<const std::vector<uint32_t>>;
+
+        struct CompileResult
+        {
+            Spirv                              spirv; // nullptr when the compile failed
+            uint64_t                           hash = 0;
+            std::vector<std::filesystem::path> files; // The source and everything it includes
+        };
+
+        struct Shader
+        {
+            ShaderDesc                                   desc;
+            Spirv                                        spirv;
+            uint64_t                                     hash = 0;
+            std::vector<std::filesystem::path>           files;
+            std::vector<std::filesystem::file_time_type> write_times;
+            std::future<CompileResult>                   pending;
+            bool                                         stale = false; // Changed again while compiling
+        };
+
+        struct Pipeline
+        {
+            std::vector<ShaderId>                    shaders;
+            std::shared_ptr<SpecializationConstants> constants;
+            PipelineBuilder                          builder;
+            VkPipeline                               pipeline = VK_NULL_HANDLE;
+            std::future<VkPipeline>                  pending;
+            bool                                     stale = false;
+        };
+
+        struct Retired
+        {
+            VkPipeline pipeline;
+            uint64_t   frame; // VulkanRenderer::get_frame_count() when it was replaced
+        };
+
+        CompileResult compile(const ShaderDesc& desc) const;
+        bool          run_compiler(const ShaderDesc& desc, const std::filesystem::path& output) const;
+        void          start_compile(Shader& shader);
+        void          start_build(Pipeline& pipeline);
+        void          apply_results(bool wait);
+        void          check_files();
+        void          retire(VkPipeline pipeline);
+
+        VulkanRenderer&       renderer_;
+        std::filesystem::path cache_dir_;
+        std::string           compiler_;
+        float                 watch_interval_ = 0.5f;
+        float                 watch_elapsed_  = 0.0f;
+        uint32_t              next_id_        = 1;
+
+        std::unordered_map<ShaderId, Shader>     shaders_;
+        std::unordered_map<PipelineId, Pipeline> pipelines_;
+        std::vector<Retired>                     retired_;
+        std::vector<std::future<VkPipeline>>     orphaned_; // Builds of destroyed pipelines still running
+    };
+} // namespace core
@@ -0,0 +1,196 @@
+#include "bindless_heap.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace core
+{
+    namespace
+    {
+        void check_vk_result(VkResult err)
+        {
+            if (err == VK_SUCCESS)
+                return;
+            APPLOG_ERROR("[bindless] Error: VkResult = {}", (int)err);
+            if (err < 0)
+                abort();
+        }
+    } // namespace
+
+    BindlessSupport BindlessHeap::query_support(VkInstance instance, VkPhysicalDevice physical_device)
+    {
+        BindlessSupport support;
+        auto get_features   = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+        auto get_properties = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
+        if (!get_features || !get_properties)
+            return support;
+
+        uint32_t count = 0;
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count, nullptr);
+        std::vector<VkExtensionProperties> extensions(count);
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count, extensions.data());
+        for (const char* name : {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, VK_KHR_MAINTENANCE3_EXTENSION_NAME})
+        {
+            auto matches = [name](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, name) == 0; };
+            if (std::none_of(extensions.begin(), extensions.end(), matches))
+                return support;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT available = {};
+        available.sType                                         = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2KHR features                   = {};
+        features.sType                                          = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features.pNext                                          = &available;
+        get_features(physical_device, &features);
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT limits = {};
+        limits.sType                                           = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2KHR properties              = {};
+        properties.sType                                       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+        properties.pNext                                       = &limits;
+        get_properties(physical_device, &properties);
+
+        // Shaders index with non-uniform values (one texture per instance), the array is sparsely filled and
+        // slots change while earlier frames using other slots are still executing.
+        if (!available.runtimeDescriptorArray || !available.descriptorBindingPartiallyBound ||
+            !available.descriptorBindingSampledImageUpdateAfterBind || !available.descriptorBindingUpdateUnusedWhilePending ||
+            !available.shaderSampledImageArrayNonUniformIndexing)
+            return support;
+
+        support.features.sType                                        = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        support.features.runtimeDescriptorArray                       = VK_TRUE;
+        support.features.descriptorBindingPartiallyBound              = VK_TRUE;
+        support.features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        support.features.descriptorBindingUpdateUnusedWhilePending    = VK_TRUE;
+        support.features.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+        // A combined image sampler counts as both a sampler and a sampled image.
+        support.max_textures = std::min({limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                                         limits.maxDescriptorSetUpdateAfterBindSamplers,
+                                         limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                         limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+        support.supported    = support.max_textures > 0;
+        return support;
+    }
+
+    BindlessHeap::BindlessHeap(VkDevice device, const VkAllocationCallbacks* allocator, VkSampler sampler, uint32_t capacity) :
+        device_(device), allocator_(allocator), sampler_(sampler), capacity_(capacity)
+    {
+        {
+            const VkDescriptorBindingFlagsEXT binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                                                              VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                                                              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+            VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flags_info = {};
+            flags_info.sType                                          = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+            flags_info.bindingCount                                   = 1;
+            flags_info.pBindingFlags                                  = &binding_flags;
+
+            VkDescriptorSetLayoutBinding binding = {};
+            binding.binding                      = 0;
+            binding.descriptorType               = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            binding.descriptorCount              = capacity_;
+            binding.stageFlags                   = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+            VkDescriptorSetLayoutCreateInfo info = {};
+            info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            info.pNext                           = &flags_info;
+            info.flags                           = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+            info.bindingCount                    = 1;
+            info.pBindings                       = &binding;
+            check_vk_result(vkCreateDescriptorSetLayout(device_, &info, allocator_, &layout_));
+        }
+        {
+            VkDescriptorPoolSize       pool_size = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity_};
+            VkDescriptorPoolCreateInfo info      = {};
+            info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            info.flags                           = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+            info.maxSets                         = 1;
+            info.poolSizeCount                   = 1;
+            info.pPoolSizes                      = &pool_size;
+            check_vk_result(vkCreateDescriptorPool(device_, &info, allocator_, &pool_));
+        }
+        {
+            VkDescriptorSetAllocateInfo info = {};
+            info.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            info.descriptorPool              = pool_;
+            info.descriptorSetCount          = 1;
+            info.pSetLayouts                 = &layout_;
+            check_vk_result(vkAllocateDescriptorSets(device_, &info, &set_));
+        }
+        APPLOG_INFO("[bindless] Texture heap of {} slots", capacity_);
+    }
+
+    BindlessHeap::~BindlessHeap()
+    {
+        vkDestroyDescriptorPool(device_, pool_, allocator_);
+        vkDestroyDescriptorSetLayout(device_, layout_, allocator_);
+    }
+
+    BindlessHeap::Index BindlessHeap::add(VkImageView view, VkImageLayout layout)
+    {
+        std::lock_guard lock(mutex_);
+        Index           index;
+        if (!free_.empty())
+        {
+            index = free_.back();
+            free_.pop_back();
+        }
+        else if (next_ < capacity_)
+        {
+            index = next_++;
+        }
+        else
+        {
+            APPLOG_ERROR("[bindless] All {} texture slots are in use", capacity_);
+            return invalid;
+        }
+        write(index, view, layout);
+        return index;
+    }
+
+    void BindlessHeap::update(Index index, VkImageView view, VkImageLayout layout)
+    {
+        std::lock_guard lock(mutex_);
+        if (index < next_)
+            write(index, view, layout);
+    }
+
+    void BindlessHeap::remove(Index index)
+    {
+        std::lock_guard lock(mutex_);
+        if (index < next_)
+            retired_.push_back({index, frame_});
+    }
+
+    void BindlessHeap::advance_frame(uint32_t frames_in_flight)
+    {
+        std::lock_guard lock(mutex_);
+        ++frame_;
+        // Retired in frame order, so the ones old enough are at the front.
+        auto end = std::find_if(retired_.begin(), retired_.end(), [&](const Retired& r) { return frame_ - r.frame <= frames_in_flight; });
+        for (auto it = retired_.begin(); it != end; ++it)
+            free_.push_back(it->index);
+        retired_.erase(retired_.begin(), end);
+    }
+
+    uint32_t BindlessHeap::get_used() const
+    {
+        std::lock_guard lock(mutex_);
+        return next_ - static_cast<uint32_t>(free_.size());
+    }
+
+    // The slot is not used by any pending frame, which update unused while pending allows to change.
+    void BindlessHeap::write(Index index, VkImageView view, VkImageLayout layout)
+    {
+        VkDescriptorImageInfo image = {sampler_, view, layout};
+        VkWriteDescriptorSet  write = {};
+        write.sType                 = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet                = set_;
+        write.dstBinding            = 0;
+        write.dstArrayElement       = index;
+        write.descriptorCount       = 1;
+        write.descriptorType        = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo            = &image;
+        vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+    }
+} // namespace core
@@ -0,0 +1,79 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace core
+{
+    // What descriptor indexing (VK_EXT_descriptor_indexing) offers on a device; the features to enable are
+    // chained into VkDeviceCreateInfo::pNext as they are.
+    struct BindlessSupport
+    {
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT features {};
+        uint32_t                                      max_textures = 0;
+        bool                                          supported    = false;
+    };
+
+    // A single descriptor set holding every sampled texture in one large array, so shaders pick textures by
+    // index (see textures[] in primitive_image.frag) and any number of them is drawn with one bind instead
+    // of a set per texture. Slots are handed out from a free list; a removed slot is only reused once the
+    // frames that might still sample it have retired, and the set stays bound while slots change
+    // (update after bind, partially bound).
+    class BindlessHeap
+    {
+    public:
+        using Index = uint32_t;
+
+        static constexpr Index    invalid          = UINT32_MAX;
+        static constexpr uint32_t default_capacity = 16384;
+
+        // Needs VK_KHR_get_physical_device_properties2 enabled on instance.
+        static BindlessSupport query_support(VkInstance instance, VkPhysicalDevice physical_device);
+
+        BindlessHeap(VkDevice device, const VkAllocationCallbacks* allocator, VkSampler sampler, uint32_t capacity);
+        ~BindlessHeap();
+
+        BindlessHeap(const BindlessHeap&)            = delete;
+        BindlessHeap& operator=(const BindlessHeap&) = delete;
+
+        // Makes view sampleable at the returned index, invalid when the heap is full. The view has to be in
+        // layout whenever a shader samples it.
+        Index add(VkImageView view, VkImageLayout layout);
+        // Points index at another view, e.g. after a resize. Only safe while no frame in flight samples it.
+        void  update(Index index, VkImageView view, VkImageLayout layout);
+        // The view may be destroyed once no frame in flight samples it; the slot is reused after that.
+        void  remove(Index index);
+
+        // Called once per frame: slots removed at least frames_in_flight frames ago become free again.
+        void advance_frame(uint32_t frames_in_flight);
+
+        [[nodiscard]] VkDescriptorSetLayout get_layout() const noexcept { return layout_; }
+        [[nodiscard]] VkDescriptorSet       get_set() const noexcept { return set_; }
+        [[nodiscard]] uint32_t              get_capacity() const noexcept { return capacity_; }
+        [[nodiscard]] uint32_t              get_used() const;
+
+    private:
+        struct Retired
+        {
+            Index    index;
+            uint64_t frame;
+        };
+
+        void write(Index index, VkImageView view, VkImageLayout layout);
+
+        VkDevice                     device_;
+        const VkAllocationCallbacks* allocator_;
+        VkSampler                    sampler_;
+        VkDescriptorSetLayout        layout_   = VK_NULL_HANDLE;
+        VkDescriptorPool             pool_     = VK_NULL_HANDLE;
+        VkDescriptorSet              set_      = VK_NULL_HANDLE;
+        uint32_t                     capacity_ = 0;
+        uint32_t                     next_     = 0; // Slots at and above it were never handed out
+        uint64_t                     frame_    = 0;
+
+        mutable std::mutex   mutex_;
+        std::vector<Index>   free_;
+        std::vector<Retired> retired_;
+    };
+} // namespace core
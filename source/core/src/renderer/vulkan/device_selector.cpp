@@ -0,0 +1,266 @@
+#include "device_selector.h"
+#include "logger.h"
+#include <SDL3/SDL_vulkan.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace core
+{
+    namespace
+    {
+        // Device type dominates the score, the rest only orders devices of the same type.
+        int64_t score_type(VkPhysicalDeviceType type)
+        {
+            switch (type)
+            {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 10000;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 5000;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 2000;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: return 0; // Software rasterizers, last resort
+            default: return 1000;
+            }
+        }
+
+        const char* get_type_name(VkPhysicalDeviceType type)
+        {
+            switch (type)
+            {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+            default: return "other";
+            }
+        }
+
+        struct ScoredFeature
+        {
+            const char*                        name;
+            VkBool32 VkPhysicalDeviceFeatures::*member;
+        };
+
+        constexpr ScoredFeature scored_features[] = {
+            {"multiDrawIndirect", &VkPhysicalDeviceFeatures::multiDrawIndirect},
+            {"drawIndirectFirstInstance", &VkPhysicalDeviceFeatures::drawIndirectFirstInstance},
+            {"samplerAnisotropy", &VkPhysicalDeviceFeatures::samplerAnisotropy},
+            {"shaderInt64", &VkPhysicalDeviceFeatures::shaderInt64},
+        };
+
+        bool has_extension(VkPhysicalDevice device, const char* name)
+        {
+            uint32_t count = 0;
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+            std::vector<VkExtensionProperties> extensions(count);
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &count, extensions.data());
+            return std::any_of(extensions.begin(), extensions.end(), [name](const VkExtensionProperties& extension) {
+                return std::strcmp(extension.extensionName, name) == 0;
+            });
+        }
+
+        // First family matching all of required and none of excluded, or QueueTopology::none.
+        uint32_t find_family(const DeviceCandidate& candidate, VkQueueFlags required, VkQueueFlags excluded, bool present)
+        {
+            for (uint32_t i = 0; i < candidate.queue_families.size(); ++i)
+            {
+                const VkQueueFlags flags = candidate.queue_families[i].queueFlags;
+                if (candidate.queue_families[i].queueCount > 0 && (flags & required) == required && (flags & excluded) == 0 &&
+                    (!present || candidate.present_support[i]))
+                    return i;
+            }
+            return QueueTopology::none;
+        }
+
+        QueueTopology find_queues(const DeviceCandidate& candidate)
+        {
+            QueueTopology queues;
+            queues.graphics = find_family(candidate, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0, true);
+            if (queues.graphics == QueueTopology::none)
+                queues.graphics = find_family(candidate, VK_QUEUE_GRAPHICS_BIT, 0, true);
+            if (queues.graphics == QueueTopology::none)
+                return queues;
+
+            queues.compute = find_family(candidate, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT, false);
+            if (queues.compute == QueueTopology::none)
+                queues.compute = queues.graphics;
+
+            queues.transfer = find_family(candidate, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, false);
+            if (queues.transfer == QueueTopology::none)
+                queues.transfer = queues.graphics;
+            return queues;
+        }
+
+        int64_t score(const DeviceCandidate& candidate)
+        {
+            int64_t result = score_type(candidate.properties.deviceType);
+            // 10 per 256 MiB, up to 16 GiB.
+            result += std::min<int64_t>(static_cast<int64_t>(candidate.device_local_memory >> 28), 64) * 10;
+            if (candidate.properties.apiVersion >= VK_API_VERSION_1_2)
+                result += 100;
+            if (candidate.properties.apiVersion >= VK_API_VERSION_1_3)
+                result += 100;
+            for (const ScoredFeature& feature : scored_features)
+            {
+                if (candidate.features.*feature.member)
+                    result += 50;
+            }
+            if (candidate.queues.has_async_compute())
+                result += 200;
+            if (candidate.queues.has_dedicated_transfer())
+                result += 200;
+            return result;
+        }
+
+        std::string to_lower(std::string text)
+        {
+            std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return text;
+        }
+
+        std::string describe_queue_flags(VkQueueFlags flags, bool present)
+        {
+            std::string text;
+            const std::pair<VkQueueFlags, const char*> names[] = {
+                {VK_QUEUE_GRAPHICS_BIT, "graphics"},
+                {VK_QUEUE_COMPUTE_BIT, "compute"},
+                {VK_QUEUE_TRANSFER_BIT, "transfer"},
+                {VK_QUEUE_SPARSE_BINDING_BIT, "sparse"},
+            };
+            for (const auto& [bit, name] : names)
+            {
+                if (flags & bit)
+                    text += text.empty() ? name : std::string(" ") + name;
+            }
+            if (present)
+                text += " present";
+            return text;
+        }
+    } // namespace
+
+    std::vector<DeviceCandidate> enumerate_devices(VkInstance instance)
+    {
+        uint32_t count = 0;
+        vkEnumeratePhysicalDevices(instance, &count, nullptr);
+        std::vector<VkPhysicalDevice> devices(count);
+        vkEnumeratePhysicalDevices(instance, &count, devices.data());
+
+        std::vector<DeviceCandidate> candidates(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            DeviceCandidate& candidate = candidates[i];
+            candidate.device           = devices[i];
+            candidate.index            = i;
+            vkGetPhysicalDeviceProperties(candidate.device, &candidate.properties);
+            vkGetPhysicalDeviceFeatures(candidate.device, &candidate.features);
+
+            VkPhysicalDeviceMemoryProperties memory;
+            vkGetPhysicalDeviceMemoryProperties(candidate.device, &memory);
+            for (uint32_t heap = 0; heap < memory.memoryHeapCount; ++heap)
+            {
+                if (memory.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                    candidate.device_local_memory += memory.memoryHeaps[heap].size;
+            }
+
+            uint32_t family_count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate.device, &family_count, nullptr);
+            candidate.queue_families.resize(family_count);
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate.device, &family_count, candidate.queue_families.data());
+            candidate.present_support.resize(family_count);
+            for (uint32_t family = 0; family < family_count; ++family)
+                candidate.present_support[family] = SDL_Vulkan_GetPresentationSupport(instance, candidate.device, family);
+
+            candidate.queues = find_queues(candidate);
+            if (candidate.queues.graphics == QueueTopology::none)
+                candidate.rejected = "no graphics queue family that can present";
+            else if (!has_extension(candidate.device, VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+                candidate.rejected = "no " VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+            candidate.score = candidate.rejected.empty() ? score(candidate) : -1;
+        }
+        return candidates;
+    }
+
+    const DeviceCandidate* select_device(const std::vector<DeviceCandidate>& candidates, const std::string& selection)
+    {
+        const DeviceCandidate* best = nullptr;
+        for (const DeviceCandidate& candidate : candidates)
+        {
+            if (candidate.rejected.empty() && (!best || candidate.score > best->score))
+                best = &candidate;
+        }
+        if (selection.empty())
+            return best;
+
+        const bool is_index = std::all_of(selection.begin(), selection.end(), [](unsigned char c) { return std::isdigit(c); });
+        const auto needle   = to_lower(selection);
+        for (const DeviceCandidate& candidate : candidates)
+        {
+            const bool matches = is_index ? std::to_string(candidate.index) == selection
+                                          : to_lower(candidate.properties.deviceName).find(needle) != std::string::npos;
+            if (!matches)
+                continue;
+            if (candidate.rejected.empty())
+                return &candidate;
+            APPLOG_WARNING("[vulkan] GPU {} ({}) was requested but can not be used: {}", candidate.index, candidate.properties.deviceName,
+                           candidate.rejected);
+            return best;
+        }
+        APPLOG_WARNING("[vulkan] No GPU matches --gpu {}, using the best scored one", selection);
+        return best;
+    }
+
+    void log_device_report(const std::vector<DeviceCandidate>& candidates, const DeviceCandidate* chosen)
+    {
+        APPLOG_INFO("[vulkan] {} physical device(s)", candidates.size());
+        for (const DeviceCandidate& candidate : candidates)
+        {
+            const VkPhysicalDeviceProperties& properties = candidate.properties;
+            APPLOG_INFO("[vulkan] GPU {}: {} ({}, Vulkan {}.{}.{}, driver 0x{:x}, vendor 0x{:04x}, device 0x{:04x}, {} MiB device local)",
+                        candidate.index,
+                        properties.deviceName,
+                        get_type_name(properties.deviceType),
+                        VK_API_VERSION_MAJOR(properties.apiVersion),
+                        VK_API_VERSION_MINOR(properties.apiVersion),
+                        VK_API_VERSION_PATCH(properties.apiVersion),
+                        properties.driverVersion,
+                        properties.vendorID,
+                        properties.deviceID,
+                        candidate.device_local_memory >> 20);
+
+            std::string features;
+            for (const ScoredFeature& feature : scored_features)
+            {
+                if (candidate.features.*feature.member)
+                    features += features.empty() ? feature.name : std::string(" ") + feature.name;
+            }
+            APPLOG_INFO("[vulkan]     features: {}", features.empty() ? "-" : features);
+
+            for (uint32_t family = 0; family < candidate.queue_families.size(); ++family)
+            {
+                const VkQueueFamilyProperties& properties = candidate.queue_families[family];
+                APPLOG_INFO("[vulkan]     queue family {}: {} x{}",
+                            family,
+                            describe_queue_flags(properties.queueFlags, candidate.present_support[family]),
+                            properties.queueCount);
+            }
+
+            if (!candidate.rejected.empty())
+            {
+                APPLOG_INFO("[vulkan]     rejected: {}", candidate.rejected);
+                continue;
+            }
+            const QueueTopology& queues = candidate.queues;
+            APPLOG_INFO("[vulkan]     queues: graphics {}, compute {}{}, transfer {}{}; score {}",
+                        queues.graphics,
+                        queues.compute,
+                        queues.has_async_compute() ? " (async)" : "",
+                        queues.transfer,
+                        queues.has_dedicated_transfer() ? " (dedicated)" : "",
+                        candidate.score);
+        }
+
+        if (chosen)
+            APPLOG_INFO("[vulkan] Using GPU {}: {}", chosen->index, chosen->properties.deviceName);
+        else
+            APPLOG_ERROR("[vulkan] No usable GPU found");
+    }
+} // namespace core
@@ -0,0 +1,50 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    // Queue families a device would be used with. compute and transfer prefer families without graphics
+    // (async compute, DMA engines) and fall back to the graphics family, so they are always valid when
+    // graphics is.
+    struct QueueTopology
+    {
+        static constexpr uint32_t none = UINT32_MAX;
+
+        uint32_t graphics = none; // Graphics, compute and presentation
+        uint32_t compute  = none;
+        uint32_t transfer = none;
+
+        [[nodiscard]] bool has_async_compute() const noexcept { return compute != graphics; }
+        [[nodiscard]] bool has_dedicated_transfer() const noexcept { return transfer != graphics && transfer != compute; }
+    };
+
+    struct DeviceCandidate
+    {
+        VkPhysicalDevice                     device = VK_NULL_HANDLE;
+        uint32_t                             index  = 0; // Enumeration order, what --gpu <index> refers to
+        VkPhysicalDeviceProperties           properties {};
+        VkPhysicalDeviceFeatures             features {};
+        std::vector<VkQueueFamilyProperties> queue_families;
+        std::vector<bool>                    present_support; // Per queue family
+        VkDeviceSize                         device_local_memory = 0;
+        QueueTopology                        queues;
+        int64_t                              score = 0;
+        std::string                          rejected; // Why the device can not be used, empty if it can
+    };
+
+    // Every physical device of instance with its capabilities, scored by type, device local memory,
+    // features and queue families. A device is rejected without a graphics family that can present or
+    // without VK_KHR_swapchain.
+    std::vector<DeviceCandidate> enumerate_devices(VkInstance instance);
+
+    // The best scored usable device, or the one selection names: a device index or a case-insensitive part
+    // of the device name (--gpu). Falls back to the best device when selection matches nothing usable.
+    // nullptr when no device is usable.
+    const DeviceCandidate* select_device(const std::vector<DeviceCandidate>& candidates, const std::string& selection);
+
+    // Logs every candidate with its queue families and score, and which one was chosen.
+    void log_device_report(const std::vector<DeviceCandidate>& candidates, const DeviceCandidate* chosen);
+} // namespace core
@@ -0,0 +1,172 @@
+#include "dynamic_resolution.h"
+#include "cmd_line/parser.hpp"
+#include "logger.h"
+#include "metrics/metrics.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace core
+{
+    namespace
+    {
+        constexpr double smoothing = 0.2;  // Weight of a new sample in the smoothed time
+        constexpr double headroom  = 0.75; // Below this fraction of the budget the scale goes up
+        constexpr double target    = 0.9;  // Fraction of the budget a lowered scale aims for
+
+        void check_vk_result(VkResult err)
+        {
+            if (err == VK_SUCCESS)
+                return;
+            APPLOG_ERROR("[resolution] Error: VkResult = {}", (int)err);
+            if (err < 0)
+                abort();
+        }
+    } // namespace
+
+    DynamicResolution::DynamicResolution(VkDevice                     device,
+                                         VkPhysicalDevice             physical_device,
+                                         uint32_t                     queue_family,
+                                         const VkAllocationCallbacks* allocator) :
+        device_(device), allocator_(allocator)
+    {
+        auto& parser = Parser::instance();
+        if (!parser.hasOption("dynamic-resolution"))
+            return;
+
+        uint32_t family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, families.data());
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+        const uint32_t valid_bits = queue_family < family_count ? families[queue_family].timestampValidBits : 0;
+        if (valid_bits == 0 || properties.limits.timestampPeriod <= 0.0f)
+        {
+            APPLOG_WARNING("[resolution] The graphics queue has no timestamps, dynamic resolution is disabled");
+            return;
+        }
+        valid_mask_ = valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << valid_bits) - 1;
+        tick_       = properties.limits.timestampPeriod / 1e6;
+        budget_     = std::max(std::stod(parser.getOptionValue("gpu-budget-ms", "14")), 0.1);
+        min_scale_  = std::clamp(std::stof(parser.getOptionValue("min-render-scale", "0.5")), step, 1.0f);
+
+        VkQueryPoolCreateInfo info = {};
+        info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+        info.queryCount            = ring_size * max_command_buffers * 2;
+        check_vk_result(vkCreateQueryPool(device_, &info, allocator_, &pool_));
+
+        if (has_subsystem<Metrics>())
+        {
+            auto& metrics = get_subsystem<Metrics>();
+            scale_gauge_  = &metrics.add_gauge("vulkan_render_scale", "Resolution scale of viewport content, see --dynamic-resolution.");
+            time_gauge_   = &metrics.add_gauge("vulkan_gpu_frame_seconds", "Smoothed GPU time of a frame.");
+            scale_gauge_->set(1.0);
+        }
+        APPLOG_INFO("[resolution] Dynamic resolution for a GPU budget of {} ms, scaling down to {}", budget_, min_scale_);
+    }
+
+    DynamicResolution::~DynamicResolution()
+    {
+        if (pool_)
+            vkDestroyQueryPool(device_, pool_, allocator_);
+    }
+
+    void DynamicResolution::begin_frame()
+    {
+        if (!pool_)
+            return;
+
+        frame_    = (frame_ + 1) % ring_size;
+        recorded_ = 0;
+        reset_    = true;
+
+        const uint32_t count = std::exchange(counts_[frame_], 0);
+        const uint32_t first = frame_ * max_command_buffers * 2;
+        if (count == 0)
+            return;
+
+        // Value and availability per query; a frame still in flight is skipped rather than waited for.
+        uint64_t results[max_command_buffers * 2][2];
+        VkResult err = vkGetQueryPoolResults(device_,
+                                             pool_,
+                                             first,
+                                             count * 2,
+                                             sizeof(results),
+                                             results,
+                                             sizeof(results[0]),
+                                             VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (err != VK_NOT_READY)
+            check_vk_result(err);
+
+        double gpu_time = 0.0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint64_t* start = results[i * 2];
+            const uint64_t* end   = results[i * 2 + 1];
+            if (!start[1] || !end[1])
+                return;
+            gpu_time += static_cast<double>((end[0] - start[0]) & valid_mask_) * tick_;
+        }
+        update(gpu_time);
+    }
+
+    void DynamicResolution::begin(VkCommandBuffer command_buffer)
+    {
+        if (!pool_ || recorded_ == max_command_buffers)
+            return;
+
+        const uint32_t first = frame_ * max_command_buffers * 2;
+        if (std::exchange(reset_, false))
+            vkCmdResetQueryPool(command_buffer, pool_, first, max_command_buffers * 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool_, first + recorded_ * 2);
+    }
+
+    void DynamicResolution::end(VkCommandBuffer command_buffer)
+    {
+        if (!pool_ || recorded_ == max_command_buffers)
+            return;
+
+        const uint32_t first = frame_ * max_command_buffers * 2;
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool_, first + recorded_ * 2 + 1);
+        counts_[frame_] = ++recorded_;
+    }
+
+    void DynamicResolution::update(double gpu_time)
+    {
+        const double previous = gpu_time_.load(std::memory_order_relaxed);
+        const double smoothed = previous > 0.0 ? previous + (gpu_time - previous) * smoothing : gpu_time;
+        gpu_time_.store(smoothed, std::memory_order_relaxed);
+        if (time_gauge_)
+            time_gauge_->set(smoothed / 1000.0);
+
+        if (settle_ > 0)
+        {
+            --settle_;
+            return;
+        }
+        if (smoothed <= budget_ && smoothed >= budget_ * headroom)
+            return;
+
+        // Over budget the scale drops as far as the scaled pixel count suggests (GPU time of the content goes
+        // with the square of the scale); with headroom it only creeps up, as the UI's share does not scale.
+        const float scale  = scale_.load(std::memory_order_relaxed);
+        float       wanted = scale + step;
+        if (smoothed > budget_)
+            wanted = std::floor(scale * static_cast<float>(std::sqrt(budget_ * target / smoothed)) / step + 0.001f) * step;
+        wanted = std::clamp(wanted, min_scale_, 1.0f);
+        if (std::abs(wanted - scale) < step * 0.5f)
+            return;
+
+        scale_.store(wanted, std::memory_order_relaxed);
+        if (scale_gauge_)
+            scale_gauge_->set(wanted);
+        // Frames already recorded still show the old scale, and the smoothed time follows with a lag.
+        settle_ = ring_size * 2;
+        APPLOG_DEBUG("[resolution] Render scale {:.2f} at {:.2f} ms of GPU time", wanted, smoothed);
+    }
+} // namespace core
@@ -0,0 +1,68 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include <atomic>
+#include <cstdint>
+
+namespace core
+{
+    class Gauge;
+
+    // Lowers the resolution heavy viewport content renders at (PrimitiveRenderer canvases) while the GPU
+    // time of a frame exceeds a budget, and raises it again when there is headroom. UI and text are not
+    // scaled: a canvas renders into the top left part of its image and ImGui stretches that part over it.
+    //
+    // Every command buffer of a frame is bracketed by timestamps. A frame's queries are read when its slot
+    // comes around again ring_size frames later, long after its fence signaled, so reading never waits.
+    // The scale follows the smoothed time in steps, and holds still until a change shows in the timings.
+    //
+    // --dynamic-resolution enables it, --gpu-budget-ms sets the budget (default 14) and --min-render-scale
+    // the lowest scale (default 0.5). Without timestamp support on the graphics queue it stays disabled.
+    class DynamicResolution
+    {
+    public:
+        static constexpr uint32_t ring_size           = 8;  // Frames of queries, more than can be in flight
+        static constexpr uint32_t max_command_buffers = 16; // Timed per frame, one per window
+        static constexpr float    step                = 0.05f;
+
+        DynamicResolution(VkDevice device, VkPhysicalDevice physical_device, uint32_t queue_family, const VkAllocationCallbacks* allocator);
+        ~DynamicResolution();
+
+        DynamicResolution(const DynamicResolution&)            = delete;
+        DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+        [[nodiscard]] bool is_enabled() const noexcept { return pool_ != VK_NULL_HANDLE; }
+        // Of width and height, in (0, 1]; 1 when disabled. Read from any thread.
+        [[nodiscard]] float get_scale() const noexcept { return scale_.load(std::memory_order_relaxed); }
+        // Smoothed GPU time of a frame in milliseconds, 0 until measured.
+        [[nodiscard]] double get_gpu_time() const noexcept { return gpu_time_.load(std::memory_order_relaxed); }
+
+        // VulkanRenderer, on the thread that records: once per frame before its first command buffer, then
+        // around each command buffer of the frame.
+        void begin_frame();
+        void begin(VkCommandBuffer command_buffer);
+        void end(VkCommandBuffer command_buffer);
+
+    private:
+        void update(double gpu_time);
+
+        VkDevice                     device_;
+        const VkAllocationCallbacks* allocator_;
+        VkQueryPool                  pool_        = VK_NULL_HANDLE;
+        double                       tick_        = 0.0; // Milliseconds per timestamp tick
+        uint64_t                     valid_mask_  = 0;
+        double                       budget_      = 14.0;
+        float                        min_scale_   = 0.5f;
+        Gauge*                       scale_gauge_ = nullptr;
+        Gauge*                       time_gauge_  = nullptr;
+
+        // Recording thread only.
+        uint32_t frame_    = 0; // Slot of the current frame
+        uint32_t recorded_ = 0; // Command buffers begun in it
+        uint32_t settle_   = 0; // Frames until a changed scale shows in the timings
+        bool     reset_    = false;
+        uint32_t counts_[ring_size] {}; // Command buffers timed per slot
+
+        std::atomic<float>  scale_ {1.0f};
+        std::atomic<double> gpu_time_ {0.0};
+    };
+} // namespace core
@@ -0,0 +1,525 @@
+#include "frame_capture.h"
+#include "cmd_line/parser.hpp"
+#include "jobs/job_system.h"
+#include "logger.h"
+#include "renderer/image_writer.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <utility>
+
+namespace core
+{
+    namespace
+    {
+        void check_vk_result(VkResult err)
+        {
+            if (err == VK_SUCCESS)
+                return;
+            APPLOG_ERROR("[capture] Error: VkResult = {}", (int)err);
+            if (err < 0)
+                abort();
+        }
+
+        bool is_bgra(VkFormat format) { return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB; }
+
+        bool is_supported(VkFormat format)
+        {
+            return is_bgra(format) || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+        }
+    } // namespace
+
+    FrameCapture::FrameCapture(VkDevice device, VkPhysicalDevice physical_device, const VkAllocationCallbacks* allocator, VkQueue queue) :
+        device_(device), physical_device_(physical_device), allocator_(allocator), queue_(queue)
+    {
+        auto&      parser     = Parser::instance();
+        const auto slot_count = std::stoul(parser.getOptionValue("capture-buffers", std::to_string(default_slot_count)));
+        slots_.resize(std::max<size_t>(slot_count, 1));
+        for (Slot& slot : slots_)
+        {
+            VkFenceCreateInfo info = {};
+            info.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            check_vk_result(vkCreateFence(device_, &info, allocator_, &slot.fence));
+        }
+
+        const auto interval = static_cast<uint32_t>(std::stoul(parser.getOptionValue("capture-every", "0")));
+        if (interval > 0)
+        {
+            const Format format = parser.getOptionValue("capture-format", "png") == "raw" ? Format::raw : Format::png;
+            set_interval(interval, parser.getOptionValue("capture-dir", "captures"), format);
+        }
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        // The GPU is idle by now (see ~VulkanRenderer), only jobs may still read the buffers.
+        for (auto& job : jobs_)
+            job.wait();
+        for (Slot& slot : slots_)
+            destroy_slot(slot);
+        for (auto& [format, render_pass] : render_passes_)
+            vkDestroyRenderPass(device_, render_pass, allocator_);
+    }
+
+    CaptureCallback FrameCapture::save_to(std::filesystem::path path)
+    {
+        return [path = std::move(path)](const CapturedImage& image) {
+            if (path.extension() == ".png")
+                write_png(path, image.width, image.height, image.rgba);
+            else
+                write_raw(get_raw_name(path, image.width, image.height), image.rgba);
+        };
+    }
+
+    void FrameCapture::capture_window(uint32_t window_id, CaptureCallback callback)
+    {
+        std::lock_guard lock(mutex_);
+        window_requests_.push_back({window_id, frame_.load(std::memory_order_relaxed), std::move(callback)});
+        update_requested();
+    }
+
+    void FrameCapture::capture_image(VkImage image, VkImageLayout layout, VkFormat format, uint32_t width, uint32_t height, CaptureCallback callback)
+    {
+        if (!is_supported(format))
+        {
+            APPLOG_WARNING("[capture] Format {} is not RGBA8 or BGRA8, the image is not captured", (int)format);
+            return;
+        }
+        std::lock_guard lock(mutex_);
+        image_requests_.push_back({image, layout, format, width, height, frame_.load(std::memory_order_relaxed), std::move(callback)});
+        update_requested();
+    }
+
+    void FrameCapture::set_interval(uint32_t interval, std::filesystem::path dir, Format format)
+    {
+        interval_ = interval;
+        dir_      = std::move(dir);
+        format_   = format;
+        if (interval_ > 0)
+            APPLOG_INFO("[capture] Capturing every {} frames to {}", interval_, dir_.string());
+    }
+
+    void FrameCapture::poll()
+    {
+        const uint64_t frame = frame_.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::erase_if(jobs_, [](const auto& job) { return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+        if (interval_ > 0 && frame % interval_ == 0)
+        {
+            const char* extension = format_ == Format::png ? "png" : "rgba";
+            capture_window(main_window, save_to(dir_ / fmt::format("frame_{:06}.{}", frame, extension)));
+        }
+
+        // Jobs are submitted outside of the lock: without workers they run right here and take it themselves.
+        std::vector<Slot*> done;
+        {
+            std::lock_guard lock(mutex_);
+            for (Slot& slot : slots_)
+            {
+                if (slot.state != SlotState::submitted || vkGetFenceStatus(device_, slot.fence) != VK_SUCCESS)
+                    continue;
+                check_vk_result(vkResetFences(device_, 1, &slot.fence));
+                slot.state = SlotState::reading;
+                done.push_back(&slot);
+            }
+        }
+
+        auto& jobs = get_subsystem<JobSystem>();
+        for (Slot* slot : done)
+        {
+            jobs_.push_back(jobs.submit([this, slot]() {
+                if (!slot->coherent)
+                {
+                    VkMappedMemoryRange range = {};
+                    range.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+                    range.memory              = slot->buffer_memory;
+                    range.size                = VK_WHOLE_SIZE;
+                    check_vk_result(vkInvalidateMappedMemoryRanges(device_, 1, &range));
+                }
+
+                const size_t             size = static_cast<size_t>(slot->width) * slot->height * 4;
+                std::span<const uint8_t> rgba(slot->mapped, size);
+                std::vector<uint8_t>     swizzled;
+                if (is_bgra(slot->format))
+                {
+                    swizzled.assign(rgba.begin(), rgba.end());
+                    for (size_t i = 0; i < size; i += 4)
+                        std::swap(swizzled[i], swizzled[i + 2]);
+                    rgba = swizzled;
+                }
+
+                CaptureCallback callback = std::move(slot->callback);
+                callback(CapturedImage {slot->width, slot->height, slot->frame, rgba});
+                captured_.fetch_add(1, std::memory_order_relaxed);
+
+                std::lock_guard lock(mutex_);
+                slot->state = SlotState::free;
+            }));
+        }
+    }
+
+    void FrameCapture::record_images(VkCommandBuffer command_buffer)
+    {
+        if (!has_requests())
+            return;
+
+        std::lock_guard lock(mutex_);
+        for (ImageRequest& request : image_requests_)
+        {
+            Slot* slot = acquire_slot(request.format, request.width, request.height, request.frame, std::move(request.callback));
+            if (!slot)
+                continue;
+
+            VkImageMemoryBarrier barrier        = {};
+            barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask               = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask               = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.oldLayout                   = request.layout;
+            barrier.newLayout                   = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image                       = request.image;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.layerCount = 1;
+            vkCmdPipelineBarrier(command_buffer,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 0,
+                                 0,
+                                 nullptr,
+                                 0,
+                                 nullptr,
+                                 1,
+                                 &barrier);
+
+            record_copy(command_buffer, *slot, request.image);
+
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.newLayout     = request.layout;
+            vkCmdPipelineBarrier(command_buffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 0,
+                                 0,
+                                 nullptr,
+                                 0,
+                                 nullptr,
+                                 1,
+                                 &barrier);
+        }
+        image_requests_.clear();
+        update_requested();
+    }
+
+    void FrameCapture::record_window(VkCommandBuffer command_buffer,
+                                     uint32_t        window_id,
+                                     bool            main,
+                                     VkCommandBuffer bundle,
+                                     VkFormat        format,
+                                     uint32_t        width,
+                                     uint32_t        height,
+                                     VkClearValue    clear)
+    {
+        if (!has_requests())
+            return;
+
+        std::lock_guard lock(mutex_);
+        std::erase_if(window_requests_, [&](WindowRequest& request) {
+            if (request.window_id != window_id && !(main && request.window_id == main_window))
+                return false;
+            if (!is_supported(format))
+            {
+                APPLOG_WARNING("[capture] Swapchain format {} is not RGBA8 or BGRA8, the window is not captured", (int)format);
+                return true;
+            }
+
+            Slot* slot = acquire_slot(format, width, height, request.frame, std::move(request.callback));
+            if (!slot)
+                return true;
+            if (!reserve_image(*slot, format, width, height))
+            {
+                slot->callback = nullptr;
+                slot->state    = SlotState::free;
+                return true;
+            }
+
+            VkRenderPassBeginInfo info    = {};
+            info.sType                    = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            info.renderPass               = get_render_pass(format);
+            info.framebuffer              = slot->framebuffer;
+            info.renderArea.extent.width  = width;
+            info.renderArea.extent.height = height;
+            info.clearValueCount          = 1;
+            info.pClearValues             = &clear;
+            vkCmdBeginRenderPass(command_buffer, &info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(command_buffer, 1, &bundle);
+            vkCmdEndRenderPass(command_buffer);
+
+            record_copy(command_buffer, *slot, slot->image);
+            return true;
+        });
+        update_requested();
+    }
+
+    void FrameCapture::submit()
+    {
+        if (!recorded_.exchange(false, std::memory_order_relaxed))
+            return;
+
+        // An empty submission signals its fence once everything submitted before it has completed.
+        std::lock_guard lock(mutex_);
+        for (Slot& slot : slots_)
+        {
+            if (slot.state != SlotState::recorded)
+                continue;
+            check_vk_result(vkQueueSubmit(queue_, 0, nullptr, slot.fence));
+            slot.state = SlotState::submitted;
+        }
+    }
+
+    FrameCapture::Slot* FrameCapture::acquire_slot(VkFormat format, uint32_t width, uint32_t height, uint64_t frame, CaptureCallback callback)
+    {
+        const auto it = std::ranges::find_if(slots_, [](const Slot& slot) { return slot.state == SlotState::free; });
+        if (it == slots_.end())
+        {
+            if (dropped_.fetch_add(1, std::memory_order_relaxed) == 0)
+                APPLOG_WARNING("[capture] Every readback buffer is busy, dropping captures (see --capture-buffers)");
+            return nullptr;
+        }
+        if (!reserve_buffer(*it, static_cast<VkDeviceSize>(width) * height * 4))
+            return nullptr;
+
+        recorded_.store(true, std::memory_order_relaxed);
+        it->state    = SlotState::recorded;
+        it->format   = format;
+        it->width    = width;
+        it->height   = height;
+        it->frame    = frame;
+        it->callback = std::move(callback);
+        return &*it;
+    }
+
+    bool FrameCapture::reserve_buffer(Slot& slot, VkDeviceSize size)
+    {
+        if (slot.buffer_size >= size)
+            return true;
+
+        if (slot.buffer)
+        {
+            vkUnmapMemory(device_, slot.buffer_memory);
+            vkDestroyBuffer(device_, slot.buffer, allocator_);
+            vkFreeMemory(device_, slot.buffer_memory, allocator_);
+            slot.buffer      = VK_NULL_HANDLE;
+            slot.buffer_size = 0;
+        }
+
+        VkBufferCreateInfo info = {};
+        info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size               = size;
+        info.usage              = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+        check_vk_result(vkCreateBuffer(device_, &info, allocator_, &slot.buffer));
+
+        // Cached memory reads back far faster than the write-combined kind; coherency is optional then.
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device_, slot.buffer, &requirements);
+        const uint32_t type_bits   = requirements.memoryTypeBits;
+        uint32_t       memory_type = find_memory_type(type_bits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        if (memory_type == UINT32_MAX)
+            memory_type = find_memory_type(type_bits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (memory_type == UINT32_MAX)
+        {
+            APPLOG_ERROR("[capture] No host visible memory for readback buffers");
+            vkDestroyBuffer(device_, std::exchange(slot.buffer, VK_NULL_HANDLE), allocator_);
+            return false;
+        }
+
+        VkPhysicalDeviceMemoryProperties properties;
+        vkGetPhysicalDeviceMemoryProperties(physical_device_, &properties);
+        slot.coherent = properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize       = requirements.size;
+        alloc_info.memoryTypeIndex      = memory_type;
+        check_vk_result(vkAllocateMemory(device_, &alloc_info, allocator_, &slot.buffer_memory));
+        check_vk_result(vkBindBufferMemory(device_, slot.buffer, slot.buffer_memory, 0));
+        void* mapped = nullptr;
+        check_vk_result(vkMapMemory(device_, slot.buffer_memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+        slot.mapped      = static_cast<uint8_t*>(mapped);
+        slot.buffer_size = size;
+        return true;
+    }
+
+    bool FrameCapture::reserve_image(Slot& slot, VkFormat format, uint32_t width, uint32_t height)
+    {
+        if (slot.image && slot.image_format == format && slot.image_width == width && slot.image_height == height)
+            return true;
+
+        vkDestroyFramebuffer(device_, std::exchange(slot.framebuffer, VK_NULL_HANDLE), allocator_);
+        vkDestroyImageView(device_, std::exchange(slot.view, VK_NULL_HANDLE), allocator_);
+        vkDestroyImage(device_, std::exchange(slot.image, VK_NULL_HANDLE), allocator_);
+        vkFreeMemory(device_, std::exchange(slot.image_memory, VK_NULL_HANDLE), allocator_);
+
+        {
+            VkImageCreateInfo info = {};
+            info.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            info.imageType         = VK_IMAGE_TYPE_2D;
+            info.format            = format;
+            info.extent            = {width, height, 1};
+            info.mipLevels         = 1;
+            info.arrayLayers       = 1;
+            info.samples           = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling            = VK_IMAGE_TILING_OPTIMAL;
+            info.usage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+            info.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+            check_vk_result(vkCreateImage(device_, &info, allocator_, &slot.image));
+        }
+        {
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(device_, slot.image, &requirements);
+            VkMemoryAllocateInfo info = {};
+            info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            info.allocationSize       = requirements.size;
+            info.memoryTypeIndex      = find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if (info.memoryTypeIndex == UINT32_MAX)
+            {
+                APPLOG_ERROR("[capture] No device local memory for a {}x{} capture image", width, height);
+                vkDestroyImage(device_, std::exchange(slot.image, VK_NULL_HANDLE), allocator_);
+                return false;
+            }
+            check_vk_result(vkAllocateMemory(device_, &info, allocator_, &slot.image_memory));
+            check_vk_result(vkBindImageMemory(device_, slot.image, slot.image_memory, 0));
+        }
+        {
+            VkImageViewCreateInfo info       = {};
+            info.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            info.image                       = slot.image;
+            info.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+            info.format                      = format;
+            info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            info.subresourceRange.levelCount = 1;
+            info.subresourceRange.layerCount = 1;
+            check_vk_result(vkCreateImageView(device_, &info, allocator_, &slot.view));
+        }
+        {
+            VkFramebufferCreateInfo info = {};
+            info.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            info.renderPass              = get_render_pass(format);
+            info.attachmentCount         = 1;
+            info.pAttachments            = &slot.view;
+            info.width                   = width;
+            info.height                  = height;
+            info.layers                  = 1;
+            check_vk_result(vkCreateFramebuffer(device_, &info, allocator_, &slot.framebuffer));
+        }
+        slot.image_format = format;
+        slot.image_width  = width;
+        slot.image_height = height;
+        return true;
+    }
+
+    // Compatible with the ImGui backend's window render pass (one color attachment of the same format), so the
+    // window's UI bundle executes in it, but it leaves the image ready to be copied from.
+    VkRenderPass FrameCapture::get_render_pass(VkFormat format)
+    {
+        VkRenderPass& render_pass = render_passes_[format];
+        if (render_pass)
+            return render_pass;
+
+        VkAttachmentDescription attachment = {};
+        attachment.format                  = format;
+        attachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachment.finalLayout             = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkAttachmentReference color = {};
+        color.attachment            = 0;
+        color.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments    = &color;
+
+        VkSubpassDependency dependencies[2] = {};
+        dependencies[0].srcSubpass          = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass          = 0;
+        dependencies[0].srcStageMask        = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[0].dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].srcAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+        dependencies[0].dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].srcSubpass          = 0;
+        dependencies[1].dstSubpass          = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].dstStageMask        = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+
+        VkRenderPassCreateInfo info = {};
+        info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        info.attachmentCount        = 1;
+        info.pAttachments           = &attachment;
+        info.subpassCount           = 1;
+        info.pSubpasses             = &subpass;
+        info.dependencyCount        = 2;
+        info.pDependencies          = dependencies;
+        check_vk_result(vkCreateRenderPass(device_, &info, allocator_, &render_pass));
+        return render_pass;
+    }
+
+    void FrameCapture::record_copy(VkCommandBuffer command_buffer, Slot& slot, VkImage image)
+    {
+        VkBufferImageCopy region           = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent                 = {slot.width, slot.height, 1};
+        vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask         = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer                = slot.buffer;
+        barrier.size                  = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    void FrameCapture::update_requested() { requested_.store(!window_requests_.empty() || !image_requests_.empty(), std::memory_order_relaxed); }
+
+    void FrameCapture::destroy_slot(Slot& slot)
+    {
+        if (slot.buffer)
+        {
+            vkUnmapMemory(device_, slot.buffer_memory);
+            vkDestroyBuffer(device_, slot.buffer, allocator_);
+            vkFreeMemory(device_, slot.buffer_memory, allocator_);
+        }
+        vkDestroyFramebuffer(device_, slot.framebuffer, allocator_);
+        vkDestroyImageView(device_, slot.view, allocator_);
+        vkDestroyImage(device_, slot.image, allocator_);
+        vkFreeMemory(device_, slot.image_memory, allocator_);
+        vkDestroyFence(device_, slot.fence, allocator_);
+        slot = Slot {};
+    }
+
+    uint32_t FrameCapture::find_memory_type(uint32_t type_bits, VkMemoryPropertyFlags properties) const
+    {
+        VkPhysicalDeviceMemoryProperties memory_properties;
+        vkGetPhysicalDeviceMemoryProperties(physical_device_, &memory_properties);
+        for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+        {
+            if ((memory_properties.memoryTypes[i].propertyFlags & properties) == properties && (type_bits & (1u << i)))
+                return i;
+        }
+        return UINT32_MAX;
+    }
+} // namespace core
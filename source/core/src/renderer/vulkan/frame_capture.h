@@ -0,0 +1,176 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace core
+{
+    // A captured image as a JobSystem worker sees it: RGBA8, rows top to bottom, valid during the callback.
+    struct CapturedImage
+    {
+        uint32_t                 width  = 0;
+        uint32_t                 height = 0;
+        uint64_t                 frame  = 0; // FrameCapture's frame counter when it was requested
+        std::span<const uint8_t> rgba;
+    };
+
+    using CaptureCallback = std::function<void(const CapturedImage&)>;
+
+    // Copies rendered images back to the CPU without stalling a frame.
+    //
+    // A capture is recorded into the command buffer of the frame it belongs to: a copy into one of a ring of
+    // host visible readback buffers, followed by a fence of its own. The fences are polled once per frame;
+    // when one has signaled, a JobSystem job hands the pixels to the callback (encoding, writing) and only
+    // then frees the buffer. With every buffer busy a capture is dropped, never waited for.
+    //
+    // Swapchain images cannot be copied from (the ImGui backend creates them as color attachments only), so
+    // a window capture replays the window's recorded UI into an offscreen image of the same format.
+    //
+    // With --capture-every N the main window is written to --capture-dir (default captures) every N frames,
+    // as --capture-format png (default) or raw. --capture-buffers sets the ring size (default 3).
+    class FrameCapture
+    {
+    public:
+        enum class Format : uint8_t
+        {
+            png,
+            raw,
+        };
+
+        // Passed to capture_window() for whichever window is the main one.
+        static constexpr uint32_t main_window = 0;
+
+        static constexpr uint32_t default_slot_count = 3;
+
+        FrameCapture(VkDevice device, VkPhysicalDevice physical_device, const VkAllocationCallbacks* allocator, VkQueue queue);
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture&)            = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        // Writes pixels to path, as PNG when it ends in .png, else raw (see get_raw_name()).
+        static CaptureCallback save_to(std::filesystem::path path);
+
+        // Captures what the window presents next.
+        void capture_window(uint32_t window_id, CaptureCallback callback);
+        // Captures image as the render passes of the next frame leave it (see VulkanRenderer::add_render_pass()).
+        // It needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT, an RGBA8 or BGRA8 format, and to be in layout at that point.
+        void capture_image(VkImage image, VkImageLayout layout, VkFormat format, uint32_t width, uint32_t height, CaptureCallback callback);
+
+        // Captures the main window every interval frames into dir; 0 stops.
+        void set_interval(uint32_t interval, std::filesystem::path dir, Format format);
+
+        [[nodiscard]] uint64_t get_captured_count() const noexcept { return captured_.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t get_dropped_count() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+        // VulkanRenderer: once per frame on the main thread, before anything is recorded.
+        void poll();
+        // VulkanRenderer, on the thread that records: the offscreen images requested, ahead of the UI.
+        void record_images(VkCommandBuffer command_buffer);
+        // VulkanRenderer, after the window's render pass: replays bundle into a capture when one is requested.
+        void record_window(VkCommandBuffer command_buffer,
+                           uint32_t        window_id,
+                           bool            main,
+                           VkCommandBuffer bundle,
+                           VkFormat        format,
+                           uint32_t        width,
+                           uint32_t        height,
+                           VkClearValue    clear);
+        // VulkanRenderer, right after submitting the command buffer that recorded captures, holding the queue lock.
+        void submit();
+
+        // Cheap check whether record_*() would do anything.
+        [[nodiscard]] bool has_requests() const noexcept { return requested_.load(std::memory_order_relaxed); }
+
+    private:
+        enum class SlotState : uint8_t
+        {
+            free,
+            recorded,  // Copy is in a command buffer that was not submitted yet
+            submitted, // Fence follows the copy
+            reading,   // A job reads the buffer
+        };
+
+        struct Slot
+        {
+            VkBuffer        buffer        = VK_NULL_HANDLE;
+            VkDeviceMemory  buffer_memory = VK_NULL_HANDLE;
+            VkDeviceSize    buffer_size   = 0;
+            uint8_t*        mapped        = nullptr;
+            bool            coherent      = false;
+            VkImage         image         = VK_NULL_HANDLE; // Offscreen target of window captures
+            VkDeviceMemory  image_memory  = VK_NULL_HANDLE;
+            VkImageView     view          = VK_NULL_HANDLE;
+            VkFramebuffer   framebuffer   = VK_NULL_HANDLE;
+            VkFormat        image_format  = VK_FORMAT_UNDEFINED;
+            uint32_t        image_width   = 0;
+            uint32_t        image_height  = 0;
+            VkFence         fence         = VK_NULL_HANDLE;
+            SlotState       state         = SlotState::free;
+            VkFormat        format        = VK_FORMAT_UNDEFINED; // Of the capture in it
+            uint32_t        width         = 0;
+            uint32_t        height        = 0;
+            uint64_t        frame         = 0;
+            CaptureCallback callback;
+        };
+
+        struct WindowRequest
+        {
+            uint32_t        window_id;
+            uint64_t        frame;
+            CaptureCallback callback;
+        };
+
+        struct ImageRequest
+        {
+            VkImage         image;
+            VkImageLayout   layout;
+            VkFormat        format;
+            uint32_t        width;
+            uint32_t        height;
+            uint64_t        frame;
+            CaptureCallback callback;
+        };
+
+        // All under mutex_.
+        Slot*        acquire_slot(VkFormat format, uint32_t width, uint32_t height, uint64_t frame, CaptureCallback callback);
+        bool         reserve_buffer(Slot& slot, VkDeviceSize size);
+        bool         reserve_image(Slot& slot, VkFormat format, uint32_t width, uint32_t height);
+        VkRenderPass get_render_pass(VkFormat format);
+        void         record_copy(VkCommandBuffer command_buffer, Slot& slot, VkImage image);
+        void         update_requested();
+        void         destroy_slot(Slot& slot);
+        uint32_t     find_memory_type(uint32_t type_bits, VkMemoryPropertyFlags properties) const;
+
+        VkDevice                     device_;
+        VkPhysicalDevice             physical_device_;
+        const VkAllocationCallbacks* allocator_;
+        VkQueue                      queue_;
+
+        std::mutex                                 mutex_;
+        std::vector<Slot>                          slots_;
+        std::vector<WindowRequest>                 window_requests_;
+        std::vector<ImageRequest>                  image_requests_;
+        std::unordered_map<VkFormat, VkRenderPass> render_passes_;
+        std::atomic<bool>                          requested_ {false};
+        std::atomic<bool>                          recorded_ {false}; // Slots wait for submit()
+        // Advanced by poll() on the main thread, read by requests from any thread.
+        std::atomic<uint64_t>                      frame_ {0};
+
+        // Main thread only.
+        std::vector<std::future<void>> jobs_;
+        uint32_t                       interval_ = 0;
+        std::filesystem::path          dir_;
+        Format                         format_ = Format::png;
+
+        std::atomic<uint64_t> captured_ {0};
+        std::atomic<uint64_t> dropped_ {0};
+    };
+} // namespace core
@@ -1,7 +1,11 @@
 #include "vulkan_renderer.h"
+#include "device_selector.h"
 #include "imgui_impl_vulkan.h"
 #include <algorithm>
+#include <bit>
+#include <cstring>
 #include <ranges>
+#include <span>
 #include <vector>
 
 #ifdef IMGUI_IMPL_VULKAN_USE_VOLK
@@ -12,6 +16,7 @@
 #ifdef _DEBUG
 #define APP_USE_VULKAN_DEBUG_REPORT
 #endif
+#include "cmd_line/parser.hpp"
 #include "event/frame_event.h"
 #include "logger.h"
 #include <SDL3/SDL_init.h>
@@ -21,9 +26,18 @@
 
 #include <event/EventManager.h>
 #include <event/sdl_event.h>
+#include <font/font_manager.h>
+#include <memory/memory_tracker.h>
+#include <metrics/metrics.h>
+#include <system/session_snapshot.h>
+#include <system/watchdog.h>
 #include <window/window_manager.h>
 namespace core
 {
+    // Versions of the session snapshot sections this file owns.
+    static constexpr uint32_t pipeline_cache_section_version = 1;
+    static constexpr uint32_t layout_section_version         = 1;
+
     static void check_vk_result(VkResult err)
     {
         if (err == VK_SUCCESS)
@@ -40,6 +54,32 @@ namespace core
         });
     }
 
+    // Drivers are meant to reject pipeline cache data of another device or driver, not all of them do.
+    static bool IsPipelineCacheCompatible(std::span<const std::byte> data, const VkPhysicalDeviceProperties& properties)
+    {
+        uint32_t header[4];
+        if (data.size() < sizeof(header) + VK_UUID_SIZE)
+            return false;
+        std::memcpy(header, data.data(), sizeof(header));
+        return header[0] >= sizeof(header) + VK_UUID_SIZE && header[1] == static_cast<uint32_t>(VK_PIPELINE_CACHE_HEADER_VERSION_ONE) &&
+               header[2] == properties.vendorID && header[3] == properties.deviceID &&
+               std::memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    static VKAPI_ATTR void* VKAPI_CALL tracked_allocation(void*, size_t size, size_t alignment, VkSystemAllocationScope)
+    {
+        return MemoryTracker::allocate(size, alignment, MemoryTracker::tag_vulkan);
+    }
+
+    static VKAPI_ATTR void* VKAPI_CALL tracked_reallocation(void*, void* original, size_t size, size_t alignment, VkSystemAllocationScope)
+    {
+        return MemoryTracker::reallocate(original, size, alignment, MemoryTracker::tag_vulkan);
+    }
+
+    static VKAPI_ATTR void VKAPI_CALL tracked_free(void*, void* memory) { MemoryTracker::deallocate(memory); }
+
+    static VkAllocationCallbacks tracked_allocation_callbacks = {nullptr, tracked_allocation, tracked_reallocation, tracked_free, nullptr, nullptr};
+
 #ifdef APP_USE_VULKAN_DEBUG_REPORT
     static VKAPI_ATTR VkBool32 VKAPI_CALL debug_report(VkDebugReportFlagsEXT      flags,
                                                        VkDebugReportObjectTypeEXT objectType,
@@ -64,11 +104,17 @@ namespace core
     VulkanRenderer::~VulkanRenderer()
     {
         // Cleanup
+        renderThread_.reset();
         auto err = vkDeviceWaitIdle(device_);
         check_vk_result(err);
-        ImGui_ImplVulkan_Shutdown();
-        ImGui_ImplSDL3_Shutdown();
-        ImGui::DestroyContext();
+        capture_.reset();
+        resolution_.reset();
+        if (has_subsystem<SessionSnapshot>())
+        {
+            auto& session = get_subsystem<SessionSnapshot>();
+            session.remove_section("vulkan.pipeline_cache");
+            session.remove_section("imgui.layout");
+        }
 
         CleanupVulkanWindow();
         CleanupVulkan();
@@ -81,6 +127,8 @@ namespace core
 #ifdef IMGUI_IMPL_VULKAN_USE_VOLK
         volkInitialize();
 #endif
+        if (MemoryTracker::is_enabled())
+            allocator_ = &tracked_allocation_callbacks;
 
         VkInstanceCreateInfo create_info = {};
         create_info.sType                = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -137,16 +185,33 @@ namespace core
         err                         = f_vkCreateDebugReportCallbackEXT(instance_, &debug_report_ci, allocator_, &debugReport_);
         check_vk_result(err);
 #endif
-        // Select Physical Device (GPU)
-        physicalDevice_ = ImGui_ImplVulkanH_SelectPhysicalDevice(instance_);
-
-        // Select graphics queue family
-        queueFamily_ = ImGui_ImplVulkanH_SelectQueueFamilyIndex(physicalDevice_);
+        // Select Physical Device (GPU) and its queue families, --gpu <index or name> overrides the scoring
+        {
+            const auto             candidates = enumerate_devices(instance_);
+            const DeviceCandidate* chosen     = select_device(candidates, Parser::instance().getOptionValue("gpu"));
+            log_device_report(candidates, chosen);
+            if (!chosen)
+                abort();
+            physicalDevice_      = chosen->device;
+            queueFamily_         = chosen->queues.graphics;
+            computeQueueFamily_  = chosen->queues.compute;
+            transferQueueFamily_ = chosen->queues.transfer;
+        }
 
-        // Create Logical Device (with 1 queue)
+        // Create Logical Device (with one queue per distinct family)
         std::vector<const char*> device_extensions;
         device_extensions.push_back("VK_KHR_swapchain");
 
+        // Descriptor indexing for the bindless texture heap. Optional, without it there are only ImGui's sets.
+        BindlessSupport bindless;
+        if (!Parser::instance().hasOption("no-bindless"))
+            bindless = BindlessHeap::query_support(instance_, physicalDevice_);
+        if (bindless.supported)
+        {
+            device_extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+            device_extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
+
         {
             // Enumerate physical device extension
             uint32_t                           properties_count;
@@ -159,28 +224,40 @@ namespace core
                 device_extensions.push_back(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
 #endif
 
-            const float             queue_priority[] = {1.0f};
-            VkDeviceQueueCreateInfo queue_info[1]    = {};
-            queue_info[0].sType                      = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            queue_info[0].queueFamilyIndex           = queueFamily_;
-            queue_info[0].queueCount                 = 1;
-            queue_info[0].pQueuePriorities           = queue_priority;
-            VkDeviceCreateInfo create_info           = {};
-            create_info.sType                        = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-            create_info.queueCreateInfoCount         = sizeof(queue_info) / sizeof(queue_info[0]);
-            create_info.pQueueCreateInfos            = queue_info;
-            create_info.enabledExtensionCount        = device_extensions.size();
-            create_info.ppEnabledExtensionNames      = device_extensions.data();
-            err                                      = vkCreateDevice(physicalDevice_, &create_info, allocator_, &device_);
+            const float                          queue_priority[] = {1.0f};
+            std::vector<VkDeviceQueueCreateInfo> queue_info;
+            for (uint32_t family : {queueFamily_, computeQueueFamily_, transferQueueFamily_})
+            {
+                if (std::ranges::any_of(queue_info, [family](const auto& info) { return info.queueFamilyIndex == family; }))
+                    continue;
+                VkDeviceQueueCreateInfo info = {};
+                info.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+                info.queueFamilyIndex        = family;
+                info.queueCount              = 1;
+                info.pQueuePriorities        = queue_priority;
+                queue_info.push_back(info);
+            }
+            VkDeviceCreateInfo create_info      = {};
+            create_info.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            create_info.pNext                   = bindless.supported ? &bindless.features : nullptr;
+            create_info.queueCreateInfoCount    = static_cast<uint32_t>(queue_info.size());
+            create_info.pQueueCreateInfos       = queue_info.data();
+            create_info.enabledExtensionCount   = device_extensions.size();
+            create_info.ppEnabledExtensionNames = device_extensions.data();
+            err                                 = vkCreateDevice(physicalDevice_, &create_info, allocator_, &device_);
             check_vk_result(err);
+            // Families shared with graphics hand out the same queue.
             vkGetDeviceQueue(device_, queueFamily_, 0, &queue_);
+            vkGetDeviceQueue(device_, computeQueueFamily_, 0, &computeQueue_);
+            vkGetDeviceQueue(device_, transferQueueFamily_, 0, &transferQueue_);
         }
 
         // Create Descriptor Pool
-        // If you wish to load e.g. additional textures you may need to alter pools sizes and maxSets.
+        // Only ImGui's sets come from it: every window owns an ImGui context with its own font texture, so the
+        // pool is sized per window. Textures beyond a few UI ones belong in the bindless heap.
         {
             VkDescriptorPoolSize pool_sizes[] = {
-                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE * maxWindowCount_},
             };
             VkDescriptorPoolCreateInfo pool_info = {};
             pool_info.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -194,33 +271,526 @@ namespace core
             check_vk_result(err);
         }
 
+        // Primed with the previous run's pipelines, so they are not compiled again.
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+            std::span<const std::byte> data;
+            if (has_subsystem<SessionSnapshot>())
+                data = get_subsystem<SessionSnapshot>().get_section("vulkan.pipeline_cache", pipeline_cache_section_version);
+            if (!data.empty() && !IsPipelineCacheCompatible(data, properties))
+            {
+                APPLOG_INFO("[vulkan] Pipeline cache of the session is from another device or driver, starting empty");
+                data = {};
+            }
+
+            VkPipelineCacheCreateInfo info = {};
+            info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            info.initialDataSize           = data.size();
+            info.pInitialData              = data.data();
+            err                            = vkCreatePipelineCache(device_, &info, allocator_, &pipelineCache_);
+            check_vk_result(err);
+        }
+
+        SetupUploadResources();
+        capture_    = std::make_unique<FrameCapture>(device_, physicalDevice_, allocator_, queue_);
+        resolution_ = std::make_unique<DynamicResolution>(device_, physicalDevice_, queueFamily_, allocator_);
+
+        if (bindless.supported)
+        {
+            const uint32_t capacity = std::min(BindlessHeap::default_capacity, bindless.max_textures);
+            bindless_               = std::make_unique<BindlessHeap>(device_, allocator_, textureSampler_, capacity);
+        }
+        else
+            APPLOG_INFO("[vulkan] No descriptor indexing, bindless textures are unavailable");
+
+        drawCacheEnabled_ = !Parser::instance().hasOption("no-ui-draw-cache");
+        if (has_subsystem<Metrics>())
+            swapchainRebuilds_ = &get_subsystem<Metrics>().add_counter("vulkan_swapchain_rebuilds_total", "Swap chains created or resized.");
+
+        mainWindow_ = CreateWindowContext(get_subsystem<WindowManager>().get_main_window(), true);
+
+        if (has_subsystem<SessionSnapshot>())
+        {
+            auto& session = get_subsystem<SessionSnapshot>();
+            session.add_section("vulkan.pipeline_cache", pipeline_cache_section_version, [this](std::vector<std::byte>& data) {
+                size_t size = 0;
+                check_vk_result(vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr));
+                data.resize(size);
+                // Pipelines created since the size query make it VK_INCOMPLETE, what fitted is still valid.
+                const VkResult result = vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data());
+                if (result != VK_INCOMPLETE)
+                    check_vk_result(result);
+                data.resize(size);
+            });
+            if (mainWindow_)
+            {
+                session.add_section("imgui.layout", layout_section_version, [this](std::vector<std::byte>& data) {
+                    ImGuiContext* previous = ImGui::GetCurrentContext();
+                    ImGui::SetCurrentContext(mainWindow_->imgui);
+                    size_t      size = 0;
+                    const auto* ini  = reinterpret_cast<const std::byte*>(ImGui::SaveIniSettingsToMemory(&size));
+                    data.assign(ini, ini + size);
+                    ImGui::SetCurrentContext(previous);
+                });
+            }
+        }
+
+        if (Parser::instance().hasOption("render-thread"))
+        {
+            const size_t depth = std::stoul(Parser::instance().getOptionValue("render-queue-depth", "1"));
+            renderThread_      = std::make_unique<RenderThread>(depth, [this](FramePacket& packet) { RenderPacket(packet); });
+            renderQueueDepth_  = static_cast<uint32_t>(depth);
+        }
+
+        connect<FrameUpdate, VulkanRenderer, &VulkanRenderer::frame_update>(*this);
+        connect<FrameUiRender, VulkanRenderer, &VulkanRenderer::frame_ui_render>(*this);
+        connect<FrameRender, VulkanRenderer, &VulkanRenderer::frame_render>(*this);
+        connect<SDLEvent, VulkanRenderer, &VulkanRenderer::pool_event>(*this);
+        connect<WindowCreated, VulkanRenderer, &VulkanRenderer::window_created>(*this);
+        connect<WindowDestroyed, VulkanRenderer, &VulkanRenderer::window_destroyed>(*this);
+    }
+
+    void VulkanRenderer::SetupUploadResources()
+    {
+        VkResult err;
+        {
+            VkSamplerCreateInfo info = {};
+            info.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+            info.magFilter           = VK_FILTER_LINEAR;
+            info.minFilter           = VK_FILTER_LINEAR;
+            info.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            info.addressModeU        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            info.addressModeV        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            info.addressModeW        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            info.minLod              = -1000;
+            info.maxLod              = 1000;
+            info.maxAnisotropy       = 1.0f;
+            err                      = vkCreateSampler(device_, &info, allocator_, &textureSampler_);
+            check_vk_result(err);
+        }
+        {
+            VkCommandPoolCreateInfo info = {};
+            info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            info.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            info.queueFamilyIndex        = queueFamily_;
+            err                          = vkCreateCommandPool(device_, &info, allocator_, &uploadCommandPool_);
+            check_vk_result(err);
+
+            for (UploadSlot& slot : uploadSlots_)
+            {
+                VkCommandBufferAllocateInfo alloc_info = {};
+                alloc_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                alloc_info.commandPool                 = uploadCommandPool_;
+                alloc_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                alloc_info.commandBufferCount          = 1;
+                err                                    = vkAllocateCommandBuffers(device_, &alloc_info, &slot.commandBuffer);
+                check_vk_result(err);
+
+                VkFenceCreateInfo fence_info = {};
+                fence_info.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+                err                          = vkCreateFence(device_, &fence_info, allocator_, &slot.fence);
+                check_vk_result(err);
+            }
+        }
+    }
+
+    uint32_t VulkanRenderer::FindMemoryType(uint32_t type_bits, VkMemoryPropertyFlags properties) const
+    {
+        VkPhysicalDeviceMemoryProperties memory_properties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memory_properties);
+        for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+        {
+            if ((memory_properties.memoryTypes[i].propertyFlags & properties) == properties && (type_bits & (1u << i)))
+                return i;
+        }
+        return UINT32_MAX;
+    }
+
+    ImTextureID VulkanRenderer::create_texture(uint32_t width, uint32_t height)
+    {
+        Texture texture = CreateTexture(width, height);
+        {
+            std::lock_guard lock(backendMutex_);
+            texture.set = ImGui_ImplVulkan_AddTexture(textureSampler_, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        if (bindless_)
+            texture.bindless = bindless_->add(texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        ImTextureID id = (ImTextureID)texture.set;
+        textures_.emplace(id, texture);
+        return id;
+    }
+
+    uint32_t VulkanRenderer::create_bindless_texture(uint32_t width, uint32_t height)
+    {
+        if (!bindless_)
+            return BindlessHeap::invalid;
+        Texture texture  = CreateTexture(width, height);
+        texture.bindless = bindless_->add(texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        if (texture.bindless == BindlessHeap::invalid)
+        {
+            DestroyTexture(texture);
+            return BindlessHeap::invalid;
+        }
+        bindlessTextures_.emplace(texture.bindless, texture);
+        return texture.bindless;
+    }
+
+    VulkanRenderer::Texture VulkanRenderer::CreateTexture(uint32_t width, uint32_t height)
+    {
+        VkResult err;
+        Texture  texture;
+        texture.width  = width;
+        texture.height = height;
+        {
+            VkImageCreateInfo info = {};
+            info.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            info.imageType         = VK_IMAGE_TYPE_2D;
+            info.format            = VK_FORMAT_R8G8B8A8_UNORM;
+            info.extent            = {width, height, 1};
+            info.mipLevels         = 1;
+            info.arrayLayers       = 1;
+            info.samples           = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling            = VK_IMAGE_TILING_OPTIMAL;
+            info.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+            info.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+            err                    = vkCreateImage(device_, &info, allocator_, &texture.image);
+            check_vk_result(err);
+
+            VkMemoryRequirements req;
+            vkGetImageMemoryRequirements(device_, texture.image, &req);
+            VkMemoryAllocateInfo alloc_info = {};
+            alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            alloc_info.allocationSize       = req.size;
+            alloc_info.memoryTypeIndex      = FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            err                             = vkAllocateMemory(device_, &alloc_info, allocator_, &texture.memory);
+            check_vk_result(err);
+            err = vkBindImageMemory(device_, texture.image, texture.memory, 0);
+            check_vk_result(err);
+        }
+        {
+            VkImageViewCreateInfo info       = {};
+            info.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            info.image                       = texture.image;
+            info.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+            info.format                      = VK_FORMAT_R8G8B8A8_UNORM;
+            info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            info.subresourceRange.levelCount = 1;
+            info.subresourceRange.layerCount = 1;
+            err                              = vkCreateImageView(device_, &info, allocator_, &texture.view);
+            check_vk_result(err);
+        }
+        return texture;
+    }
+
+    void VulkanRenderer::update_texture(ImTextureID id, int x, int y, int w, int h, const uint8_t* pixels, int row_length)
+    {
+        auto it = textures_.find(id);
+        if (it != textures_.end() && w > 0 && h > 0)
+            UploadTexture(it->second, x, y, w, h, pixels, row_length);
+    }
+
+    void VulkanRenderer::update_bindless_texture(uint32_t index, int x, int y, int w, int h, const uint8_t* pixels, int row_length)
+    {
+        auto it = bindlessTextures_.find(index);
+        if (it != bindlessTextures_.end() && w > 0 && h > 0)
+            UploadTexture(it->second, x, y, w, h, pixels, row_length);
+    }
+
+    VulkanRenderer::UploadSlot& VulkanRenderer::AcquireUploadSlot(VkDeviceSize size)
+    {
+        UploadSlot& slot = uploadSlots_[nextUploadSlot_];
+        nextUploadSlot_  = (nextUploadSlot_ + 1) % upload_slot_count;
+
+        VkResult err;
+        if (slot.pending)
+        {
+            // Only blocks when the GPU is still behind on all slots, e.g. many uploads within one frame.
+            if (vkGetFenceStatus(device_, slot.fence) == VK_NOT_READY)
+            {
+                WatchdogScope scope("VulkanRenderer::AcquireUploadSlot: vkWaitForFences");
+                err = vkWaitForFences(device_, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+                check_vk_result(err);
+            }
+            err = vkResetFences(device_, 1, &slot.fence);
+            check_vk_result(err);
+            slot.pending = false;
+        }
+
+        if (slot.capacity < size)
+        {
+            if (slot.buffer)
+            {
+                vkDestroyBuffer(device_, slot.buffer, allocator_);
+                vkFreeMemory(device_, slot.memory, allocator_);
+            }
+            slot.capacity = std::max(upload_slot_min_size, std::bit_ceil(size));
+
+            VkBufferCreateInfo info = {};
+            info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            info.size               = slot.capacity;
+            info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+            err                     = vkCreateBuffer(device_, &info, allocator_, &slot.buffer);
+            check_vk_result(err);
+
+            VkMemoryRequirements req;
+            vkGetBufferMemoryRequirements(device_, slot.buffer, &req);
+            VkMemoryAllocateInfo alloc_info = {};
+            alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            alloc_info.allocationSize       = req.size;
+            alloc_info.memoryTypeIndex =
+                FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            err = vkAllocateMemory(device_, &alloc_info, allocator_, &slot.memory);
+            check_vk_result(err);
+            err = vkBindBufferMemory(device_, slot.buffer, slot.memory, 0);
+            check_vk_result(err);
+            err = vkMapMemory(device_, slot.memory, 0, req.size, 0, reinterpret_cast<void**>(&slot.mapped));
+            check_vk_result(err);
+        }
+        return slot;
+    }
+
+    void VulkanRenderer::UploadTexture(Texture& texture, int x, int y, int w, int h, const uint8_t* pixels, int row_length)
+    {
+        texturesUpdated_ = true;
+        UploadSlot& slot = AcquireUploadSlot(static_cast<VkDeviceSize>(w) * h * 4);
+
+        // Only the changed region is staged, tightly packed.
+        for (int row = 0; row < h; ++row)
+        {
+            const uint8_t* src = pixels + (static_cast<size_t>(y + row) * row_length + x) * 4;
+            std::memcpy(slot.mapped + static_cast<size_t>(row) * w * 4, src, static_cast<size_t>(w) * 4);
+        }
+
+        VkResult err = vkResetCommandBuffer(slot.commandBuffer, 0);
+        check_vk_result(err);
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        err                                 = vkBeginCommandBuffer(slot.commandBuffer, &begin_info);
+        check_vk_result(err);
+
+        // Earlier frames on this queue sampling the texture are ordered before the copy by this barrier.
+        VkImageMemoryBarrier barrier            = {};
+        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask                   = texture.initialized ? VK_ACCESS_SHADER_READ_BIT : 0;
+        barrier.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout                       = texture.initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                           = texture.image;
+        barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount     = 1;
+        barrier.subresourceRange.layerCount     = 1;
+        vkCmdPipelineBarrier(slot.commandBuffer,
+                             texture.initialized ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             1,
+                             &barrier);
+
+        VkBufferImageCopy region           = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset                 = {x, y, 0};
+        region.imageExtent                 = {static_cast<uint32_t>(w), static_cast<uint32_t>(h), 1};
+        vkCmdCopyBufferToImage(slot.commandBuffer, slot.buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(
+            slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        err = vkEndCommandBuffer(slot.commandBuffer);
+        check_vk_result(err);
+
+        VkSubmitInfo submit_info       = {};
+        submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers    = &slot.commandBuffer;
+        {
+            std::lock_guard lock(queueMutex_);
+            err = vkQueueSubmit(queue_, 1, &submit_info, slot.fence);
+        }
+        check_vk_result(err);
+
+        // No wait: frames submitted after this are ordered behind the copy by the barrier above.
+        slot.pending        = true;
+        texture.initialized = true;
+    }
+
+    void VulkanRenderer::destroy_texture(ImTextureID id)
+    {
+        auto it = textures_.find(id);
+        if (it == textures_.end())
+            return;
+
+        // No idle wait: frames still sampling it keep the image and its descriptor set until they retired,
+        // see RetireResources().
+        if (bindless_ && it->second.bindless != BindlessHeap::invalid)
+            bindless_->remove(it->second.bindless);
+        retiredTextures_.push_back({it->second, frameCount_});
+        textures_.erase(it);
+    }
+
+    uint32_t VulkanRenderer::get_bindless_index(ImTextureID id) const
+    {
+        auto it = textures_.find(id);
+        return it != textures_.end() ? it->second.bindless : BindlessHeap::invalid;
+    }
+
+    void VulkanRenderer::destroy_bindless_texture(uint32_t index)
+    {
+        auto it = bindlessTextures_.find(index);
+        if (it == bindlessTextures_.end())
+            return;
+
+        // No idle wait: frames still sampling it keep the image until they retired, see RetireResources().
+        bindless_->remove(index);
+        retiredTextures_.push_back({it->second, frameCount_});
+        bindlessTextures_.erase(it);
+    }
+
+    ImTextureID VulkanRenderer::add_image_texture(VkImageView view, VkImageLayout layout)
+    {
+        std::lock_guard lock(backendMutex_);
+        return (ImTextureID)ImGui_ImplVulkan_AddTexture(textureSampler_, view, layout);
+    }
+
+    void VulkanRenderer::remove_image_texture(ImTextureID id)
+    {
+        wait_gpu_idle();
+        std::lock_guard lock(backendMutex_);
+        for (auto& [window_id, context] : windows_)
+            std::ranges::fill(context->drawCache.bundleHashes, 0);
+        ImGui_ImplVulkan_RemoveTexture((VkDescriptorSet)id);
+    }
+
+    void VulkanRenderer::add_render_pass(RenderPass pass) { pendingPasses_.push_back(std::move(pass)); }
+
+    std::unique_lock<std::mutex> VulkanRenderer::lock_queue(VkQueue queue)
+    {
+        if (queue == queue_)
+            return std::unique_lock(queueMutex_);
+        if (queue == computeQueue_)
+            return std::unique_lock(computeQueueMutex_);
+        return std::unique_lock(transferQueueMutex_);
+    }
+
+    void VulkanRenderer::wait_gpu_idle()
+    {
+        WaitRenderIdle();
+        std::scoped_lock lock(queueMutex_, computeQueueMutex_, transferQueueMutex_);
+        auto             err = vkDeviceWaitIdle(device_);
+        check_vk_result(err);
+    }
+
+    // A frame's submissions are done once as many later frames reused its swapchain image slot, plus the frames
+    // queued for the render thread.
+    uint32_t VulkanRenderer::GetFramesInFlight() const
+    {
+        uint32_t image_count = minImageCount_;
+        for (const auto& [id, context] : windows_)
+            image_count = std::max(image_count, context->data.ImageCount);
+        return image_count + renderQueueDepth_ + 1;
+    }
+
+    void VulkanRenderer::RetireResources()
+    {
+        ++frameCount_;
+        const uint32_t frames_in_flight = GetFramesInFlight();
+        if (bindless_)
+            bindless_->advance_frame(frames_in_flight);
+        auto end = std::find_if(retiredTextures_.begin(), retiredTextures_.end(), [&](const RetiredTexture& retired) {
+            return frameCount_ - retired.frame <= frames_in_flight;
+        });
+        for (auto it = retiredTextures_.begin(); it != end; ++it)
+        {
+            if (it->texture.set != VK_NULL_HANDLE)
+            {
+                std::lock_guard lock(backendMutex_);
+                ImGui_ImplVulkan_RemoveTexture(it->texture.set);
+                ++textureGeneration_;
+            }
+            DestroyTexture(it->texture);
+        }
+        retiredTextures_.erase(retiredTextures_.begin(), end);
+    }
+
+    void VulkanRenderer::DestroyTexture(Texture& texture)
+    {
+        vkDestroyImageView(device_, texture.view, allocator_);
+        vkDestroyImage(device_, texture.image, allocator_);
+        vkFreeMemory(device_, texture.memory, allocator_);
+    }
+
+    VulkanRenderer::WindowContext* VulkanRenderer::CreateWindowContext(Window* window, bool main)
+    {
+        if (windows_.size() >= maxWindowCount_)
+        {
+            APPLOG_ERROR("Window limit of {} reached, window {} will not be rendered", maxWindowCount_, window->get_id());
+            return nullptr;
+        }
+
         // Create Window Surface
         VkSurfaceKHR surface;
-        auto         window = get_subsystem<WindowManager>().get_main_window()->get_sdl_window_ptr();
-        if (SDL_Vulkan_CreateSurface(window, instance_, allocator_, &surface) == 0)
+        SDL_Window*  sdl_window = window->get_sdl_window_ptr();
+        if (SDL_Vulkan_CreateSurface(sdl_window, instance_, allocator_, &surface) == 0)
         {
             APPLOG_ERROR("Failed to create Vulkan surface.\n");
+            return nullptr;
         }
 
+        auto  context = std::make_unique<WindowContext>();
+        auto* wc      = context.get();
+        wc->window    = window;
+
         // Create Framebuffers
-        ImGui_ImplVulkanH_Window* wd = &mainWindowData_;
+        ImGui_ImplVulkanH_Window* wd = &wc->data;
         int                       w, h;
-        SDL_GetWindowSize(window, &w, &h);
+        window->get_size(w, h);
         SetupVulkanWindow(wd, surface, w, h);
-        SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
-        SDL_ShowWindow(window);
 
         // Setup Dear ImGui context
+        ImGuiContext* previous = ImGui::GetCurrentContext();
         IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
+        wc->imgui = ImGui::CreateContext();
+        ImGui::SetCurrentContext(wc->imgui);
         ImGuiIO& io = ImGui::GetIO();
         (void)io;
         io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard; // Enable Keyboard Controls
         io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;  // Enable Gamepad Controls
         io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;     // Enable Docking
-        io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;   // Enable Multi-Viewport / Platform Windows
-        // io.ConfigFlags |= ImGuiConfigFlags_ViewportsNoTaskBarIcons;
-        // io.ConfigFlags |= ImGuiConfigFlags_ViewportsNoMerge;
+        if (main)
+        {
+            // Only the main window hosts platform windows; secondary windows keep their UI inside themselves.
+            io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable; // Enable Multi-Viewport / Platform Windows
+            // io.ConfigFlags |= ImGuiConfigFlags_ViewportsNoTaskBarIcons;
+            // io.ConfigFlags |= ImGuiConfigFlags_ViewportsNoMerge;
+        }
+        else
+        {
+            io.IniFilename = nullptr;
+        }
+        // With a session the layout is part of it; the first session run still starts from imgui.ini.
+        if (main && has_subsystem<SessionSnapshot>())
+        {
+            const auto layout = get_subsystem<SessionSnapshot>().get_section("imgui.layout", layout_section_version);
+            if (!layout.empty())
+            {
+                io.IniFilename = nullptr;
+                ImGui::LoadIniSettingsFromMemory(reinterpret_cast<const char*>(layout.data()), layout.size());
+            }
+        }
 
         // Setup Dear ImGui style
         ImGui::StyleColorsDark();
@@ -234,7 +804,7 @@ namespace core
             style.Colors[ImGuiCol_WindowBg].w = 1.0f;
         }
 
-        ImGui_ImplSDL3_InitForVulkan(window);
+        ImGui_ImplSDL3_InitForVulkan(sdl_window);
         ImGui_ImplVulkan_InitInfo init_info = {};
         init_info.Instance                  = instance_;
         init_info.PhysicalDevice            = physicalDevice_;
@@ -252,77 +822,251 @@ namespace core
         init_info.CheckVkResultFn           = check_vk_result;
         ImGui_ImplVulkan_Init(&init_info);
 
-        connect<FrameUpdate, VulkanRenderer, &VulkanRenderer::frame_update>(*this);
-        connect<FrameRender, VulkanRenderer, &VulkanRenderer::frame_render>(*this);
-        connect<SDLEvent, VulkanRenderer, &VulkanRenderer::pool_event>(*this);
+        ImGui::SetCurrentContext(previous ? previous : wc->imgui);
+
+        {
+            VkCommandPoolCreateInfo info = {};
+            info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            info.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            info.queueFamilyIndex        = queueFamily_;
+            auto err                     = vkCreateCommandPool(device_, &info, allocator_, &wc->drawCache.commandPool);
+            check_vk_result(err);
+            wc->drawCache.slotCount = init_info.ImageCount;
+            ResetDrawCache(wc);
+        }
+
+        if (main)
+            SDL_SetWindowPosition(sdl_window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
+        SDL_ShowWindow(sdl_window);
+        windows_.emplace(window->get_id(), std::move(context));
+        return wc;
+    }
+
+    void VulkanRenderer::DestroyWindowContext(WindowContext* wc)
+    {
+        auto err = vkDeviceWaitIdle(device_);
+        check_vk_result(err);
+
+        ImGuiContext* previous = ImGui::GetCurrentContext();
+        ImGui::SetCurrentContext(wc->imgui);
+        ImGui_ImplVulkan_Shutdown();
+        ImGui_ImplSDL3_Shutdown();
+        ImGui::DestroyContext(wc->imgui);
+        ImGui::SetCurrentContext(previous != wc->imgui ? previous : nullptr);
+
+        vkDestroyCommandPool(device_, wc->drawCache.commandPool, allocator_);
+        ImGui_ImplVulkanH_DestroyWindow(instance_, device_, &wc->data, allocator_);
+    }
+
+    VulkanRenderer::WindowContext* VulkanRenderer::FindWindowContext(uint32_t window_id) const
+    {
+        auto it = windows_.find(window_id);
+        return it != windows_.end() ? it->second.get() : nullptr;
+    }
+
+    void VulkanRenderer::window_created(const WindowCreated& event)
+    {
+        WaitRenderIdle();
+        CreateWindowContext(event.window, false);
     }
 
-    void VulkanRenderer::pool_event(const SDLEvent& event) { ImGui_ImplSDL3_ProcessEvent(event.event); }
+    void VulkanRenderer::window_destroyed(const WindowDestroyed& event)
+    {
+        auto it = windows_.find(event.window_id);
+        if (it == windows_.end() || it->second.get() == mainWindow_)
+            return;
+
+        WaitRenderIdle();
+        DestroyWindowContext(it->second.get());
+        windows_.erase(it);
+    }
+
+    void VulkanRenderer::pool_event(const SDLEvent& event)
+    {
+        // Events for secondary windows go to their own context; anything else, including ImGui's platform windows, to the main one.
+        WindowContext* wc = event.window ? FindWindowContext(event.window->get_id()) : nullptr;
+        if (!wc)
+            wc = mainWindow_;
+
+        ImGui::SetCurrentContext(wc->imgui);
+        ImGui_ImplSDL3_ProcessEvent(event.event);
+        ImGui::SetCurrentContext(mainWindow_->imgui);
+    }
 
     void VulkanRenderer::frame_update(const FrameUpdate& dt)
     {
-        // Resize swap chain?
-        int fb_width, fb_height;
-        get_subsystem<WindowManager>().get_size(fb_width, fb_height);
-        if (fb_width > 0 && fb_height > 0 && (swapChainRebuild_ || mainWindowData_.Width != fb_width || mainWindowData_.Height != fb_height))
+        for (auto& [id, context] : windows_)
         {
-            ImGui_ImplVulkan_SetMinImageCount(minImageCount_);
-            ImGui_ImplVulkanH_CreateOrResizeWindow(
-                instance_, physicalDevice_, device_, &mainWindowData_, queueFamily_, allocator_, fb_width, fb_height, minImageCount_);
-            mainWindowData_.FrameIndex = 0;
-            swapChainRebuild_          = false;
+            WindowContext* wc = context.get();
+            wc->visible       = wc->window->is_renderable();
+            if (!wc->visible)
+                continue;
+
+            // Resize swap chain?
+            int fb_width = 0, fb_height = 0;
+            wc->window->get_size(fb_width, fb_height);
+            ImGui::SetCurrentContext(wc->imgui);
+            if (fb_width > 0 && fb_height > 0 && (wc->swapChainRebuild || wc->data.Width != fb_width || wc->data.Height != fb_height))
+            {
+                WaitRenderIdle();
+                std::scoped_lock lock(backendMutex_, queueMutex_);
+                ImGui_ImplVulkan_SetMinImageCount(minImageCount_);
+                ImGui_ImplVulkanH_CreateOrResizeWindow(
+                    instance_, physicalDevice_, device_, &wc->data, queueFamily_, allocator_, fb_width, fb_height, minImageCount_);
+                wc->data.FrameIndex  = 0;
+                wc->swapChainRebuild = false;
+                ResetDrawCache(wc);
+                if (swapchainRebuilds_)
+                    swapchainRebuilds_->add();
+            }
+
+            if (has_subsystem<FontManager>())
+                get_subsystem<FontManager>().apply(wc->window);
+
+            {
+                std::lock_guard lock(backendMutex_);
+                ImGui_ImplVulkan_NewFrame();
+            }
+            ImGui_ImplSDL3_NewFrame();
+            ImGui::NewFrame();
         }
+        ImGui::SetCurrentContext(mainWindow_->imgui);
+    }
 
-        ImGui_ImplVulkan_NewFrame();
-        ImGui_ImplSDL3_NewFrame();
-        ImGui::NewFrame();
+    // Connected before any UI subscriber, so it makes the target window's context current for the handlers that follow.
+    void VulkanRenderer::frame_ui_render(const FrameUiRender& event)
+    {
+        WindowContext* wc = FindWindowContext(event.window_id);
+        ImGui::SetCurrentContext(wc && wc->visible ? wc->imgui : mainWindow_->imgui);
     }
 
     void VulkanRenderer::frame_render(const FrameRender& dt)
     {
-        ImGui::Render();
+        capture_->poll();
+        // Render passes and texture updates change pixels the draw data does not show.
+        bool unchanged   = pendingPasses_.empty() && !texturesUpdated_;
+        texturesUpdated_ = false;
 
-        ImGuiIO&    io                = ImGui::GetIO();
-        ImDrawData* main_draw_data    = ImGui::GetDrawData();
-        const bool  main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
-        if (!main_is_minimized)
-            Renderer();
+        FramePacket* packet = renderThread_ ? &renderThread_->begin_frame() : nullptr;
+        if (packet)
+            packet->passes.swap(pendingPasses_);
+        else
+            resolution_->begin_frame();
+        for (auto& [id, context] : windows_)
+        {
+            WindowContext* wc = context.get();
+            if (!wc->visible)
+                continue;
 
-        // Update and Render additional Platform Windows
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+            ImGui::SetCurrentContext(wc->imgui);
+            ImGui::Render();
+
+            ImDrawData* draw_data    = ImGui::GetDrawData();
+            const bool  is_minimized = (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f);
+            if (!is_minimized)
+            {
+                DrawDataHash hash = hash_draw_data(*draw_data);
+                // A freed descriptor set's handle can come back for a new texture; bundles recorded before
+                // it was freed must not match draw data that names the new one.
+                hash.value = (hash.value ^ textureGeneration_ * 0x9E3779B97F4A7C15ull) | 1;
+                unchanged  = unchanged && hash.cacheable && hash.value == wc->lastHash;
+                wc->lastHash            = hash.value;
+                if (packet)
+                {
+                    FramePacket::View& view = packet->add_view(id);
+                    view.draw_data.capture(*draw_data);
+                    view.hash = hash;
+                }
+                else
+                    Renderer(wc, draw_data, hash, pendingPasses_);
+            }
+            // A swapchain to rebuild means a frame that did not make it to the screen.
+            unchanged = unchanged && !wc->swapChainRebuild;
+
+            // Update and Render additional Platform Windows. They stay on this thread, their draw data is ImGui's own.
+            if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+            {
+                unchanged = false; // Platform windows are not hashed
+                std::scoped_lock lock(backendMutex_, queueMutex_);
+                ImGui::UpdatePlatformWindows();
+                ImGui::RenderPlatformWindowsDefault();
+            }
+
+            // Present Platform Window
+            if (!is_minimized && !packet)
+                FramePresent(wc);
+        }
+        ImGui::SetCurrentContext(mainWindow_->imgui);
+        // Nothing was presented, the passes captured this frame's state and are of no use for the next one.
+        pendingPasses_.clear();
+
+        if (packet)
+            renderThread_->submit_frame();
+        RetireResources();
+        frameUnchanged_ = unchanged;
+    }
+
+    // Render thread: its current ImGui context is its own, see imgui_user_config.h.
+    void VulkanRenderer::RenderPacket(FramePacket& packet)
+    {
+        resolution_->begin_frame();
+        for (size_t i = 0; i < packet.view_count; ++i)
         {
-            ImGui::UpdatePlatformWindows();
-            ImGui::RenderPlatformWindowsDefault();
+            FramePacket::View& view = packet.views[i];
+            WindowContext*     wc   = FindWindowContext(view.window_id);
+            if (!wc)
+                continue;
+
+            ImGui::SetCurrentContext(wc->imgui);
+            Renderer(wc, view.draw_data.get(), view.hash, packet.passes);
+            FramePresent(wc);
         }
+        ImGui::SetCurrentContext(nullptr);
+    }
 
-        // Present Main Platform Window
-        if (!main_is_minimized)
-            FramePresent();
+    void VulkanRenderer::WaitRenderIdle()
+    {
+        if (renderThread_)
+            renderThread_->wait_idle();
     }
 
-    void VulkanRenderer::Renderer()
+    // The passes go into the first window that gets recorded; returns false when the window was skipped.
+    bool VulkanRenderer::Renderer(WindowContext* wc, ImDrawData* draw_data, const DrawDataHash& hash, std::vector<RenderPass>& passes)
     {
-        ImDrawData* draw_data = ImGui::GetDrawData();
+        ImGui_ImplVulkanH_Window& wd = wc->data;
 
-        VkSemaphore image_acquired_semaphore  = mainWindowData_.FrameSemaphores[mainWindowData_.SemaphoreIndex].ImageAcquiredSemaphore;
-        VkSemaphore render_complete_semaphore = mainWindowData_.FrameSemaphores[mainWindowData_.SemaphoreIndex].RenderCompleteSemaphore;
-        VkResult    err                       = vkAcquireNextImageKHR(
-            device_, mainWindowData_.Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &mainWindowData_.FrameIndex);
+        VkSemaphore image_acquired_semaphore  = wd.FrameSemaphores[wd.SemaphoreIndex].ImageAcquiredSemaphore;
+        VkSemaphore render_complete_semaphore = wd.FrameSemaphores[wd.SemaphoreIndex].RenderCompleteSemaphore;
+        VkResult    err;
+        {
+            WatchdogScope scope("VulkanRenderer::Renderer: vkAcquireNextImageKHR");
+            err = vkAcquireNextImageKHR(device_, wd.Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &wd.FrameIndex);
+        }
         if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
-            swapChainRebuild_ = true;
+            wc->swapChainRebuild = true;
         if (err == VK_ERROR_OUT_OF_DATE_KHR)
-            return;
+            return false;
         if (err != VK_SUBOPTIMAL_KHR)
             check_vk_result(err);
 
-        ImGui_ImplVulkanH_Frame* fd = &mainWindowData_.Frames[mainWindowData_.FrameIndex];
+        ImGui_ImplVulkanH_Frame* fd = &wd.Frames[wd.FrameIndex];
         {
+            WatchdogScope scope("VulkanRenderer::Renderer: vkWaitForFences (frame fence)");
             err = vkWaitForFences(device_, 1, &fd->Fence, VK_TRUE, UINT64_MAX); // wait indefinitely instead of periodically checking
             check_vk_result(err);
 
             err = vkResetFences(device_, 1, &fd->Fence);
             check_vk_result(err);
         }
+
+        // The previous submission of this image has retired, so it no longer holds on to a bundle.
+        wc->drawCache.imageBundles[wd.FrameIndex] = no_bundle;
+        VkCommandBuffer bundle                    = VK_NULL_HANDLE;
+        {
+            std::lock_guard lock(backendMutex_);
+            bundle = PrepareDrawBundle(wc, draw_data, hash);
+        }
+
         {
             err = vkResetCommandPool(device_, fd->CommandPool, 0);
             check_vk_result(err);
@@ -332,23 +1076,35 @@ namespace core
             err = vkBeginCommandBuffer(fd->CommandBuffer, &info);
             check_vk_result(err);
         }
+        resolution_->begin(fd->CommandBuffer);
+        for (RenderPass& pass : passes)
+            pass(fd->CommandBuffer);
+        passes.clear();
+        capture_->record_images(fd->CommandBuffer);
         {
             VkRenderPassBeginInfo info    = {};
             info.sType                    = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            info.renderPass               = mainWindowData_.RenderPass;
+            info.renderPass               = wd.RenderPass;
             info.framebuffer              = fd->Framebuffer;
-            info.renderArea.extent.width  = mainWindowData_.Width;
-            info.renderArea.extent.height = mainWindowData_.Height;
+            info.renderArea.extent.width  = wd.Width;
+            info.renderArea.extent.height = wd.Height;
             info.clearValueCount          = 1;
-            info.pClearValues             = &mainWindowData_.ClearValue;
-            vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+            info.pClearValues             = &wd.ClearValue;
+            vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
         }
 
-        // Record dear imgui primitives into command buffer
-        ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
+        vkCmdExecuteCommands(fd->CommandBuffer, 1, &bundle);
 
         // Submit command buffer
         vkCmdEndRenderPass(fd->CommandBuffer);
+        capture_->record_window(fd->CommandBuffer,
+                                wc->window->get_id(),
+                                wc == mainWindow_,
+                                bundle,
+                                wd.SurfaceFormat.format,
+                                wd.Width,
+                                wd.Height,
+                                wd.ClearValue);
         {
             VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
             VkSubmitInfo         info       = {};
@@ -361,11 +1117,109 @@ namespace core
             info.signalSemaphoreCount       = 1;
             info.pSignalSemaphores          = &render_complete_semaphore;
 
+            resolution_->end(fd->CommandBuffer);
             err = vkEndCommandBuffer(fd->CommandBuffer);
             check_vk_result(err);
+            std::lock_guard lock(queueMutex_);
             err = vkQueueSubmit(queue_, 1, &info, fd->Fence);
             check_vk_result(err);
+            capture_->submit();
         }
+        return true;
+    }
+
+    void VulkanRenderer::ResetDrawCache(WindowContext* wc)
+    {
+        // Called with the device idle (window creation, swapchain rebuild), so no bundle is pending.
+        DrawCache&     cache       = wc->drawCache;
+        const uint32_t image_count = wc->data.ImageCount;
+        if (cache.bundles.size() < image_count)
+        {
+            // One bundle per image is enough: the other images pin at most image_count - 1 of them.
+            VkCommandBufferAllocateInfo alloc_info = {};
+            alloc_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            alloc_info.commandPool                 = cache.commandPool;
+            alloc_info.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            alloc_info.commandBufferCount          = image_count - static_cast<uint32_t>(cache.bundles.size());
+            cache.bundles.resize(image_count);
+            auto err = vkAllocateCommandBuffers(device_, &alloc_info, cache.bundles.data() + (image_count - alloc_info.commandBufferCount));
+            check_vk_result(err);
+        }
+        cache.bundleHashes.assign(cache.bundles.size(), 0);
+        cache.bundleSlots.assign(cache.bundles.size(), no_bundle);
+        cache.imageBundles.assign(image_count, no_bundle);
+    }
+
+    VkCommandBuffer VulkanRenderer::PrepareDrawBundle(WindowContext* wc, ImDrawData* draw_data, const DrawDataHash& hash)
+    {
+        ImGui_ImplVulkanH_Window& wd    = wc->data;
+        DrawCache&                cache = wc->drawCache;
+
+        const uint64_t key = drawCacheEnabled_ && hash.cacheable ? hash.value : 0;
+        if (key != 0)
+        {
+            for (uint32_t b = 0; b < cache.bundles.size(); ++b)
+            {
+                if (cache.bundleHashes[b] == key)
+                {
+                    cache.imageBundles[wd.FrameIndex] = b;
+                    return cache.bundles[b];
+                }
+            }
+        }
+
+        // The backend uploads into its next vertex/index buffer slot, unless it skips the frame like it
+        // does for an empty framebuffer. Frames still reading that slot have to retire first, and
+        // bundles recorded against it are stale from now on.
+        const int fb_width  = static_cast<int>(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+        const int fb_height = static_cast<int>(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+        if (fb_width > 0 && fb_height > 0)
+        {
+            cache.slot = (cache.slot + 1) % cache.slotCount;
+            for (uint32_t image = 0; image < cache.imageBundles.size(); ++image)
+            {
+                const uint32_t bundle = cache.imageBundles[image];
+                if (bundle == no_bundle || cache.bundleSlots[bundle] != cache.slot)
+                    continue;
+                WatchdogScope scope("VulkanRenderer::PrepareDrawBundle: vkWaitForFences (bundle slot)");
+                auto          err = vkWaitForFences(device_, 1, &wd.Frames[image].Fence, VK_TRUE, UINT64_MAX);
+                check_vk_result(err);
+                cache.imageBundles[image] = no_bundle;
+            }
+            for (uint32_t b = 0; b < cache.bundles.size(); ++b)
+            {
+                if (cache.bundleSlots[b] == cache.slot)
+                    cache.bundleHashes[b] = 0;
+            }
+        }
+
+        uint32_t target = 0;
+        while (std::ranges::find(cache.imageBundles, target) != cache.imageBundles.end())
+            ++target;
+
+        VkCommandBufferInheritanceInfo inheritance = {};
+        inheritance.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass                     = wd.RenderPass;
+        inheritance.subpass                        = 0;
+        inheritance.framebuffer                    = VK_NULL_HANDLE;
+
+        VkCommandBufferBeginInfo info = {};
+        info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        info.flags                    = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        info.pInheritanceInfo         = &inheritance;
+
+        VkCommandBuffer bundle = cache.bundles[target];
+        auto            err    = vkBeginCommandBuffer(bundle, &info);
+        check_vk_result(err);
+        // Record dear imgui primitives into command buffer
+        ImGui_ImplVulkan_RenderDrawData(draw_data, bundle);
+        err = vkEndCommandBuffer(bundle);
+        check_vk_result(err);
+
+        cache.bundleHashes[target]        = key;
+        cache.bundleSlots[target]         = cache.slot;
+        cache.imageBundles[wd.FrameIndex] = target;
+        return bundle;
     }
 
     // All the ImGui_ImplVulkanH_XXX structures/functions are optional helpers used by the demo.
@@ -403,34 +1257,71 @@ namespace core
         ImGui_ImplVulkanH_CreateOrResizeWindow(instance_, physicalDevice_, device_, wd, queueFamily_, allocator_, width, height, minImageCount_);
     }
 
-    void VulkanRenderer::FramePresent()
+    void VulkanRenderer::FramePresent(WindowContext* wc)
     {
-        if (swapChainRebuild_)
+        if (wc->swapChainRebuild)
             return;
-        VkSemaphore      render_complete_semaphore = mainWindowData_.FrameSemaphores[mainWindowData_.SemaphoreIndex].RenderCompleteSemaphore;
-        VkPresentInfoKHR info                      = {};
-        info.sType                                 = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        info.waitSemaphoreCount                    = 1;
-        info.pWaitSemaphores                       = &render_complete_semaphore;
-        info.swapchainCount                        = 1;
-        info.pSwapchains                           = &mainWindowData_.Swapchain;
-        info.pImageIndices                         = &mainWindowData_.FrameIndex;
-        VkResult err                               = vkQueuePresentKHR(queue_, &info);
+        ImGui_ImplVulkanH_Window& wd                        = wc->data;
+        VkSemaphore               render_complete_semaphore = wd.FrameSemaphores[wd.SemaphoreIndex].RenderCompleteSemaphore;
+        VkPresentInfoKHR          info                      = {};
+        info.sType                                          = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        info.waitSemaphoreCount                             = 1;
+        info.pWaitSemaphores                                = &render_complete_semaphore;
+        info.swapchainCount                                 = 1;
+        info.pSwapchains                                    = &wd.Swapchain;
+        info.pImageIndices                                  = &wd.FrameIndex;
+        VkResult                  err                       = VK_SUCCESS;
+        {
+            WatchdogScope   scope("VulkanRenderer::FramePresent: vkQueuePresentKHR");
+            std::lock_guard lock(queueMutex_);
+            err = vkQueuePresentKHR(queue_, &info);
+        }
         if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
-            swapChainRebuild_ = true;
+            wc->swapChainRebuild = true;
         if (err == VK_ERROR_OUT_OF_DATE_KHR)
             return;
         if (err != VK_SUBOPTIMAL_KHR)
             check_vk_result(err);
-        mainWindowData_.SemaphoreIndex =
-            (mainWindowData_.SemaphoreIndex + 1) % mainWindowData_.SemaphoreCount; // Now we can use the next set of semaphores
+        wd.SemaphoreIndex = (wd.SemaphoreIndex + 1) % wd.SemaphoreCount; // Now we can use the next set of semaphores
     }
 
-    void VulkanRenderer::CleanupVulkanWindow() { ImGui_ImplVulkanH_DestroyWindow(instance_, device_, &mainWindowData_, allocator_); }
+    void VulkanRenderer::CleanupVulkanWindow()
+    {
+        // Secondary windows first, the main context owns the platform windows and goes last.
+        for (auto& [id, context] : windows_)
+        {
+            if (context.get() != mainWindow_)
+                DestroyWindowContext(context.get());
+        }
+        if (mainWindow_)
+            DestroyWindowContext(mainWindow_);
+        windows_.clear();
+        mainWindow_ = nullptr;
+    }
 
     void VulkanRenderer::CleanupVulkan()
     {
+        for (auto& [id, texture] : textures_)
+            DestroyTexture(texture);
+        textures_.clear();
+        for (auto& [index, texture] : bindlessTextures_)
+            DestroyTexture(texture);
+        bindlessTextures_.clear();
+        for (RetiredTexture& retired : retiredTextures_)
+            DestroyTexture(retired.texture);
+        retiredTextures_.clear();
+        bindless_.reset();
+        for (UploadSlot& slot : uploadSlots_)
+        {
+            vkDestroyFence(device_, slot.fence, allocator_);
+            vkDestroyBuffer(device_, slot.buffer, allocator_);
+            vkFreeMemory(device_, slot.memory, allocator_);
+        }
+        vkDestroyCommandPool(device_, uploadCommandPool_, allocator_);
+        vkDestroySampler(device_, textureSampler_, allocator_);
+
         vkDestroyDescriptorPool(device_, descriptorPool_, allocator_);
+        vkDestroyPipelineCache(device_, pipelineCache_, allocator_);
 
 #ifdef APP_USE_VULKAN_DEBUG_REPORT
         // Remove the debug report callback
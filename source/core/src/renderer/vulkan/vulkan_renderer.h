@@ -2,13 +2,31 @@
 #include "event/EventSubscriber.h"
 #include "event/frame_event.h"
 #include "event/sdl_event.h"
+#include "event/window_event.h"
+#include "bindless_heap.h"
+#include "dynamic_resolution.h"
+#include "frame_capture.h"
 #include "imgui_impl_vulkan.h"
+#include "renderer/draw_data_hash.h"
+#include "renderer/render_thread.h"
 #include "renderer/renderer.h"
 #include "vulkan/vulkan.h"
 #include <SDL3/SDL_events.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct ImGuiContext;
 
 namespace core
 {
+    class Counter;
+    class Window;
+
     class VulkanRenderer : public EventSubscriber
     {
     public:
@@ -25,26 +43,204 @@ namespace core
         void pool_event(const SDLEvent& event);
 
         void frame_update(const FrameUpdate& dt);
+        void frame_ui_render(const FrameUiRender& event);
         void frame_render(const FrameRender& dt);
 
+        void window_created(const WindowCreated& event);
+        void window_destroyed(const WindowDestroyed& event);
+
+        // Sampled RGBA8 textures, usable as ImTextureID from the ImGui context of any window.
+        ImTextureID create_texture(uint32_t width, uint32_t height);
+        // Copies the (x, y, w, h) region of an image of row_length texels per row, whose first texel is pixels.
+        // Does not wait for the GPU: the copy is queued ahead of the frames submitted after it.
+        void update_texture(ImTextureID id, int x, int y, int w, int h, const uint8_t* pixels, int row_length);
+        // Does not wait either: the texture is freed once no frame in flight samples it anymore.
+        void destroy_texture(ImTextureID id);
+        // Heap slot of a create_texture() texture, BindlessHeap::invalid without a bindless heap.
+        [[nodiscard]] uint32_t get_bindless_index(ImTextureID id) const;
+
+        // Sampled RGBA8 textures that only shaders use, by their bindless heap index. They take no ImGui
+        // descriptor set, so there can be as many as the heap has slots (thumbnails, sprites). Update before
+        // the first draw. Destroying is deferred until no frame in flight samples the texture anymore.
+        // BindlessHeap::invalid when the device has no bindless heap or it is full.
+        uint32_t create_bindless_texture(uint32_t width, uint32_t height);
+        void     update_bindless_texture(uint32_t index, int x, int y, int w, int h, const uint8_t* pixels, int row_length);
+        void     destroy_bindless_texture(uint32_t index);
+
+        // Makes an image view the caller owns sampleable from ImGui. The view has to stay in layout until removed.
+        ImTextureID add_image_texture(VkImageView view, VkImageLayout layout);
+        void        remove_image_texture(ImTextureID id);
+
+        // Records pass into this frame's command buffer ahead of the UI, on the render thread with --render-thread,
+        // so it must only capture state that stays valid until then. Passes run in the order they were added.
+        void add_render_pass(RenderPass pass);
+
+        // Blocks until nothing submitted so far is executing, before resources the GPU may read get changed.
+        void wait_gpu_idle();
+
+        // Frames rendered so far. What the GPU reads during frame n (get_frame_count() at the time) may be in
+        // use until the count moved more than get_frames_in_flight() past n; is_frame_retired() tells.
+        [[nodiscard]] uint64_t get_frame_count() const noexcept { return frameCount_; }
+        [[nodiscard]] uint32_t get_frames_in_flight() const { return GetFramesInFlight(); }
+        [[nodiscard]] bool     is_frame_retired(uint64_t frame) const { return frameCount_ - frame > GetFramesInFlight(); }
+        // True when the last frame_render() showed what the one before did: the same draw data in every
+        // window, no render passes and no texture updates. App waits for input or a timer after such frames.
+        [[nodiscard]] bool     is_frame_unchanged() const noexcept { return frameUnchanged_; }
+
+        // nullptr when the device lacks descriptor indexing (or with --no-bindless).
+        [[nodiscard]] BindlessHeap*                get_bindless_heap() const noexcept { return bindless_.get(); }
+        [[nodiscard]] FrameCapture&                get_frame_capture() noexcept { return *capture_; }
+        // What heavy viewport content renders at, as a fraction of its size; 1 without --dynamic-resolution.
+        [[nodiscard]] float                        get_render_scale() const noexcept { return resolution_->get_scale(); }
+        [[nodiscard]] VkDevice                     get_device() const noexcept { return device_; }
+        [[nodiscard]] VkPhysicalDevice             get_physical_device() const noexcept { return physicalDevice_; }
+        [[nodiscard]] const VkAllocationCallbacks* get_allocator() const noexcept { return allocator_; }
+        [[nodiscard]] VkPipelineCache              get_pipeline_cache() const noexcept { return pipelineCache_; }
+        [[nodiscard]] uint32_t                     get_queue_family() const noexcept { return queueFamily_; }
+        // Compute and transfer queues; each is the graphics queue when the device has no separate family for it.
+        [[nodiscard]] VkQueue                      get_compute_queue() const noexcept { return computeQueue_; }
+        [[nodiscard]] uint32_t                     get_compute_queue_family() const noexcept { return computeQueueFamily_; }
+        [[nodiscard]] VkQueue                      get_transfer_queue() const noexcept { return transferQueue_; }
+        [[nodiscard]] uint32_t                     get_transfer_queue_family() const noexcept { return transferQueueFamily_; }
+        // Submissions to any of the queues above have to hold this, shared queues share the lock.
+        [[nodiscard]] std::unique_lock<std::mutex> lock_queue(VkQueue queue);
+        [[nodiscard]] uint32_t                     find_memory_type(uint32_t type_bits, VkMemoryPropertyFlags properties) const
+        {
+            return FindMemoryType(type_bits, properties);
+        }
+
     protected:
+        static constexpr uint32_t no_bundle = UINT32_MAX;
+
+        // Recorded UI of a window, kept in secondary command buffers so unchanged frames are neither
+        // uploaded nor recorded again. Bundles are recorded without a framebuffer and with simultaneous
+        // use, so any swapchain image can execute them. They read the vertex/index buffers of the
+        // ImGui backend, which rotates over imageCount slots per recording; slot mirrors that index.
+        struct DrawCache
+        {
+            VkCommandPool                commandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> bundles;
+            std::vector<uint64_t>        bundleHashes; // 0 when the bundle holds nothing reusable
+            std::vector<uint32_t>        bundleSlots;
+            std::vector<uint32_t>        imageBundles; // Bundle the last submission of each swapchain image executed
+            uint32_t                     slot      = 0;
+            uint32_t                     slotCount = 0;
+        };
+
+        // Everything one OS window needs to be presented: its own swapchain and its own ImGui context.
+        struct WindowContext
+        {
+            Window*                  window = nullptr;
+            ImGui_ImplVulkanH_Window data;
+            ImGuiContext*            imgui            = nullptr;
+            std::atomic<bool>        swapChainRebuild = false; // Set by whichever thread acquires and presents
+            bool                     visible          = false;
+            uint64_t                 lastHash         = 0; // Of the draw data the main thread last rendered
+            DrawCache                drawCache;
+        };
+
+        struct Texture
+        {
+            VkImage         image       = VK_NULL_HANDLE;
+            VkDeviceMemory  memory      = VK_NULL_HANDLE;
+            VkImageView     view        = VK_NULL_HANDLE;
+            VkDescriptorSet set         = VK_NULL_HANDLE;
+            uint32_t        width       = 0;
+            uint32_t        height      = 0;
+            uint32_t        bindless    = BindlessHeap::invalid;
+            bool            initialized = false;
+        };
+
+        // Texture updates are staged in a ring of persistently mapped buffers. A slot's fence is only looked at
+        // when the ring comes round to it again, so an update waits for the GPU only when all slots are in flight.
+        struct UploadSlot
+        {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence         fence         = VK_NULL_HANDLE;
+            VkBuffer        buffer        = VK_NULL_HANDLE;
+            VkDeviceMemory  memory        = VK_NULL_HANDLE;
+            uint8_t*        mapped        = nullptr;
+            VkDeviceSize    capacity      = 0;
+            bool            pending       = false; // Submitted, fence not yet seen signaled
+        };
+
+        static constexpr uint32_t     upload_slot_count    = 4;
+        static constexpr VkDeviceSize upload_slot_min_size = 256 * 1024;
+
+        struct RetiredTexture
+        {
+            Texture  texture;
+            uint64_t frame;
+        };
+
         VkAllocationCallbacks*   allocator_;
         VkInstance               instance_;
         VkPhysicalDevice         physicalDevice_;
         VkDevice                 device_;
         uint32_t                 queueFamily_;
         VkQueue                  queue_;
+        uint32_t                 computeQueueFamily_  = static_cast<uint32_t>(-1);
+        VkQueue                  computeQueue_        = VK_NULL_HANDLE;
+        uint32_t                 transferQueueFamily_ = static_cast<uint32_t>(-1);
+        VkQueue                  transferQueue_       = VK_NULL_HANDLE;
         VkDebugReportCallbackEXT debugReport_;
         VkPipelineCache          pipelineCache_;
         VkDescriptorPool         descriptorPool_;
 
-        ImGui_ImplVulkanH_Window mainWindowData_;
-        uint32_t                 minImageCount_    = 2;
-        bool                     swapChainRebuild_ = false;
-        void                     Renderer();
-        void                     SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height);
-        void                     FramePresent();
-        void                     CleanupVulkanWindow();
-        void                     CleanupVulkan();
+        VkSampler                                 textureSampler_    = VK_NULL_HANDLE;
+        VkCommandPool                             uploadCommandPool_ = VK_NULL_HANDLE;
+        std::array<UploadSlot, upload_slot_count> uploadSlots_;
+        uint32_t                                  nextUploadSlot_    = 0;
+
+        std::unique_ptr<BindlessHeap>                                bindless_;
+        std::unique_ptr<FrameCapture>                                capture_;
+        std::unique_ptr<DynamicResolution>                           resolution_;
+        std::unordered_map<ImTextureID, Texture>                     textures_;
+        std::unordered_map<uint32_t, Texture>                        bindlessTextures_; // By heap index
+        std::vector<RetiredTexture>                                  retiredTextures_;
+        uint64_t                                                     frameCount_        = 0;
+        uint64_t                                                     textureGeneration_ = 0; // ImGui descriptor sets freed so far
+        bool                                                         texturesUpdated_   = false; // Since the last frame_render()
+        bool                                                         frameUnchanged_    = false;
+        uint32_t                                                     renderQueueDepth_  = 0;
+        std::unordered_map<uint32_t, std::unique_ptr<WindowContext>> windows_;
+        WindowContext*                                               mainWindow_        = nullptr;
+        uint32_t                                                     minImageCount_     = 2;
+        uint32_t                                                     maxWindowCount_    = 16;
+        bool                                                         drawCacheEnabled_  = true;
+        Counter*                                                     swapchainRebuilds_ = nullptr;
+
+        // With --render-thread, frame_render() only snapshots the draw data and this thread records, submits
+        // and presents it. backendMutex_ serializes the ImGui Vulkan backend and the descriptor pool between
+        // the two threads, queueMutex_ the queue; when both are needed backendMutex_ is taken first. The main
+        // thread calls renderThread_->wait_idle() before it touches swapchains, window contexts or textures.
+        // The compute and transfer queues have their own mutexes (see lock_queue()), taken after queueMutex_.
+        std::unique_ptr<RenderThread> renderThread_;
+        std::mutex                    backendMutex_;
+        std::mutex                    queueMutex_;
+        std::mutex                    computeQueueMutex_;
+        std::mutex                    transferQueueMutex_;
+        std::vector<RenderPass>       pendingPasses_;
+
+        WindowContext*  CreateWindowContext(Window* window, bool main);
+        void            DestroyWindowContext(WindowContext* wc);
+        WindowContext*  FindWindowContext(uint32_t window_id) const;
+        uint32_t        FindMemoryType(uint32_t type_bits, VkMemoryPropertyFlags properties) const;
+        void            SetupUploadResources();
+        Texture         CreateTexture(uint32_t width, uint32_t height);
+        UploadSlot&     AcquireUploadSlot(VkDeviceSize size);
+        void            UploadTexture(Texture& texture, int x, int y, int w, int h, const uint8_t* pixels, int row_length);
+        void            DestroyTexture(Texture& texture);
+        uint32_t        GetFramesInFlight() const;
+        void            RetireResources();
+        void            ResetDrawCache(WindowContext* wc);
+        VkCommandBuffer PrepareDrawBundle(WindowContext* wc, ImDrawData* draw_data, const DrawDataHash& hash);
+        bool            Renderer(WindowContext* wc, ImDrawData* draw_data, const DrawDataHash& hash, std::vector<RenderPass>& passes);
+        void            RenderPacket(FramePacket& packet);
+        void            WaitRenderIdle();
+        void            SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height);
+        void            FramePresent(WindowContext* wc);
+        void            CleanupVulkanWindow();
+        void            CleanupVulkan();
     };
 } // namespace core
@@ -0,0 +1,31 @@
+#include "scene.h"
+#include <algorithm>
+#include <chrono>
+
+namespace core
+{
+    Scene::Scene() { connect<FrameFixedUpdate, Scene, &Scene::frame_fixed_update>(*this); }
+
+    Scene::~Scene()
+    {
+        disconnect(*this);
+        registry_.clear();
+    }
+
+    void Scene::add_system(const std::string& name, System system) { systems_.push_back(SystemEntry {name, std::move(system)}); }
+
+    void Scene::remove_system(const std::string& name)
+    {
+        std::erase_if(systems_, [&](const SystemEntry& entry) { return entry.name == name; });
+    }
+
+    void Scene::frame_fixed_update(const FrameFixedUpdate& event)
+    {
+        for (auto& system : systems_)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            system.func(registry_, event.delta_time);
+            system.last_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+} // namespace core
@@ -0,0 +1,66 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include "jobs/job_system.h"
+#include <entt/entity/registry.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace core
+{
+    // Owns tool data as EnTT components and runs the registered systems on every FrameFixedUpdate,
+    // so simulation advances at the fixed rate whatever the display refresh rate.
+    class Scene : public EventSubscriber
+    {
+    public:
+        using System = std::function<void(entt::registry&, float)>;
+
+        Scene();
+        ~Scene();
+
+        [[nodiscard]] entt::registry& get_registry() noexcept { return registry_; }
+
+        // Systems run in the order they were added.
+        void add_system(const std::string& name, System system);
+        void remove_system(const std::string& name);
+
+        // Calls func(entity, Components&...) for every entity of the view, in chunks on the job pool.
+        // func may write the components it receives but must not create or destroy entities or components.
+        template<typename... Components, typename Func>
+        void parallel_each(Func&& func, size_t grain = 4096);
+
+        void frame_fixed_update(const FrameFixedUpdate& event);
+
+    private:
+        struct SystemEntry
+        {
+            std::string name;
+            System      func;
+            float       last_ms = 0.0f;
+        };
+
+        entt::registry           registry_;
+        std::vector<SystemEntry> systems_;
+    };
+
+    template<typename... Components, typename Func>
+    void Scene::parallel_each(Func&& func, size_t grain)
+    {
+        auto        view    = registry_.view<Components...>();
+        const auto* leading = view.handle();
+        if (!leading || leading->empty())
+            return;
+
+        // Walk the packed entity array of the smallest storage directly, it is contiguous and indexable.
+        const entt::entity* entities = leading->data();
+        get_subsystem<JobSystem>().parallel_for(leading->size(), grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const entt::entity entity = entities[i];
+                if (view.contains(entity))
+                    func(entity, view.template get<Components>(entity)...);
+            }
+        });
+    }
+} // namespace core
@@ -0,0 +1,225 @@
+#include "text_corpus.h"
+#include "jobs/job_system.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace core
+{
+    namespace
+    {
+        constexpr size_t npos = std::string_view::npos;
+
+        static_assert(TextCorpus::signature_bits == 1u << 16, "trigram_bit() yields 16 bits");
+
+        uint32_t fold(char c)
+        {
+            const auto byte = static_cast<uint8_t>(c);
+            return byte >= 'A' && byte <= 'Z' ? byte | 0x20u : byte;
+        }
+
+        // Case-folded, so one signature serves searches with and without ignore case.
+        uint32_t trigram_bit(const char* text) { return ((fold(text[0]) | fold(text[1]) << 8 | fold(text[2]) << 16) * 0x9E3779B1u) >> 16; }
+    } // namespace
+
+    void TextCorpus::append(std::string_view text)
+    {
+        if (!text.empty() && text.back() == '\n')
+            text.remove_suffix(1);
+        for (size_t begin = 0;;)
+        {
+            const size_t end = std::min(text.find('\n', begin), text.size());
+            add_line(text.substr(begin, end - begin));
+            if (end == text.size())
+                break;
+            begin = end + 1;
+        }
+    }
+
+    void TextCorpus::append_line(std::string_view text) { add_line(text); }
+
+    void TextCorpus::discard_before(LineId line)
+    {
+        size_t count = 0;
+        while (count + 1 < blocks_.size() && blocks_[count + 1].first_line <= line)
+        {
+            size_ -= blocks_[count].size;
+            ++count;
+        }
+        // Every block but the last is sealed, so each discarded one has its signature at the front.
+        blocks_.erase(blocks_.begin(), blocks_.begin() + count);
+        signatures_.erase(signatures_.begin(), signatures_.begin() + count * signature_words);
+    }
+
+    void TextCorpus::clear()
+    {
+        blocks_.clear();
+        signatures_.clear();
+        line_count_ = 0;
+        size_       = 0;
+    }
+
+    std::string_view TextCorpus::get_line(LineId line) const
+    {
+        if (line >= line_count_ || line < get_first_line())
+            return {};
+        const Block& block = blocks_[find_block(line)];
+        const size_t index = static_cast<size_t>(line - block.first_line);
+        const size_t begin = index == 0 ? 0 : block.line_ends[index - 1] + 1;
+        return {block.text.get() + begin, block.line_ends[index] - begin};
+    }
+
+    TextCorpus::SearchStats TextCorpus::search(const TextMatcher& matcher, std::vector<LineId>& lines, LineId from) const
+    {
+        SearchStats stats;
+        stats.blocks = blocks_.size();
+        if (blocks_.empty())
+            return stats;
+
+        // A term shorter than a trigram has no bits and passes every signature.
+        std::vector<std::vector<uint32_t>> trigrams;
+        for (const TextPattern& pattern : matcher.get_patterns())
+        {
+            const std::string&     text = pattern.get_text();
+            std::vector<uint32_t>& bits = trigrams.emplace_back();
+            for (size_t i = 0; i + 3 <= text.size(); ++i)
+            {
+                bits.push_back(trigram_bit(text.data() + i));
+            }
+            std::sort(bits.begin(), bits.end());
+            bits.erase(std::unique(bits.begin(), bits.end()), bits.end());
+        }
+
+        // Blocks before the one holding from are skipped, the lines of that one before it dropped below.
+        std::vector<size_t> candidates;
+        for (size_t block = find_block(from); block + 1 < blocks_.size(); ++block)
+        {
+            if (matcher.empty() || may_match(block, trigrams, matcher.get_mode()))
+                candidates.push_back(block);
+        }
+        candidates.push_back(blocks_.size() - 1);
+
+        std::vector<std::vector<LineId>> found(candidates.size());
+        auto                             scan_blocks = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                scan(blocks_[candidates[i]], matcher, found[i]);
+            }
+        };
+        if (candidates.size() > 1 && has_subsystem<JobSystem>())
+            get_subsystem<JobSystem>().parallel_for(candidates.size(), 1, scan_blocks);
+        else
+            scan_blocks(0, candidates.size());
+
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            lines.insert(lines.end(), std::lower_bound(found[i].begin(), found[i].end(), from), found[i].end());
+            stats.scanned_bytes += blocks_[candidates[i]].size;
+        }
+        stats.scanned_blocks = candidates.size();
+        return stats;
+    }
+
+    size_t TextCorpus::find_block(LineId line) const
+    {
+        const auto before = [](LineId value, const Block& block) { return value < block.first_line; };
+        const auto it     = std::upper_bound(blocks_.begin(), blocks_.end(), line, before);
+        return it == blocks_.begin() ? 0 : static_cast<size_t>(it - blocks_.begin()) - 1;
+    }
+
+    void TextCorpus::add_line(std::string_view line)
+    {
+        if (blocks_.empty() || blocks_.back().size + line.size() + 1 > blocks_.back().capacity)
+        {
+            if (!blocks_.empty())
+                seal();
+            Block& block     = blocks_.emplace_back();
+            block.capacity   = std::max(block_size, line.size() + 1);
+            block.text       = std::make_unique<char[]>(block.capacity);
+            block.first_line = line_count_;
+        }
+
+        Block& block = blocks_.back();
+        std::memcpy(block.text.get() + block.size, line.data(), line.size());
+        block.size += line.size();
+        block.line_ends.push_back(static_cast<uint32_t>(block.size));
+        block.text[block.size++] = '\n';
+        ++line_count_;
+        size_ += line.size() + 1;
+    }
+
+    void TextCorpus::seal()
+    {
+        const Block& block = blocks_.back();
+        const size_t first = signatures_.size();
+        signatures_.resize(first + signature_words);
+        uint64_t* signature = signatures_.data() + first;
+        for (size_t i = 0; i + 3 <= block.size; ++i)
+        {
+            const uint32_t bit = trigram_bit(block.text.get() + i);
+            signature[bit / 64] |= uint64_t {1} << (bit % 64);
+        }
+    }
+
+    bool TextCorpus::may_match(size_t block, const std::vector<std::vector<uint32_t>>& trigrams, MatchMode mode) const
+    {
+        const uint64_t* signature = signatures_.data() + block * signature_words;
+        auto            contains  = [signature](const std::vector<uint32_t>& bits) {
+            return std::all_of(bits.begin(), bits.end(), [signature](uint32_t bit) { return (signature[bit / 64] >> (bit % 64) & 1) != 0; });
+        };
+        return mode == MatchMode::all ? std::all_of(trigrams.begin(), trigrams.end(), contains)
+                                      : std::any_of(trigrams.begin(), trigrams.end(), contains);
+    }
+
+    void TextCorpus::scan(const Block& block, const TextMatcher& matcher, std::vector<LineId>& lines) const
+    {
+        const std::string_view text(block.text.get(), block.size);
+        const auto             patterns = matcher.get_patterns();
+        if (patterns.empty())
+        {
+            for (size_t index = 0; index < block.line_ends.size(); ++index)
+            {
+                lines.push_back(block.first_line + index);
+            }
+            return;
+        }
+
+        // Runs over the hits of pattern, each line once; func gets the line's index in the block and its text.
+        // A hit running past the end of its line has a '\n' in it and can not match inside a line. Hits come
+        // in order, so their lines are found by walking line_ends along with them, one pass per pattern,
+        // rather than by a binary search per hit, which cost more than the kernel itself on common terms.
+        auto for_each_hit = [&](const TextPattern& pattern, auto&& func) {
+            size_t index = 0;
+            for (size_t from = pattern.find(text); from < text.size(); from = pattern.find(text, from))
+            {
+                while (block.line_ends[index] < from)
+                    ++index;
+                const size_t end   = block.line_ends[index];
+                const size_t begin = index == 0 ? 0 : block.line_ends[index - 1] + 1;
+                if (from + pattern.get_text().size() <= end)
+                    func(index, text.substr(begin, end - begin));
+                from = end + 1;
+            }
+        };
+
+        // In all mode the longest term finds the candidate lines and the others only check those.
+        if (matcher.get_mode() == MatchMode::all)
+        {
+            for_each_hit(patterns[0], [&](size_t index, std::string_view line) {
+                const auto found = [line](const TextPattern& pattern) { return pattern.find(line) != npos; };
+                if (std::all_of(patterns.begin() + 1, patterns.end(), found))
+                    lines.push_back(block.first_line + index);
+            });
+            return;
+        }
+
+        const size_t first = lines.size();
+        for (const TextPattern& pattern : patterns)
+        {
+            for_each_hit(pattern, [&](size_t index, std::string_view) { lines.push_back(block.first_line + index); });
+        }
+        std::sort(lines.begin() + first, lines.end());
+        lines.erase(std::unique(lines.begin() + first, lines.end()), lines.end());
+    }
+} // namespace core
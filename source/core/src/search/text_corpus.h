@@ -0,0 +1,78 @@
+#pragma once
+#include "search/text_search.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace core
+{
+    // Append-only store of text lines that a TextMatcher filters much faster than line by line. Old lines
+    // can be let go of a block at a time; line ids keep counting from the first line ever appended.
+    //
+    // Lines are packed '\n' terminated into blocks of block_size bytes, so the kernels run over a whole
+    // block at a time, and only lines where a term was found are looked at. When a block is full it is
+    // sealed with a trigram signature: one bit per hashed, case-folded trigram it contains. A search tests
+    // the trigrams of its terms against the signatures first and scans only the blocks that can match,
+    // which for a selective query is a small part of the text; the open block is always scanned. The
+    // remaining blocks are scanned in parallel on the JobSystem when there is one.
+    //
+    // append(), discard_before() and clear() must not run while a search does; searches may run concurrently.
+    class TextCorpus
+    {
+    public:
+        using LineId = uint64_t;
+
+        static constexpr size_t   block_size     = 256 * 1024;
+        static constexpr uint32_t signature_bits = 1u << 16; // 8 KiB per block, 3% of its text
+
+        struct SearchStats
+        {
+            size_t   blocks         = 0;
+            size_t   scanned_blocks = 0;
+            uint64_t scanned_bytes  = 0;
+        };
+
+        // Adds one line per '\n' separated part of text; a '\n' at its end does not add an empty one.
+        void append(std::string_view text);
+        // Adds text as one line, whatever it holds, so lines can stay in step with an outside numbering.
+        void append_line(std::string_view text);
+        // Frees the blocks that only hold lines before line; the open block is kept.
+        void discard_before(LineId line);
+        // Also restarts the line ids at 0.
+        void clear();
+
+        [[nodiscard]] size_t           get_line_count() const noexcept { return line_count_; } // Id of the next line
+        [[nodiscard]] LineId           get_first_line() const noexcept { return blocks_.empty() ? line_count_ : blocks_.front().first_line; }
+        [[nodiscard]] uint64_t         get_size() const noexcept { return size_; } // In bytes, line ends included
+        [[nodiscard]] std::string_view get_line(LineId line) const;                // Empty once discarded
+
+        // Appends the ids of the matching lines from from on to lines, in ascending order.
+        SearchStats search(const TextMatcher& matcher, std::vector<LineId>& lines, LineId from = 0) const;
+
+    private:
+        static constexpr size_t signature_words = signature_bits / 64;
+
+        struct Block
+        {
+            std::unique_ptr<char[]> text;
+            size_t                  size       = 0;
+            size_t                  capacity   = 0;
+            LineId                  first_line = 0;
+            std::vector<uint32_t>   line_ends; // Offset of each line's '\n'
+        };
+
+        void add_line(std::string_view line);
+        void seal();
+
+        [[nodiscard]] size_t find_block(LineId line) const; // Holding line, or the first block for lines before it
+        [[nodiscard]] bool   may_match(size_t block, const std::vector<std::vector<uint32_t>>& trigrams, MatchMode mode) const;
+        void                 scan(const Block& block, const TextMatcher& matcher, std::vector<LineId>& lines) const;
+
+        std::vector<Block>    blocks_;
+        std::vector<uint64_t> signatures_; // signature_words per sealed block; every block but the last is sealed
+        size_t                line_count_ = 0;
+        uint64_t              size_       = 0;
+    };
+} // namespace core
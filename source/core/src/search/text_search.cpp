@@ -0,0 +1,333 @@
+#include "text_search.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CORE_SEARCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define CORE_TARGET_AVX2
+#else
+#define CORE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace core
+{
+    namespace
+    {
+        constexpr size_t npos = std::string_view::npos;
+
+        // Bytes of typical text and logs, most frequent first; bytes missing here count as rare.
+        constexpr std::string_view frequent_bytes = " etaoinsrhldcumfpgwybv0123456789.:/_-=,()[]kxjqz";
+
+        constexpr std::array<uint8_t, 256> make_fold_table()
+        {
+            std::array<uint8_t, 256> table {};
+            for (size_t i = 0; i < table.size(); ++i)
+                table[i] = static_cast<uint8_t>(i >= 'A' && i <= 'Z' ? i + ('a' - 'A') : i);
+            return table;
+        }
+
+        constexpr std::array<uint8_t, 256> make_rank_table()
+        {
+            std::array<uint8_t, 256> table {};
+            for (size_t i = 0; i < frequent_bytes.size(); ++i)
+                table[static_cast<uint8_t>(frequent_bytes[i])] = static_cast<uint8_t>(frequent_bytes.size() - i);
+            for (size_t i = 'A'; i <= 'Z'; ++i)
+                table[i] = table[i + ('a' - 'A')];
+            return table;
+        }
+
+        constexpr auto fold_table = make_fold_table();
+        constexpr auto rank_table = make_rank_table();
+
+        uint8_t fold(char c) { return fold_table[static_cast<uint8_t>(c)]; }
+
+        uint8_t swap_case(uint8_t c)
+        {
+            if (c >= 'a' && c <= 'z')
+                return static_cast<uint8_t>(c - ('a' - 'A'));
+            if (c >= 'A' && c <= 'Z')
+                return static_cast<uint8_t>(c + ('a' - 'A'));
+            return c;
+        }
+
+        struct Needle
+        {
+            const char* data;
+            size_t      size;
+            size_t      first; // Offsets of the rare bytes
+            size_t      second;
+            bool        ignore_case;
+        };
+
+        // A plain loop rather than memcmp: the kernels inline it, a call would make them spill their registers.
+        inline bool equals(const char* text, const Needle& needle)
+        {
+            for (size_t i = 0; i < needle.size; ++i)
+            {
+                if (needle.ignore_case ? fold(text[i]) != fold(needle.data[i]) : text[i] != needle.data[i])
+                    return false;
+            }
+            return true;
+        }
+
+        // Callers make sure size >= needle.size > 0.
+        size_t find_scalar(const char* text, size_t size, const Needle& needle)
+        {
+            if (!needle.ignore_case)
+                return std::string_view(text, size).find(std::string_view(needle.data, needle.size));
+
+            const uint8_t rare = fold(needle.data[needle.first]);
+            const size_t  end  = size - needle.size + 1;
+            for (size_t i = 0; i < end; ++i)
+            {
+                if (fold(text[i + needle.first]) == rare && equals(text + i, needle))
+                    return i;
+            }
+            return npos;
+        }
+
+#ifdef CORE_SEARCH_X86
+        // Both cases of a letter with ignore_case, else the byte twice.
+        std::array<char, 2> get_variants(const Needle& needle, size_t offset)
+        {
+            const auto byte = static_cast<uint8_t>(needle.data[offset]);
+            return {static_cast<char>(byte), static_cast<char>(needle.ignore_case ? swap_case(byte) : byte)};
+        }
+
+        size_t find_sse2(const char* text, size_t size, const Needle& needle)
+        {
+            const auto    first    = get_variants(needle, needle.first);
+            const auto    second   = get_variants(needle, needle.second);
+            const __m128i first_a  = _mm_set1_epi8(first[0]);
+            const __m128i first_b  = _mm_set1_epi8(first[1]);
+            const __m128i second_a = _mm_set1_epi8(second[0]);
+            const __m128i second_b = _mm_set1_epi8(second[1]);
+
+            // Loads stay inside text: the last start position plus an offset is at most size - 1.
+            const size_t end = size - needle.size + 1;
+            size_t       i   = 0;
+            for (; i + 16 <= end; i += 16)
+            {
+                const __m128i a    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + needle.first));
+                const __m128i b    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + needle.second));
+                const __m128i eq_a = _mm_or_si128(_mm_cmpeq_epi8(a, first_a), _mm_cmpeq_epi8(a, first_b));
+                const __m128i eq_b = _mm_or_si128(_mm_cmpeq_epi8(b, second_a), _mm_cmpeq_epi8(b, second_b));
+                auto          mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eq_a, eq_b)));
+                while (mask != 0)
+                {
+                    const size_t candidate = i + std::countr_zero(mask);
+                    if (equals(text + candidate, needle))
+                        return candidate;
+                    mask &= mask - 1;
+                }
+            }
+
+            const size_t rest = find_scalar(text + i, size - i, needle);
+            return rest != npos ? i + rest : npos;
+        }
+
+        CORE_TARGET_AVX2 size_t find_avx2(const char* text, size_t size, const Needle& needle)
+        {
+            const auto    first    = get_variants(needle, needle.first);
+            const auto    second   = get_variants(needle, needle.second);
+            const __m256i first_a  = _mm256_set1_epi8(first[0]);
+            const __m256i first_b  = _mm256_set1_epi8(first[1]);
+            const __m256i second_a = _mm256_set1_epi8(second[0]);
+            const __m256i second_b = _mm256_set1_epi8(second[1]);
+
+            // Two vectors per step, the branch on their combined mask is taken once per 64 positions.
+            const size_t end = size - needle.size + 1;
+            size_t       i   = 0;
+            for (; i + 64 <= end; i += 64)
+            {
+                const __m256i a0   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + needle.first));
+                const __m256i b0   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + needle.second));
+                const __m256i a1   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + 32 + needle.first));
+                const __m256i b1   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + 32 + needle.second));
+                const __m256i eq_0 = _mm256_and_si256(_mm256_or_si256(_mm256_cmpeq_epi8(a0, first_a), _mm256_cmpeq_epi8(a0, first_b)),
+                                                      _mm256_or_si256(_mm256_cmpeq_epi8(b0, second_a), _mm256_cmpeq_epi8(b0, second_b)));
+                const __m256i eq_1 = _mm256_and_si256(_mm256_or_si256(_mm256_cmpeq_epi8(a1, first_a), _mm256_cmpeq_epi8(a1, first_b)),
+                                                      _mm256_or_si256(_mm256_cmpeq_epi8(b1, second_a), _mm256_cmpeq_epi8(b1, second_b)));
+                const auto    low  = static_cast<uint32_t>(_mm256_movemask_epi8(eq_0));
+                const auto    high = static_cast<uint32_t>(_mm256_movemask_epi8(eq_1));
+                uint64_t      mask = low | (uint64_t(high) << 32);
+                while (mask != 0)
+                {
+                    const size_t candidate = i + std::countr_zero(mask);
+                    if (equals(text + candidate, needle))
+                        return candidate;
+                    mask &= mask - 1;
+                }
+            }
+            for (; i + 32 <= end; i += 32)
+            {
+                const __m256i a    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + needle.first));
+                const __m256i b    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + needle.second));
+                const __m256i eq_a = _mm256_or_si256(_mm256_cmpeq_epi8(a, first_a), _mm256_cmpeq_epi8(a, first_b));
+                const __m256i eq_b = _mm256_or_si256(_mm256_cmpeq_epi8(b, second_a), _mm256_cmpeq_epi8(b, second_b));
+                auto          mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(eq_a, eq_b)));
+                while (mask != 0)
+                {
+                    const size_t candidate = i + std::countr_zero(mask);
+                    if (equals(text + candidate, needle))
+                        return candidate;
+                    mask &= mask - 1;
+                }
+            }
+
+            const size_t rest = find_sse2(text + i, size - i, needle);
+            return rest != npos ? i + rest : npos;
+        }
+#endif
+
+        SearchIsa detect_isa() noexcept
+        {
+#ifdef CORE_SEARCH_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+            // AVX2 needs the CPU flag and the OS saving the YMM registers (OSXSAVE, then XCR0 bits 1 and 2).
+            int info[4];
+            __cpuid(info, 0);
+            const int max_leaf = info[0];
+            __cpuid(info, 1);
+            const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+            if (os_avx && max_leaf >= 7)
+            {
+                __cpuidex(info, 7, 0);
+                if (info[1] & (1 << 5))
+                    return SearchIsa::avx2;
+            }
+#else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return SearchIsa::avx2;
+#endif
+            return SearchIsa::sse2;
+#else
+            return SearchIsa::scalar;
+#endif
+        }
+
+        SearchIsa get_supported_isa() noexcept
+        {
+            static const SearchIsa isa = detect_isa();
+            return isa;
+        }
+
+        std::atomic<SearchIsa>& get_current_isa() noexcept
+        {
+            static std::atomic<SearchIsa> isa {get_supported_isa()};
+            return isa;
+        }
+    } // namespace
+
+    SearchIsa get_search_isa() noexcept { return get_current_isa().load(std::memory_order_relaxed); }
+
+    const char* get_search_isa_name(SearchIsa isa) noexcept
+    {
+        switch (isa)
+        {
+            case SearchIsa::sse2:
+                return "sse2";
+            case SearchIsa::avx2:
+                return "avx2";
+            default:
+                return "scalar";
+        }
+    }
+
+    void set_search_isa(SearchIsa isa) noexcept { get_current_isa().store(std::min(isa, get_supported_isa()), std::memory_order_relaxed); }
+
+    TextPattern::TextPattern(std::string text, bool ignore_case) : text_(std::move(text)), ignore_case_(ignore_case)
+    {
+        // The rarest byte goes first, the second rarest at another offset second.
+        for (size_t i = 1; i < text_.size(); ++i)
+        {
+            if (rank_table[fold(text_[i])] < rank_table[fold(text_[rare_first_])])
+                rare_first_ = i;
+        }
+        rare_second_ = rare_first_ == 0 && text_.size() > 1 ? 1 : 0;
+        for (size_t i = 0; i < text_.size(); ++i)
+        {
+            if (i != rare_first_ && rank_table[fold(text_[i])] < rank_table[fold(text_[rare_second_])])
+                rare_second_ = i;
+        }
+    }
+
+    size_t TextPattern::find(std::string_view text, size_t from) const noexcept
+    {
+        if (from > text.size())
+            return npos;
+        if (text_.empty())
+            return from;
+        if (text.size() - from < text_.size())
+            return npos;
+
+        const Needle needle {text_.data(), text_.size(), rare_first_, rare_second_, ignore_case_};
+        const char*  data = text.data() + from;
+        const size_t size = text.size() - from;
+        size_t       found;
+        switch (get_search_isa())
+        {
+#ifdef CORE_SEARCH_X86
+            case SearchIsa::avx2:
+                found = find_avx2(data, size, needle);
+                break;
+            case SearchIsa::sse2:
+                found = find_sse2(data, size, needle);
+                break;
+#endif
+            default:
+                found = find_scalar(data, size, needle);
+                break;
+        }
+        return found != npos ? from + found : npos;
+    }
+
+    size_t find_text(std::string_view text, std::string_view needle, bool ignore_case)
+    {
+        return TextPattern(std::string(needle), ignore_case).find(text);
+    }
+
+    TextMatcher::TextMatcher(std::string_view query, bool ignore_case, MatchMode mode) : mode_(mode)
+    {
+        constexpr std::string_view whitespace = " \t\r\n";
+
+        std::vector<std::string> terms;
+        for (size_t begin = query.find_first_not_of(whitespace); begin != npos; begin = query.find_first_not_of(whitespace, begin))
+        {
+            const size_t end = std::min(query.find_first_of(whitespace, begin), query.size());
+            terms.emplace_back(query.substr(begin, end - begin));
+            begin = end;
+        }
+        *this = TextMatcher(terms, ignore_case, mode);
+    }
+
+    TextMatcher::TextMatcher(std::span<const std::string> terms, bool ignore_case, MatchMode mode) : mode_(mode)
+    {
+        for (const std::string& term : terms)
+        {
+            if (!term.empty())
+                patterns_.emplace_back(term, ignore_case);
+        }
+        std::stable_sort(patterns_.begin(), patterns_.end(), [](const TextPattern& a, const TextPattern& b) {
+            return a.get_text().size() > b.get_text().size();
+        });
+    }
+
+    bool TextMatcher::matches(std::string_view text) const noexcept
+    {
+        if (patterns_.empty())
+            return true;
+        const auto found = [text](const TextPattern& pattern) { return pattern.find(text) != npos; };
+        return mode_ == MatchMode::all ? std::all_of(patterns_.begin(), patterns_.end(), found)
+                                       : std::any_of(patterns_.begin(), patterns_.end(), found);
+    }
+} // namespace core
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core
+{
+    // Instruction sets the search kernels are built for, in order of preference.
+    enum class SearchIsa : uint8_t
+    {
+        scalar,
+        sse2,
+        avx2,
+    };
+
+    // Kernels in use: the best the CPU has, detected on first use, unless set_search_isa() chose others.
+    [[nodiscard]] SearchIsa   get_search_isa() noexcept;
+    [[nodiscard]] const char* get_search_isa_name(SearchIsa isa) noexcept;
+    // For comparisons and tests; a set the CPU lacks falls back to the best it has.
+    void set_search_isa(SearchIsa isa) noexcept;
+
+    // A substring prepared once for any number of searches.
+    //
+    // Kernels compare the two least frequent bytes of the pattern (by a table of typical text) at every
+    // position, 16 or 32 positions per step, and only check the whole pattern where both match. Case
+    // folding, when asked for, covers ASCII letters; other bytes compare as they are.
+    class TextPattern
+    {
+    public:
+        TextPattern() = default;
+        TextPattern(std::string text, bool ignore_case);
+
+        [[nodiscard]] const std::string& get_text() const noexcept { return text_; }
+        [[nodiscard]] bool               ignores_case() const noexcept { return ignore_case_; }
+
+        // Offset of the first occurrence at or after from, std::string_view::npos if there is none.
+        // An empty pattern is found at from.
+        [[nodiscard]] size_t find(std::string_view text, size_t from = 0) const noexcept;
+
+    private:
+        std::string text_;
+        size_t      rare_first_  = 0; // Offsets of the bytes compared first
+        size_t      rare_second_ = 0;
+        bool        ignore_case_ = false;
+    };
+
+    // Offset of the first occurrence of needle in text, for one-off searches.
+    [[nodiscard]] size_t find_text(std::string_view text, std::string_view needle, bool ignore_case);
+
+    enum class MatchMode : uint8_t
+    {
+        all, // Every term has to occur
+        any, // One term is enough
+    };
+
+    // Filter of several terms, as typed into a search box: "error vulkan" keeps the lines with both words.
+    class TextMatcher
+    {
+    public:
+        TextMatcher() = default;
+        // Whitespace separates the terms.
+        explicit TextMatcher(std::string_view query, bool ignore_case = true, MatchMode mode = MatchMode::all);
+        TextMatcher(std::span<const std::string> terms, bool ignore_case, MatchMode mode);
+
+        // An empty matcher matches everything.
+        [[nodiscard]] bool                         empty() const noexcept { return patterns_.empty(); }
+        [[nodiscard]] MatchMode                    get_mode() const noexcept { return mode_; }
+        [[nodiscard]] std::span<const TextPattern> get_patterns() const noexcept { return patterns_; }
+
+        [[nodiscard]] bool matches(std::string_view text) const noexcept;
+
+    private:
+        std::vector<TextPattern> patterns_; // Longest first, the likeliest to rule a line out
+        MatchMode                mode_ = MatchMode::all;
+    };
+} // namespace core
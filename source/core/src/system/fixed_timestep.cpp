@@ -0,0 +1,35 @@
+#include "fixed_timestep.h"
+#include <algorithm>
+#include <cmath>
+
+namespace core
+{
+    FixedTimestep::FixedTimestep(double rate, uint32_t max_steps) :
+        step_(rate > 0.0 ? 1.0 / rate : 0.0), max_steps_(std::max<uint32_t>(1, max_steps))
+    {}
+
+    uint32_t FixedTimestep::advance(double dt)
+    {
+        dt = std::max(0.0, dt);
+        if (!is_fixed())
+        {
+            last_dt_ = dt;
+            ++step_count_;
+            return 1;
+        }
+
+        accumulator_ += dt;
+        uint32_t steps = static_cast<uint32_t>(std::floor(accumulator_ / step_));
+        if (steps > max_steps_)
+        {
+            // Keep the fraction of a step so alpha stays continuous, drop the rest.
+            double kept  = std::fmod(accumulator_, step_);
+            dropped_    += accumulator_ - kept - max_steps_ * step_;
+            accumulator_ = kept + max_steps_ * step_;
+            steps        = max_steps_;
+        }
+        accumulator_ -= steps * step_;
+        step_count_ += steps;
+        return steps;
+    }
+} // namespace core
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+namespace core
+{
+    // Accumulates frame time and hands it out in fixed steps. When a frame owes more than max_steps steps the
+    // surplus is dropped, so a slow frame can not snowball into ever longer catch-up frames.
+    // A rate of 0 turns it into a pass-through: one step per frame of exactly the frame's delta time.
+    class FixedTimestep
+    {
+    public:
+        FixedTimestep() = default;
+        FixedTimestep(double rate, uint32_t max_steps);
+
+        // Adds dt and returns the number of steps to run this frame.
+        uint32_t advance(double dt);
+
+        [[nodiscard]] bool     is_fixed() const noexcept { return step_ > 0.0; }
+        [[nodiscard]] float    get_step() const noexcept { return static_cast<float>(is_fixed() ? step_ : last_dt_); }
+        [[nodiscard]] uint64_t get_step_count() const noexcept { return step_count_; }
+
+        // How far the time left in the accumulator is into the next step, in [0, 1).
+        [[nodiscard]] float get_alpha() const noexcept { return is_fixed() ? static_cast<float>(accumulator_ / step_) : 1.0f; }
+
+        // Total time thrown away to keep within max_steps, in seconds.
+        [[nodiscard]] double get_dropped_time() const noexcept { return dropped_; }
+
+    private:
+        double   step_        = 1.0 / 60.0;
+        uint32_t max_steps_   = 5;
+        double   accumulator_ = 0.0;
+        double   last_dt_     = 0.0;
+        double   dropped_     = 0.0;
+        uint64_t step_count_  = 0;
+    };
+} // namespace core
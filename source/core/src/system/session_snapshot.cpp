@@ -0,0 +1,280 @@
+#include "session_snapshot.h"
+#include "cmd_line/parser.hpp"
+#include "jobs/job_system.h"
+#include "logger.h"
+#include "system/subsystem.h"
+#include "system/timers.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace core
+{
+    namespace
+    {
+        constexpr uint64_t fnv_offset = 0xCBF29CE484222325ull;
+        constexpr uint64_t fnv_prime  = 0x100000001B3ull;
+
+        uint64_t hash_bytes(const void* data, size_t size, uint64_t hash = fnv_offset)
+        {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= fnv_prime;
+            }
+            return hash;
+        }
+
+        uint64_t hash_name(std::string_view name) { return hash_bytes(name.data(), name.size()); }
+    } // namespace
+
+    SessionSnapshot::SessionSnapshot()
+    {
+        auto& parser = Parser::instance();
+        if (!parser.hasOption("session"))
+            return;
+
+        // The newer of the two files is the previous run's save, the next save overwrites the other one.
+        const std::filesystem::path primary   = parser.getOptionValue("session", "session.bin");
+        const std::filesystem::path alternate = std::filesystem::path(primary).concat(".alt");
+        Mapping                     first;
+        Mapping                     second;
+        const bool                  has_first  = open(primary, first);
+        const bool                  has_second = open(alternate, second);
+        if (has_second && (!has_first || second.sequence > first.sequence))
+        {
+            mapping_ = std::move(second);
+            path_    = primary;
+        }
+        else
+        {
+            if (has_first)
+                mapping_ = std::move(first);
+            path_ = alternate;
+        }
+        sequence_ = mapping_.sequence + 1;
+
+        if (mapping_.file.is_open())
+            APPLOG_INFO("[session] Restoring {} sections of session {}", mapping_.entries.size(), mapping_.sequence);
+        else
+            APPLOG_INFO("[session] No session to restore in {}", primary.string());
+
+        const double interval = std::stod(parser.getOptionValue("session-interval", "30"));
+        if (interval > 0.0 && has_subsystem<Timers>())
+        {
+            const auto period = std::chrono::duration_cast<Timers::Clock::duration>(std::chrono::duration<double>(interval));
+            timer_            = get_subsystem<Timers>().schedule_repeating(period, [this]() { save(); }, TimerPhase::end);
+        }
+    }
+
+    SessionSnapshot::~SessionSnapshot()
+    {
+        if (!is_enabled())
+            return;
+        if (timer_ != Timers::invalid && has_subsystem<Timers>())
+            get_subsystem<Timers>().cancel(timer_);
+        if (job_.valid())
+            job_.wait();
+
+        std::vector<Collected> sections;
+        collect(sections);
+        write(sections, sequence_);
+    }
+
+    std::span<const std::byte> SessionSnapshot::get_section(std::string_view name, uint32_t version) const
+    {
+        const uint64_t hash  = hash_name(name);
+        auto           first = std::lower_bound(
+            mapping_.entries.begin(), mapping_.entries.end(), hash, [](const Entry& entry, uint64_t value) { return entry.name_hash < value; });
+        for (auto it = first; it != mapping_.entries.end() && it->name_hash == hash; ++it)
+        {
+            if (mapping_.names.substr(it->name_offset, it->name_size) != name)
+                continue;
+            if (it->version != version)
+                return {};
+            return mapping_.file.get_data().subspan(static_cast<size_t>(it->offset), static_cast<size_t>(it->size));
+        }
+        return {};
+    }
+
+    void SessionSnapshot::add_section(std::string name, uint32_t version, Writer writer)
+    {
+        if (!is_enabled())
+            return;
+        auto it = std::find_if(sections_.begin(), sections_.end(), [&name](const Section& section) { return section.name == name; });
+        if (it == sections_.end())
+            it = sections_.insert(sections_.end(), Section {std::move(name)});
+        it->version = version;
+        it->writer  = std::move(writer);
+        it->data.clear();
+    }
+
+    void SessionSnapshot::remove_section(std::string_view name)
+    {
+        auto it = std::find_if(sections_.begin(), sections_.end(), [name](const Section& section) { return section.name == name; });
+        if (it == sections_.end() || !it->writer)
+            return;
+        it->data.clear();
+        it->writer(it->data);
+        it->writer = nullptr;
+    }
+
+    void SessionSnapshot::save()
+    {
+        if (!is_enabled())
+            return;
+        // Skipping is fine, the next save has whatever changed meanwhile.
+        if (job_.valid() && job_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        std::vector<Collected> sections;
+        collect(sections);
+        job_ = get_subsystem<JobSystem>().submit([this, sections = std::move(sections), sequence = sequence_++]() { write(sections, sequence); });
+    }
+
+    void SessionSnapshot::collect(std::vector<Collected>& sections) const
+    {
+        sections.reserve(sections_.size() + mapping_.entries.size());
+        for (const Section& section : sections_)
+        {
+            Collected& collected = sections.emplace_back(Collected {section.name, section.version});
+            if (section.writer)
+                section.writer(collected.data);
+            else
+                collected.data = section.data;
+        }
+
+        // Sections nobody claimed this run, e.g. of a tool that was not opened, are kept as they were.
+        for (const Entry& entry : mapping_.entries)
+        {
+            const std::string_view name = mapping_.names.substr(entry.name_offset, entry.name_size);
+            if (std::any_of(sections_.begin(), sections_.end(), [name](const Section& section) { return section.name == name; }))
+                continue;
+            const auto data = mapping_.file.get_data().subspan(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+            sections.push_back({std::string(name), entry.version, {data.begin(), data.end()}});
+        }
+    }
+
+    void SessionSnapshot::write(const std::vector<Collected>& sections, uint64_t sequence)
+    {
+        uint64_t hash = fnv_offset;
+        for (const Collected& section : sections)
+        {
+            hash = hash_bytes(section.name.data(), section.name.size(), hash);
+            hash = hash_bytes(&section.version, sizeof(section.version), hash);
+            hash = hash_bytes(section.data.data(), section.data.size(), hash);
+        }
+        if (hash == saved_)
+            return;
+
+        std::string error;
+        if (!write_file(path_, sequence, sections, error))
+        {
+            APPLOG_WARNING("[session] Session not saved: {}", error);
+            return;
+        }
+        saved_ = hash;
+    }
+
+    bool SessionSnapshot::open(const std::filesystem::path& path, Mapping& mapping)
+    {
+        if (!mapping.file.open(path))
+            return false;
+
+        const auto data = mapping.file.get_data();
+        Header     header;
+        if (data.size() < sizeof(header))
+        {
+            mapping.file.close();
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        // Everything the index points at has to lie inside the file, so lookups need no further checks.
+        const bool valid = std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version &&
+                           header.index_offset % alignof(Entry) == 0 && header.index_offset <= data.size() &&
+                           header.entry_count <= (data.size() - header.index_offset) / sizeof(Entry) &&
+                           header.names_offset >= header.index_offset + header.entry_count * sizeof(Entry) && header.names_offset <= data.size();
+        if (!valid)
+        {
+            mapping.file.close();
+            return false;
+        }
+
+        mapping.entries  = {reinterpret_cast<const Entry*>(data.data() + header.index_offset), static_cast<size_t>(header.entry_count)};
+        mapping.names    = {reinterpret_cast<const char*>(data.data() + header.names_offset), data.size() - static_cast<size_t>(header.names_offset)};
+        mapping.sequence = header.sequence;
+        for (const Entry& entry : mapping.entries)
+        {
+            if (entry.offset > data.size() || entry.size > data.size() - entry.offset || entry.name_offset > mapping.names.size() ||
+                entry.name_size > mapping.names.size() - entry.name_offset)
+            {
+                mapping.entries = {};
+                mapping.names   = {};
+                mapping.file.close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SessionSnapshot::write_file(const std::filesystem::path& path, uint64_t sequence, const std::vector<Collected>& sections, std::string& error)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            error = "can not create " + path.string();
+            return false;
+        }
+
+        auto pad = [&file](uint64_t alignment)
+        {
+            static constexpr char zeros[data_alignment] = {};
+            const uint64_t        position              = static_cast<uint64_t>(file.tellp());
+            file.write(zeros, static_cast<std::streamsize>((alignment - position % alignment) % alignment));
+        };
+
+        // Without its magic the file fails to open until the real header goes in last.
+        Header header {{}, version, sequence, sections.size(), 0, 0};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::string        names;
+        std::vector<Entry> entries;
+        entries.reserve(sections.size());
+        for (const Collected& section : sections)
+        {
+            pad(data_alignment);
+            Entry& entry      = entries.emplace_back();
+            entry.name_hash   = hash_name(section.name);
+            entry.offset      = static_cast<uint64_t>(file.tellp());
+            entry.size        = section.data.size();
+            entry.name_offset = static_cast<uint32_t>(names.size());
+            entry.name_size   = static_cast<uint32_t>(section.name.size());
+            entry.version     = section.version;
+            entry.reserved    = 0;
+            names += section.name;
+            file.write(reinterpret_cast<const char*>(section.data.data()), static_cast<std::streamsize>(section.data.size()));
+        }
+
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.name_hash < b.name_hash; });
+        pad(data_alignment);
+        header.index_offset = static_cast<uint64_t>(file.tellp());
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+        header.names_offset = static_cast<uint64_t>(file.tellp());
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+        file.flush();
+
+        std::memcpy(header.magic, magic, sizeof(magic));
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!file)
+        {
+            error = "can not write " + path.string();
+            return false;
+        }
+        return true;
+    }
+} // namespace core
@@ -0,0 +1,119 @@
+#pragma once
+#include "asset/mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core
+{
+    // State one run leaves for the next: tool state, the ImGui layout, the Vulkan pipeline cache.
+    //
+    // Owners register named sections with a writer. At every save the writers run on the main thread and a
+    // JobSystem job writes the file; saves happen every --session-interval seconds (default 30, 0 only saves
+    // on exit) and when the subsystem is destroyed. --session <file> enables it.
+    //
+    // Layout: Header, section data (each aligned to data_alignment), the index as entry_count Entry records
+    // sorted by name hash, then the names. At startup the newest valid file is mapped and only its header
+    // and index are checked, so a section costs nothing until its owner asks for it, and is a span into the
+    // mapping then. Saves alternate between <file> and <file>.alt, the one not mapped, which keeps the
+    // mapping valid on every platform; a sequence number tells the newer one. A save interrupted before
+    // its header is written leaves a file that fails the check, the other one is used then.
+    class SessionSnapshot
+    {
+    public:
+        using Writer = std::function<void(std::vector<std::byte>& data)>;
+
+        struct Header
+        {
+            char     magic[4];
+            uint32_t version;
+            uint64_t sequence;
+            uint64_t entry_count;
+            uint64_t index_offset;
+            uint64_t names_offset;
+        };
+
+        struct Entry
+        {
+            uint64_t name_hash;
+            uint64_t offset; // From the start of the file
+            uint64_t size;
+            uint32_t name_offset; // From names_offset
+            uint32_t name_size;
+            uint32_t version;
+            uint32_t reserved;
+        };
+
+        static constexpr char     magic[4]       = {'C', 'S', 'E', 'S'};
+        static constexpr uint32_t version        = 1;
+        static constexpr uint64_t data_alignment = 16;
+
+        SessionSnapshot();
+        ~SessionSnapshot();
+
+        SessionSnapshot(const SessionSnapshot&)            = delete;
+        SessionSnapshot& operator=(const SessionSnapshot&) = delete;
+
+        [[nodiscard]] bool is_enabled() const noexcept { return !path_.empty(); }
+
+        // Data the previous run saved under name with this version; empty if there is none. Valid as long
+        // as the SessionSnapshot, the first access faults its pages in.
+        [[nodiscard]] std::span<const std::byte> get_section(std::string_view name, uint32_t version) const;
+
+        // writer appends the section's data to an empty vector at every save. A saved section of another
+        // version is dropped on load, so bump it when the format of the data changes.
+        void add_section(std::string name, uint32_t version, Writer writer);
+        // Runs the writer one last time and keeps its data for the saves that follow. Owners call it before
+        // what the writer reads goes away.
+        void remove_section(std::string_view name);
+
+        // Collects the sections and writes them on a worker thread, unless the previous save still runs or
+        // nothing changed since it.
+        void save();
+
+    private:
+        struct Mapping
+        {
+            MappedFile             file;
+            std::span<const Entry> entries;
+            std::string_view       names;
+            uint64_t               sequence = 0;
+        };
+
+        struct Section
+        {
+            std::string            name;
+            uint32_t               version = 0;
+            Writer                 writer; // Empty once removed
+            std::vector<std::byte> data;   // Of a removed section
+        };
+
+        struct Collected
+        {
+            std::string            name;
+            uint32_t               version = 0;
+            std::vector<std::byte> data;
+        };
+
+        void collect(std::vector<Collected>& sections) const;
+        // Writes unless the data is the same as the last save's. Any thread, one at a time.
+        void write(const std::vector<Collected>& sections, uint64_t sequence);
+
+        static bool open(const std::filesystem::path& path, Mapping& mapping);
+        static bool write_file(const std::filesystem::path& path, uint64_t sequence, const std::vector<Collected>& sections, std::string& error);
+
+        std::filesystem::path path_;    // Of the next save
+        Mapping               mapping_; // Of the previous run's save
+        std::vector<Section>  sections_;
+        std::future<void>     job_;
+        uint64_t              sequence_ = 0;
+        uint64_t              timer_    = 0;
+        uint64_t              saved_    = 0; // Hash of the last saved data, only the save in progress touches it
+    };
+} // namespace core
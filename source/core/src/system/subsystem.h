@@ -1,5 +1,6 @@
 #pragma once
 
+#include "memory/memory_tracker.h"
 #include <any>
 #include <cassert>
 #include <memory>
@@ -58,6 +59,7 @@ namespace core
         assert(!has_subsystem<S>() && "Subsystem already exists!");
 
         _orders.push_back(index);
+        MemoryScope scope(memory_tag<S>());
         _subsystems[index] = std::make_shared<S>(std::forward<Args>(args)...);
 
         return get_subsystem<S>();
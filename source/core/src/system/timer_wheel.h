@@ -0,0 +1,281 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace core
+{
+    // Hierarchical timing wheel: values scheduled for deadlines in nanoseconds of a monotonic clock, with
+    // constant time add, reschedule and remove however many entries it holds.
+    //
+    // There are levels wheels of slot_count slots. A level 0 slot spans one tick of 2^tick_shift ns (about a
+    // millisecond), a slot of level n spans slot_count^n ticks. An entry sits on the lowest level where its
+    // tick shares the slot above with the current tick, and moves down (cascades) once the current tick
+    // enters its slot. Deadlines are kept exact: advance() only expires entries whose deadline has passed.
+    // Entries past the reach of the top level (about two years) park in it and cascade again from there.
+    //
+    // Expired entries stay allocated until removed, so a repeating timer can be rescheduled under its Id.
+    template<typename T>
+    class TimerWheel
+    {
+    public:
+        using Id                    = uint64_t; // Generation in the upper 32 bits, index + 1 in the lower
+        static constexpr Id invalid = 0;
+
+        static constexpr uint32_t tick_shift = 20;
+        static constexpr uint32_t slot_bits  = 6;
+        static constexpr uint32_t slot_count = 1u << slot_bits;
+        static constexpr uint32_t levels     = 6;
+
+        explicit TimerWheel(uint64_t now = 0) : now_(now), tick_(now >> tick_shift)
+        {
+            for (auto& level : heads_)
+                level.fill(none);
+        }
+
+        Id add(uint64_t deadline, T value)
+        {
+            uint32_t index = free_;
+            if (index != none)
+                free_ = nodes_[index].next;
+            else
+            {
+                index = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+
+            Node& node = nodes_[index];
+            node.value = std::move(value);
+            node.alive = true;
+            ++size_;
+            link(index, deadline);
+            return (static_cast<Id>(node.generation) << 32) | (index + 1);
+        }
+
+        // Schedules an entry again, whether it already expired or is still waiting.
+        bool reschedule(Id id, uint64_t deadline)
+        {
+            const uint32_t index = find(id);
+            if (index == none)
+                return false;
+            if (nodes_[index].level != unlinked)
+                unlink(index);
+            link(index, deadline);
+            return true;
+        }
+
+        bool remove(Id id)
+        {
+            const uint32_t index = find(id);
+            if (index == none)
+                return false;
+
+            Node& node = nodes_[index];
+            if (node.level != unlinked)
+                unlink(index);
+            node.value = T {};
+            node.alive = false;
+            ++node.generation;
+            node.next = free_;
+            free_     = index;
+            --size_;
+            return true;
+        }
+
+        [[nodiscard]] T* get(Id id)
+        {
+            const uint32_t index = find(id);
+            return index != none ? &nodes_[index].value : nullptr;
+        }
+        [[nodiscard]] bool contains(Id id) const { return find(id) != none; }
+        [[nodiscard]] bool is_scheduled(Id id) const
+        {
+            const uint32_t index = find(id);
+            return index != none && nodes_[index].level != unlinked;
+        }
+        // 0 for unknown ids.
+        [[nodiscard]] uint64_t get_deadline(Id id) const
+        {
+            const uint32_t index = find(id);
+            return index != none ? nodes_[index].deadline : 0;
+        }
+
+        // Entries added and not removed, expired ones included.
+        [[nodiscard]] size_t   size() const noexcept { return size_; }
+        [[nodiscard]] size_t   get_scheduled_count() const noexcept { return scheduled_; }
+        [[nodiscard]] uint64_t get_now() const noexcept { return now_; }
+
+        // Moves time forward to now and appends the entries whose deadline passed to expired.
+        void advance(uint64_t now, std::vector<Id>& expired)
+        {
+            now_                  = std::max(now, now_);
+            const uint64_t target = now_ >> tick_shift;
+            while (tick_ < target)
+            {
+                // The current tick is over, everything in its slot is due.
+                expire(expired);
+
+                // Below the lowest occupied level nothing expires or cascades before that level's next slot.
+                uint32_t empty = 0;
+                while (empty < levels && occupied_[empty] == 0)
+                    ++empty;
+                if (empty == levels)
+                {
+                    tick_ = target;
+                    break;
+                }
+                if (empty > 0)
+                {
+                    const uint64_t last = tick_ | ((uint64_t(1) << (empty * slot_bits)) - 1);
+                    if (last >= target)
+                    {
+                        tick_ = target;
+                        break;
+                    }
+                    tick_ = last;
+                }
+
+                ++tick_;
+                // Top down: a cascade can fill the slot of a lower level that cascades on the same tick.
+                for (uint32_t level = levels - 1; level > 0; --level)
+                {
+                    if ((tick_ & ((uint64_t(1) << (level * slot_bits)) - 1)) == 0)
+                        cascade(level, get_slot(tick_, level));
+                }
+            }
+            // The current tick is only partly over, its entries expire as their deadlines pass.
+            expire(expired);
+        }
+
+        // Earliest deadline of the scheduled entries.
+        [[nodiscard]] std::optional<uint64_t> get_next_deadline() const
+        {
+            // All entries of a level lie before those of the levels above, and its slots are in order.
+            for (uint32_t level = 0; level < levels; ++level)
+            {
+                if (occupied_[level] == 0)
+                    continue;
+                uint64_t deadline = UINT64_MAX;
+                for (uint32_t index = heads_[level][std::countr_zero(occupied_[level])]; index != none; index = nodes_[index].next)
+                    deadline = std::min(deadline, nodes_[index].deadline);
+                return deadline;
+            }
+            return std::nullopt;
+        }
+
+    private:
+        static constexpr uint32_t none     = UINT32_MAX;
+        static constexpr uint8_t  unlinked = UINT8_MAX;
+        static constexpr uint64_t reach    = (uint64_t(1) << (slot_bits * levels)) - 1; // In ticks
+
+        struct Node
+        {
+            T        value {};
+            uint64_t deadline   = 0;
+            uint32_t prev       = none;
+            uint32_t next       = none; // Next in the slot, or in the free list
+            uint32_t generation = 1;
+            uint8_t  level      = unlinked;
+            uint8_t  slot       = 0;
+            bool     alive      = false;
+        };
+
+        static uint32_t get_slot(uint64_t tick, uint32_t level) { return static_cast<uint32_t>(tick >> (level * slot_bits)) & (slot_count - 1); }
+
+        uint32_t find(Id id) const
+        {
+            const uint64_t index = (id & 0xFFFFFFFFu) - 1;
+            if (id == invalid || index >= nodes_.size())
+                return none;
+            const Node& node = nodes_[index];
+            return node.alive && node.generation == static_cast<uint32_t>(id >> 32) ? static_cast<uint32_t>(index) : none;
+        }
+
+        void link(uint32_t index, uint64_t deadline)
+        {
+            Node& node    = nodes_[index];
+            node.deadline = deadline;
+
+            const uint64_t tick  = std::min(std::max(deadline >> tick_shift, tick_), tick_ | reach);
+            const uint64_t other = tick ^ tick_; // Highest differing slot digit is the level
+            const uint32_t level = other != 0 ? static_cast<uint32_t>(std::bit_width(other) - 1) / slot_bits : 0;
+            const uint32_t slot  = get_slot(tick, level);
+
+            uint32_t& head = heads_[level][slot];
+            node.level     = static_cast<uint8_t>(level);
+            node.slot      = static_cast<uint8_t>(slot);
+            node.prev      = none;
+            node.next      = head;
+            if (head != none)
+                nodes_[head].prev = index;
+            head = index;
+            occupied_[level] |= uint64_t(1) << slot;
+            ++scheduled_;
+        }
+
+        void unlink(uint32_t index)
+        {
+            Node& node = nodes_[index];
+            if (node.prev != none)
+                nodes_[node.prev].next = node.next;
+            else
+                heads_[node.level][node.slot] = node.next;
+            if (node.next != none)
+                nodes_[node.next].prev = node.prev;
+            if (heads_[node.level][node.slot] == none)
+                occupied_[node.level] &= ~(uint64_t(1) << node.slot);
+            node.level = unlinked;
+            node.prev  = none;
+            node.next  = none;
+            --scheduled_;
+        }
+
+        void cascade(uint32_t level, uint32_t slot)
+        {
+            uint32_t index = std::exchange(heads_[level][slot], none);
+            occupied_[level] &= ~(uint64_t(1) << slot);
+            while (index != none)
+            {
+                const uint32_t next = nodes_[index].next;
+                --scheduled_;
+                link(index, nodes_[index].deadline);
+                index = next;
+            }
+        }
+
+        void expire(std::vector<Id>& expired)
+        {
+            uint32_t index = heads_[0][get_slot(tick_, 0)];
+            while (index != none)
+            {
+                Node&          node = nodes_[index];
+                const uint32_t next = node.next;
+                if (node.deadline <= now_)
+                {
+                    unlink(index);
+                    expired.push_back((static_cast<Id>(node.generation) << 32) | (index + 1));
+                }
+                else if ((node.deadline >> tick_shift) > tick_)
+                {
+                    // Parked beyond the reach of the wheels, it goes back up.
+                    unlink(index);
+                    link(index, node.deadline);
+                }
+                index = next;
+            }
+        }
+
+        std::vector<Node>                                     nodes_;
+        std::array<std::array<uint32_t, slot_count>, levels> heads_;
+        std::array<uint64_t, levels>                          occupied_ {}; // Bit per non-empty slot
+        uint64_t                                              now_;
+        uint64_t                                              tick_;
+        uint32_t                                              free_      = none;
+        size_t                                                size_      = 0;
+        size_t                                                scheduled_ = 0;
+    };
+} // namespace core
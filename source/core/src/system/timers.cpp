@@ -0,0 +1,121 @@
+#include "timers.h"
+#include <algorithm>
+#include <utility>
+
+namespace core
+{
+    Timers::Timers() : wheel_(to_ns(Clock::now()))
+    {
+        connect<FrameBegin, Timers, &Timers::frame_begin>(*this);
+        connect<FrameUpdate, Timers, &Timers::frame_update>(*this);
+        connect<FrameRender, Timers, &Timers::frame_render>(*this);
+        connect<FrameEnd, Timers, &Timers::frame_end>(*this);
+    }
+
+    Timers::~Timers() { disconnect(*this); }
+
+    uint64_t Timers::to_ns(Clock::time_point time)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+    }
+
+    Timers::TimerId Timers::schedule(Clock::duration delay, Callback callback, TimerPhase phase)
+    {
+        return add(delay, 0, std::move(callback), phase);
+    }
+
+    Timers::TimerId Timers::schedule_repeating(Clock::duration period, Callback callback, TimerPhase phase)
+    {
+        // A period below the clock's resolution would be due again right away, every frame anyway.
+        const auto ns = std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(period).count(), 1);
+        return add(period, static_cast<uint64_t>(ns), std::move(callback), phase);
+    }
+
+    Timers::TimerId Timers::add(Clock::duration delay, uint64_t period, Callback callback, TimerPhase phase)
+    {
+        if (!callback || phase >= TimerPhase::count)
+            return invalid;
+        const auto deadline = to_ns(Clock::now() + std::max(delay, Clock::duration::zero()));
+        return wheel_.add(deadline, Timer {std::move(callback), period, phase});
+    }
+
+    bool Timers::cancel(TimerId id) { return wheel_.remove(id); }
+
+    std::optional<Timers::Clock::time_point> Timers::get_next_deadline() const
+    {
+        for (const auto& due : due_)
+        {
+            if (!due.empty())
+                return Clock::now();
+        }
+        const auto deadline = wheel_.get_next_deadline();
+        if (!deadline)
+            return std::nullopt;
+        return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(*deadline)));
+    }
+
+    void Timers::run_due()
+    {
+        advance();
+        for (size_t phase = 0; phase < due_.size(); ++phase)
+            run(static_cast<TimerPhase>(phase));
+    }
+
+    void Timers::advance()
+    {
+        wheel_.advance(to_ns(Clock::now()), expired_);
+        for (TimerId id : expired_)
+        {
+            if (const Timer* timer = wheel_.get(id))
+                due_[static_cast<size_t>(timer->phase)].push_back(id);
+        }
+        expired_.clear();
+    }
+
+    void Timers::run(TimerPhase phase)
+    {
+        std::vector<TimerId>& due = due_[static_cast<size_t>(phase)];
+        if (due.empty())
+            return;
+
+        running_.swap(due);
+        for (TimerId id : running_)
+        {
+            Timer* timer = wheel_.get(id);
+            if (!timer)
+                continue; // Cancelled by an earlier callback
+
+            // Out of the wheel during the call: callbacks may add timers, which can move it.
+            Callback callback = std::move(timer->callback);
+            if (timer->period == 0)
+            {
+                wheel_.remove(id);
+                callback();
+                continue;
+            }
+
+            // From the previous deadline, so frame timing does not make the period drift.
+            const uint64_t now      = wheel_.get_now();
+            uint64_t       deadline = wheel_.get_deadline(id) + timer->period;
+            if (deadline <= now)
+                deadline = now + timer->period;
+            wheel_.reschedule(id, deadline);
+            callback();
+            if (Timer* again = wheel_.get(id))
+                again->callback = std::move(callback);
+        }
+        running_.clear();
+    }
+
+    void Timers::frame_begin(const FrameBegin&)
+    {
+        advance();
+        run(TimerPhase::begin);
+    }
+
+    void Timers::frame_update(const FrameUpdate&) { run(TimerPhase::update); }
+
+    void Timers::frame_render(const FrameRender&) { run(TimerPhase::render); }
+
+    void Timers::frame_end(const FrameEnd&) { run(TimerPhase::end); }
+} // namespace core
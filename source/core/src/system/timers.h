@@ -0,0 +1,85 @@
+#pragma once
+#include "event/EventSubscriber.h"
+#include "event/frame_event.h"
+#include "system/timer_wheel.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace core
+{
+    // Frame events a timer callback can run in, in the order they happen.
+    enum class TimerPhase : uint8_t
+    {
+        begin,
+        update,
+        render,
+        end,
+        count,
+    };
+
+    // Delayed and periodic callbacks for the main loop: autosave, polling, tooltips.
+    //
+    // Timers sit in a TimerWheel on the steady clock. At FrameBegin the wheel advances and the due timers
+    // run in their phase of that frame: FrameBegin, FrameUpdate, FrameRender or FrameEnd. A repeating timer
+    // is due again one period after its previous deadline; periods missed by a long frame are skipped,
+    // not caught up. Frames in which no window renders have no frame events, App then runs due timers
+    // itself, whatever their phase, and sleeps until get_next_deadline() or the next SDL event. After a
+    // frame that changed nothing on screen it sleeps the same way, the timers then run in the next frame.
+    //
+    // Callbacks may schedule and cancel timers, themselves included. Every call here is main thread only.
+    class Timers : public EventSubscriber
+    {
+    public:
+        using Clock    = std::chrono::steady_clock;
+        using Callback = std::function<void()>;
+        using TimerId  = uint64_t;
+
+        static constexpr TimerId invalid = 0;
+
+        Timers();
+        ~Timers();
+
+        TimerId schedule(Clock::duration delay, Callback callback, TimerPhase phase = TimerPhase::update);
+        // First runs one period from now.
+        TimerId schedule_repeating(Clock::duration period, Callback callback, TimerPhase phase = TimerPhase::update);
+        // False when the timer is unknown, already ran (one shot) or was cancelled before.
+        bool cancel(TimerId id);
+
+        [[nodiscard]] bool   is_pending(TimerId id) const { return wheel_.contains(id); }
+        [[nodiscard]] size_t get_count() const noexcept { return wheel_.size(); }
+
+        // When the earliest timer is due, possibly in the past; nullopt without timers.
+        [[nodiscard]] std::optional<Clock::time_point> get_next_deadline() const;
+
+        // Runs every due timer right away, whatever its phase. For App iterations without frame events.
+        void run_due();
+
+    private:
+        struct Timer
+        {
+            Callback   callback;
+            uint64_t   period = 0; // In nanoseconds, 0 for a one shot
+            TimerPhase phase  = TimerPhase::update;
+        };
+
+        static uint64_t to_ns(Clock::time_point time);
+
+        TimerId add(Clock::duration delay, uint64_t period, Callback callback, TimerPhase phase);
+        void    advance();
+        void    run(TimerPhase phase);
+
+        void frame_begin(const FrameBegin& event);
+        void frame_update(const FrameUpdate& event);
+        void frame_render(const FrameRender& event);
+        void frame_end(const FrameEnd& event);
+
+        TimerWheel<Timer>                                                        wheel_;
+        std::vector<TimerId>                                                     expired_;
+        std::array<std::vector<TimerId>, static_cast<size_t>(TimerPhase::count)> due_; // Expired, waiting for their phase
+        std::vector<TimerId>                                                     running_;
+    };
+} // namespace core
@@ -0,0 +1,308 @@
+#include "watchdog.h"
+#include "cmd_line/parser.hpp"
+#include "event/EventManager.h"
+#include "jobs/job_system.h"
+#include "log/log_ring.h"
+#include "logger.h"
+#include "memory/frame_arena.h"
+#include "memory/memory_tracker.h"
+#include "system/subsystem.h"
+#include <algorithm>
+#include <fstream>
+
+namespace core
+{
+    namespace
+    {
+        constexpr size_t   max_threads     = 16;
+        constexpr uint64_t snapshot_log    = 64; // Most recent log records in a snapshot
+        constexpr float    check_fraction  = 0.25f;
+        constexpr float    min_check_delay = 0.1f;
+
+        const char* const phase_names[] = {"events", "begin", "fixed update", "update", "ui render", "render", "end"};
+        static_assert(std::size(phase_names) == Watchdog::phase_count);
+
+        // Where each thread is, readable from the watch thread. A thread claims a slot on its first scope and
+        // frees it when it exits; threads beyond max_threads are simply not tracked.
+        struct ThreadSlot
+        {
+            std::atomic<bool>        used {false};
+            std::atomic<const char*> name {nullptr};
+            std::atomic<const char*> location {nullptr};
+        };
+
+        ThreadSlot thread_slots[max_threads];
+
+        struct SlotOwner
+        {
+            ThreadSlot* slot    = nullptr;
+            bool        claimed = false; // Tried already, slot stays nullptr when all were taken
+
+            ~SlotOwner()
+            {
+                if (!slot)
+                    return;
+                slot->location.store(nullptr, std::memory_order_relaxed);
+                slot->name.store(nullptr, std::memory_order_relaxed);
+                slot->used.store(false, std::memory_order_release);
+            }
+        };
+
+        thread_local SlotOwner slot_owner;
+
+        ThreadSlot* get_slot() noexcept
+        {
+            if (slot_owner.claimed)
+                return slot_owner.slot;
+            slot_owner.claimed = true;
+            for (ThreadSlot& slot : thread_slots)
+            {
+                bool expected = false;
+                if (slot.used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                {
+                    slot_owner.slot = &slot;
+                    break;
+                }
+            }
+            return slot_owner.slot;
+        }
+
+        int64_t to_ns(std::chrono::steady_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        float to_ms(std::chrono::steady_clock::duration duration) { return std::chrono::duration<float, std::milli>(duration).count(); }
+    } // namespace
+
+    WatchdogScope::WatchdogScope(const char* location) noexcept
+    {
+        if (ThreadSlot* slot = get_slot())
+            previous_ = slot->location.exchange(location, std::memory_order_relaxed);
+    }
+
+    WatchdogScope::~WatchdogScope()
+    {
+        if (ThreadSlot* slot = get_slot())
+            slot->location.store(previous_, std::memory_order_relaxed);
+    }
+
+    // Everything frozen at a hitch, written out by a job.
+    struct Watchdog::Snapshot
+    {
+        float                                   budget_ms = 0.0f;
+        std::vector<FrameRecord>                history; // Oldest first, the hitch last
+        std::vector<EventManager::TriggerCount> events;
+        MemoryTracker::Stats                    memory;
+        std::vector<MemoryTracker::Stats>       memory_tags;
+        size_t                                  arena_used       = 0;
+        size_t                                  arena_high_water = 0;
+        size_t                                  arena_capacity   = 0;
+        std::vector<LogRecord>                  log;
+    };
+
+    Watchdog::Watchdog()
+    {
+        auto& parser  = Parser::instance();
+        budget_ms_    = std::stof(parser.getOptionValue("frame-budget", "50"));
+        hang_timeout_ = std::stof(parser.getOptionValue("hang-timeout", "5"));
+        dump_dir_     = parser.getOptionValue("hitch-dir", "log/hitches");
+        dump_limit_   = static_cast<uint32_t>(std::stoul(parser.getOptionValue("hitch-limit", "32")));
+
+        name_thread("main");
+        if (hang_timeout_ > 0.0f)
+            thread_ = std::thread([this]() { watch(); });
+    }
+
+    Watchdog::~Watchdog()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+        for (auto& write : writes_)
+            write.wait();
+    }
+
+    void Watchdog::name_thread(const char* name) noexcept
+    {
+        if (ThreadSlot* slot = get_slot())
+            slot->name.store(name, std::memory_order_relaxed);
+    }
+
+    void Watchdog::begin_frame()
+    {
+        frame_start_   = Clock::now();
+        phase_start_   = frame_start_;
+        phase_         = FramePhase::events;
+        current_       = FrameRecord {};
+        current_.frame = frame_;
+        get_subsystem<EventManager>().reset_frame_counts();
+        std::erase_if(writes_, [](const auto& write) { return write.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
+        running_frame_.store(frame_, std::memory_order_relaxed);
+        running_since_.store(to_ns(frame_start_), std::memory_order_release);
+        if (ThreadSlot* slot = get_slot())
+            slot->location.store(phase_names[0], std::memory_order_relaxed);
+    }
+
+    void Watchdog::phase(FramePhase phase)
+    {
+        const auto now = Clock::now();
+        current_.phase_ms[static_cast<size_t>(phase_)] += to_ms(now - phase_start_);
+        phase_start_ = now;
+        phase_       = phase;
+        if (ThreadSlot* slot = get_slot())
+            slot->location.store(phase_names[static_cast<size_t>(phase)], std::memory_order_relaxed);
+    }
+
+    void Watchdog::end_frame()
+    {
+        const auto now = Clock::now();
+        current_.phase_ms[static_cast<size_t>(phase_)] += to_ms(now - phase_start_);
+        current_.total_ms = to_ms(now - frame_start_);
+        skip_frame();
+
+        history_[frame_ % history_size] = current_;
+        ++frame_;
+        if (budget_ms_ > 0.0f && current_.total_ms > budget_ms_)
+            capture(current_);
+    }
+
+    void Watchdog::skip_frame()
+    {
+        running_since_.store(0, std::memory_order_relaxed);
+        if (reported_frame_.exchange(0, std::memory_order_relaxed) == frame_ + 1)
+            APPLOG_WARNING("[watchdog] Frame {} finished after {:.1f} s", frame_, to_ms(Clock::now() - frame_start_) / 1000.0f);
+        if (ThreadSlot* slot = get_slot())
+            slot->location.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void Watchdog::capture(const FrameRecord& record)
+    {
+        ++hitch_count_;
+        APPLOG_WARNING("[watchdog] Frame {} took {:.1f} ms, over the budget of {:.1f} ms", record.frame, record.total_ms, budget_ms_);
+        if (hitch_count_ > dump_limit_)
+            return;
+
+        // Only copies here, formatting and the file are left to the job.
+        auto snapshot       = std::make_shared<Snapshot>();
+        snapshot->budget_ms = budget_ms_;
+        const size_t count  = static_cast<size_t>(std::min<uint64_t>(frame_, history_size));
+        for (size_t i = 0; i < count; ++i)
+            snapshot->history.push_back(history_[(frame_ - count + i) % history_size]);
+        snapshot->events = get_subsystem<EventManager>().get_trigger_counts();
+
+        snapshot->memory = MemoryTracker::get_total();
+        for (uint16_t tag = 0; tag < MemoryTracker::get_tag_count(); ++tag)
+        {
+            MemoryTracker::Stats stats = MemoryTracker::get_stats(tag);
+            if (stats.peak > 0)
+                snapshot->memory_tags.push_back(stats);
+        }
+        if (has_subsystem<FrameArena>())
+        {
+            const auto& arena          = get_subsystem<FrameArena>();
+            snapshot->arena_used       = arena.get_frame_used();
+            snapshot->arena_high_water = arena.get_high_water();
+            snapshot->arena_capacity   = arena.get_capacity();
+        }
+
+        const LogRing& ring = Logger::getRing();
+        const uint64_t end  = ring.get_published(ring.get_oldest());
+        for (uint64_t ticket = std::max(ring.get_oldest(), end > snapshot_log ? end - snapshot_log : 0); ticket < end; ++ticket)
+        {
+            LogRecord log_record;
+            if (ring.read(ticket, log_record))
+                snapshot->log.push_back(log_record);
+        }
+
+        const auto path = dump_dir_ / fmt::format("hitch_{:06}.txt", record.frame);
+        writes_.push_back(get_subsystem<JobSystem>().submit([snapshot, path]() {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+            std::ofstream file(path, std::ios::trunc);
+            if (!file)
+            {
+                APPLOG_ERROR("[watchdog] Could not write {}", path.string());
+                return;
+            }
+
+            const FrameRecord& hitch = snapshot->history.back();
+            file << fmt::format("Frame {} took {:.2f} ms (budget {:.2f} ms)\n\n", hitch.frame, hitch.total_ms, snapshot->budget_ms);
+
+            file << "Frames, oldest first (ms):\nframe      total";
+            for (const char* name : phase_names)
+                file << fmt::format(" {:>12}", name);
+            file << '\n';
+            for (const FrameRecord& frame : snapshot->history)
+            {
+                file << fmt::format("{:<10} {:>5.2f}", frame.frame, frame.total_ms);
+                for (float ms : frame.phase_ms)
+                    file << fmt::format(" {:>12.2f}", ms);
+                file << '\n';
+            }
+
+            std::ranges::sort(snapshot->events, [](const auto& a, const auto& b) { return a.frame > b.frame; });
+            file << "\nEvents triggered (this frame, total):\n";
+            for (const EventManager::TriggerCount& count : snapshot->events)
+                file << fmt::format("  {:>8} {:>12}  {}\n", count.frame, count.total, count.name);
+
+            file << fmt::format("\nFrame arena: {} KiB used last frame, {} KiB high water, {} KiB capacity\n",
+                                snapshot->arena_used / 1024,
+                                snapshot->arena_high_water / 1024,
+                                snapshot->arena_capacity / 1024);
+            if (MemoryTracker::is_enabled())
+            {
+                const MemoryTracker::Stats& all = snapshot->memory;
+                file << fmt::format("Memory: {} KiB in {} blocks, peak {} KiB\n", all.current / 1024, all.live, all.peak / 1024);
+                std::ranges::sort(snapshot->memory_tags, [](const auto& a, const auto& b) { return a.current > b.current; });
+                for (const MemoryTracker::Stats& stats : snapshot->memory_tags)
+                {
+                    file << fmt::format("  {:<24} {:>10} KiB {:>8} blocks, {} allocations\n",
+                                        stats.name,
+                                        stats.current / 1024,
+                                        stats.live,
+                                        stats.allocations);
+                }
+            }
+
+            file << "\nRecent log:\n";
+            for (const LogRecord& log_record : snapshot->log)
+                file << fmt::format("  [{}] {}\n", spdlog::level::to_string_view(log_record.level), log_record.get_text());
+        }));
+    }
+
+    // Watch thread: reports a frame in progress for longer than the timeout once.
+    void Watchdog::watch()
+    {
+        name_thread("watchdog");
+        const auto delay = std::chrono::duration<float>(std::max(hang_timeout_ * check_fraction, min_check_delay));
+
+        std::unique_lock lock(mutex_);
+        while (!condition_.wait_for(lock, delay, [this]() { return stopping_; }))
+        {
+            const int64_t  since = running_since_.load(std::memory_order_acquire);
+            const uint64_t frame = running_frame_.load(std::memory_order_relaxed);
+            if (since == 0 || reported_frame_.load(std::memory_order_relaxed) == frame + 1)
+                continue;
+            const float elapsed = static_cast<float>(to_ns(Clock::now()) - since) / 1e9f;
+            if (elapsed < hang_timeout_)
+                continue;
+
+            reported_frame_.store(frame + 1, std::memory_order_relaxed);
+            APPLOG_ERROR("[watchdog] Frame {} has been running for {:.1f} s, the main loop looks hung", frame, elapsed);
+            for (const ThreadSlot& slot : thread_slots)
+            {
+                if (!slot.used.load(std::memory_order_acquire))
+                    continue;
+                const char* name     = slot.name.load(std::memory_order_relaxed);
+                const char* location = slot.location.load(std::memory_order_relaxed);
+                APPLOG_ERROR("[watchdog]   {} thread: {}", name ? name : "unnamed", location ? location : "-");
+            }
+        }
+    }
+} // namespace core
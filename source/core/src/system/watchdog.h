@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace core
+{
+    // Marks what the calling thread is doing until it goes out of scope, so a hang report can tell where each
+    // thread is stuck. Scopes nest and cost two atomic stores; wrap blocking calls with them.
+    class WatchdogScope
+    {
+    public:
+        explicit WatchdogScope(const char* location) noexcept;
+        ~WatchdogScope();
+
+        WatchdogScope(const WatchdogScope&)            = delete;
+        WatchdogScope& operator=(const WatchdogScope&) = delete;
+
+    private:
+        const char* previous_ = nullptr;
+    };
+
+    // Parts of App::run_one_frame, in order.
+    enum class FramePhase : uint8_t
+    {
+        events,
+        begin,
+        fixed_update,
+        update,
+        ui_render,
+        render,
+        end,
+        count,
+    };
+
+    // Watches the main loop for hitches and hangs.
+    //
+    // App::run_one_frame reports its phases, which are kept for the last history_size frames. A frame
+    // over --frame-budget milliseconds (default 50, 0 turns it off) freezes that history together with
+    // the frame's event counts, memory and frame arena stats and the recent log, and a job writes it to
+    // --hitch-dir (default log/hitches), at most --hitch-limit (default 32) files per run.
+    // A thread of its own checks the frame in progress: when one runs longer than --hang-timeout seconds
+    // (default 5, 0 turns it off) it logs where every thread is, see WatchdogScope.
+    class Watchdog
+    {
+    public:
+        static constexpr size_t history_size = 128;
+        static constexpr size_t phase_count  = static_cast<size_t>(FramePhase::count);
+
+        struct FrameRecord
+        {
+            uint64_t                       frame    = 0;
+            float                          total_ms = 0.0f;
+            std::array<float, phase_count> phase_ms = {};
+        };
+
+        Watchdog();
+        ~Watchdog();
+
+        // Names the calling thread in hang reports; threads that do not stay unnamed but are still reported.
+        static void name_thread(const char* name) noexcept;
+
+        void begin_frame();
+        // Ends the current phase and starts phase.
+        void phase(FramePhase phase);
+        void end_frame();
+        // Ends a loop iteration that rendered nothing without recording it.
+        void skip_frame();
+
+        [[nodiscard]] uint64_t get_hitch_count() const noexcept { return hitch_count_; }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Snapshot;
+
+        void capture(const FrameRecord& record);
+        void watch();
+
+        float                 budget_ms_    = 50.0f;
+        float                 hang_timeout_ = 5.0f;
+        std::filesystem::path dump_dir_;
+        uint32_t              dump_limit_  = 32;
+        uint64_t              hitch_count_ = 0;
+
+        std::array<FrameRecord, history_size> history_ {};
+        uint64_t                              frame_ = 0;
+        FrameRecord                           current_;
+        FramePhase                            phase_ = FramePhase::events;
+        Clock::time_point                     frame_start_;
+        Clock::time_point                     phase_start_;
+
+        std::vector<std::future<void>> writes_;
+
+        // Shared with the watch thread: start of the frame in progress in steady clock nanoseconds, 0 between frames.
+        std::atomic<int64_t>    running_since_ {0};
+        std::atomic<uint64_t>   running_frame_ {0};
+        std::atomic<uint64_t>   reported_frame_ {0}; // Frame number + 1 of the hang reported last, 0 once it ended
+        std::thread             thread_;
+        std::mutex              mutex_;
+        std::condition_variable condition_;
+        bool                    stopping_ = false;
+    };
+} // namespace core
@@ -34,4 +34,9 @@ namespace core
         }
     }
 
+    bool Window::is_renderable() const noexcept
+    {
+        return window_ && (get_flags() & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_OCCLUDED | SDL_WINDOW_HIDDEN)) == 0;
+    }
+
 } // namespace core
@@ -15,7 +15,10 @@ namespace core
         [[nodiscard]] uint32_t    get_id() const noexcept;
         void                      get_size(int& width, int& height) const noexcept;
 
-        [[nodiscard]] SDL_WindowFlags get_flags() const noexcept { return flags_; }
+        [[nodiscard]] SDL_WindowFlags get_flags() const noexcept { return window_ ? SDL_GetWindowFlags(window_) : flags_; }
+
+        // Minimized, occluded or hidden windows have nothing to present.
+        [[nodiscard]] bool is_renderable() const noexcept;
 
     private:
         SDL_Window*     window_ = nullptr;
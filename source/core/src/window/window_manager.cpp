@@ -1,8 +1,13 @@
 ﻿#include "window_manager.h"
+#include <event/EventManager.h>
+#include <event/window_event.h>
 #include <logger.h>
+#include <system/subsystem.h>
 
 namespace core
 {
+    static constexpr SDL_WindowFlags window_flags =
+        static_cast<SDL_WindowFlags>(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_HIDDEN);
 
     WindowManager::WindowManager(const std::string& title, int w, int h)
     {
@@ -11,10 +16,7 @@ namespace core
             APPLOG_ERROR("SDL_Init failed: {}", SDL_GetError());
         }
 
-        SDL_WindowFlags flags =
-            static_cast<SDL_WindowFlags>(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_HIDDEN);
-
-        auto main_window = std::make_unique<Window>(title, w, h, flags);
+        auto main_window = std::make_unique<Window>(title, w, h, window_flags);
         main_window_id_  = main_window->get_id();
         windows_.emplace(main_window_id_, std::move(main_window));
     }
@@ -25,19 +27,67 @@ namespace core
         SDL_Quit();
     }
 
-    Window* WindowManager::get_main_window() const noexcept
+    Window* WindowManager::create_window(const std::string& title, int w, int h)
     {
-        return windows_.begin()->second.get();
-        // auto it = windows_.find(main_window_id_);
-        // return it != windows_.end() ? it->second.get() : nullptr;
+        auto window = std::make_unique<Window>(title, w, h, window_flags);
+        if (!window->get_sdl_window_ptr())
+        {
+            return nullptr;
+        }
+
+        const uint32_t id  = window->get_id();
+        Window*        ptr = window.get();
+        windows_.emplace(id, std::move(window));
+
+        if (has_subsystem<EventManager>())
+        {
+            get_subsystem<EventManager>().trigger<WindowCreated>(WindowCreated {ptr});
+        }
+        return ptr;
     }
 
+    bool WindowManager::destroy_window(uint64_t id)
+    {
+        if (id == main_window_id_)
+        {
+            APPLOG_WARNING("The main window {} can not be destroyed", id);
+            return false;
+        }
+
+        auto it = windows_.find(id);
+        if (it == windows_.end())
+        {
+            return false;
+        }
+
+        // Listeners release their per-window resources (e.g. the surface) while the SDL window is still alive.
+        if (has_subsystem<EventManager>())
+        {
+            get_subsystem<EventManager>().trigger<WindowDestroyed>(WindowDestroyed {static_cast<uint32_t>(id)});
+        }
+        windows_.erase(it);
+        return true;
+    }
+
+    Window* WindowManager::get_main_window() const noexcept { return get_window_by_id(main_window_id_); }
+
     Window* WindowManager::get_window_by_id(uint64_t id) const noexcept
     {
         auto it = windows_.find(id);
         return it != windows_.end() ? it->second.get() : nullptr;
     }
 
+    std::pmr::vector<Window*> WindowManager::get_windows(std::pmr::memory_resource* resource) const
+    {
+        std::pmr::vector<Window*> result(resource);
+        result.reserve(windows_.size());
+        for (const auto& [id, window] : windows_)
+        {
+            result.push_back(window.get());
+        }
+        return result;
+    }
+
     uint32_t WindowManager::get_id() const noexcept
     {
         if (auto* win = get_main_window())
@@ -2,8 +2,10 @@
 #include "window.h"
 #include <SDL3/SDL.h>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace core
 {
@@ -14,8 +16,14 @@ namespace core
         explicit WindowManager(const std::string& title, int w, int h);
         ~WindowManager();
 
-        [[nodiscard]] Window* get_main_window() const noexcept;
-        [[nodiscard]] Window* get_window_by_id(uint64_t id) const noexcept;
+        // Secondary windows are created hidden; the renderer shows them once their swapchain exists.
+        Window* create_window(const std::string& title, int w, int h);
+        bool    destroy_window(uint64_t id);
+
+        [[nodiscard]] Window*                   get_main_window() const noexcept;
+        [[nodiscard]] Window*                   get_window_by_id(uint64_t id) const noexcept;
+        [[nodiscard]] std::pmr::vector<Window*> get_windows(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+        [[nodiscard]] bool                      is_main_window(uint64_t id) const noexcept { return id == main_window_id_; }
 
         [[nodiscard]] uint64_t get_ticks() const noexcept { return SDL_GetTicks(); }
         [[nodiscard]] uint32_t get_id() const noexcept;
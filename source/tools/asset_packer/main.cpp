@@ -0,0 +1,30 @@
+#include "asset/asset_archive.h"
+#include <cstdio>
+#include <string>
+
+// asset_packer <asset directory> <archive>: packs every file under the directory into one archive
+// that AssetSystem mounts (see asset/asset_archive.h for the format).
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "usage: asset_packer <asset directory> <archive>\n");
+        return 2;
+    }
+
+    std::string error;
+    if (!core::AssetArchive::build(argv[1], argv[2], error))
+    {
+        std::fprintf(stderr, "asset_packer: %s\n", error.c_str());
+        return 1;
+    }
+
+    core::AssetArchive archive;
+    if (!archive.open(argv[2]))
+    {
+        std::fprintf(stderr, "asset_packer: %s can not be read back\n", argv[2]);
+        return 1;
+    }
+    std::printf("asset_packer: %zu files packed into %s\n", archive.get_entries().size(), argv[2]);
+    return 0;
+}